@@ -30,6 +30,10 @@ const uint8_t BME680_SPI_MEM_PAGE_POSITION{4};         ///< Bit position for mem
 const uint8_t BME680_HUMIDITY_MASK{0xF8};              ///< Mask is binary B11111000
 const uint8_t BME680_PRESSURE_MASK{0xE3};              ///< Mask is binary B11100011
 const uint8_t BME680_TEMPERATURE_MASK{0x1F};           ///< Mask is binary B00011111
+const uint8_t BME680_MODE_MASK{0xFC};                  ///< Mask is binary B11111100
+const uint8_t BME680_SHADOW_SIZE{6};                   ///< Registers 0x70 to 0x75
+const uint8_t BME680_NB_CONV_MASK{0x0F};               ///< Heater profile bits of ctrl_gas_1
+const uint8_t BME680_RUN_GAS_BIT{0x10};                ///< Gas measurement enable bit
 /***************************************************************************************************
 ** Declare the constants used for calibration                                                     **
 ***************************************************************************************************/
@@ -197,14 +201,44 @@ bool BME680_Class::commonInitialization() {
       bitWrite(SPI_Register, BME680_SPI_MEM_PAGE_POSITION, 1);  // Page "1" again
       putData(BME680_SPI_REGISTER, SPI_Register);               // Update register value
     }                                                           // of if-then SPI mode
-    uint8_t workRegister = readByte(BME680_CONTROL_MEASURE_REGISTER);  // Read the control measure
-    putData(BME680_CONTROL_MEASURE_REGISTER,
-            (uint8_t)(workRegister | 1));  // Trigger 1st measurement
+    loadShadowRegisters();                                      // Cache the control registers
+    triggerMeasurement();                                       // Trigger 1st measurement
     return true;
   }  // of if-then device is really a BME680
   else
     return false;
 }  // of method commonInitialization
+void BME680_Class::loadShadowRegisters() {
+  /*!
+  @brief   Reads the control registers once into the shadow copies
+  @details All later changes to these registers are done on the shadow copies and written out
+           directly, so no read-modify-write cycle is needed on the bus. The mode bits of the
+           measurement control register are not kept as the device clears them on its own
+  */
+  uint8_t regs[BME680_SHADOW_SIZE] = {0};            // Registers 0x70 to 0x75
+  getData(BME680_CONTROL_GAS_REGISTER1, regs);       // read all of them in one burst
+  _ctrlGas0 = regs[0];                               // 0x70 ctrl_gas_0
+  _ctrlGas1 = regs[1];                               // 0x71 ctrl_gas_1
+  _ctrlHum  = regs[2];                               // 0x72 ctrl_hum
+  _ctrlMeas = regs[4] & BME680_MODE_MASK;            // 0x74 ctrl_meas without mode bits
+  _config   = regs[5];                               // 0x75 config
+}  // of method loadShadowRegisters()
+void BME680_Class::putRegisters(const uint8_t *pairs, const uint8_t count) const {
+  /*!
+  @brief   Writes several registers as register/value pairs
+  @details Over I2C all pairs are sent in a single transaction, which the BME680 supports for
+           non-consecutive registers. Other interfaces write the pairs one by one
+  param[in] pairs Array of 2 * count bytes, register address followed by its value
+  param[in] count Number of registers to write
+  */
+  if (_I2CAddress) {                      // Using I2C if address is non-zero
+    Wire.beginTransmission(_I2CAddress);  // Address the I2C device
+    for (uint8_t i = 0; i < count * 2; i++) Wire.write(pairs[i]);  // Send every pair
+    Wire.endTransmission();               // Close transmission
+  } else {
+    for (uint8_t i = 0; i < count; i++) putData(pairs[i * 2], pairs[i * 2 + 1]);
+  }  // of if-then-else using I2C
+}  // of method putRegisters()
 uint8_t BME680_Class::readByte(const uint8_t addr) const {
   /*!
   @brief   Read a single byte from the given address
@@ -240,17 +274,31 @@ void BME680_Class::getCalibration() {
   @details  The calibration registers are read into a temporary array and then parsed into the
             appropriate calibration variables, this was taken from the example BOSCH software and
             minimizes register reads, but makes it rather difficult to read. This will be redone
-            for legibility at some point in the future
+            for legibility at some point in the future. When an image was given with
+            setCalibrationImage() only the second coefficient block is read back; if it matches,
+            the rest of the image is trusted and the other registers are not read
   param[in] addr Address of device
   return    single byte read
   */
+  uint8_t *coeff_arr1 = _calibration;                      // Image layout: array 1, array 2,
+  uint8_t *coeff_arr2 = _calibration + BME680_COEFF_SIZE1;  // then the 3 gas registers
+  uint8_t *gas_regs   = coeff_arr2 + BME680_COEFF_SIZE2;    //
+  uint8_t  check[BME680_COEFF_SIZE2] = {0};                 // Block read back to validate
+  getData(BME680_COEFF_START_ADDRESS2, check);              // the given image
+  _calibrationReused = _calibrationValid && memcmp(check, coeff_arr2, sizeof(check)) == 0;
+  if (!_calibrationReused) {                                // Read the whole image otherwise
+    uint8_t block1[BME680_COEFF_SIZE1] = {0};               //
+    getData(BME680_COEFF_START_ADDRESS1, block1);           // Split reading registers into 2
+    memcpy(coeff_arr1, block1, sizeof(block1));             // one 25 bytes and the other 16
+    memcpy(coeff_arr2, check, sizeof(check));               //
+    getData(BME680_ADDR_RES_HEAT_RANGE_ADDR, gas_regs[0]);  //
+    getData(BME680_ADDR_RES_HEAT_VAL_ADDR, gas_regs[1]);    //
+    getData(BME680_ADDR_RANGE_SW_ERR_ADDR, gas_regs[2]);    //
+    _calibrationValid = true;                               //
+  }                                                         // of if-then image not reused
   /*************************************
   ** Temperature related coefficients **
   *************************************/
-  uint8_t coeff_arr1[BME680_COEFF_SIZE1] = {0};      // Define temp array 1 and initialize with 0x
-  uint8_t coeff_arr2[BME680_COEFF_SIZE2] = {0};      // Define temp array 2 and initialize with 0s
-  getData(BME680_COEFF_START_ADDRESS1, coeff_arr1);  // Split reading registers into 2
-  getData(BME680_COEFF_START_ADDRESS2, coeff_arr2);  // one 25 bytes and the other 16
   _T1 = (uint16_t)(CONCAT_BYTES(coeff_arr2[BME680_T1_MSB_REG], coeff_arr2[BME680_T1_LSB_REG]));
   _T2 = (int16_t)(CONCAT_BYTES(coeff_arr1[BME680_T2_MSB_REG], coeff_arr1[BME680_T2_LSB_REG]));
   _T3 = (int8_t)(coeff_arr1[BME680_T3_REG]);
@@ -287,14 +335,36 @@ void BME680_Class::getCalibration() {
   _G1 = (int8_t)coeff_arr2[BME680_GH1_REG];
   _G2 = (int16_t)(CONCAT_BYTES(coeff_arr2[BME680_GH2_MSB_REG], coeff_arr2[BME680_GH2_LSB_REG]));
   _G3 = (int8_t)coeff_arr2[BME680_GH3_REG];
-  uint8_t temp_var = 0;
-  getData(BME680_ADDR_RES_HEAT_RANGE_ADDR, temp_var);
-  _res_heat_range = ((temp_var & BME680_RHRANGE_MSK) / 16);
-  getData(BME680_ADDR_RES_HEAT_VAL_ADDR, temp_var);
-  _res_heat = (int8_t)temp_var;
-  getData(BME680_ADDR_RANGE_SW_ERR_ADDR, temp_var);
-  _rng_sw_err = ((int8_t)temp_var & (int8_t)BME680_RSERROR_MSK) / 16;
+  _res_heat_range = ((gas_regs[0] & BME680_RHRANGE_MSK) / 16);
+  _res_heat       = (int8_t)gas_regs[1];
+  _rng_sw_err     = ((int8_t)gas_regs[2] & (int8_t)BME680_RSERROR_MSK) / 16;
 }  // of method getCalibration()
+void BME680_Class::setCalibrationImage(const uint8_t *image) {
+  /*!
+  @brief    Gives the calibration image saved from an earlier run
+  @details  The next begin() validates it against the device instead of reading all of it
+  param[in] image BME680_CALIBRATION_SIZE bytes returned by getCalibrationImage()
+  */
+  memcpy(_calibration, image, BME680_CALIBRATION_SIZE);
+  _calibrationValid = true;
+}  // of method setCalibrationImage()
+bool BME680_Class::getCalibrationImage(uint8_t *image) const {
+  /*!
+  @brief    Copies the calibration image in use, to be saved for the next run
+  param[in] image Destination of BME680_CALIBRATION_SIZE bytes
+  return    "true" if an image is available, i.e. after a successful begin()
+  */
+  if (!_calibrationValid) return false;
+  memcpy(image, _calibration, BME680_CALIBRATION_SIZE);
+  return true;
+}  // of method getCalibrationImage()
+bool BME680_Class::isCalibrationReused() const {
+  /*!
+  @brief    Tells whether the last begin() kept the image given with setCalibrationImage()
+  return    "true" if only the validation block was read
+  */
+  return _calibrationReused;
+}  // of method isCalibrationReused()
 uint8_t BME680_Class::setOversampling(const uint8_t sensor, const uint8_t sampling) const {
   /*!
   @brief   sets the oversampling mode for the sensor
@@ -316,13 +386,14 @@ uint8_t BME680_Class::setOversampling(const uint8_t sensor, const uint8_t sampli
   switch (sensor) {                // Depending upon which sensor is chosen
     case HumiditySensor:           // Set the humidity oversampling
     {
-      tempRegister = readByte(BME680_CONTROL_HUMIDITY_REGISTER);  // Read the register contents
-      if (sampling == UINT8_MAX) {                                // If we just want to read values
+      tempRegister = _ctrlHum;      // Use the shadow register contents
+      if (sampling == UINT8_MAX) {  // If we just want to read values
 
         returnValue = tempRegister & ~BME680_HUMIDITY_MASK;  // Set return value
       } else {
         tempRegister &= BME680_HUMIDITY_MASK;  // Mask bits to 0
         tempRegister |= sampling;              // Add in the sampling bits
+        _ctrlHum = tempRegister;               // Update the shadow copy
         putData(BME680_CONTROL_HUMIDITY_REGISTER,
                 (uint8_t)tempRegister);  // Update humidity bits 0:2
       }                                  // if-then return current value or set new value
@@ -330,24 +401,26 @@ uint8_t BME680_Class::setOversampling(const uint8_t sensor, const uint8_t sampli
     }                     // of HumiditySensor
     case PressureSensor:  // Set the pressure oversampling
     {
-      tempRegister = readByte(BME680_CONTROL_MEASURE_REGISTER);  // Read the register contents
+      tempRegister = _ctrlMeas;     // Use the shadow register contents
       if (sampling == UINT8_MAX) {  // If we just want to read the values
         returnValue = (tempRegister & ~BME680_PRESSURE_MASK) >> 2;  // Set return value
       } else {
         tempRegister &= BME680_PRESSURE_MASK;  // Mask bits to 0
         tempRegister |= (sampling << 2);       // Add in sampling bits at offset
+        _ctrlMeas = tempRegister;              // Update the shadow copy
         putData(BME680_CONTROL_MEASURE_REGISTER, (uint8_t)tempRegister);  // Update register
       }  // if-then return current value or set new value
       break;
     }                        // of PressureSensor
     case TemperatureSensor:  // Set the temperature oversampling
     {
-      tempRegister = readByte(BME680_CONTROL_MEASURE_REGISTER);  // Read the register contents
+      tempRegister = _ctrlMeas;     // Use the shadow register contents
       if (sampling == UINT8_MAX) {  // If we just want to read the values
         returnValue = (tempRegister & ~BME680_TEMPERATURE_MASK) >> 5;  // Set return value
       } else {
         tempRegister &= BME680_TEMPERATURE_MASK;  // Mask bits to 0
         tempRegister |= (sampling << 5);          // Add in the sampling bits at offset
+        _ctrlMeas = tempRegister;                 // Update the shadow copy
         putData(BME680_CONTROL_MEASURE_REGISTER,
                 (uint8_t)tempRegister);  // Update humidity bits 5:7
       }                                  // if-then return current value or set new value
@@ -366,17 +439,46 @@ uint8_t BME680_Class::setIIRFilter(const uint8_t iirFilterSetting) const {
    param[in] iirFilterSetting New setting
    return   IIR Filter setting
    */
-  waitForReadings();                                       // Ensure any active reading is finished
-  uint8_t returnValue = readByte(BME680_CONFIG_REGISTER);  // Get control register byte contents
+  uint8_t returnValue = _config;                           // Use the shadow register contents
   if (iirFilterSetting != UINT8_MAX)                       // If the value is to be changed
   {                                                        //
+    waitForReadings();                                     // Ensure any active reading is finished
     returnValue = returnValue & B11100011;                 // mask IIR bits
     returnValue |= (iirFilterSetting & B00000111) << 2;    // use 3 bits of iirFilterSetting
+    _config = returnValue;                                 // Update the shadow copy
     putData(BME680_CONFIG_REGISTER, returnValue);          // Write new control register value
   }  // if the value is to be changed                                   //
   returnValue = (returnValue >> 2) & B00000111;  // Extract IIR filter setting from register
   return (returnValue);                          // Return IIR Filter setting
 }  // of method setIIRFilter()
+bool BME680_Class::setMeasurementConfig(const uint8_t tempSampling, const uint8_t humSampling,
+                                        const uint8_t pressSampling,
+                                        const uint8_t iirFilterSetting) const {
+  /*!
+   @brief   Sets the three oversampling rates and the IIR filter in one bus transaction
+   @details Equivalent to three calls to setOversampling() and one to setIIRFilter(), but the
+            humidity, measurement and configuration registers are written as a single burst.
+            The humidity register is written first as it only takes effect with ctrl_meas
+   param[in] tempSampling  Temperature oversampling from enumerated type oversamplingTypes
+   param[in] humSampling   Humidity oversampling from enumerated type oversamplingTypes
+   param[in] pressSampling Pressure oversampling from enumerated type oversamplingTypes
+   param[in] iirFilterSetting IIR filter from enumerated type iirFilterTypes
+   return "true" if successful otherwise false
+   */
+  if (tempSampling >= UnknownOversample || humSampling >= UnknownOversample ||
+      pressSampling >= UnknownOversample || iirFilterSetting >= UnknownIIR) {
+    return false;  // return an error if a value is out of range
+  }
+  waitForReadings();  // Ensure any active reading is finished
+  _ctrlHum  = (_ctrlHum & BME680_HUMIDITY_MASK) | humSampling;
+  _ctrlMeas = (uint8_t)((tempSampling << 5) | (pressSampling << 2));
+  _config   = (_config & B11100011) | ((iirFilterSetting & B00000111) << 2);
+  const uint8_t pairs[] = {BME680_CONTROL_HUMIDITY_REGISTER, _ctrlHum,
+                           BME680_CONTROL_MEASURE_REGISTER,  _ctrlMeas,
+                           BME680_CONFIG_REGISTER,           _config};
+  putRegisters(pairs, 3);  // Write all three registers in one go
+  return true;
+}  // of method setMeasurementConfig()
 uint8_t BME680_Class::getSensorData(int32_t& temp, int32_t& hum, int32_t& press, int32_t& gas,
                                     const bool waitSwitch) {
   /*!
@@ -438,6 +540,7 @@ uint8_t BME680_Class::readSensors(const bool waitSwitch) {
   adc_gas_res =
       (uint16_t)((uint32_t)buff[13] << 2 | (((uint32_t)buff[14]) >> 6));  // put the 2 bytes of Gas
   gas_range = buff[14] & 0X0F;                                            // Retrieve the range
+  _gasIndex = buff[0] & BME680_NB_CONV_MASK;                              // and the heater profile
                                 //*******************************//
                                 // First compute the temperature //
                                 //*******************************//
@@ -519,46 +622,117 @@ bool BME680_Class::setGas(uint16_t GasTemp, uint16_t GasMillis) const {
    * return Always returns "true"
    */
   waitForReadings();  // Ensure any active reading is finished
-  uint8_t gasRegister = readByte(BME680_CONTROL_GAS_REGISTER2);  // Read current register values
   if (GasTemp == 0 || GasMillis == 0) {
     // If either input variable is zero //
-    putData(BME680_CONTROL_GAS_REGISTER1, (uint8_t)B00001000);  // Turn off gas heater
-    putData(BME680_CONTROL_GAS_REGISTER2,
-            (uint8_t)(gasRegister & B11101111));  // Turn off gas measurements
+    _ctrlGas0 = B00001000;                    // Turn off gas heater
+    _ctrlGas1 = _ctrlGas1 & B11101111;        // Turn off gas measurements
+    const uint8_t pairs[] = {BME680_CONTROL_GAS_REGISTER1, _ctrlGas0,
+                             BME680_CONTROL_GAS_REGISTER2, _ctrlGas1};
+    putRegisters(pairs, 2);  // Write both registers in one go
   } else {
-    putData(BME680_CONTROL_GAS_REGISTER1, (uint8_t)0);  // Turn off heater bit to turn on
-    uint8_t heatr_res;
-    int32_t var1, var2, var3, var4, var5, heatr_res_x100;
-    if (GasTemp < 200)
-      GasTemp = 200;
-    else if (GasTemp > 400)
-      GasTemp = 400;  // Clamp temperature to min/max
-
-    var1 = (((int32_t)(_Temperature / 100) * _H3) / 1000) << 8;
-    var2 = (_G1 + 784) * (((((_G2 + 154009) * GasTemp * 5) / 100) + 3276800) / 10);  // Issue #26
-    var3 = var1 + (var2 / 2);
-    var4 = (var3 / (_res_heat_range + 4));
-    var5 = (131 * _res_heat) + 65536;
-    heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
-    heatr_res      = (uint8_t)((heatr_res_x100 + 50) / 100);
-    putData(BME680_GAS_HEATER_REGISTER0, heatr_res);
-    uint8_t factor = 0;
-    uint8_t durval;
-    if (GasMillis >= 0xfc0)
-      durval = 0xff;  // Max duration
-    else {
-      while (GasMillis > 0x3F) {
-        GasMillis = GasMillis >> 2;
-        factor += 1;
-      }  // of while loop
-      durval = (uint8_t)(GasMillis + (factor * 64));
-    }                                                   // of if-then-else duration exceeds max
-    putData(BME680_CONTROL_GAS_REGISTER1, (uint8_t)0);  // then turn off gas heater
-    putData(BME680_GAS_DURATION_REGISTER0, durval);
-    putData(BME680_CONTROL_GAS_REGISTER2, (uint8_t)(gasRegister | B00010000));
+    uint8_t heatr_res = calcHeaterResistance(GasTemp);  // Heater resistance set-point
+    uint8_t durval    = calcHeaterDuration(GasMillis);  // Encoded heating duration
+    _ctrlGas0 = 0;                     // Clear heat_off to turn the heater on
+    _ctrlGas1 = (_ctrlGas1 & 0xE0) | BME680_RUN_GAS_BIT;  // Run gas using heater profile 0
+    const uint8_t pairs[] = {BME680_CONTROL_GAS_REGISTER1,  _ctrlGas0,
+                             BME680_GAS_HEATER_REGISTER0,   heatr_res,
+                             BME680_GAS_DURATION_REGISTER0, durval,
+                             BME680_CONTROL_GAS_REGISTER2,  _ctrlGas1};
+    putRegisters(pairs, 4);  // Write all heater settings in one go
   }  // of if-then-else turn gas measurements on or off
+  _gasPending = false;       // ctrl_gas_1 has just been written
   return true;
 }  // of method setGas()
+uint8_t BME680_Class::calcHeaterResistance(uint16_t GasTemp) const {
+  /*!
+   * @brief    Computes the res_heat_x register value for a target temperature
+   * @details  The result depends on the last measured ambient temperature, so it must be
+   *           recomputed when the ambient temperature changes significantly
+   * param[in] GasTemp  Target temperature in Celsius, clamped to 200-400
+   * return    Value for one of the res_heat_0 to res_heat_9 registers
+   */
+  int32_t var1, var2, var3, var4, var5, heatr_res_x100;
+  if (GasTemp < 200)
+    GasTemp = 200;
+  else if (GasTemp > 400)
+    GasTemp = 400;  // Clamp temperature to min/max
+
+  var1 = (((int32_t)(_Temperature / 100) * _H3) / 1000) << 8;
+  var2 = (_G1 + 784) * (((((_G2 + 154009) * GasTemp * 5) / 100) + 3276800) / 10);  // Issue #26
+  var3 = var1 + (var2 / 2);
+  var4 = (var3 / (_res_heat_range + 4));
+  var5 = (131 * _res_heat) + 65536;
+  heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
+  return (uint8_t)((heatr_res_x100 + 50) / 100);
+}  // of method calcHeaterResistance()
+uint8_t BME680_Class::calcHeaterDuration(uint16_t GasMillis) const {
+  /*!
+   * @brief    Encodes a heating duration for the gas_wait_x registers
+   * param[in] GasMillis Milliseconds to keep the heater on, at most 4032
+   * return    6-bit duration with a 2-bit multiplication factor
+   */
+  uint8_t factor = 0;
+  if (GasMillis >= 0xfc0) return 0xff;  // Max duration
+  while (GasMillis > 0x3F) {
+    GasMillis = GasMillis >> 2;
+    factor += 1;
+  }  // of while loop
+  return (uint8_t)(GasMillis + (factor * 64));
+}  // of method calcHeaterDuration()
+bool BME680_Class::setHeaterProfiles(const uint16_t *GasTemps, const uint16_t *GasMillis,
+                                     const uint8_t count) const {
+  /*!
+   * @brief    Programs several heater set-points at once
+   * @details  The resistance and duration of profiles 0 to count-1 are computed for the last
+   *           measured ambient temperature and written with the heater control registers in a
+   *           single bus transaction. Measurements keep using profile 0 until another one is
+   *           chosen with selectHeaterProfile()
+   * param[in] GasTemps  Target temperatures in Celsius, one per profile
+   * param[in] GasMillis Heating durations in milliseconds, one per profile
+   * param[in] count     Number of profiles, 1 to BME680_HEATER_PROFILES
+   * return    "true" if successful otherwise false
+   */
+  uint8_t pairs[(BME680_HEATER_PROFILES * 2 + 2) * 2];  // Register/value pairs to write
+  uint8_t n = 0;                                        // Bytes used in pairs
+  if (count == 0 || count > BME680_HEATER_PROFILES) return false;
+  waitForReadings();  // Ensure any active reading is finished
+  _ctrlGas0 = 0;      // Clear heat_off to turn the heater on
+  _ctrlGas1 = (_ctrlGas1 & 0xE0) | BME680_RUN_GAS_BIT;  // Run gas using heater profile 0
+  pairs[n++] = BME680_CONTROL_GAS_REGISTER1;
+  pairs[n++] = _ctrlGas0;
+  for (uint8_t i = 0; i < count; i++) {
+    pairs[n++] = BME680_GAS_HEATER_REGISTER0 + i;
+    pairs[n++] = calcHeaterResistance(GasTemps[i]);
+    pairs[n++] = BME680_GAS_DURATION_REGISTER0 + i;
+    pairs[n++] = calcHeaterDuration(GasMillis[i]);
+  }  // of for-next each profile
+  pairs[n++] = BME680_CONTROL_GAS_REGISTER2;
+  pairs[n++] = _ctrlGas1;
+  putRegisters(pairs, n / 2);  // Write all set-points in one go
+  _gasPending = false;         // ctrl_gas_1 has just been written
+  return true;
+}  // of method setHeaterProfiles()
+bool BME680_Class::selectHeaterProfile(const uint8_t index) const {
+  /*!
+   * @brief    Chooses the heater set-point used by the next measurement
+   * @details  Only the shadow register is changed here. It is written together with the next
+   *           measurement trigger, so the measurement in progress is not disturbed and no extra
+   *           bus transaction is needed
+   * param[in] index Heater profile, 0 to BME680_HEATER_PROFILES-1
+   * return    "true" if successful otherwise false
+   */
+  if (index >= BME680_HEATER_PROFILES) return false;
+  _ctrlGas1   = (_ctrlGas1 & ~BME680_NB_CONV_MASK) | index;  // Set nb_conv
+  _gasPending = true;                                        // Write it on next trigger
+  return true;
+}  // of method selectHeaterProfile()
+uint8_t BME680_Class::getGasIndex() const {
+  /*!
+   * @brief    Returns the heater profile used by the last reading
+   * return    Value of gas_meas_index_0 when the last reading was made
+   */
+  return (_gasIndex);
+}  // of method getGasIndex()
 bool BME680_Class::measuring() const {
   /*!
    * @brief Returns whether the BME680 is currently measuring
@@ -574,7 +748,13 @@ void BME680_Class::triggerMeasurement() const {
   /*!
    * @brief Trigger a new measurement on the BME680
    */
-  uint8_t workRegister = readByte(BME680_CONTROL_MEASURE_REGISTER);  // Read the control measure
-  putData(BME680_CONTROL_MEASURE_REGISTER,
-          (uint8_t)(workRegister | 1));  // Trigger start of next measurement
+  if (_gasPending) {  // A new heater profile was selected, write it with the trigger
+    const uint8_t pairs[] = {BME680_CONTROL_GAS_REGISTER2, _ctrlGas1,
+                             BME680_CONTROL_MEASURE_REGISTER, (uint8_t)(_ctrlMeas | 1)};
+    putRegisters(pairs, 2);
+    _gasPending = false;
+  } else {
+    putData(BME680_CONTROL_MEASURE_REGISTER,
+            (uint8_t)(_ctrlMeas | 1));  // Trigger start of next measurement from the shadow copy
+  }  // of if-then-else profile changed
 }  // of method "triggerMeasurement()"
@@ -56,6 +56,9 @@ Written by Arnd, https://github.com/SV-Zanshin
 
 Version | Date       | Developer  | Comments
 ------- | ---------- | ---------- | ---------------------------------------------------------------
+1.0.12  | 2026-10-18 | AeroSense  | Heater profiles 0-9 programmed in one burst, profile selection
+1.0.11  | 2026-10-18 | AeroSense  | Shadow registers, burst register writes, repeated-start reads
+1.0.11  | 2026-10-18 | AeroSense  | getData/putData sizes no longer cached in a static, 32-bit I2C speed
 1.0.10  | 2020-12-03 | SV-Zanshin | Issue #34 Enhancements from Alain2019 - added measurement functionality
 1.0.10  | 2020-12-02 | SV-Zanshin | Issue #33 Optimize library code for size, performance, initializers
 1.0.10  | 2020-10-19 | Alain2019  | Issue #32 Change division to bit shifts for clarity
@@ -90,6 +93,8 @@ Version | Date       | Developer  | Comments
 #ifndef BME680_h
 #define BME680_h  ///< Guard code definition for the header
 #define CONCAT_BYTES(msb, lsb) (((uint16_t)msb << 8) | (uint16_t)lsb)  ///< combine msb & lsb bytes
+const uint8_t BME680_HEATER_PROFILES{10};  ///< Number of heater set-points in the device
+const uint8_t BME680_CALIBRATION_SIZE{44};  ///< Bytes of the raw calibration image
 #ifndef _BV
 #define _BV(bit) (1 << (bit))  ///< This macro isn't pre-defined on all platforms
 #endif
@@ -141,6 +146,15 @@ class BME680_Class {
                           const uint8_t sampling = UINT8_MAX) const;  // and return current value
   bool    setGas(uint16_t GasTemp, uint16_t GasMillis) const;  // Gas heating temperature and time
   uint8_t setIIRFilter(const uint8_t iirFilterSetting = UINT8_MAX) const;  // Set IIR Filter
+  bool    setMeasurementConfig(const uint8_t tempSampling,                 // Set all oversampling
+                               const uint8_t humSampling,                  // rates and the IIR
+                               const uint8_t pressSampling,                // filter in a single
+                               const uint8_t iirFilterSetting) const;      // bus transaction
+  bool    setHeaterProfiles(const uint16_t *GasTemps,         // Program heater set-points 0 to
+                            const uint16_t *GasMillis,        // count-1 for the current ambient
+                            const uint8_t   count) const;     // temperature
+  bool    selectHeaterProfile(const uint8_t index) const;     // Set-point of next measurement
+  uint8_t getGasIndex() const;                                // Set-point of the last reading
   uint8_t getSensorData(int32_t &temp, int32_t &hum,    // get most recent readings
                         int32_t &press, int32_t &gas,   //
                         const bool waitSwitch = true);  //
@@ -148,14 +162,30 @@ class BME680_Class {
   void    reset();                                      // Reset the BME680
   bool    measuring() const;                            ///< true if currently measuring
   void    triggerMeasurement() const;                   ///< trigger a measurement
+  void    setCalibrationImage(const uint8_t *image);    // Image to try at the next begin()
+  bool    getCalibrationImage(uint8_t *image) const;    // Image of the calibration in use
+  bool    isCalibrationReused() const;                  // true if begin() kept the given image
  private:                                               //
   bool     commonInitialization();                      ///< Common initialization code
   uint8_t  readByte(const uint8_t addr) const;          ///< Read byte from register address
   uint8_t  readSensors(const bool waitSwitch);          ///< read the registers in one burst
   void     waitForReadings() const;                     ///< Wait for readings to finish
   void     getCalibration();                            ///< Load calibration from registers
+  void     loadShadowRegisters();                       ///< Cache the control registers
+  void     putRegisters(const uint8_t *pairs,           ///< Write register/value pairs in
+                        const uint8_t count) const;     ///< one transaction
+  uint8_t  calcHeaterResistance(uint16_t GasTemp) const;    ///< res_heat_x for a temperature
+  uint8_t  calcHeaterDuration(uint16_t GasMillis) const;    ///< gas_wait_x for a duration
   uint8_t  _I2CAddress = 0;                             ///< Default is I2C address is unknown
-  uint16_t _I2CSpeed   = 0;                             ///< Default is I2C speed is unknown
+  uint32_t _I2CSpeed   = 0;                             ///< Default is I2C speed is unknown
+  mutable uint8_t _ctrlGas0 = 0, _ctrlGas1 = 0;         ///< Shadow of gas control registers
+  mutable uint8_t _ctrlHum = 0, _ctrlMeas = 0;          ///< Shadow of measurement control regs
+  mutable uint8_t _config = 0;                          ///< Shadow of the configuration register
+  mutable bool    _gasPending = false;                  ///< ctrl_gas_1 changed since last trigger
+  uint8_t  _gasIndex = 0;                               ///< Heater profile of the last reading
+  uint8_t  _calibration[BME680_CALIBRATION_SIZE];       ///< Raw calibration registers
+  bool     _calibrationValid  = false;                  ///< _calibration holds an image
+  bool     _calibrationReused = false;                  ///< begin() kept the given image
   uint8_t  _cs, _sck, _mosi, _miso;                     ///< Hardware and software SPI pins
   uint8_t  _H6, _P10, _res_heat_range;                  ///< unsigned configuration vars
   int8_t   _H3, _H4, _H5, _H7, _G1, _G3, _T3, _P3, _P6, _P7, _res_heat,
@@ -178,7 +208,7 @@ class BME680_Class {
    the getData().  The "putData()" is called directly in the code.
   */
   template <typename T>
-  uint8_t &getData(const uint8_t addr, T &value) const {
+  uint8_t getData(const uint8_t addr, T &value) const {
     /*!
       @brief     Template for reading from I2C or SPI using any data type
       @details   As a template it can support compile-time data type definitions
@@ -186,14 +216,14 @@ class BME680_Class {
       @param[in] value Data Type "T" to read
       @return    Size of data read in bytes
     */
-    uint8_t *      bytePtr    = (uint8_t *)&value;  // Pointer to structure beginning
-    static uint8_t structSize = sizeof(T);          // Number of bytes in structure
+    uint8_t *bytePtr    = (uint8_t *)&value;        // Pointer to structure beginning
+    uint8_t  structSize = sizeof(T);                // Number of bytes in structure
     if (_I2CAddress)                                // Using I2C if address is non-zero
     {                                               //
       Wire.beginTransmission(_I2CAddress);          // Address the I2C device
       Wire.write(addr);                             // Send register address to read
-      Wire.endTransmission();                       // Close transmission
-      Wire.requestFrom(_I2CAddress, sizeof(T));     // Request 1 byte of data
+      Wire.endTransmission(false);                  // Repeated start, keep the bus
+      Wire.requestFrom(_I2CAddress, sizeof(T));     // Request sizeof(T) bytes of data
       structSize = Wire.available();                // Use the actual number of bytes
       for (uint8_t i = 0; i < structSize; i++)
         *bytePtr++ = Wire.read();  // loop for each byte to be read
@@ -238,7 +268,7 @@ class BME680_Class {
     return (structSize);
   }  // of method getData()
   template <typename T>
-  uint8_t &putData(const uint8_t addr, const T &value) const {
+  uint8_t putData(const uint8_t addr, const T &value) const {
     /*!
       @brief     Template for writing to I2C or SPI using any data type
       @details   As a template it can support compile-time data type definitions
@@ -247,7 +277,7 @@ class BME680_Class {
       @return    Size of data written in bytes
     */
     const uint8_t *bytePtr    = (const uint8_t *)&value;  // Pointer to structure beginning
-    static uint8_t structSize = sizeof(T);                // Number of bytes in structure
+    uint8_t        structSize = sizeof(T);                // Number of bytes in structure
     if (_I2CAddress)                                      // Using I2C if address is non-zero
     {                                                     //
       Wire.beginTransmission(_I2CAddress);                // Address the I2C device
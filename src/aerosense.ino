@@ -45,44 +45,148 @@
 // Includes Bluetooth communication functions
 #include "protocols/Bluetooth.hpp"
 
+// Includes the swarm logic and its ESP-NOW link
+#include "protocols/Swarm.hpp"
+#include "protocols/EspNow.hpp"
+
+// Includes the Wi-Fi uplink of the ground stations
+#include "protocols/Uplink.hpp"
+
+// Includes the compression setting of the recorded and uplinked frames
+#include "protocols/Compress.hpp"
+
+// Includes the identity of the unit
+#include "system/Identity.hpp"
+
+// Includes the session recorder, served by the log server
+#include "storage/Recorder.hpp"
+
+// Includes the state store keeping calibrations and settings across reboots
+#include "storage/State.hpp"
+
+// Includes the boot sequence, the cooperative scheduler and the sensor
+// health layer
+#include "system/Boot.hpp"
+#include "system/Scheduler.hpp"
+#include "system/Health.hpp"
+
+// Includes the monotonic clock and the UTC estimate
+#include "system/Timebase.hpp"
+
+// Includes the ADC characterisation the analog sensors are read through,
+// and the tick capturing them together
+#include "system/Adc.hpp"
+#include "system/Sampler.hpp"
+
+// Includes the channel definitions and the streaming statistics
+#include "processing/Channels.hpp"
+#include "processing/Statistics.hpp"
+#include "processing/Altitude.hpp"
+
+// Includes the air quality estimator fed by the BME680
+#include "processing/IAQ.hpp"
+
+// Includes the pollution grid served to the live maps
+#include "processing/Grid.hpp"
+
+// Includes the plume detector driving the burst sampling
+#include "processing/Events.hpp"
+
+// Includes the compensation de-mixing the MQ gas sensors
+#include "processing/Compensation.hpp"
+
 /* ---------------------- GLOBAL VARIABLES ---------------------- */
 
 // Stores data from BME680 sensor
 t_dataBME680 dataBME680;
 
+#if PROFILE_HAS_MHZ19B
 // Stores data from MH-Z19B sensor
 t_dataMHZ19B dataMHZ19B;
+#endif
 
+#if PROFILE_HAS_MQ4
 // Stores data from MQ-4 sensor
 t_dataMQ4 dataMQ4;
+#endif
 
+#if PROFILE_HAS_MQ7
 // Stores data from MQ-7 sensor
 t_dataMQ7 dataMQ7;
+#endif
 
+#if PROFILE_HAS_MQ131
 // Stores data from MQ-131 sensor
 t_dataMQ131 dataMQ131;
+#endif
 
+#if PROFILE_HAS_MQ137
 // Stores data from MQ-137 sensor
 t_dataMQ137 dataMQ137;
+#endif
 
+#if PROFILE_HAS_GYUV1
 // Stores data from GY-UV1 sensor
 t_dataGYUV1 dataGYUV1;
+#endif
 
+#if PROFILE_HAS_PMS5003
 // Stores data from PMS5003 sensor
 t_dataPMS5003 dataPMS5003;
+#endif
 
+#if PROFILE_HAS_PIXHAWK
 // Stores data from Pixhawk
 t_dataPixhawk dataPixhawk;
+#endif
 
-// Flag to enable or disable measurement
-uint8_t xEnableMeasuring = 0;
+// Stores the values of all channels for the current cycle
+t_sampleSet sampleSet;
 
-// Stores the previous timestamp for periodic measurement
-long preMillis;
+// Stores the last gas resistance vector of the BME680 scan
+t_scanBME680 scanBME680;
+
+// Heater ladder used in MEASURE_SCAN mode
+const uint16_t scanTemps[BME680_SCAN_STEPS] = BME680_SCAN_TEMPS;
+const uint16_t scanDurations[BME680_SCAN_STEPS] = BME680_SCAN_DURATIONS;
+
+// Measurement mode (MEASURE_OFF, MEASURE_RAW, MEASURE_SUMMARY or MEASURE_SCAN)
+uint8_t xEnableMeasuring = MEASURE_OFF;
+
+// Scheduler tasks re-armed or stopped after registration
+int8_t measureTaskId = SCHEDULER_NO_TASK;
+int8_t bootReportTaskId = SCHEDULER_NO_TASK;
+
+// Boot step of ESP-NOW, the swarm link is only used once it is up
+int8_t espNowStep = BOOT_NO_STEP;
 
 // Measurement interval in milliseconds
 #define PERIODE_MESURE 2000
 
+// Both measurement periods keep their phase to the sampler tick
+static_assert(PERIODE_MESURE % SAMPLER_TICK_MS == 0 && EVENT_BURST_PERIOD_MS % SAMPLER_TICK_MS == 0,
+              "Measurement periods must be multiples of the sampler tick");
+
+// Summary interval in milliseconds
+#define PERIODE_SUMMARY STATS_WINDOW_MS
+
+// Interval at which the end of the boot sequence is checked
+#define BOOT_REPORT_POLL_MS 100
+
+// Layout version of the runtime settings kept in the state store
+#define RUNTIME_CONFIG_VERSION 2
+
+// Runtime settings kept in the state store
+typedef struct
+{
+    // Measurement mode (MEASURE_x)
+    uint8_t mode;
+
+    // 1 if the recorded and uplinked frames are compressed
+    uint8_t compression;
+
+} t_runtimeConfig;
+
 
 /* *****************************************************************
     *                        SETUP FUNCTION                       *
@@ -96,19 +200,181 @@ void setup()
     Serial.begin(115200);
     
     Serial.println("Initialization");
-    // Initialize all sensors
+    Serial.println("Profile: " PROFILE_NAME);
+
+    /* --------------------- BOOT SEQUENCE --------------------- */
+
+    // The saved state first, the sensors start from their saved calibration.
+    // Then the ADC tables and the sensors on this core, so sampling starts as
+    // soon as they answer
+    addBootStep("STATE", bootState, BOOT_LANE_INLINE);
+    addBootStep("ADC", bootAdc, BOOT_LANE_INLINE);
+    addBootStep("SENSORS", bootSensors, BOOT_LANE_INLINE);
+    addBootStep("IAQ", bootIAQ, BOOT_LANE_INLINE);
+    addBootStep("GAS MATRIX", bootCompensation, BOOT_LANE_INLINE);
+
+    // The Bluetooth stack is the slowest to start, it gets a lane of its own
+    addBootStep("BT", initCommBT, BOOT_LANE_LINK);
+
+    // Flash is mounted before the uplink backlog, ESP-NOW starts Wi-Fi
+    // before the uplink station
+    addBootStep("RECORDER", initRecorder, BOOT_LANE_NETWORK);
+
+    if (SWARM_ROLE != SWARM_ROLE_STANDALONE)
+    {
+        espNowStep = addBootStep("ESP-NOW", bootEspNow, BOOT_LANE_NETWORK);
+    }
+
+    addBootStep("UPLINK", bootUplink, BOOT_LANE_NETWORK);
+
+    // Returns once the inline lane is done, the others keep running
+    startBoot();
+
+    /* ------------------- TASK REGISTRATION ------------------- */
+
+    // The sampler tick starts just before the measurement is registered, so
+    // every measurement runs half a tick after the tick it latches. The first
+    // one is taken right away rather than one period after boot
+    if (!initSampler())
+    {
+        Serial.println("Sampler timer failed, analog inputs read on demand");
+    }
+
+    // Periodic measurement and summary transmission
+    measureTaskId = addSchedulerTask(measureTask, PERIODE_MESURE, 1);
+    runSchedulerTaskIn(measureTaskId, SAMPLER_PHASE_MS);
+    addSchedulerTask(summaryTask, PERIODE_SUMMARY, 1);
+
+    // Step the BME680 heater ladder while scanning
+    addSchedulerTask(scanTask, BME680_SCAN_SERVICE_MS, 1);
+
+    // Keep the MQ-7 heater cycle running, even while not measuring
+    addSchedulerTask(serviceMQHeaters, MQ_HEATER_SERVICE_MS, 1);
+
+#if PROFILE_HAS_PMS5003
+    // Spin the PMS5003 fan up ahead of the measurements, let it sleep otherwise
+    addSchedulerTask(particleTask, PMS5003_SERVICE_MS, 1);
+#endif
+
+    // Re-initialize failed sensors without blocking the loop
+    addSchedulerTask(serviceHealth, HEALTH_SERVICE_MS, 1);
+
+    // Keep the UTC estimate disciplined by the host when there is no GPS
+    addSchedulerTask(timeSyncTask, TIME_PING_PERIOD_MS, 1);
+
+    // Send the batches and keep the Wi-Fi uplink connected
+    addSchedulerTask(serviceUplink, UPLINK_SERVICE_MS, 1);
+
+    // Write the recorded samples to flash in blocks
+    addSchedulerTask(serviceRecorder, RECORDER_SERVICE_MS, 1);
+
+    // Write the changed calibrations and settings once they settle
+    addSchedulerTask(serviceStateStore, STATE_SERVICE_MS, 1);
+
+    // Report the boot timing once the background lanes are done
+    bootReportTaskId = addSchedulerTask(bootReportTask, BOOT_REPORT_POLL_MS, 1);
+}
+
+
+/* *****************************************************************
+    *                         BOOT STEPS                          *
+   ***************************************************************** */
+
+// Opens the state store and restores the settings of the last run
+int bootState()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Saved settings
+    t_runtimeConfig config;
+
+    /* -------------------- SETTINGS RESTORE -------------------- */
+
+    if (!initStateStore())
+    {
+        return 0;
+    }
+
+    if (!loadState(STATE_RUNTIME_CONFIG, RUNTIME_CONFIG_VERSION, &config, sizeof(config)))
+    {
+        return 1;
+    }
+
+    // A warm boot resumes measuring in the mode it was left in
+    if (config.mode <= MEASURE_SCAN)
+    {
+        xEnableMeasuring = config.mode;
+    }
+
+    // Before the recorder and the uplink start, so their frames follow it
+    setCompressionEnabled(config.compression);
+
+    return 1;
+}
+
+// Characterises the ADCs the analog sensors are read through
+int bootAdc()
+{
+    initAdc();
+    Serial.print("ADC calibration: ");
+    Serial.println(getAdcCalibrationName());
+
+    // Without an eFuse calibration the nominal Vref is used
+    return 1;
+}
+
+// Initializes the sensors, each one is sampled as soon as it is ready
+int bootSensors()
+{
     initSensors();
+    initStatistics(STATS_EMA_ALPHA);
+    initGrid();
+    initEvents(PERIODE_MESURE);
+    initAltitude();
+    return 1;
+}
 
-    // Initialize Bluetooth communication
-    if (!initCommBT())
+// Restores the clean-air baseline learnt before the last reboot
+int bootIAQ()
+{
+    if (initIAQ())
     {
-        Serial.println("Failed Init BT");
+        Serial.println("IAQ baseline restored");
     }
 
-    else
+    // Without a baseline the estimator learns a new one
+    return 1;
+}
+
+// Restores the compensation matrix of the MQ sensors fitted on the host
+int bootCompensation()
+{
+    if (initCompensation())
+    {
+        Serial.println("Gas matrix restored");
+    }
+
+    // Without a fit each gas is read from its own sensor
+    return 1;
+}
+
+// Joins the swarm as a node or as its gateway
+int bootEspNow()
+{
+    initSwarm(getNodeId(), sendEspNow, forwardNodeFrame);
+    return initEspNow();
+}
+
+// Batches the samples to a collector when a network is configured
+int bootUplink()
+{
+    if (initUplink())
     {
-        Serial.println("Init BT Done");
+        Serial.println("Uplink enabled");
     }
+
+    // A unit without a configured network is not a failure
+    return 1;
 }
 
 
@@ -116,27 +382,176 @@ void setup()
     *                         LOOP FUNCTION                       *
    ***************************************************************** */
 
-// Main loop that handles Bluetooth commands and performs periodic measurement
+// Main loop that handles Bluetooth commands and runs the scheduled tasks
 void loop()
 {
     /* -------------------- HANDLE BLUETOOTH -------------------- */
 
     // Handle incoming Bluetooth commands
     handleBT(&xEnableMeasuring);
+    applyMeasureMode();
+    saveRuntimeConfig();
+
+    /* --------------------- HANDLE SWARM --------------------- */
+
+    // Forward the frames received from the nodes
+    if (SWARM_ROLE == SWARM_ROLE_GATEWAY && isBootStepReady(espNowStep))
+    {
+        serviceEspNow();
+    }
+
+    /* -------------------- SCHEDULED TASKS -------------------- */
+
+    // Run measurement, heater and health tasks that are due
+    runScheduler();
+}
+
+
+/* *****************************************************************
+    *                      SCHEDULED TASKS                        *
+   ***************************************************************** */
+
+// Performs a measurement every PERIODE_MESURE milliseconds, faster during a plume
+void measureTask()
+{
+    // Swarm nodes always measure, the gateway is their link to the host
+    if (!xEnableMeasuring && SWARM_ROLE != SWARM_ROLE_NODE)
+    {
+        return;
+    }
 
-    /* ------------------ PERIODIC MEASUREMENT ------------------ */
+    Serial.println("Measuring...");
+    readAllSensors();
+    markFirstSample();
+    detectEvents();
 
-    // Perform measurement if the interval has elapsed
-    if (millis() - preMillis >= PERIODE_MESURE)
+    if (SWARM_ROLE == SWARM_ROLE_NODE && isBootStepReady(espNowStep))
     {
-        preMillis = millis();
+        sendSwarmFrame();
+    }
+
+    sendUplinkSample();
+    recordCycle();
+    mapCycle();
+    telemetryCycle();
 
-        if (xEnableMeasuring)
+    // Raw mode sends every reading, summary mode only aggregates except
+    // during a plume, which is sent at full resolution
+    if (xEnableMeasuring == MEASURE_RAW ||
+        (xEnableMeasuring == MEASURE_SUMMARY && getEventState() != EVENT_IDLE))
+    {
+        sendAllSensors();
+    }
+}
+
+// Advances the BME680 heater scan and sends every complete vector
+void scanTask()
+{
+    serviceScanBME680();
+
+    if (getScanBME680(&scanBME680) && xEnableMeasuring == MEASURE_SCAN)
+    {
+        sendScan("GasScan:", scanBME680.heaterTemp, scanBME680.resistance,
+                 scanBME680.steps, scanBME680.validMask);
+    }
+}
+
+#if PROFILE_HAS_PMS5003
+// Tells the PMS5003 driver when the next measurement reads it
+void particleTask()
+{
+    // Swarm nodes always measure, like measureTask()
+    if (!xEnableMeasuring && SWARM_ROLE != SWARM_ROLE_NODE)
+    {
+        servicePMS5003(UINT32_MAX);
+        return;
+    }
+
+    servicePMS5003(getSchedulerDelay(measureTaskId));
+}
+#endif
+
+// Pings the host so it can discipline the UTC estimate
+void timeSyncTask()
+{
+    sendTimePing(getTimeUs());
+}
+
+// Sends the boot-timing report once, when every boot step is done
+void bootReportTask()
+{
+    if (isBootComplete())
+    {
+        sendBootReport();
+        setSchedulerEnabled(bootReportTaskId, 0);
+    }
+}
+
+// Sends the aggregated window at a lower rate than the samples
+void summaryTask()
+{
+    if (xEnableMeasuring == MEASURE_SUMMARY)
+    {
+        sendSummaries();
+    }
+
+    else
+    {
+        resetStatisticsWindow();
+    }
+}
+
+
+/* *****************************************************************
+    *                     APPLY MEASURE MODE                      *
+   ***************************************************************** */
+
+// Starts or stops the BME680 heater scan when the mode changes
+void applyMeasureMode()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Mode the sensors are currently configured for
+    static uint8_t activeMode = MEASURE_OFF;
+
+    /* -------------------- MODE SWITCHING -------------------- */
+
+    if (xEnableMeasuring == activeMode)
+    {
+        return;
+    }
+
+    if (xEnableMeasuring == MEASURE_SCAN)
+    {
+        if (!startScanBME680(scanTemps, scanDurations, BME680_SCAN_STEPS))
         {
-            Serial.println("Measuring...");
-            readAllSensors();
+            sendStatus("GasScan:", "UNAVAILABLE", 1);
         }
     }
+
+    else if (activeMode == MEASURE_SCAN)
+    {
+        stopScanBME680();
+    }
+
+    activeMode = xEnableMeasuring;
+}
+
+// Keeps the settings changed over Bluetooth for the next boot
+void saveRuntimeConfig()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Settings in use
+    t_runtimeConfig config;
+
+    /* -------------------- SAVE -------------------- */
+
+    config.mode = xEnableMeasuring;
+    config.compression = isCompressionEnabled();
+
+    // Unchanged settings are not written again, the store compares them
+    saveState(STATE_RUNTIME_CONFIG, RUNTIME_CONFIG_VERSION, &config, sizeof(config));
 }
 
 
@@ -144,81 +559,653 @@ void loop()
     *                       READ ALL SENSORS                     *
    ***************************************************************** */
 
-// Reads data from all sensors and sends it via Bluetooth
+// Reads data from all sensors and feeds the statistics engine
 void readAllSensors()
 {
-    
     /* ------------------- SENSOR MEASUREMENTS ------------------- */
 
+    clearSampleSet(&sampleSet);
+
+    // Every analog reading of this cycle comes from the same tick
+    latchSampler();
+
     /* ====================== BME680 SENSOR ====================== */
-    sendSectionHeader("BME680 SENSOR");
-    // // Acquire and forward BME680 environmental metrics
-    getDataBME680(&dataBME680);
-    sendData("Temp:", dataBME680.temp, "°", 0);
-    sendData("Humidity:", dataBME680.humidity, "%", 0);
-    sendData("Pressure:", dataBME680.pressure, "hPa", 0);
-    sendData("VOC Index:", dataBME680.vocIndex, "", 1);
+    // Acquire BME680 environmental metrics
+    if (getDataBME680(&dataBME680))
+    {
+        setSampleValue(&sampleSet, CH_TEMP, dataBME680.temp, dataBME680.timestamp);
+        setSampleValue(&sampleSet, CH_HUMIDITY, dataBME680.humidity, dataBME680.timestamp);
+        setSampleValue(&sampleSet, CH_PRESSURE, dataBME680.pressure, dataBME680.timestamp);
+
+        // The index means nothing until a baseline is available
+        if (dataBME680.iaqAccuracy != IAQ_STABILISING)
+        {
+            setSampleValue(&sampleSet, CH_VOC, dataBME680.vocIndex, dataBME680.timestamp);
+        }
+
+        setSampleValue(&sampleSet, CH_ALTITUDE, dataBME680.altitude, dataBME680.timestamp);
+        setSampleValue(&sampleSet, CH_CLIMB, dataBME680.climbRate, dataBME680.timestamp);
+    }
 
+#if PROFILE_HAS_MHZ19B
     /* ====================== MH-Z19B SENSOR ===================== */
-    // Uncomment when MH-Z19B data is ready to be reported
-    sendSectionHeader("MH-Z19B SENSOR");
     getDataMHZ19B(&dataMHZ19B);
-    sendData("CO2:", dataMHZ19B.CO2, "ppm", 0);
 
+    // A clipped output does not tell the concentration
+    if (!dataMHZ19B.clipped)
+    {
+        setSampleValue(&sampleSet, CH_CO2, dataMHZ19B.CO2, dataMHZ19B.timestamp);
+    }
+#endif
+
+#if PROFILE_HAS_MQ4
     /* ======================= MQ-4 SENSOR ======================= */
-    sendSectionHeader("MQ-4 SENSOR");
     // Capture methane concentration from MQ-4
     getDataMQ4(&dataMQ4);
-    sendData("CH4:", dataMQ4.methane, "ppm", 1);
+#endif
 
+#if PROFILE_HAS_MQ7
     /* ======================= MQ-7 SENSOR ======================= */
-    sendSectionHeader("MQ-7 SENSOR");
     // Capture carbon monoxide concentration from MQ-7
     getDataMQ7(&dataMQ7);
-    sendData("CO:", dataMQ7.carbonMonoxyde, "ppm", 1);
+#endif
 
+#if PROFILE_HAS_MQ131
     /* ====================== MQ-131 SENSOR ====================== */
-    sendSectionHeader("MQ-131 SENSOR");
     // Capture ozone and NO2 levels from MQ-131
     getDataMQ131(&dataMQ131);
-    sendData("O3:", dataMQ131.ozone, "ppm", 0);
-    sendData("NO2:", dataMQ131.no2, "ppm", 1);
+#endif
+
+#if PROFILE_HAS_MQ137
+    /* ====================== MQ-137 SENSOR ====================== */
+    // Only an input of the compensation, it also responds to CO
+    getDataMQ137(&dataMQ137);
+#endif
 
+    /* ===================== GAS COMPENSATION ==================== */
+    // The MQ readings of this cycle are de-mixed together
+    compensateGasSensors();
+
+#if PROFILE_HAS_GYUV1
     /* ======================= GY-UV1 SENSOR ===================== */
-    sendSectionHeader("GY-UV1 SENSOR");
     // Capture UV intensity from GY-UV1
     getDataGYUV1(&dataGYUV1);
+    if (!dataGYUV1.clipped)
+    {
+        setSampleValue(&sampleSet, CH_UV, dataGYUV1.uvRaw, dataGYUV1.timestamp);
+    }
+#endif
+
+#if PROFILE_HAS_PMS5003
+    /* ====================== PMS5003 SENSOR ===================== */
+    // Capture particulate matter concentrations from PMS5003
+    if (getDataPMS5003(&dataPMS5003))
+    {
+        setSampleValue(&sampleSet, CH_PM1_0, dataPMS5003.pm1_0, dataPMS5003.timestamp);
+        setSampleValue(&sampleSet, CH_PM2_5, dataPMS5003.pm2_5, dataPMS5003.timestamp);
+        setSampleValue(&sampleSet, CH_PM10, dataPMS5003.pm10, dataPMS5003.timestamp);
+    }
+#endif
+
+#if PROFILE_HAS_PIXHAWK
+    /* ====================== PIXHAWK STATUS ===================== */
+    // Read data from Pixhawk autopilot
+    getDataPixhawk(&dataPixhawk);
+#endif
+
+    /* ------------------- STREAMING STATISTICS ------------------- */
+
+    updateStatistics(&sampleSet, millis());
+}
+
+
+/* *****************************************************************
+    *                   COMPENSATE GAS SENSORS                    *
+   ***************************************************************** */
+
+// De-mixes the MQ readings of the cycle into the concentration of each gas
+void compensateGasSensors()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Voltages, temperature and humidity of the cycle
+    int32_t inputs[COMP_INPUTS] = {0};
+    uint8_t validInputs = 0;
+
+    // Concentrations, and those computed from usable readings only
+    int32_t outputs[COMP_OUTPUTS];
+    uint8_t validOutputs;
+
+    /* -------------------- INPUT VECTOR -------------------- */
+
+    // A sensor still heating or clipped by the ADC is not usable, nor any
+    // gas depending on it
+#if PROFILE_HAS_MQ4
+    inputs[COMP_IN_MQ4] = dataMQ4.millivolts;
+    validInputs |= (dataMQ4.readiness == MQ_READY && !dataMQ4.clipped) << COMP_IN_MQ4;
+#endif
+#if PROFILE_HAS_MQ7
+    inputs[COMP_IN_MQ7] = dataMQ7.millivolts;
+    validInputs |= (dataMQ7.readiness == MQ_READY && !dataMQ7.clipped) << COMP_IN_MQ7;
+#endif
+#if PROFILE_HAS_MQ131
+    inputs[COMP_IN_MQ131] = dataMQ131.millivolts;
+    validInputs |= (dataMQ131.readiness == MQ_READY && !dataMQ131.clipped) << COMP_IN_MQ131;
+#endif
+#if PROFILE_HAS_MQ137
+    inputs[COMP_IN_MQ137] = dataMQ137.millivolts;
+    validInputs |= (dataMQ137.readiness == MQ_READY && !dataMQ137.clipped) << COMP_IN_MQ137;
+#endif
+
+    if (isSampleValid(&sampleSet, CH_TEMP))
+    {
+        inputs[COMP_IN_TEMP] = dataBME680.temp;
+        inputs[COMP_IN_HUMIDITY] = dataBME680.humidity;
+        validInputs |= (1U << COMP_IN_TEMP) | (1U << COMP_IN_HUMIDITY);
+    }
+
+    /* -------------------- CONCENTRATIONS -------------------- */
+
+    validOutputs = compensateGases(inputs, validInputs, outputs);
+
+#if PROFILE_HAS_MQ4
+    dataMQ4.methane = outputs[COMP_OUT_CH4];
+    if (validOutputs & (1U << COMP_OUT_CH4))
+    {
+        setSampleValue(&sampleSet, CH_CH4, dataMQ4.methane, dataMQ4.timestamp);
+    }
+#endif
+
+#if PROFILE_HAS_MQ7
+    dataMQ7.carbonMonoxyde = outputs[COMP_OUT_CO];
+    if (validOutputs & (1U << COMP_OUT_CO))
+    {
+        setSampleValue(&sampleSet, CH_CO, dataMQ7.carbonMonoxyde, dataMQ7.timestamp);
+    }
+#endif
+
+#if PROFILE_HAS_MQ131
+    dataMQ131.ozone = outputs[COMP_OUT_O3];
+    dataMQ131.no2 = outputs[COMP_OUT_NO2];
+    if (validOutputs & (1U << COMP_OUT_O3))
+    {
+        setSampleValue(&sampleSet, CH_O3, dataMQ131.ozone, dataMQ131.timestamp);
+    }
+    if (validOutputs & (1U << COMP_OUT_NO2))
+    {
+        setSampleValue(&sampleSet, CH_NO2, dataMQ131.no2, dataMQ131.timestamp);
+    }
+#endif
+}
+
+
+/* *****************************************************************
+    *                       SEND ALL SENSORS                      *
+   ***************************************************************** */
+
+// Sends the last raw readings of all sensors via Bluetooth
+void sendAllSensors()
+{
+    // Signed values formatted as text
+    char text[24];
+
+    /* ======================== TIME BASE ======================== */
+    sendSectionHeader("TIME");
+    sendTimeReference();
+
+    /* ====================== BME680 SENSOR ====================== */
+    sendSectionHeader("BME680 SENSOR");
+    sendTimestamp("Time:", dataBME680.timestamp, 0);
+    if (isSampleValid(&sampleSet, CH_TEMP))
+    {
+        sendData("Temp:", dataBME680.temp, "°", 0);
+        sendData("Humidity:", dataBME680.humidity, "%", 0);
+        sendData("Pressure:", dataBME680.pressure, "hPa", 0);
+
+        if (isSampleValid(&sampleSet, CH_VOC))
+        {
+            sendData("VOC Index:", dataBME680.vocIndex, "", 0);
+        }
+        else
+        {
+            sendStatus("VOC Index:", "STABILISING", 0);
+        }
+
+        // Altitude and climb rate can be negative, they go out as text
+        snprintf(text, sizeof(text), "%ld cm", (long)dataBME680.altitude);
+        sendStatus("Altitude:", text, 0);
+        snprintf(text, sizeof(text), "%ld cm/s", (long)dataBME680.climbRate);
+        sendStatus("Climb:", text, 0);
+
+        sendStatus("IAQ Accuracy:", getIAQAccuracyName((e_iaqAccuracy)dataBME680.iaqAccuracy), 1);
+    }
+    else
+    {
+        sendStatus("BME680:", "NO DATA", 1);
+    }
+
+#if PROFILE_HAS_MHZ19B
+    /* ====================== MH-Z19B SENSOR ===================== */
+    sendSectionHeader("MH-Z19B SENSOR");
+    sendTimestamp("Time:", dataMHZ19B.timestamp, 0);
+    sendData("CO2:", dataMHZ19B.CO2, "ppm", 0);
+#endif
+
+#if PROFILE_HAS_MQ4
+    /* ======================= MQ-4 SENSOR ======================= */
+    sendSectionHeader("MQ-4 SENSOR");
+    sendTimestamp("Time:", dataMQ4.timestamp, 0);
+    if (dataMQ4.readiness == MQ_READY)
+    {
+        sendData("CH4:", dataMQ4.methane, "ppm", 1);
+    }
+    else
+    {
+        // Skip unstable readings while the heater warms up
+        sendStatus("CH4:", getMQReadinessName((e_mqReadiness)dataMQ4.readiness), 1);
+    }
+#endif
+
+#if PROFILE_HAS_MQ7
+    /* ======================= MQ-7 SENSOR ======================= */
+    sendSectionHeader("MQ-7 SENSOR");
+    sendTimestamp("Time:", dataMQ7.timestamp, 0);
+    if (dataMQ7.readiness == MQ_READY)
+    {
+        sendData("CO:", dataMQ7.carbonMonoxyde, "ppm", 1);
+    }
+    else
+    {
+        // Only the end of the low heater phase gives valid CO readings
+        sendStatus("CO:", getMQReadinessName((e_mqReadiness)dataMQ7.readiness), 1);
+    }
+#endif
+
+#if PROFILE_HAS_MQ131
+    /* ====================== MQ-131 SENSOR ====================== */
+    sendSectionHeader("MQ-131 SENSOR");
+    sendTimestamp("Time:", dataMQ131.timestamp, 0);
+    if (dataMQ131.readiness == MQ_READY)
+    {
+        sendData("O3:", dataMQ131.ozone, "ppm", 0);
+        sendData("NO2:", dataMQ131.no2, "ppm", 1);
+    }
+    else
+    {
+        sendStatus("O3/NO2:", getMQReadinessName((e_mqReadiness)dataMQ131.readiness), 1);
+    }
+#endif
+
+#if PROFILE_HAS_GYUV1
+    /* ======================= GY-UV1 SENSOR ===================== */
+    sendSectionHeader("GY-UV1 SENSOR");
+    sendTimestamp("Time:", dataGYUV1.timestamp, 0);
     sendData("UV:", dataGYUV1.uvRaw, "mW/cm2", 1);
+#endif
 
+#if PROFILE_HAS_PMS5003
     /* ====================== PMS5003 SENSOR ===================== */
     sendSectionHeader("PMS5003 SENSOR");
-    // Capture particulate matter concentrations from PMS5003
-    getDataPMS5003(&dataPMS5003);
-    sendData("PM1.0:", dataPMS5003.pm1_0, "ug/m3", 0);
-    sendData("PM2.5:", dataPMS5003.pm2_5, "ug/m3", 0);
-    sendData("PM10:", dataPMS5003.pm10, "ug/m3", 1);
+    sendTimestamp("Time:", dataPMS5003.timestamp, 0);
+    if (isSampleValid(&sampleSet, CH_PM2_5))
+    {
+        sendData("PM1.0:", dataPMS5003.pm1_0, "ug/m3", 0);
+        sendData("PM2.5:", dataPMS5003.pm2_5, "ug/m3", 0);
+        sendData("PM10:", dataPMS5003.pm10, "ug/m3", 1);
+    }
+    else
+    {
+        sendStatus("PMS5003:", "NO DATA", 1);
+    }
+#endif
 
+#if PROFILE_HAS_PIXHAWK
     /* ====================== PIXHAWK STATUS ===================== */
-    // sendSectionHeader("PIXHAWK STATUS");
-    // Read and send data from Pixhawk autopilot
-    // getDataPixhawk(&dataPixhawk);
-    // if (dataPixhawk.data_valid)
-    // {
-    //     sendData("LAT:", (int32_t)(dataPixhawk.latitude * 1000000), "µdeg", 0);
-    //     sendData("LON:", (int32_t)(dataPixhawk.longitude * 1000000), "µdeg", 0);
-    //     sendData("ALT:", (int32_t)(dataPixhawk.altitude * 100), "cm", 0);
-    //     sendData("SAT:", dataPixhawk.satellites_visible, "", 0);
-    //     sendData("FIX:", dataPixhawk.fix_type, "", 1);
-    // }
-    // else
-    // {
-        // sendData("GPS:", 0, "NO_FIX", 1);
-    // }
+    sendSectionHeader("PIXHAWK STATUS");
+    sendTimestamp("Time:", dataPixhawk.timestamp, 0);
+    if (dataPixhawk.data_valid)
+    {
+        // Coordinates do not fit sendData(), they go out as text
+        snprintf(text, sizeof(text), "%.6f", dataPixhawk.latitude);
+        sendStatus("LAT:", text, 0);
+        snprintf(text, sizeof(text), "%.6f", dataPixhawk.longitude);
+        sendStatus("LON:", text, 0);
+        snprintf(text, sizeof(text), "%.1f m", dataPixhawk.altitude);
+        sendStatus("ALT:", text, 0);
+        sendData("SAT:", dataPixhawk.satellites_visible, "", 0);
+        sendData("FIX:", dataPixhawk.fix_type, "", 1);
+    }
+    else
+    {
+        sendStatus("GPS:", "NO FIX", 1);
+    }
+#endif
+
+    // One bit per sensor (e_sensor order), set when it is not healthy
+    sendData("HEALTH:", getHealthBits(), "", 1);
 
     sendSectionHeader("END OF MEASUREMENT");
 }
 
 
+/* *****************************************************************
+    *                     SEND TIME REFERENCE                     *
+   ***************************************************************** */
+
+// Sends the local time and the UTC estimate of the same instant, so the
+// local capture times of the frame can be converted to UTC
+void sendTimeReference()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Local and UTC time of the frame
+    uint64_t localUs = getTimeUs();
+    uint64_t utcUs;
+
+    // Source and quality of the UTC estimate
+    t_timeStatus timeStatus;
+
+    /* ------------------- TIME TRANSMISSION ------------------- */
+
+    getTimeStatus(&timeStatus);
+
+    sendTimestamp("Local:", localUs, 0);
+
+    if (getUtcTime(localUs, &utcUs))
+    {
+        sendTimestamp("UTC:", utcUs, 0);
+    }
+    else
+    {
+        sendStatus("UTC:", "UNSYNCED", 0);
+    }
+
+    sendStatus("Sync:", getTimeSourceName((e_timeSource)timeStatus.source), 1);
+}
+
+
+/* *****************************************************************
+    *                       FRAME FUNCTIONS                       *
+   ***************************************************************** */
+
+// Returns the time stamped on outgoing frames, UTC when available so the
+// receivers can merge several units on a common time base
+// @param localUs: Local time of the frame
+// @param frameUs: Pointer where the time of the frame will be stored
+// @return: Frame flags matching the time (FRAME_FLAG_UTC or 0), with
+// FRAME_FLAG_EVENT while sampling a plume
+uint8_t getFrameTime(uint64_t localUs, uint64_t *frameUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Marks the samples taken at the burst rate
+    uint8_t flags = (getEventState() != EVENT_IDLE) ? FRAME_FLAG_EVENT : 0;
+
+    /* -------------------- FRAME TIME -------------------- */
+
+    if (getUtcTime(localUs, frameUs))
+    {
+        return flags | FRAME_FLAG_UTC;
+    }
+
+    *frameUs = localUs;
+    return flags;
+}
+
+// Sends the current sample set to the gateway
+void sendSwarmFrame()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Local time and time of the frame
+    uint64_t localUs = getTimeUs();
+    uint64_t frameUs;
+    uint8_t flags = getFrameTime(localUs, &frameUs);
+
+    /* ------------------- FRAME TRANSMISSION ------------------- */
+
+    swarmNodeSend(&sampleSet, frameUs, (int64_t)(frameUs - localUs), flags);
+}
+
+// Adds the current sample set to the batch of the Wi-Fi uplink
+void sendUplinkSample()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of the sample set
+    uint64_t frameUs;
+    uint8_t flags = getFrameTime(getTimeUs(), &frameUs);
+
+    /* ------------------- BATCH UPDATE ------------------- */
+
+    addUplinkSample(&sampleSet, frameUs, flags);
+}
+
+// Appends the current sample set to the recorded session
+void recordCycle()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Local time and time of the frame
+    uint64_t localUs = getTimeUs();
+    uint64_t frameUs;
+    uint8_t flags = getFrameTime(localUs, &frameUs);
+
+    /* ------------------- SESSION RECORDING ------------------- */
+
+    recordSample(&sampleSet, frameUs, (int64_t)(frameUs - localUs), flags);
+}
+
+// Runs the plume detector and sets the period of the next measurement
+void detectEvents()
+{
+    // Set when this cycle starts a plume
+    uint8_t started = updateEvents(&sampleSet, getTimeUs(), millis());
+
+    setSchedulerPeriod(measureTaskId, getEventPeriod());
+
+    if (started)
+    {
+        // The next run was already set a base period ahead, the burst
+        // starts one burst period from now instead
+        runSchedulerTaskIn(measureTaskId, getEventPeriod());
+        sendEventStart();
+    }
+}
+
+// Announces a plume with the channel that fired it and the air just before
+void sendEventStart()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Cycle of the pre-event history and its time
+    t_sampleSet history;
+    uint64_t historyUs;
+
+    // Channel that fired the event
+    e_channel channel = getEventChannel();
+
+    /* ------------------- EVENT TRANSMISSION ------------------- */
+
+    if (!xEnableMeasuring)
+    {
+        return;
+    }
+
+    sendSectionHeader("EVENT");
+    sendData("EVENT:", getEventCount(), "", 0);
+    sendLongData(getChannelName(channel), sampleSet.value[channel], getChannelUnit(channel), 1);
+
+    // Oldest first, taken at the base period
+    while (popPreEvent(&history, &historyUs))
+    {
+        sendSectionHeader("PRE-EVENT");
+        sendTimestamp("Time:", historyUs, 0);
+
+        for (uint8_t i = 0; i < CH_COUNT; i++)
+        {
+            if (isSampleValid(&history, (e_channel)i))
+            {
+                sendLongData(getChannelName((e_channel)i), history.value[i],
+                             getChannelUnit((e_channel)i), 0);
+            }
+        }
+    }
+
+    sendSectionHeader("END OF PRE-EVENT");
+}
+
+// Adds the current sample set to the pollution grid at the unit's position
+void mapCycle()
+{
+#if PROFILE_HAS_PIXHAWK
+    // Without a fix the cell is unknown
+    if (dataPixhawk.data_valid && dataPixhawk.fix_type >= 2)
+    {
+        addGridSample(&sampleSet, dataPixhawk.latitude, dataPixhawk.longitude,
+                      dataPixhawk.altitude, millis());
+    }
+#endif
+}
+
+// Sends the sample set to the autopilot, for its log and its telemetry radio
+void telemetryCycle()
+{
+#if PROFILE_HAS_PIXHAWK
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Channel the rate limit stopped at, the next cycle starts from it
+    static uint8_t nextChannel = 0;
+
+    // Label of the channel without its punctuation (e.g. "VOCIndex")
+    char name[MAVLINK_NAME_SIZE + 1];
+    const char *label;
+    uint8_t length;
+
+    // Channel being sent
+    e_channel channel;
+
+    /* ------------------- TELEMETRY ------------------- */
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        channel = (e_channel)((nextChannel + i) % CH_COUNT);
+
+        if (!isSampleValid(&sampleSet, channel))
+        {
+            continue;
+        }
+
+        length = 0;
+
+        for (label = getChannelName(channel); *label && length < MAVLINK_NAME_SIZE; label++)
+        {
+            if (isalnum((unsigned char)*label) || *label == '.')
+            {
+                name[length++] = *label;
+            }
+        }
+
+        name[length] = '\0';
+
+        if (!sendPixhawkValue(name, sampleSet.value[channel],
+                              (uint32_t)(sampleSet.timeUs[channel] / 1000ULL)))
+        {
+            nextChannel = channel;
+            return;
+        }
+    }
+#endif
+}
+
+// Forwards a node frame accepted by the gateway to the host
+void forwardNodeFrame(const t_frameHeader *header, const t_sampleSet *set, const t_swarmNode *node)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Section title identifying the node
+    char title[16];
+
+    /* ------------------- FRAME FORWARDING ------------------- */
+
+    if (!xEnableMeasuring)
+    {
+        return;
+    }
+
+    snprintf(title, sizeof(title), "NODE %04X", header->nodeId);
+    sendSectionHeader(title);
+
+    sendTimestamp((header->flags & FRAME_FLAG_UTC) ? "UTC:" : "Local:", header->timeUs, 0);
+    sendData("SEQ:", header->seq, "", 0);
+
+    if (header->flags & FRAME_FLAG_EVENT)
+    {
+        sendStatus("EVENT:", "BURST", 0);
+    }
+
+    sendLongData("LOST:", node->lost, "", 0);
+    sendLongData("RECOVERED:", node->recovered, "", 0);
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (isSampleValid(set, (e_channel)i))
+        {
+            sendLongData(getChannelName((e_channel)i), set->value[i],
+                         getChannelUnit((e_channel)i), 0);
+        }
+    }
+
+    sendSectionHeader("END OF NODE");
+}
+
+
+/* *****************************************************************
+    *                        SEND SUMMARIES                       *
+   ***************************************************************** */
+
+// Sends the statistics of every channel over the last window
+void sendSummaries()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Summary of the channel being sent
+    t_channelSummary summary;
+
+    // Counters of the Wi-Fi uplink
+    t_uplinkStatus uplinkStatus;
+
+    /* ------------------- SUMMARY TRANSMISSION ------------------- */
+
+    sendSectionHeader("SUMMARY");
+    sendTimeReference();
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (getStatisticsSummary((e_channel)i, millis(), &summary))
+        {
+            sendSummary(getChannelName((e_channel)i), &summary, getChannelUnit((e_channel)i));
+        }
+    }
+
+    sendData("HEALTH:", getHealthBits(), "", 1);
+
+    // Link state and batches waiting for the collector
+    getUplinkStatus(&uplinkStatus);
+    if (uplinkStatus.state != UPLINK_DISABLED)
+    {
+        sendStatus("UPLINK:", getUplinkStateName((e_uplinkState)uplinkStatus.state), 0);
+        sendData("QUEUED:", uplinkStatus.queued, "", 0);
+        sendData("BACKLOG:", (uplinkStatus.backlogBytes + 1023) / 1024, "kB", 1);
+    }
+
+    sendSectionHeader("END OF SUMMARY");
+
+    // Start aggregating the next window
+    resetStatisticsWindow();
+}
+
+
 /* *****************************************************************
     *                   INITIALIZE ALL SENSORS                   *
    ***************************************************************** */
@@ -230,7 +1217,7 @@ void initSensors()
 
     // Initialize BME680 sensor
     Serial.println("Start Init BME680...");
-    if (!initBME680())
+    if (!reportSensorInit(SENSOR_BME680, initBME680()))
     {
         Serial.println("Failed Init BME680");
         Serial.flush();
@@ -240,11 +1227,12 @@ void initSensors()
         Serial.println("Init BME680 OK !");
     }
 
+#if PROFILE_HAS_MHZ19B
     /* ------------------ INITIALIZE MH-Z19B ------------------ */
 
     // Initialize MH-Z19B sensor
     Serial.println("Start Init MHZ19B...");
-    if (!initMHZ19B())
+    if (!reportSensorInit(SENSOR_MHZ19B, initMHZ19B()))
     {
         Serial.println("Failed Init MHZ19B");
     }
@@ -252,12 +1240,14 @@ void initSensors()
     {
         Serial.println("Init MHZ19B OK !");
     }
+#endif
 
+#if PROFILE_HAS_MQ4
     /* ------------------ INITIALIZE MQ-4 ------------------ */
 
     // Initialize MQ-4 sensor
     Serial.println("Start Init MQ-4...");
-    if (!initMQ4())
+    if (!reportSensorInit(SENSOR_MQ4, initMQ4()))
     {
         Serial.println("Failed Init MQ-4");
     }
@@ -266,12 +1256,14 @@ void initSensors()
     {
         Serial.println("Init MQ-4 OK !");
     }
+#endif
 
+#if PROFILE_HAS_MQ7
     /* ------------------ INITIALIZE MQ-7 ------------------ */
 
     // Initialize MQ-7 sensor
     Serial.println("Start Init MQ-7...");
-    if (!initMQ7())
+    if (!reportSensorInit(SENSOR_MQ7, initMQ7()))
     {
         Serial.println("Failed Init MQ-7");
     }
@@ -280,12 +1272,14 @@ void initSensors()
     {
         Serial.println("Init MQ-7 OK !");
     }
+#endif
 
+#if PROFILE_HAS_MQ131
     /* ------------------ INITIALIZE MQ-131 ------------------ */
 
     // Initialize MQ-131 sensor
     Serial.println("Start Init MQ-131...");
-    if (!initMQ131())
+    if (!reportSensorInit(SENSOR_MQ131, initMQ131()))
     {
         Serial.println("Failed Init MQ-131");
     }
@@ -294,12 +1288,30 @@ void initSensors()
     {
         Serial.println("Init MQ-131 OK !");
     }
+#endif
 
+#if PROFILE_HAS_MQ137
+    /* ------------------ INITIALIZE MQ-137 ------------------ */
+
+    // Initialize MQ-137 sensor, an input of the gas compensation
+    Serial.println("Start Init MQ-137...");
+    if (!reportSensorInit(SENSOR_MQ137, initMQ137()))
+    {
+        Serial.println("Failed Init MQ-137");
+    }
+
+    else
+    {
+        Serial.println("Init MQ-137 OK !");
+    }
+#endif
+
+#if PROFILE_HAS_PMS5003
     /* ------------------ INITIALIZE PMS5003 ------------------ */
 
     // Initialize PMS5003 sensor
     Serial.println("Start Init PMS5003...");
-    if (!initPMS5003())
+    if (!reportSensorInit(SENSOR_PMS5003, initPMS5003()))
     {
         Serial.println("Failed Init PMS5003");
     }
@@ -308,32 +1320,37 @@ void initSensors()
     {
         Serial.println("Init PMS5003 OK !");
     }
+#endif
 
+#if PROFILE_HAS_GYUV1
     /* ------------------ INITIALIZE GY-UV1 ------------------ */
 
     // Initialize GY-UV1 sensor
-    // Serial.println("Start Init GY-UV1...");
-    // if (!initGYUV1())
-    // {
-    //     Serial.println("Failed Init GY-UV1");
-    // }
+    Serial.println("Start Init GY-UV1...");
+    if (!reportSensorInit(SENSOR_GYUV1, initGYUV1()))
+    {
+        Serial.println("Failed Init GY-UV1");
+    }
 
-    // else
-    // {
-    //     Serial.println("Init GY-UV1 OK !");
-    // }
+    else
+    {
+        Serial.println("Init GY-UV1 OK !");
+    }
+#endif
 
+#if PROFILE_HAS_PIXHAWK
     /* ------------------ INITIALIZE PIXHAWK ------------------ */
 
     // Initialize Pixhawk communication
-    // Serial.println("Start Init Pixhawk...");
-    // if (!initPixhawk())
-    // {
-    //     Serial.println("Failed Init Pixhawk");
-    // }
+    Serial.println("Start Init Pixhawk...");
+    if (!reportSensorInit(SENSOR_PIXHAWK, initPixhawk()))
+    {
+        Serial.println("Failed Init Pixhawk");
+    }
     
-    // else
-    // {
-    //     Serial.println("Init Pixhawk OK !");
-    // }
+    else
+    {
+        Serial.println("Init Pixhawk OK !");
+    }
+#endif
 }
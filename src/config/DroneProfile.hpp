@@ -0,0 +1,55 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef DRONEPROFILE_hpp
+#define DRONEPROFILE_hpp
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Airborne unit: the Pixhawk takes UART2 for the GPS position and time,
+// the PMS5003 moves to UART1. Flies as a swarm node, so Wi-Fi is on
+#define PROFILE_NAME "drone"
+
+#define PROFILE_HAS_MHZ19B  1
+#define PROFILE_HAS_MQ4     1
+#define PROFILE_HAS_MQ7     1
+#define PROFILE_HAS_MQ131   1
+#define PROFILE_HAS_MQ137   0
+#define PROFILE_HAS_GYUV1   1
+#define PROFILE_HAS_PMS5003 1
+#define PROFILE_HAS_PIXHAWK 1
+
+#define PROFILE_USES_WIFI 1
+
+/* --------------------------- PINS --------------------------- */
+
+// I2C bus (ESP32 defaults)
+constexpr int8_t P_I2C_SDA = 21;
+constexpr int8_t P_I2C_SCL = 22;
+
+// Analog outputs of the sensors, all on ADC1
+constexpr int8_t P_MH = 36;
+constexpr int8_t P_MQ4 = 33;
+constexpr int8_t P_MQ7 = 34;
+constexpr int8_t P_MQ131 = 35;
+constexpr int8_t P_MQ137 = PIN_NONE;
+constexpr int8_t P_UV = 39;
+
+// MOSFET of the MQ-7 heater
+constexpr int8_t P_MQ7_HEATER = 25;
+
+// PMS5003 on UART1, reset and sleep lines not wired
+constexpr uint8_t PMS5003_SERIAL_INDEX = 1;
+constexpr int8_t P_PMS5003_RX = 26;
+constexpr int8_t P_PMS5003_TX = 27;
+constexpr int8_t P_PMS5003_RESET = PIN_NONE;
+constexpr int8_t P_PMS5003_SLEEP = PIN_NONE;
+
+// Pixhawk TELEM port on UART2
+constexpr uint8_t PIXHAWK_SERIAL_INDEX = 2;
+constexpr int8_t PIXHAWK_RX = 16;
+constexpr int8_t PIXHAWK_TX = 17;
+
+#endif // DRONEPROFILE_hpp
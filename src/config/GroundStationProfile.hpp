@@ -0,0 +1,55 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef GROUNDSTATIONPROFILE_hpp
+#define GROUNDSTATIONPROFILE_hpp
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Fixed ground station: no autopilot, the samples leave over the Wi-Fi
+// uplink or the swarm gateway, so every analog input is on ADC1
+#define PROFILE_NAME "ground-station"
+
+#define PROFILE_HAS_MHZ19B  1
+#define PROFILE_HAS_MQ4     1
+#define PROFILE_HAS_MQ7     1
+#define PROFILE_HAS_MQ131   1
+#define PROFILE_HAS_MQ137   0
+#define PROFILE_HAS_GYUV1   1
+#define PROFILE_HAS_PMS5003 1
+#define PROFILE_HAS_PIXHAWK 0
+
+#define PROFILE_USES_WIFI 1
+
+/* --------------------------- PINS --------------------------- */
+
+// I2C bus (ESP32 defaults)
+constexpr int8_t P_I2C_SDA = 21;
+constexpr int8_t P_I2C_SCL = 22;
+
+// Analog outputs of the sensors, all on ADC1
+constexpr int8_t P_MH = 36;
+constexpr int8_t P_MQ4 = 33;
+constexpr int8_t P_MQ7 = 34;
+constexpr int8_t P_MQ131 = 35;
+constexpr int8_t P_MQ137 = PIN_NONE;
+constexpr int8_t P_UV = 39;
+
+// MOSFET of the MQ-7 heater
+constexpr int8_t P_MQ7_HEATER = 25;
+
+// PMS5003 on UART2, reset and sleep lines not wired
+constexpr uint8_t PMS5003_SERIAL_INDEX = 2;
+constexpr int8_t P_PMS5003_RX = 16;
+constexpr int8_t P_PMS5003_TX = 17;
+constexpr int8_t P_PMS5003_RESET = PIN_NONE;
+constexpr int8_t P_PMS5003_SLEEP = PIN_NONE;
+
+// No autopilot
+constexpr uint8_t PIXHAWK_SERIAL_INDEX = 0;
+constexpr int8_t PIXHAWK_RX = PIN_NONE;
+constexpr int8_t PIXHAWK_TX = PIN_NONE;
+
+#endif // GROUNDSTATIONPROFILE_hpp
@@ -0,0 +1,126 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef PROFILE_hpp
+#define PROFILE_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Mission profiles, each with its own wiring and set of drivers
+#define PROFILE_BENCH          0
+#define PROFILE_DRONE          1
+#define PROFILE_GROUND_STATION 2
+
+// Profile of this unit, chosen at build time (-DAEROSENSE_PROFILE=...)
+#ifndef AEROSENSE_PROFILE
+#define AEROSENSE_PROFILE PROFILE_BENCH
+#endif
+
+// Pin value of a signal the profile does not wire
+constexpr int8_t PIN_NONE = -1;
+
+// The profile defines PROFILE_HAS_x (1 to compile a driver in), the
+// pins of every driver (PIN_NONE for the ones left out) and the UARTs.
+// The BME680 is on every unit and has no flag
+#if AEROSENSE_PROFILE == PROFILE_BENCH
+#include "BenchProfile.hpp"
+#elif AEROSENSE_PROFILE == PROFILE_DRONE
+#include "DroneProfile.hpp"
+#elif AEROSENSE_PROFILE == PROFILE_GROUND_STATION
+#include "GroundStationProfile.hpp"
+#else
+#error "Unknown AEROSENSE_PROFILE"
+#endif
+
+// The swarm roles bring up Wi-Fi for ESP-NOW, whatever the profile says
+#if defined(SWARM_ROLE) && SWARM_ROLE != 0
+#define PROFILE_RADIO_ON 1
+#else
+#define PROFILE_RADIO_ON PROFILE_USES_WIFI
+#endif
+
+/* ---------------------- PIN CONFLICT CHECKS ---------------------- */
+
+// Every pin of the profile, PIN_NONE entries are ignored
+constexpr int8_t profilePins[] = {
+    P_I2C_SDA, P_I2C_SCL, P_MH, P_MQ4, P_MQ7, P_MQ7_HEATER, P_MQ131, P_MQ137, P_UV,
+    P_PMS5003_RX, P_PMS5003_TX, P_PMS5003_RESET, P_PMS5003_SLEEP, PIXHAWK_RX, PIXHAWK_TX};
+
+// Pins read with analogRead()
+constexpr int8_t profileAnalogPins[] = {P_MH, P_MQ4, P_MQ7, P_MQ131, P_MQ137, P_UV};
+
+// Pins driven by the firmware
+constexpr int8_t profileOutputPins[] = {
+    P_I2C_SDA, P_I2C_SCL, P_MQ7_HEATER, P_PMS5003_TX, P_PMS5003_RESET, P_PMS5003_SLEEP,
+    PIXHAWK_TX};
+
+// Number of the pins equal to a given pin
+// @param pins: Pins to search
+// @param count: Number of pins
+// @param pin: Pin to look for
+constexpr uint8_t countPin(const int8_t *pins, uint8_t count, int8_t pin)
+{
+    return count == 0 ? 0 : (pins[0] == pin) + countPin(pins + 1, count - 1, pin);
+}
+
+// Tells whether no pin is used twice
+constexpr bool arePinsUnique(const int8_t *pins, uint8_t count)
+{
+    return count == 0 ||
+           ((pins[0] == PIN_NONE || countPin(pins + 1, count - 1, pins[0]) == 0) &&
+            arePinsUnique(pins + 1, count - 1));
+}
+
+// Tells whether all pins lie in [first, last]
+constexpr bool arePinsWithin(const int8_t *pins, uint8_t count, int8_t first, int8_t last)
+{
+    return count == 0 ||
+           ((pins[0] == PIN_NONE || (pins[0] >= first && pins[0] <= last)) &&
+            arePinsWithin(pins + 1, count - 1, first, last));
+}
+
+// Tells whether no pin lies in [first, last]
+constexpr bool arePinsOutside(const int8_t *pins, uint8_t count, int8_t first, int8_t last)
+{
+    return count == 0 ||
+           ((pins[0] == PIN_NONE || pins[0] < first || pins[0] > last) &&
+            arePinsOutside(pins + 1, count - 1, first, last));
+}
+
+#define PROFILE_COUNT(pins) (sizeof(pins) / sizeof(pins[0]))
+
+static_assert(arePinsUnique(profilePins, PROFILE_COUNT(profilePins)),
+              "Profile: a pin is wired to two signals");
+
+// GPIO 6 to 11 hold the SPI flash
+static_assert(arePinsOutside(profilePins, PROFILE_COUNT(profilePins), 6, 11),
+              "Profile: GPIO 6-11 are reserved for the flash");
+
+// GPIO 34 to 39 have no output driver
+static_assert(arePinsOutside(profileOutputPins, PROFILE_COUNT(profileOutputPins), 34, 39),
+              "Profile: GPIO 34-39 are input only");
+
+// ADC2 cannot be read while Wi-Fi runs, only ADC1 (GPIO 32-39) is left
+static_assert(!PROFILE_RADIO_ON ||
+                  arePinsWithin(profileAnalogPins, PROFILE_COUNT(profileAnalogPins), 32, 39),
+              "Profile: analog inputs must be on ADC1 when Wi-Fi is used");
+
+// UART0 is the console, the sensors need one UART each
+static_assert(!PROFILE_HAS_PMS5003 || PMS5003_SERIAL_INDEX != 0,
+              "Profile: the PMS5003 cannot use the console UART");
+static_assert(!PROFILE_HAS_PIXHAWK || PIXHAWK_SERIAL_INDEX != 0,
+              "Profile: the Pixhawk cannot use the console UART");
+static_assert(!PROFILE_HAS_PMS5003 || !PROFILE_HAS_PIXHAWK ||
+                  PMS5003_SERIAL_INDEX != PIXHAWK_SERIAL_INDEX,
+              "Profile: the PMS5003 and the Pixhawk share a UART");
+
+#undef PROFILE_COUNT
+
+#endif // PROFILE_hpp
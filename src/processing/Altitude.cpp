@@ -0,0 +1,269 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file estimates the altitude and the vertical speed of the
+    unit at every pressure sample. The barometric altitude comes from
+    the hypsometric equation on the full resolution pressure, with
+    the air temperature of the same sample, and is smoothed by an
+    alpha-beta filter in fixed point. The GPS altitude is too noisy
+    and too late to follow the climb, it only corrects the offset of
+    the barometer, compared with the barometric altitude of the time
+    the fix was computed.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the altitude filter
+#include "Altitude.hpp"
+
+// log2Q16() for the pressure ratio
+#include "IAQ.hpp"
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// log2 of the reference pressure in Q16
+static int32_t referenceLog2 = 0;
+
+// Filter state: altitude in mm and vertical speed in mm/s
+static int32_t altitudeMm = 0;
+static int32_t climbMmS = 0;
+static uint64_t lastUs = 0;
+static uint8_t running = 0;
+
+// GPS altitude minus barometric altitude in mm
+static int32_t offsetMm = 0;
+static uint8_t gpsAligned = 0;
+static uint64_t lastGpsUs = 0;
+
+// Recent filtered altitudes, oldest at historyHead
+static int32_t historyMm[ALTITUDE_HISTORY];
+static uint64_t historyUs[ALTITUDE_HISTORY];
+static uint8_t historyHead = 0;
+static uint8_t historyCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Converts a pressure to an altitude above the reference pressure
+// @param pressurePa: Pressure in Pa
+// @param tempCenti: Air temperature in degrees Celsius, scaled by 100
+// @return: Altitude in mm
+static int32_t pressureToMm(int32_t pressurePa, int32_t tempCenti);
+
+// Adds a filtered altitude to the history
+// @param value: Altitude in mm
+// @param timeUs: Time of the altitude
+static void pushHistory(int32_t value, uint64_t timeUs);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Clears the filter, the next pressure sample starts it again
+void initAltitude()
+{
+    referenceLog2 = log2Q16(ALTITUDE_REFERENCE_PA);
+    running = 0;
+    offsetMm = 0;
+    gpsAligned = 0;
+    lastGpsUs = 0;
+    historyHead = 0;
+    historyCount = 0;
+}
+
+
+/* *****************************************************************
+    *                       FILTER FUNCTIONS                      *
+   ***************************************************************** */
+
+// Feeds one pressure sample to the filter
+// @param pressurePa: Pressure in Pa
+// @param tempCenti: Air temperature of the same sample in degrees Celsius, scaled by 100
+// @param timeUs: Local time the sample was taken
+void updateAltitudeBaro(int32_t pressurePa, int32_t tempCenti, uint64_t timeUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Barometric altitude of the sample
+    int32_t measured;
+
+    // Sample period in ms, altitude expected from the climb rate and
+    // what the measurement adds to it
+    int32_t periodMs;
+    int32_t predicted;
+    int32_t residual;
+
+    /* -------------------- PREDICTION -------------------- */
+
+    if (pressurePa <= 0)
+    {
+        return;
+    }
+
+    measured = pressureToMm(pressurePa, tempCenti);
+
+    // Sample already filtered, the driver returns it until the next one
+    if (running && timeUs <= lastUs)
+    {
+        return;
+    }
+
+    // First sample or long gap, the filter starts from the measurement
+    if (!running || timeUs - lastUs > ALTITUDE_MAX_GAP_US)
+    {
+        altitudeMm = measured;
+        climbMmS = 0;
+        lastUs = timeUs;
+        running = 1;
+        pushHistory(altitudeMm, timeUs);
+        return;
+    }
+
+    periodMs = (int32_t)((timeUs - lastUs) / 1000);
+
+    if (periodMs == 0)
+    {
+        periodMs = 1;
+    }
+
+    predicted = altitudeMm + (int32_t)((int64_t)climbMmS * periodMs / 1000);
+    residual = measured - predicted;
+
+    /* -------------------- CORRECTION -------------------- */
+
+    altitudeMm = predicted + (int32_t)((int64_t)residual * ALTITUDE_ALPHA_Q8 / 256);
+    climbMmS += (int32_t)((int64_t)residual * ALTITUDE_BETA_Q8 * 1000 / (256 * periodMs));
+    lastUs = timeUs;
+
+    pushHistory(altitudeMm, timeUs);
+}
+
+// Feeds one GPS altitude, correcting the offset of the barometric altitude
+// @param gpsMm: Altitude above sea level in mm
+// @param timeUs: Local time the altitude was received
+void updateAltitudeGps(int32_t gpsMm, uint64_t timeUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time the fix was computed
+    uint64_t fixUs;
+
+    // Barometric altitude at that time
+    int32_t baroMm;
+    uint8_t index;
+
+    // GPS altitude minus barometric altitude for this fix
+    int32_t difference;
+
+    /* -------------------- MATCHING SAMPLE -------------------- */
+
+    // The same fix is read on every cycle until the next one arrives
+    if (!running || historyCount == 0 || timeUs == lastGpsUs)
+    {
+        return;
+    }
+
+    lastGpsUs = timeUs;
+    fixUs = (timeUs > ALTITUDE_GPS_LATENCY_US) ? timeUs - ALTITUDE_GPS_LATENCY_US : 0;
+
+    // Latest altitude not after the fix, the oldest one otherwise
+    baroMm = historyMm[historyHead];
+
+    for (uint8_t i = 0; i < historyCount; i++)
+    {
+        index = (historyHead + i) % ALTITUDE_HISTORY;
+
+        if (historyUs[index] > fixUs)
+        {
+            break;
+        }
+
+        baroMm = historyMm[index];
+    }
+
+    /* -------------------- OFFSET -------------------- */
+
+    difference = gpsMm - baroMm;
+
+    if (!gpsAligned)
+    {
+        offsetMm = difference;
+        gpsAligned = 1;
+    }
+
+    else
+    {
+        offsetMm += (int32_t)((int64_t)(difference - offsetMm) * ALTITUDE_GPS_GAIN_Q8 / 256);
+    }
+}
+
+// Retrieves the estimate at the last pressure sample
+// @param estimate: Pointer to structure where the estimate will be stored
+// @return: 1 if the filter is running, 0 before the first pressure sample
+uint8_t getAltitude(t_altitude *estimate)
+{
+    if (!running)
+    {
+        return 0;
+    }
+
+    estimate->altitude = (altitudeMm + offsetMm) / 10;
+    estimate->climbRate = climbMmS / 10;
+    estimate->gpsAligned = gpsAligned;
+    estimate->timeUs = lastUs;
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Converts a pressure to an altitude above the reference pressure
+static int32_t pressureToMm(int32_t pressurePa, int32_t tempCenti)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Halvings of the pressure from the reference in Q16
+    int32_t halvings = referenceLog2 - log2Q16((uint32_t)pressurePa);
+
+    // Absolute temperature in K, scaled by 100
+    int64_t kelvinCenti = (int64_t)tempCenti + 27315;
+
+    /* -------------------- CONVERSION -------------------- */
+
+    // A Q16 step is about 9 cm, below the noise of the sensor
+    return (int32_t)((int64_t)halvings * ALTITUDE_SCALE_MM_PER_K * kelvinCenti / (65536LL * 100));
+}
+
+// Adds a filtered altitude to the history
+static void pushHistory(int32_t value, uint64_t timeUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Slot written, the oldest one once the history is full
+    uint8_t index = (historyHead + historyCount) % ALTITUDE_HISTORY;
+
+    /* -------------------- INSERTION -------------------- */
+
+    historyMm[index] = value;
+    historyUs[index] = timeUs;
+
+    if (historyCount < ALTITUDE_HISTORY)
+    {
+        historyCount++;
+    }
+
+    else
+    {
+        historyHead = (historyHead + 1) % ALTITUDE_HISTORY;
+    }
+}
@@ -0,0 +1,83 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef ALTITUDE_hpp
+#define ALTITUDE_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Reference pressure of the barometric altitude, sea level in the
+// standard atmosphere, in Pa
+#define ALTITUDE_REFERENCE_PA 101325
+
+// R / g x ln(2): metres per kelvin for each halving of the pressure,
+// in mm (hypsometric equation)
+#define ALTITUDE_SCALE_MM_PER_K 20290
+
+// Filter gains in Q8: share of the residual taken by the altitude and,
+// per second of the sample period, by the climb rate
+#define ALTITUDE_ALPHA_Q8 64
+#define ALTITUDE_BETA_Q8  8
+
+// Share of the GPS to barometer difference taken per GPS fix in Q8, the
+// GPS only corrects the slow drift of the barometric altitude
+#define ALTITUDE_GPS_GAIN_Q8 4
+
+// Age of a GPS altitude when it is received, it is compared with the
+// barometric altitude of that time
+#define ALTITUDE_GPS_LATENCY_US 200000ULL
+
+// Barometric altitudes kept to meet the delayed GPS altitudes
+#define ALTITUDE_HISTORY 16
+
+// A longer gap between pressure samples restarts the filter
+#define ALTITUDE_MAX_GAP_US 10000000ULL
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Altitude estimate at a pressure sample
+typedef struct
+{
+    // Altitude in cm, above sea level once a GPS fix aligned it
+    int32_t altitude;
+
+    // Vertical speed in cm/s, positive when climbing
+    int32_t climbRate;
+
+    // 1 once the GPS aligned the barometric altitude
+    uint8_t gpsAligned;
+
+    // Local time of the pressure sample (see getTimeUs())
+    uint64_t timeUs;
+
+} t_altitude;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Clears the filter, the next pressure sample starts it again
+void initAltitude();
+
+// Feeds one pressure sample to the filter
+// @param pressurePa: Pressure in Pa
+// @param tempCenti: Air temperature of the same sample in degrees Celsius, scaled by 100
+// @param timeUs: Local time the sample was taken
+void updateAltitudeBaro(int32_t pressurePa, int32_t tempCenti, uint64_t timeUs);
+
+// Feeds one GPS altitude, correcting the offset of the barometric altitude
+// @param gpsMm: Altitude above sea level in mm
+// @param timeUs: Local time the altitude was received
+void updateAltitudeGps(int32_t gpsMm, uint64_t timeUs);
+
+// Retrieves the estimate at the last pressure sample
+// @param estimate: Pointer to structure where the estimate will be stored
+// @return: 1 if the filter is running, 0 before the first pressure sample
+uint8_t getAltitude(t_altitude *estimate);
+
+#endif // ALTITUDE_hpp
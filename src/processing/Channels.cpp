@@ -0,0 +1,110 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file describes the measurement channels shared by the
+    processing modules: their labels, their units, the sensor
+    producing them and the sample set holding one value per channel
+    for a measurement cycle.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the channel definitions
+#include "Channels.hpp"
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Labels of each channel, in e_channel order
+static const char *const channelNames[CH_COUNT] = {
+    "Temp:", "Humidity:", "Pressure:", "VOC Index:", "CO2:", "CH4:", "CO:",
+    "O3:", "NO2:", "UV:", "PM1.0:", "PM2.5:", "PM10:", "Altitude:", "Climb:"};
+
+// Units of each channel, in e_channel order
+static const char *const channelUnits[CH_COUNT] = {
+    "°", "%", "hPa", "", "ppm", "ppm", "ppm",
+    "ppm", "ppm", "mW/cm2", "ug/m3", "ug/m3", "ug/m3", "cm", "cm/s"};
+
+// Sensor producing each channel, in e_channel order
+static const char *const channelSources[CH_COUNT] = {
+    "BME680", "BME680", "BME680", "BME680", "MH-Z19B", "MQ-4", "MQ-7",
+    "MQ-131", "MQ-131", "GY-UV1", "PMS5003", "PMS5003", "PMS5003", "BME680", "BME680"};
+
+
+/* *****************************************************************
+    *                     SAMPLE SET FUNCTIONS                    *
+   ***************************************************************** */
+
+// Marks every channel of a sample set as invalid
+// @param set: Sample set to clear
+void clearSampleSet(t_sampleSet *set)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        set->value[i] = 0;
+        set->timeUs[i] = 0;
+    }
+
+    set->validMask = 0;
+}
+
+// Stores a valid value in a sample set
+// @param set: Sample set to update
+// @param channel: Channel to write
+// @param value: Value to store
+// @param timeUs: Local time the value was sampled
+void setSampleValue(t_sampleSet *set, e_channel channel, int32_t value, uint64_t timeUs)
+{
+    if (channel >= CH_COUNT)
+    {
+        return;
+    }
+
+    set->value[channel] = value;
+    set->timeUs[channel] = timeUs;
+    set->validMask |= (1UL << channel);
+}
+
+// Tells whether a channel of a sample set holds a usable reading
+// @param set: Sample set to query
+// @param channel: Channel to check
+// @return: 1 if the value is valid, 0 otherwise
+uint8_t isSampleValid(const t_sampleSet *set, e_channel channel)
+{
+    return (channel < CH_COUNT) && (set->validMask & (1UL << channel));
+}
+
+
+/* *****************************************************************
+    *                    CHANNEL INFO FUNCTIONS                   *
+   ***************************************************************** */
+
+// Returns the label used when transmitting a channel (e.g. "CO:")
+// @param channel: Channel to query
+// @return: Constant string with the label
+const char *getChannelName(e_channel channel)
+{
+    return (channel < CH_COUNT) ? channelNames[channel] : "";
+}
+
+// Returns the unit of a channel (e.g. "ppm")
+// @param channel: Channel to query
+// @return: Constant string with the unit
+const char *getChannelUnit(e_channel channel)
+{
+    return (channel < CH_COUNT) ? channelUnits[channel] : "";
+}
+
+// Returns the name of the sensor producing a channel (e.g. "MQ-7")
+// @param channel: Channel to query
+// @return: Constant string with the sensor name
+const char *getChannelSource(e_channel channel)
+{
+    return (channel < CH_COUNT) ? channelSources[channel] : "";
+}
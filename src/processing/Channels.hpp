@@ -0,0 +1,86 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef CHANNELS_hpp
+#define CHANNELS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Measurement channels produced by the sensors
+typedef enum
+{
+    CH_TEMP,
+    CH_HUMIDITY,
+    CH_PRESSURE,
+    CH_VOC,
+    CH_CO2,
+    CH_CH4,
+    CH_CO,
+    CH_O3,
+    CH_NO2,
+    CH_UV,
+    CH_PM1_0,
+    CH_PM2_5,
+    CH_PM10,
+    CH_ALTITUDE,
+    CH_CLIMB,
+    CH_COUNT
+
+} e_channel;
+
+// One value per channel taken during a single measurement cycle
+typedef struct
+{
+    // Channel values in the units reported by the drivers
+    int32_t value[CH_COUNT];
+
+    // Local capture time of each value (see getTimeUs())
+    uint64_t timeUs[CH_COUNT];
+
+    // Bit n set when value[n] holds a usable reading
+    uint32_t validMask;
+
+} t_sampleSet;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Marks every channel of a sample set as invalid
+// @param set: Sample set to clear
+void clearSampleSet(t_sampleSet *set);
+
+// Stores a valid value in a sample set
+// @param set: Sample set to update
+// @param channel: Channel to write
+// @param value: Value to store
+// @param timeUs: Local time the value was sampled
+void setSampleValue(t_sampleSet *set, e_channel channel, int32_t value, uint64_t timeUs);
+
+// Tells whether a channel of a sample set holds a usable reading
+// @param set: Sample set to query
+// @param channel: Channel to check
+// @return: 1 if the value is valid, 0 otherwise
+uint8_t isSampleValid(const t_sampleSet *set, e_channel channel);
+
+// Returns the label used when transmitting a channel (e.g. "CO:")
+// @param channel: Channel to query
+// @return: Constant string with the label
+const char *getChannelName(e_channel channel);
+
+// Returns the unit of a channel (e.g. "ppm")
+// @param channel: Channel to query
+// @return: Constant string with the unit
+const char *getChannelUnit(e_channel channel);
+
+// Returns the name of the sensor producing a channel (e.g. "MQ-7")
+// @param channel: Channel to query
+// @return: Constant string with the sensor name
+const char *getChannelSource(e_channel channel);
+
+#endif // CHANNELS_hpp
@@ -0,0 +1,219 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file de-mixes the MQ gas sensors, which all respond to more
+    than one gas. The voltages of the sensors sampled together, with
+    the temperature and the humidity, form one input vector; a
+    matrix fitted on the host from co-location data turns it into
+    the concentration of each gas. The product is done in fixed
+    point, a few multiply-adds per gas, so it can run on every
+    sample. The matrix is uploaded over Bluetooth and kept in the
+    state store.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the gas compensation
+#include "Compensation.hpp"
+
+// Includes the state store keeping the matrix across reboots
+#include "../storage/State.hpp"
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Coefficients of each gas, the record kept in the state store
+typedef struct
+{
+    int32_t coeff[COMP_OUTPUTS][COMP_INPUTS];
+
+} t_compMatrix;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Matrix in use
+static t_compMatrix matrix;
+
+// Bit n set when a gas depends on input n, updated with the matrix
+static uint8_t usedInputs[COMP_OUTPUTS];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Fills the matrix with each gas read from its own sensor
+static void loadDefaultMatrix();
+
+// Finds the inputs each gas depends on
+static void updateUsedInputs();
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Restores the matrix fitted on the host, or each gas from its own sensor
+// @return: 1 if a matrix was restored, 0 if the default one is used
+int initCompensation()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Set when the state store held a matrix
+    uint8_t restored;
+
+    /* -------------------- MATRIX -------------------- */
+
+    restored = loadState(STATE_GAS_COMPENSATION, COMP_STATE_VERSION, &matrix, sizeof(matrix));
+
+    if (!restored)
+    {
+        loadDefaultMatrix();
+    }
+
+    updateUsedInputs();
+    return restored;
+}
+
+
+/* *****************************************************************
+    *                    COMPENSATION FUNCTION                    *
+   ***************************************************************** */
+
+// Computes the concentrations from the simultaneous readings
+// @param inputs: Input vector, COMP_INPUTS values in e_compInput order
+// @param validInputs: Bit n set when inputs[n] holds a usable reading
+// @param outputs: Output vector, COMP_OUTPUTS values in e_compOutput order
+// @return: Bit n set when outputs[n] only depends on usable readings
+uint8_t compensateGases(const int32_t *inputs, uint8_t validInputs, int32_t *outputs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Gases computed from usable readings only
+    uint8_t validOutputs = 0;
+
+    // Sum of the products, COMP_FRACTION_BITS fractional bits
+    int64_t sum;
+
+    /* -------------------- PRODUCT -------------------- */
+
+    validInputs |= (1U << COMP_IN_ONE);
+
+    for (uint8_t out = 0; out < COMP_OUTPUTS; out++)
+    {
+        sum = 0;
+
+        for (uint8_t in = 0; in < COMP_INPUTS; in++)
+        {
+            sum += (int64_t)matrix.coeff[out][in] * inputs[in];
+        }
+
+        // Rounded, a concentration is never negative
+        outputs[out] = (sum > 0) ? (int32_t)((sum + COMP_ONE / 2) >> COMP_FRACTION_BITS) : 0;
+
+        if ((usedInputs[out] & validInputs) == usedInputs[out])
+        {
+            validOutputs |= (1U << out);
+        }
+    }
+
+    return validOutputs;
+}
+
+
+/* *****************************************************************
+    *                      MATRIX FUNCTIONS                       *
+   ***************************************************************** */
+
+// Replaces the coefficients of one gas, and saves the matrix
+// @param output: Gas to change (e_compOutput)
+// @param coeffs: COMP_INPUTS coefficients with COMP_FRACTION_BITS fractional bits
+// @return: 1 if the gas exists, 0 otherwise
+uint8_t setCompensationRow(uint8_t output, const int32_t *coeffs)
+{
+    if (output >= COMP_OUTPUTS)
+    {
+        return 0;
+    }
+
+    for (uint8_t in = 0; in < COMP_INPUTS; in++)
+    {
+        matrix.coeff[output][in] = coeffs[in];
+    }
+
+    updateUsedInputs();
+
+    // The rows of a fit arrive together, the store writes them once
+    saveState(STATE_GAS_COMPENSATION, COMP_STATE_VERSION, &matrix, sizeof(matrix));
+    return 1;
+}
+
+// Retrieves the coefficients of one gas
+// @param output: Gas to read (e_compOutput)
+// @param coeffs: Destination of the COMP_INPUTS coefficients
+// @return: 1 if the gas exists, 0 otherwise
+uint8_t getCompensationRow(uint8_t output, int32_t *coeffs)
+{
+    if (output >= COMP_OUTPUTS)
+    {
+        return 0;
+    }
+
+    for (uint8_t in = 0; in < COMP_INPUTS; in++)
+    {
+        coeffs[in] = matrix.coeff[output][in];
+    }
+
+    return 1;
+}
+
+// Restores the default matrix, each gas from its own sensor, and saves it
+void resetCompensation()
+{
+    loadDefaultMatrix();
+    updateUsedInputs();
+    saveState(STATE_GAS_COMPENSATION, COMP_STATE_VERSION, &matrix, sizeof(matrix));
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Fills the matrix with each gas read from its own sensor
+static void loadDefaultMatrix()
+{
+    for (uint8_t out = 0; out < COMP_OUTPUTS; out++)
+    {
+        for (uint8_t in = 0; in < COMP_INPUTS; in++)
+        {
+            matrix.coeff[out][in] = 0;
+        }
+    }
+
+    // Each gas follows the voltage of its sensor until a fit is uploaded
+    matrix.coeff[COMP_OUT_CH4][COMP_IN_MQ4] = COMP_ONE;
+    matrix.coeff[COMP_OUT_CO][COMP_IN_MQ7] = COMP_ONE;
+    matrix.coeff[COMP_OUT_O3][COMP_IN_MQ131] = COMP_ONE;
+    matrix.coeff[COMP_OUT_NO2][COMP_IN_MQ131] = COMP_ONE;
+}
+
+// Finds the inputs each gas depends on
+static void updateUsedInputs()
+{
+    for (uint8_t out = 0; out < COMP_OUTPUTS; out++)
+    {
+        usedInputs[out] = 0;
+
+        for (uint8_t in = 0; in < COMP_INPUTS; in++)
+        {
+            if (matrix.coeff[out][in] != 0)
+            {
+                usedInputs[out] |= (1U << in);
+            }
+        }
+    }
+}
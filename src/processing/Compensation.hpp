@@ -0,0 +1,84 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef COMPENSATION_hpp
+#define COMPENSATION_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Fractional bits of the coefficients, 1.0 is 65536
+#define COMP_FRACTION_BITS 16
+#define COMP_ONE           (1L << COMP_FRACTION_BITS)
+
+// Layout version of the matrix kept in the state store, 2 since the MQ
+// inputs are voltages rather than counts
+#define COMP_STATE_VERSION 2
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Entries of the input vector, the MQ readings are calibrated voltages in mV
+typedef enum
+{
+    COMP_IN_MQ4,
+    COMP_IN_MQ7,
+    COMP_IN_MQ131,
+    COMP_IN_MQ137,
+
+    // Air temperature in degrees Celsius and relative humidity in %
+    COMP_IN_TEMP,
+    COMP_IN_HUMIDITY,
+
+    // Constant 1, its coefficient is the offset of each gas
+    COMP_IN_ONE,
+
+    COMP_INPUTS
+
+} e_compInput;
+
+// Entries of the output vector, the de-mixed concentrations
+typedef enum
+{
+    COMP_OUT_CH4,
+    COMP_OUT_CO,
+    COMP_OUT_O3,
+    COMP_OUT_NO2,
+    COMP_OUTPUTS
+
+} e_compOutput;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Restores the matrix fitted on the host, or each gas from its own sensor
+// @return: 1 if a matrix was restored, 0 if the default one is used
+int initCompensation();
+
+// Computes the concentrations from the simultaneous readings
+// @param inputs: Input vector, COMP_INPUTS values in e_compInput order
+// @param validInputs: Bit n set when inputs[n] holds a usable reading
+// @param outputs: Output vector, COMP_OUTPUTS values in e_compOutput order
+// @return: Bit n set when outputs[n] only depends on usable readings
+uint8_t compensateGases(const int32_t *inputs, uint8_t validInputs, int32_t *outputs);
+
+// Replaces the coefficients of one gas, and saves the matrix
+// @param output: Gas to change (e_compOutput)
+// @param coeffs: COMP_INPUTS coefficients with COMP_FRACTION_BITS fractional bits
+// @return: 1 if the gas exists, 0 otherwise
+uint8_t setCompensationRow(uint8_t output, const int32_t *coeffs);
+
+// Retrieves the coefficients of one gas
+// @param output: Gas to read (e_compOutput)
+// @param coeffs: Destination of the COMP_INPUTS coefficients
+// @return: 1 if the gas exists, 0 otherwise
+uint8_t getCompensationRow(uint8_t output, int32_t *coeffs);
+
+// Restores the default matrix, each gas from its own sensor, and saves it
+void resetCompensation();
+
+#endif // COMPENSATION_hpp
@@ -0,0 +1,331 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file detects plumes on the gas channels so the unit samples
+    fast only when it matters. Each watched channel runs an upward
+    CUSUM against a slowly learnt baseline, plus a test on the rise
+    between two samples. A detection starts a burst at a short
+    period, which then decays back to the base period. The last
+    cycles are kept in a ring so the air just before the plume can
+    be sent along with it.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the event detector
+#include "Events.hpp"
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Detector of a watched channel
+typedef struct
+{
+    // Baseline mean and mean absolute deviation
+    float mean;
+    float deviation;
+
+    // Upward cumulative sum, in deviations
+    float sum;
+
+    // Previous value and number of values seen
+    int32_t last;
+    uint16_t samples;
+
+} t_cusum;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Watched channels and their smallest deviation
+static const e_channel eventChannels[EVENT_CHANNELS] = EVENT_CHANNEL_LIST;
+static const float minDeviations[EVENT_CHANNELS] = EVENT_MIN_DEVIATIONS;
+
+// Detector of each watched channel
+static t_cusum detectors[EVENT_CHANNELS];
+
+// Sampling regime and its timing
+static e_eventState state = EVENT_IDLE;
+static uint32_t basePeriod = 0;
+static uint32_t period = 0;
+static uint32_t burstMs = EVENT_BURST_MS;
+static uint32_t burstStartMs = 0;
+static uint32_t burstEndMs = 0;
+
+// Last event
+static e_channel eventChannel = CH_COUNT;
+static uint16_t eventCount = 0;
+
+// Cycles before the event, oldest at ringHead
+static t_sampleSet ringSets[EVENT_PRE_SAMPLES];
+static uint64_t ringTimes[EVENT_PRE_SAMPLES];
+static uint8_t ringHead = 0;
+static uint8_t ringCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Feeds a value to the detector of a channel
+// @param detector: Detector of the channel
+// @param value: New value
+// @param learn: 1 to update the baseline, 0 to keep it
+// @param minDeviation: Smallest deviation of the channel
+// @return: 1 if the value is part of a rise, 0 otherwise
+static uint8_t updateCusum(t_cusum *detector, int32_t value, uint8_t learn, float minDeviation);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Resets the detectors and the pre-event history
+// @param basePeriodMs: Measurement period outside events
+void initEvents(uint32_t basePeriodMs)
+{
+    for (uint8_t i = 0; i < EVENT_CHANNELS; i++)
+    {
+        detectors[i].mean = 0;
+        detectors[i].deviation = 0;
+        detectors[i].sum = 0;
+        detectors[i].last = 0;
+        detectors[i].samples = 0;
+    }
+
+    state = EVENT_IDLE;
+    basePeriod = basePeriodMs;
+    period = basePeriodMs;
+    ringHead = 0;
+    ringCount = 0;
+}
+
+
+/* *****************************************************************
+    *                       UPDATE FUNCTION                       *
+   ***************************************************************** */
+
+// Feeds a measurement cycle to the detectors and keeps it in the pre-event history
+// @param set: Sample set of the cycle
+// @param timeUs: Local time of the cycle
+// @param nowMs: Current time in milliseconds
+// @return: 1 if an event starts with this cycle, 0 otherwise
+uint8_t updateEvents(const t_sampleSet *set, uint64_t timeUs, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Channel detecting a rise on this cycle, CH_COUNT if none
+    e_channel fired = CH_COUNT;
+
+    // Set when this cycle starts an event
+    uint8_t started = 0;
+
+    /* -------------------- DETECTION -------------------- */
+
+    for (uint8_t i = 0; i < EVENT_CHANNELS; i++)
+    {
+        if (!isSampleValid(set, eventChannels[i]))
+        {
+            continue;
+        }
+
+        // The baseline is frozen during a burst so the plume does not become it
+        if (updateCusum(&detectors[i], set->value[eventChannels[i]], state != EVENT_BURST,
+                        minDeviations[i]) &&
+            fired == CH_COUNT)
+        {
+            fired = eventChannels[i];
+        }
+    }
+
+    /* -------------------- SAMPLING REGIME -------------------- */
+
+    if (fired != CH_COUNT)
+    {
+        if (state != EVENT_BURST)
+        {
+            state = EVENT_BURST;
+            burstStartMs = nowMs;
+            eventChannel = fired;
+            eventCount++;
+            started = 1;
+        }
+
+        // Every new detection keeps the burst going
+        burstEndMs = nowMs + burstMs;
+        period = EVENT_BURST_PERIOD_MS;
+    }
+
+    else if (state == EVENT_BURST && (int32_t)(nowMs - burstEndMs) >= 0)
+    {
+        state = EVENT_DECAY;
+    }
+
+    // A level that stays high is the new clean air
+    if (state == EVENT_BURST && nowMs - burstStartMs >= EVENT_MAX_BURST_MS)
+    {
+        for (uint8_t i = 0; i < EVENT_CHANNELS; i++)
+        {
+            detectors[i].mean = (float)detectors[i].last;
+            detectors[i].sum = 0;
+        }
+
+        state = EVENT_DECAY;
+    }
+
+    if (state == EVENT_DECAY)
+    {
+        period *= 2;
+
+        if (period >= basePeriod)
+        {
+            period = basePeriod;
+            state = EVENT_IDLE;
+        }
+    }
+
+    /* -------------------- PRE-EVENT HISTORY -------------------- */
+
+    // Only clean-air cycles are history, the burst is sent as it goes
+    if (state == EVENT_IDLE)
+    {
+        ringSets[(ringHead + ringCount) % EVENT_PRE_SAMPLES] = *set;
+        ringTimes[(ringHead + ringCount) % EVENT_PRE_SAMPLES] = timeUs;
+
+        if (ringCount < EVENT_PRE_SAMPLES)
+        {
+            ringCount++;
+        }
+
+        else
+        {
+            ringHead = (ringHead + 1) % EVENT_PRE_SAMPLES;
+        }
+    }
+
+    return started;
+}
+
+
+/* *****************************************************************
+    *                       QUERY FUNCTIONS                       *
+   ***************************************************************** */
+
+// Returns the period until the next measurement
+uint32_t getEventPeriod()
+{
+    return period;
+}
+
+// Returns the sampling regime
+e_eventState getEventState()
+{
+    return state;
+}
+
+// Returns the channel that fired the last event
+e_channel getEventChannel()
+{
+    return eventChannel;
+}
+
+// Returns the number of events since boot
+uint16_t getEventCount()
+{
+    return eventCount;
+}
+
+// Sets the length of a burst
+void setEventBurstWindow(uint32_t windowMs)
+{
+    burstMs = windowMs ? windowMs : EVENT_BURST_MS;
+}
+
+// Takes the oldest cycle of the pre-event history
+uint8_t popPreEvent(t_sampleSet *set, uint64_t *timeUs)
+{
+    if (ringCount == 0)
+    {
+        return 0;
+    }
+
+    *set = ringSets[ringHead];
+    *timeUs = ringTimes[ringHead];
+    ringHead = (ringHead + 1) % EVENT_PRE_SAMPLES;
+    ringCount--;
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Feeds a value to the detector of a channel
+static uint8_t updateCusum(t_cusum *detector, int32_t value, uint8_t learn, float minDeviation)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Deviation used to normalise the value
+    float deviation;
+
+    // Distance to the baseline and rise since the last value, in deviations
+    float distance, rise;
+
+    /* -------------------- WARM-UP -------------------- */
+
+    if (detector->samples == 0)
+    {
+        detector->mean = (float)value;
+    }
+
+    if (detector->samples < EVENT_WARMUP_SAMPLES)
+    {
+        detector->deviation += EVENT_BASELINE_ALPHA *
+                               ((value > detector->mean ? value - detector->mean
+                                                        : detector->mean - value) -
+                                detector->deviation);
+        detector->mean += EVENT_BASELINE_ALPHA * (value - detector->mean);
+        detector->last = value;
+        detector->samples++;
+        return 0;
+    }
+
+    /* -------------------- DETECTION -------------------- */
+
+    deviation = (detector->deviation > minDeviation) ? detector->deviation : minDeviation;
+    distance = (value - detector->mean) / deviation;
+    rise = (float)(value - detector->last) / deviation;
+
+    // Plumes raise the concentrations, only rises are tracked
+    detector->sum += distance - EVENT_CUSUM_K;
+    if (detector->sum < 0)
+    {
+        detector->sum = 0;
+    }
+
+    detector->last = value;
+
+    /* -------------------- BASELINE -------------------- */
+
+    if (learn && detector->sum == 0)
+    {
+        detector->deviation += EVENT_BASELINE_ALPHA *
+                               ((distance > 0 ? distance : -distance) * deviation -
+                                detector->deviation);
+        detector->mean += EVENT_BASELINE_ALPHA * (value - detector->mean);
+    }
+
+    if (detector->sum <= EVENT_CUSUM_H && rise <= EVENT_JUMP_DEVIATIONS)
+    {
+        return 0;
+    }
+
+    // Starts again from zero, a lasting plume fires again within a few cycles
+    // and the burst ends soon after the air clears
+    detector->sum = 0;
+    return 1;
+}
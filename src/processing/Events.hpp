@@ -0,0 +1,104 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef EVENTS_hpp
+#define EVENTS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Channel definitions and sample sets
+#include "Channels.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Gas channels watched for plumes
+#define EVENT_CHANNELS     4
+#define EVENT_CHANNEL_LIST {CH_CO, CH_CH4, CH_PM2_5, CH_CO2}
+
+// Smallest deviation of each watched channel, in its unit, so sensor
+// quantisation in clean air does not read as a change
+#define EVENT_MIN_DEVIATIONS {2, 10, 2, 15}
+
+// CUSUM allowance and threshold, in deviations
+#define EVENT_CUSUM_K 0.5f
+#define EVENT_CUSUM_H 5.0f
+
+// A rise between two samples larger than this, in deviations, fires at once
+#define EVENT_JUMP_DEVIATIONS 6.0f
+
+// Smoothing factor of the baseline mean and deviation
+#define EVENT_BASELINE_ALPHA 0.05f
+
+// Samples needed to learn the baseline before detecting
+#define EVENT_WARMUP_SAMPLES 10
+
+// Measurement period during a burst
+#define EVENT_BURST_PERIOD_MS 500
+
+// Default length of a burst, extended by every new detection
+#define EVENT_BURST_MS 30000UL
+
+// Longest burst: a level that stays high becomes the new baseline
+#define EVENT_MAX_BURST_MS 300000UL
+
+// Samples kept from before the event
+#define EVENT_PRE_SAMPLES 16
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Sampling regime set by the detector
+typedef enum
+{
+    // Clean air, base period
+    EVENT_IDLE,
+
+    // Plume detected, burst period
+    EVENT_BURST,
+
+    // Burst over, the period doubles back to the base one
+    EVENT_DECAY
+
+} e_eventState;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Resets the detectors and the pre-event history
+// @param basePeriodMs: Measurement period outside events
+void initEvents(uint32_t basePeriodMs);
+
+// Feeds a measurement cycle to the detectors and keeps it in the pre-event history
+// @param set: Sample set of the cycle
+// @param timeUs: Local time of the cycle
+// @param nowMs: Current time in milliseconds
+// @return: 1 if an event starts with this cycle, 0 otherwise
+uint8_t updateEvents(const t_sampleSet *set, uint64_t timeUs, uint32_t nowMs);
+
+// Returns the period until the next measurement
+// @return: Period in milliseconds
+uint32_t getEventPeriod();
+
+// Returns the sampling regime
+e_eventState getEventState();
+
+// Returns the channel that fired the last event
+e_channel getEventChannel();
+
+// Returns the number of events since boot
+uint16_t getEventCount();
+
+// Sets the length of a burst
+// @param windowMs: Length in milliseconds, 0 restores EVENT_BURST_MS
+void setEventBurstWindow(uint32_t windowMs);
+
+// Takes the oldest cycle of the pre-event history
+// @param set: Pointer where the sample set will be stored
+// @param timeUs: Pointer where the local time of the cycle will be stored
+// @return: 1 if a cycle was taken, 0 once the history is empty
+uint8_t popPreEvent(t_sampleSet *set, uint64_t *timeUs);
+
+#endif // EVENTS_hpp
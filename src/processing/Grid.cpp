@@ -0,0 +1,377 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file bins the geolocated samples into a grid of fixed-size
+    cells, with altitude layers, for live pollution maps. Each
+    sample updates the count, sum and maximum of one cell per
+    resolution level, found through a small hash table, so the cost
+    does not grow with the flight. Each level has a fixed number of
+    cells: a new cell that finds its probed slots all taken reuses
+    the least recently updated of those, not of the level. Tiles
+    are read page by page under a mutex, so the log server task can
+    query them while samples are added.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the grid aggregator
+#include "Grid.hpp"
+
+// floor() and cos() for the cell indexes
+#include <math.h>
+
+// Mutex shared with the log server task
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Slot of a level: a cell and whether it holds one
+typedef struct
+{
+    t_gridCell cell;
+    uint8_t used;
+
+} t_gridSlot;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Cells of every level
+static t_gridSlot slots[GRID_LEVELS][GRID_CELLS];
+
+// Cell sizes of each level in metres
+static const uint16_t cellSizes[GRID_LEVELS] = GRID_CELL_SIZES;
+static const uint16_t altSizes[GRID_LEVELS] = GRID_ALT_SIZES;
+
+// Channels aggregated in the cells
+static const e_channel gridChannels[GRID_CHANNELS] = GRID_CHANNEL_LIST;
+
+// First position, origin of the cell indexes
+static double originLat = 0;
+static double originLon = 0;
+static float originAlt = 0;
+static uint8_t hasOrigin = 0;
+
+// Metres per degree of longitude at the origin
+static double metresPerDegreeLon = GRID_METRES_PER_DEGREE;
+
+// Cells reused because their probed slots were all taken
+static uint32_t evictions = 0;
+
+// Protects the cells against queries from other tasks
+static SemaphoreHandle_t gridMutex = NULL;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Finds the slot of a cell, claiming one if the cell is new
+// @param level: Resolution level
+// @param x, y, z: Cell indexes
+// @return: Slot of the cell
+static t_gridSlot *findCell(uint8_t level, int16_t x, int16_t y, int16_t z);
+
+// Converts a distance from the origin into a cell index
+// @param metres: Distance in metres
+// @param size: Size of the cells in metres
+// @return: Cell index, clamped to 16 bits
+static int16_t toCellIndex(double metres, uint16_t size);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Clears the grid, the next position becomes the origin
+// @return: 1 if successful, 0 otherwise
+int initGrid()
+{
+    if (!gridMutex)
+    {
+        gridMutex = xSemaphoreCreateMutex();
+    }
+
+    if (!gridMutex)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(gridMutex, portMAX_DELAY);
+
+    for (uint8_t level = 0; level < GRID_LEVELS; level++)
+    {
+        for (uint16_t i = 0; i < GRID_CELLS; i++)
+        {
+            slots[level][i].used = 0;
+        }
+    }
+
+    hasOrigin = 0;
+    evictions = 0;
+
+    xSemaphoreGive(gridMutex);
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                       UPDATE FUNCTION                       *
+   ***************************************************************** */
+
+// Adds the valid aggregated channels of a sample set to the cells of every level
+// @param set: Sample set to add
+// @param latitude: Latitude of the sample in degrees
+// @param longitude: Longitude of the sample in degrees
+// @param altitude: Altitude of the sample in metres
+// @param nowMs: Current time in milliseconds
+void addGridSample(const t_sampleSet *set, double latitude, double longitude, float altitude,
+                   uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Position relative to the origin in metres
+    double east, north, up;
+
+    // Cell updated at the current level
+    t_gridCell *cell;
+
+    // Value of the channel being added
+    int32_t value;
+
+    /* -------------------- POSITION -------------------- */
+
+    if (!gridMutex)
+    {
+        return;
+    }
+
+    xSemaphoreTake(gridMutex, portMAX_DELAY);
+
+    // Flat-earth approximation around the first fix, a few cm per km
+    if (!hasOrigin)
+    {
+        originLat = latitude;
+        originLon = longitude;
+        originAlt = altitude;
+        metresPerDegreeLon = GRID_METRES_PER_DEGREE * cos(latitude * M_PI / 180.0);
+        hasOrigin = 1;
+    }
+
+    east = (longitude - originLon) * metresPerDegreeLon;
+    north = (latitude - originLat) * GRID_METRES_PER_DEGREE;
+    up = altitude - originAlt;
+
+    /* -------------------- CELL UPDATE -------------------- */
+
+    for (uint8_t level = 0; level < GRID_LEVELS; level++)
+    {
+        cell = &findCell(level, toCellIndex(east, cellSizes[level]),
+                         toCellIndex(north, cellSizes[level]), toCellIndex(up, altSizes[level]))
+                    ->cell;
+        cell->updatedMs = nowMs;
+
+        for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+        {
+            if (!isSampleValid(set, gridChannels[i]) || cell->count[i] == UINT16_MAX)
+            {
+                continue;
+            }
+
+            value = set->value[gridChannels[i]];
+
+            if (cell->count[i] == 0 || value > cell->max[i])
+            {
+                cell->max[i] = value;
+            }
+
+            cell->sum[i] += value;
+            cell->count[i]++;
+        }
+    }
+
+    xSemaphoreGive(gridMutex);
+}
+
+
+/* *****************************************************************
+    *                       QUERY FUNCTIONS                       *
+   ***************************************************************** */
+
+// Returns the origin of the cell indexes
+uint8_t getGridOrigin(double *latitude, double *longitude, float *altitude)
+{
+    if (!gridMutex)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(gridMutex, portMAX_DELAY);
+    *latitude = originLat;
+    *longitude = originLon;
+    *altitude = originAlt;
+    xSemaphoreGive(gridMutex);
+
+    return hasOrigin;
+}
+
+// Copies the cells of a level lying in a tile, a page at a time, while
+// samples keep being added
+uint16_t queryGridTile(uint8_t level, int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                       uint16_t *cursor, t_gridCell *cells, uint16_t maxCells)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Number of cells copied
+    uint16_t count = 0;
+
+    // Cell being checked
+    const t_gridCell *cell;
+
+    /* -------------------- TILE SCAN -------------------- */
+
+    if (level >= GRID_LEVELS || !gridMutex)
+    {
+        return 0;
+    }
+
+    // Held for one page only, the measurements wait at most that long
+    xSemaphoreTake(gridMutex, portMAX_DELAY);
+
+    while (*cursor < GRID_CELLS && count < maxCells)
+    {
+        cell = &slots[level][*cursor].cell;
+
+        if (slots[level][*cursor].used && cell->x >= xMin && cell->x <= xMax &&
+            cell->y >= yMin && cell->y <= yMax)
+        {
+            cells[count++] = *cell;
+        }
+
+        (*cursor)++;
+    }
+
+    xSemaphoreGive(gridMutex);
+    return count;
+}
+
+// Returns the size of the cells of a level
+uint16_t getGridCellSize(uint8_t level, uint16_t *altitude)
+{
+    if (level >= GRID_LEVELS)
+    {
+        *altitude = 0;
+        return 0;
+    }
+
+    *altitude = altSizes[level];
+    return cellSizes[level];
+}
+
+// Returns the channel aggregated at an index of the cells
+e_channel getGridChannel(uint8_t index)
+{
+    return (index < GRID_CHANNELS) ? gridChannels[index] : CH_COUNT;
+}
+
+// Returns the number of cells reused because their probed slots were all taken
+uint32_t getGridEvictions()
+{
+    return evictions;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Finds the slot of a cell, claiming one if the cell is new
+static t_gridSlot *findCell(uint8_t level, int16_t x, int16_t y, int16_t z)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // First slot probed
+    uint32_t hash;
+
+    // Slot being probed and slot to claim for a new cell
+    t_gridSlot *slot;
+    t_gridSlot *victim = NULL;
+
+    /* -------------------- LOOKUP -------------------- */
+
+    hash = ((uint32_t)(uint16_t)x * 73856093UL) ^ ((uint32_t)(uint16_t)y * 19349663UL) ^
+           ((uint32_t)(uint16_t)z * 83492791UL);
+
+    for (uint8_t probe = 0; probe < GRID_MAX_PROBE; probe++)
+    {
+        slot = &slots[level][(hash + probe) & (GRID_CELLS - 1)];
+
+        // Cells are never removed, only reused in place: a free slot
+        // ends the probe sequence
+        if (!slot->used)
+        {
+            victim = slot;
+            break;
+        }
+
+        if (slot->cell.x == x && slot->cell.y == y && slot->cell.z == z)
+        {
+            return slot;
+        }
+
+        // No free slot in the probe: reuse the least recently updated of
+        // the probed cells, an older cell elsewhere in the level stays
+        if (!victim || (int32_t)(slot->cell.updatedMs - victim->cell.updatedMs) < 0)
+        {
+            victim = slot;
+        }
+    }
+
+    /* -------------------- NEW CELL -------------------- */
+
+    if (victim->used)
+    {
+        evictions++;
+    }
+
+    victim->used = 1;
+    victim->cell.x = x;
+    victim->cell.y = y;
+    victim->cell.z = z;
+
+    for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+    {
+        victim->cell.count[i] = 0;
+        victim->cell.sum[i] = 0;
+        victim->cell.max[i] = 0;
+    }
+
+    return victim;
+}
+
+// Converts a distance from the origin into a cell index
+static int16_t toCellIndex(double metres, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Unclamped index
+    double index = floor(metres / size);
+
+    /* -------------------- CLAMPING -------------------- */
+
+    if (index > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    if (index < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t)index;
+}
@@ -0,0 +1,111 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef GRID_hpp
+#define GRID_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Channel definitions and sample sets
+#include "Channels.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Resolution levels, from the finest to the coarsest
+#define GRID_LEVELS 3
+
+// Horizontal and vertical size of the cells of each level in metres
+#define GRID_CELL_SIZES {10, 50, 250}
+#define GRID_ALT_SIZES  {10, 25, 100}
+
+// Cells kept per level, a power of two so the probe wraps with a mask.
+// A new cell whose probed slots are all taken reuses the least recently
+// updated of them, so memory stays bounded
+#define GRID_CELLS 128
+
+// Slots probed for a cell before one of them is reused
+#define GRID_MAX_PROBE 8
+
+static_assert((GRID_CELLS & (GRID_CELLS - 1)) == 0, "Grid: GRID_CELLS must be a power of two");
+static_assert(GRID_MAX_PROBE <= GRID_CELLS, "Grid: more probes than cells");
+
+// Channels aggregated in each cell
+#define GRID_CHANNELS     4
+#define GRID_CHANNEL_LIST {CH_VOC, CH_CO2, CH_CO, CH_PM2_5}
+
+// Metres per degree of latitude
+#define GRID_METRES_PER_DEGREE 111320.0
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Cell of the grid, indexed east (x), north (y) and up (z) from the origin
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+
+    // Time of the last sample added to the cell
+    uint32_t updatedMs;
+
+    // Per aggregated channel: number of samples, their sum and their maximum.
+    // The sum stops at UINT16_MAX samples, the mean then covers those
+    uint16_t count[GRID_CHANNELS];
+    int32_t sum[GRID_CHANNELS];
+    int32_t max[GRID_CHANNELS];
+
+} t_gridCell;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Clears the grid, the next position becomes the origin
+// @return: 1 if successful, 0 otherwise
+int initGrid();
+
+// Adds the valid aggregated channels of a sample set to the cells of every level
+// @param set: Sample set to add
+// @param latitude: Latitude of the sample in degrees
+// @param longitude: Longitude of the sample in degrees
+// @param altitude: Altitude of the sample in metres
+// @param nowMs: Current time in milliseconds
+void addGridSample(const t_sampleSet *set, double latitude, double longitude, float altitude,
+                   uint32_t nowMs);
+
+// Returns the origin of the cell indexes
+// @param latitude: Pointer where the latitude in degrees will be stored
+// @param longitude: Pointer where the longitude in degrees will be stored
+// @param altitude: Pointer where the altitude in metres will be stored
+// @return: 1 once a position has been added, 0 before
+uint8_t getGridOrigin(double *latitude, double *longitude, float *altitude);
+
+// Copies the cells of a level lying in a tile, a page at a time, while
+// samples keep being added
+// @param level: Resolution level, 0 to GRID_LEVELS - 1
+// @param xMin, yMin, xMax, yMax: Tile bounds in cells, inclusive
+// @param cursor: Slot to resume from, 0 for the first page, updated for the next one
+// @param cells: Destination of the cells
+// @param maxCells: Size of the destination
+// @return: Number of cells copied, 0 once the level has been scanned
+uint16_t queryGridTile(uint8_t level, int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                       uint16_t *cursor, t_gridCell *cells, uint16_t maxCells);
+
+// Returns the size of the cells of a level
+// @param level: Resolution level
+// @param altitude: Pointer where the vertical size in metres will be stored
+// @return: Horizontal size in metres, 0 for an invalid level
+uint16_t getGridCellSize(uint8_t level, uint16_t *altitude);
+
+// Returns the channel aggregated at an index of the cells
+// @param index: Index in the cell arrays, 0 to GRID_CHANNELS - 1
+// @return: Channel aggregated at this index
+e_channel getGridChannel(uint8_t index);
+
+// Returns the number of cells reused because their probed slots were all taken
+uint32_t getGridEvictions();
+
+#endif // GRID_hpp
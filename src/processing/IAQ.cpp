@@ -0,0 +1,412 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file computes an indoor air quality index from the BME680
+    gas resistance. The resistance is handled in the log domain,
+    compensated for humidity and compared to a clean-air baseline
+    learnt from the upper percentile of the last hours. All the
+    arithmetic is fixed-point and the baseline is kept in flash so
+    it survives a reboot.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the IAQ estimator
+#include "IAQ.hpp"
+
+// Arduino core for millis()
+#include <Arduino.h>
+
+// Versioned storage of the baseline
+#include "../storage/State.hpp"
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Baseline image stored in flash
+typedef struct
+{
+    uint8_t version;
+    uint8_t count;
+    uint8_t head;
+    int32_t hourly[IAQ_BASELINE_HOURS];
+
+} t_iaqStore;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Clean-air level of each past period (log2 ohms, Q16)
+static t_iaqStore store;
+
+// Histogram of the compensated resistance in the current period
+static uint16_t histogram[IAQ_HIST_BINS];
+static uint16_t histCount = 0;
+
+// Start of the current period and of the burn-in
+static uint32_t hourStart = 0;
+static uint32_t startMillis = 0;
+
+// Baseline derived from the stored periods (log2 ohms, Q16)
+static int32_t ringBaseline = 0;
+
+// Confidence of the last computed index
+static e_iaqAccuracy accuracy = IAQ_STABILISING;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Returns the value below which a percentage of the period's samples lie
+// @param percent: Percentile in %
+// @return: Compensated log2 resistance in Q16
+static int32_t getHistogramPercentile(uint8_t percent);
+
+// Closes the current period and stores its clean-air level
+static void closeHour();
+
+// Recomputes the baseline from the stored periods
+static void updateRingBaseline();
+
+// Hands the stored periods to the state store
+static void saveBaseline();
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Restores the persisted baseline and starts the burn-in period
+// @return: 1 if a baseline was restored, 0 if it has to be learnt
+int initIAQ()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Set when a baseline image was read
+    uint8_t restored;
+
+    /* -------------------- BASELINE RESTORE -------------------- */
+
+    startMillis = millis();
+    hourStart = startMillis;
+    histCount = 0;
+
+    for (uint8_t i = 0; i < IAQ_HIST_BINS; i++)
+    {
+        histogram[i] = 0;
+    }
+
+    restored = loadState(STATE_IAQ_BASELINE, IAQ_NVS_VERSION, &store, sizeof(store));
+
+    // Discard images from another firmware layout
+    if (!restored || store.version != IAQ_NVS_VERSION || store.count > IAQ_BASELINE_HOURS ||
+        store.head >= IAQ_BASELINE_HOURS)
+    {
+        store.version = IAQ_NVS_VERSION;
+        store.count = 0;
+        store.head = 0;
+        ringBaseline = 0;
+        return 0;
+    }
+
+    updateRingBaseline();
+    return store.count > 0;
+}
+
+
+/* *****************************************************************
+    *                       UPDATE FUNCTION                       *
+   ***************************************************************** */
+
+// Feeds one gas resistance sample and computes the IAQ index
+// @param gasResistance: Gas resistance in ohms
+// @param humidity: Relative humidity of the same sample in %
+// @param nowMs: Current time in milliseconds
+// @return: IAQ index from 0 (clean) to IAQ_MAX_INDEX
+uint16_t updateIAQ(uint32_t gasResistance, int32_t humidity, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Humidity compensated log2 resistance (Q16)
+    int32_t compensated;
+
+    // Clean-air reference (Q16)
+    int32_t baseline;
+
+    // Histogram bin of the sample
+    int32_t bin;
+
+    // Index before clamping
+    int32_t index;
+
+    /* -------------------- COMPENSATION -------------------- */
+
+    if (gasResistance == 0)
+    {
+        return 0;
+    }
+
+    // Humidity lowers the resistance, bring it back to the reference
+    compensated = log2Q16(gasResistance) + IAQ_HUM_SLOPE_Q16 * (humidity - IAQ_HUM_REF);
+
+    // Fresh heaters read far too high, keep them out of the baseline
+    if (nowMs - startMillis < IAQ_STABILISE_MS)
+    {
+        accuracy = IAQ_STABILISING;
+        return 0;
+    }
+
+    /* -------------------- BASELINE TRACKING -------------------- */
+
+    bin = (compensated - ((int32_t)IAQ_LOG2_MIN << 16)) >> IAQ_BIN_SHIFT;
+    if (bin < 0)
+    {
+        bin = 0;
+    }
+
+    else if (bin >= IAQ_HIST_BINS)
+    {
+        bin = IAQ_HIST_BINS - 1;
+    }
+
+    if (histCount < UINT16_MAX)
+    {
+        histogram[bin]++;
+        histCount++;
+    }
+
+    if (nowMs - hourStart >= IAQ_HOUR_MS)
+    {
+        closeHour();
+        hourStart += IAQ_HOUR_MS;
+    }
+
+    // Use the stored periods, or the current one until one is stored
+    if (store.count > 0)
+    {
+        baseline = ringBaseline;
+        accuracy = (store.count >= IAQ_CALIBRATED_HOURS) ? IAQ_HIGH : IAQ_MEDIUM;
+    }
+
+    else if (histCount >= IAQ_MIN_HOUR_SAMPLES)
+    {
+        baseline = getHistogramPercentile(IAQ_BASELINE_PERCENTILE);
+        accuracy = IAQ_LOW;
+    }
+
+    else
+    {
+        accuracy = IAQ_STABILISING;
+        return 0;
+    }
+
+    /* -------------------- INDEX -------------------- */
+
+    // Every halving of the resistance below clean air adds the same amount
+    index = IAQ_CLEAN_INDEX + (((baseline - compensated) * IAQ_POINTS_PER_LOG2) >> 16);
+
+    if (index < 0)
+    {
+        index = 0;
+    }
+
+    else if (index > IAQ_MAX_INDEX)
+    {
+        index = IAQ_MAX_INDEX;
+    }
+
+    return (uint16_t)index;
+}
+
+
+/* *****************************************************************
+    *                     ACCURACY FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the confidence of the last computed index
+e_iaqAccuracy getIAQAccuracy()
+{
+    return accuracy;
+}
+
+// Returns a short printable name for an accuracy state
+// @param accuracy: Accuracy state
+// @return: Constant string describing the state
+const char *getIAQAccuracyName(e_iaqAccuracy accuracy)
+{
+    switch (accuracy)
+    {
+        case IAQ_LOW:
+            return "LOW";
+
+        case IAQ_MEDIUM:
+            return "MEDIUM";
+
+        case IAQ_HIGH:
+            return "HIGH";
+
+        default:
+            return "STABILISING";
+    }
+}
+
+
+/* *****************************************************************
+    *                    FIXED-POINT LOGARITHM                    *
+   ***************************************************************** */
+
+// Returns the base-2 logarithm of a value in Q16 fixed point
+// @param value: Value to convert, must be non-zero
+// @return: log2(value) * 65536
+int32_t log2Q16(uint32_t value)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Integer part of the result
+    int32_t result = 31;
+
+    // Mantissa in [1, 2) as Q31
+    uint64_t mantissa;
+
+    /* -------------------- INTEGER PART -------------------- */
+
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    while (!(value & 0x80000000UL))
+    {
+        value <<= 1;
+        result--;
+    }
+
+    result <<= 16;
+    mantissa = value;
+
+    /* -------------------- FRACTIONAL PART -------------------- */
+
+    // Squaring the mantissa doubles its logarithm, so each overflow
+    // past 2 gives the next fractional bit
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        mantissa = (mantissa * mantissa) >> 31;
+
+        if (mantissa >= (1ULL << 32))
+        {
+            mantissa >>= 1;
+            result |= (1L << (15 - i));
+        }
+    }
+
+    return result;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the value below which a percentage of the period's samples lie
+static int32_t getHistogramPercentile(uint8_t percent)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rank of the percentile and samples counted so far
+    uint32_t rank = ((uint32_t)histCount * percent + 99) / 100;
+    uint32_t cumulated = 0;
+
+    // Bin holding the percentile
+    uint8_t bin = 0;
+
+    /* -------------------- HISTOGRAM WALK -------------------- */
+
+    for (bin = 0; bin < IAQ_HIST_BINS - 1; bin++)
+    {
+        cumulated += histogram[bin];
+
+        if (cumulated >= rank)
+        {
+            break;
+        }
+    }
+
+    // Middle of the bin
+    return ((int32_t)IAQ_LOG2_MIN << 16) + ((int32_t)bin << IAQ_BIN_SHIFT) +
+           (1L << (IAQ_BIN_SHIFT - 1));
+}
+
+// Closes the current period and stores its clean-air level
+static void closeHour()
+{
+    // Periods with too few samples would only add noise
+    if (histCount >= IAQ_MIN_HOUR_SAMPLES)
+    {
+        store.hourly[store.head] = getHistogramPercentile(IAQ_BASELINE_PERCENTILE);
+        store.head = (store.head + 1) % IAQ_BASELINE_HOURS;
+
+        if (store.count < IAQ_BASELINE_HOURS)
+        {
+            store.count++;
+        }
+
+        updateRingBaseline();
+        saveBaseline();
+    }
+
+    for (uint8_t i = 0; i < IAQ_HIST_BINS; i++)
+    {
+        histogram[i] = 0;
+    }
+
+    histCount = 0;
+}
+
+// Recomputes the baseline from the stored periods
+static void updateRingBaseline()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sorted copy of the stored periods
+    int32_t sorted[IAQ_BASELINE_HOURS];
+
+    // Value being inserted
+    int32_t value;
+
+    // Insertion position
+    int8_t j;
+
+    /* -------------------- UPPER QUARTILE -------------------- */
+
+    if (store.count == 0)
+    {
+        ringBaseline = 0;
+        return;
+    }
+
+    // Insertion sort, at most IAQ_BASELINE_HOURS entries once per period
+    for (uint8_t i = 0; i < store.count; i++)
+    {
+        value = store.hourly[i];
+
+        for (j = (int8_t)i - 1; j >= 0 && sorted[j] > value; j--)
+        {
+            sorted[j + 1] = sorted[j];
+        }
+
+        sorted[j + 1] = value;
+    }
+
+    // A few polluted periods do not drag the baseline down, a single
+    // unusually clean one does not push it up
+    ringBaseline = sorted[(store.count - 1) * 3 / 4];
+}
+
+// Hands the stored periods to the state store
+static void saveBaseline()
+{
+    // Once per period, the store writes it once it has settled
+    saveState(STATE_IAQ_BASELINE, IAQ_NVS_VERSION, &store, sizeof(store));
+}
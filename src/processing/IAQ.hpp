@@ -0,0 +1,94 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef IAQ_hpp
+#define IAQ_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Heater burn-in after power-on, samples are ignored meanwhile
+#define IAQ_STABILISE_MS 300000UL
+
+// Length of one baseline period and number of periods kept
+#define IAQ_HOUR_MS        3600000UL
+#define IAQ_BASELINE_HOURS 24
+
+// Minimum number of samples for a period to enter the baseline
+#define IAQ_MIN_HOUR_SAMPLES 60
+
+// Number of periods after which the baseline is considered reliable
+#define IAQ_CALIBRATED_HOURS 4
+
+// Percentile of the compensated resistance taken as clean air, in %
+#define IAQ_BASELINE_PERCENTILE 90
+
+// Histogram of log2(resistance): 64 bins of 1/4 from 2^8 to 2^24 ohms
+#define IAQ_LOG2_MIN   8
+#define IAQ_HIST_BINS  64
+#define IAQ_BIN_SHIFT  14
+
+// Humidity compensation: log2 units per % RH in Q16, around 40 % RH
+#define IAQ_HUM_SLOPE_Q16 1300
+#define IAQ_HUM_REF       40
+
+// Index at the baseline and index points per halving of the resistance
+#define IAQ_CLEAN_INDEX   25
+#define IAQ_POINTS_PER_LOG2 100
+#define IAQ_MAX_INDEX     500
+
+// Layout version of the baseline kept in the state store
+#define IAQ_NVS_VERSION 1
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Confidence in the index, from burn-in to a fully learnt baseline
+typedef enum
+{
+    // Heater burn-in or no baseline yet, the index is not usable
+    IAQ_STABILISING,
+
+    // Baseline from the current period only
+    IAQ_LOW,
+
+    // Baseline from fewer than IAQ_CALIBRATED_HOURS periods
+    IAQ_MEDIUM,
+
+    // Baseline from IAQ_CALIBRATED_HOURS periods or more
+    IAQ_HIGH
+
+} e_iaqAccuracy;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Restores the persisted baseline and starts the burn-in period
+// @return: 1 if a baseline was restored, 0 if it has to be learnt
+int initIAQ();
+
+// Feeds one gas resistance sample and computes the IAQ index
+// @param gasResistance: Gas resistance in ohms
+// @param humidity: Relative humidity of the same sample in %
+// @param nowMs: Current time in milliseconds
+// @return: IAQ index from 0 (clean) to IAQ_MAX_INDEX
+uint16_t updateIAQ(uint32_t gasResistance, int32_t humidity, uint32_t nowMs);
+
+// Returns the confidence of the last computed index
+e_iaqAccuracy getIAQAccuracy();
+
+// Returns a short printable name for an accuracy state
+// @param accuracy: Accuracy state
+// @return: Constant string describing the state
+const char *getIAQAccuracyName(e_iaqAccuracy accuracy);
+
+// Returns the base-2 logarithm of a value in Q16 fixed point
+// @param value: Value to convert, must be non-zero
+// @return: log2(value) * 65536
+int32_t log2Q16(uint32_t value);
+
+#endif // IAQ_hpp
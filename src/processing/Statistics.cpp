@@ -0,0 +1,467 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file implements the on-device streaming statistics. Every
+    channel keeps a running mean and variance (Welford), a sliding
+    window minimum and maximum (monotonic deques), an exponential
+    moving average and two P-square percentile estimators, exact
+    over the first samples of a window. All of them are updated in
+    constant time per sample.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the statistics engine
+#include "Statistics.hpp"
+
+// Square root for the standard deviation
+#include <math.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Statistics of every channel
+static t_channelStats channelStats[CH_COUNT];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Parabolic prediction of a P-square marker height
+static float p2Parabolic(const t_p2 *e, uint8_t i, int32_t d);
+
+// Linear prediction of a P-square marker height
+static float p2Linear(const t_p2 *e, uint8_t i, int32_t d);
+
+// Places the P-square markers on the sorted observations
+static void p2Start(t_p2 *e);
+
+
+/* *****************************************************************
+    *                      WELFORD FUNCTIONS                      *
+   ***************************************************************** */
+
+// Resets a Welford accumulator
+void resetWelford(t_welford *w)
+{
+    w->count = 0;
+    w->mean = 0.0f;
+    w->m2 = 0.0f;
+}
+
+// Adds a value to a Welford accumulator
+void updateWelford(t_welford *w, float x)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Distance to the mean before the update
+    float delta;
+
+    /* --------------------- ACCUMULATION --------------------- */
+
+    w->count++;
+    delta = x - w->mean;
+    w->mean += delta / (float)w->count;
+    w->m2 += delta * (x - w->mean);
+}
+
+// Returns the sample variance of a Welford accumulator
+float getWelfordVariance(const t_welford *w)
+{
+    return (w->count > 1) ? w->m2 / (float)(w->count - 1) : 0.0f;
+}
+
+
+/* *****************************************************************
+    *                     EXTREMUM FUNCTIONS                      *
+   ***************************************************************** */
+
+// Initializes a sliding-window extremum
+void initExtremum(t_extremum *e, uint8_t isMax)
+{
+    e->head = 0;
+    e->count = 0;
+    e->isMax = isMax;
+}
+
+// Adds a timestamped value to a sliding-window extremum
+void pushExtremum(t_extremum *e, float x, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Index of the last entry of the deque
+    uint8_t back;
+
+    /* ------------------ DEQUE MAINTENANCE ------------------ */
+
+    // Drop entries from the back that can never be the extremum again
+    while (e->count)
+    {
+        back = (e->head + e->count - 1) % STATS_DEQUE_SIZE;
+
+        if ((e->isMax && e->value[back] > x) || (!e->isMax && e->value[back] < x))
+        {
+            break;
+        }
+
+        e->count--;
+    }
+
+    // When full, forget the oldest candidate
+    if (e->count == STATS_DEQUE_SIZE)
+    {
+        e->head = (e->head + 1) % STATS_DEQUE_SIZE;
+        e->count--;
+    }
+
+    back = (e->head + e->count) % STATS_DEQUE_SIZE;
+    e->value[back] = x;
+    e->time[back] = nowMs;
+    e->count++;
+}
+
+// Returns the extremum over the last windowMs milliseconds
+// @return: 1 if the window holds at least one value, 0 otherwise
+uint8_t getExtremum(t_extremum *e, uint32_t nowMs, uint32_t windowMs, float *out)
+{
+    // Expire entries that left the window
+    while (e->count && nowMs - e->time[e->head] >= windowMs)
+    {
+        e->head = (e->head + 1) % STATS_DEQUE_SIZE;
+        e->count--;
+    }
+
+    if (!e->count)
+    {
+        return 0;
+    }
+
+    *out = e->value[e->head];
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                        EMA FUNCTIONS                        *
+   ***************************************************************** */
+
+// Initializes an exponential moving average
+void initEma(t_ema *e, float alpha)
+{
+    e->value = 0.0f;
+    e->alpha = alpha;
+    e->primed = 0;
+}
+
+// Adds a value to an exponential moving average and returns it
+float updateEma(t_ema *e, float x)
+{
+    if (!e->primed)
+    {
+        e->value = x;
+        e->primed = 1;
+    }
+
+    else
+    {
+        e->value += e->alpha * (x - e->value);
+    }
+
+    return e->value;
+}
+
+
+/* *****************************************************************
+    *                      P-SQUARE FUNCTIONS                     *
+   ***************************************************************** */
+
+// Initializes a P-square estimator for percentile p (0..1)
+void initP2(t_p2 *e, float p)
+{
+    // The markers are placed once the sorted buffer is full
+    e->p = p;
+    e->count = 0;
+}
+
+// Adds a value to a P-square estimator
+void updateP2(t_p2 *e, float x)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Desired marker position increments
+    const float dn[5] = {0.0f, e->p / 2.0f, e->p, (1.0f + e->p) / 2.0f, 1.0f};
+
+    // Cell of the new observation and working variables
+    uint8_t k;
+    float d, qp;
+    int32_t step;
+
+    /* ------------------- FIRST OBSERVATIONS ------------------- */
+
+    // Keep the first observations sorted (insertion sort)
+    if (e->count < STATS_P2_EXACT)
+    {
+        k = e->count++;
+
+        while (k > 0 && e->exact[k - 1] > x)
+        {
+            e->exact[k] = e->exact[k - 1];
+            k--;
+        }
+
+        e->exact[k] = x;
+
+        if (e->count == STATS_P2_EXACT)
+        {
+            p2Start(e);
+        }
+
+        return;
+    }
+
+    e->count++;
+
+    /* ------------------- MARKER ADJUSTMENT ------------------- */
+
+    // Find the cell containing x and widen the extremes if needed
+    if (x < e->q[0])
+    {
+        e->q[0] = x;
+        k = 0;
+    }
+
+    else if (x >= e->q[4])
+    {
+        e->q[4] = x;
+        k = 3;
+    }
+
+    else
+    {
+        k = 0;
+        while (k < 3 && x >= e->q[k + 1])
+        {
+            k++;
+        }
+    }
+
+    for (uint8_t i = k + 1; i < 5; i++)
+    {
+        e->n[i]++;
+    }
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        e->np[i] += dn[i];
+    }
+
+    // Move the three middle markers towards their desired positions
+    for (uint8_t i = 1; i < 4; i++)
+    {
+        d = e->np[i] - (float)e->n[i];
+
+        if ((d >= 1.0f && e->n[i + 1] - e->n[i] > 1) ||
+            (d <= -1.0f && e->n[i - 1] - e->n[i] < -1))
+        {
+            step = (d > 0.0f) ? 1 : -1;
+            qp = p2Parabolic(e, i, step);
+
+            if (e->q[i - 1] < qp && qp < e->q[i + 1])
+            {
+                e->q[i] = qp;
+            }
+
+            else
+            {
+                e->q[i] = p2Linear(e, i, step);
+            }
+
+            e->n[i] += step;
+        }
+    }
+}
+
+// Returns the current percentile estimate
+float getP2(const t_p2 *e)
+{
+    if (e->count == 0)
+    {
+        return 0.0f;
+    }
+
+    // Few observations yet: read the sorted buffer directly
+    if (e->count <= STATS_P2_EXACT)
+    {
+        return e->exact[(uint8_t)(e->p * (float)(e->count - 1) + 0.5f)];
+    }
+
+    return e->q[2];
+}
+
+
+/* *****************************************************************
+    *                     CHANNEL STATISTICS                      *
+   ***************************************************************** */
+
+// Initializes the statistics of every channel
+// @param emaAlpha: Smoothing factor of the moving averages
+void initStatistics(float emaAlpha)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        resetWelford(&channelStats[i].window);
+        initExtremum(&channelStats[i].min, 0);
+        initExtremum(&channelStats[i].max, 1);
+        initEma(&channelStats[i].ema, emaAlpha);
+        initP2(&channelStats[i].pLow, STATS_P_LOW);
+        initP2(&channelStats[i].pHigh, STATS_P_HIGH);
+    }
+}
+
+// Adds the valid channels of a sample set to the statistics
+// @param set: Sample set taken during the last measurement cycle
+// @param nowMs: Time of the measurement in milliseconds
+void updateStatistics(const t_sampleSet *set, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Value being accumulated
+    float x;
+
+    /* --------------------- ACCUMULATION --------------------- */
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (!(set->validMask & (1UL << i)))
+        {
+            continue;
+        }
+
+        x = (float)set->value[i];
+
+        updateWelford(&channelStats[i].window, x);
+        pushExtremum(&channelStats[i].min, x, nowMs);
+        pushExtremum(&channelStats[i].max, x, nowMs);
+        updateEma(&channelStats[i].ema, x);
+        updateP2(&channelStats[i].pLow, x);
+        updateP2(&channelStats[i].pHigh, x);
+    }
+}
+
+// Builds the summary of a channel over the current window
+// @param channel: Channel to summarise
+// @param nowMs: Current time in milliseconds
+// @param summary: Pointer to structure where the summary will be stored
+// @return: 1 if the window holds samples for this channel, 0 otherwise
+uint8_t getStatisticsSummary(e_channel channel, uint32_t nowMs, t_channelSummary *summary)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Statistics of the requested channel
+    t_channelStats *stats;
+
+    /* -------------------- SUMMARY BUILDING -------------------- */
+
+    if (channel >= CH_COUNT || channelStats[channel].window.count == 0)
+    {
+        return 0;
+    }
+
+    stats = &channelStats[channel];
+
+    summary->count = stats->window.count;
+    summary->mean = stats->window.mean;
+    summary->stddev = sqrtf(getWelfordVariance(&stats->window));
+    summary->ema = stats->ema.value;
+    summary->pLow = getP2(&stats->pLow);
+    summary->pHigh = getP2(&stats->pHigh);
+
+    // Fall back to the mean if the sliding window has already expired
+    if (!getExtremum(&stats->min, nowMs, STATS_WINDOW_MS, &summary->min))
+    {
+        summary->min = summary->mean;
+    }
+
+    if (!getExtremum(&stats->max, nowMs, STATS_WINDOW_MS, &summary->max))
+    {
+        summary->max = summary->mean;
+    }
+
+    return 1;
+}
+
+// Starts a new aggregation window (mean, variance and percentiles)
+void resetStatisticsWindow()
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        resetWelford(&channelStats[i].window);
+        initP2(&channelStats[i].pLow, STATS_P_LOW);
+        initP2(&channelStats[i].pHigh, STATS_P_HIGH);
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Parabolic prediction of a P-square marker height
+static float p2Parabolic(const t_p2 *e, uint8_t i, int32_t d)
+{
+    const float n0 = (float)e->n[i - 1];
+    const float n1 = (float)e->n[i];
+    const float n2 = (float)e->n[i + 1];
+
+    return e->q[i] + (float)d / (n2 - n0) *
+                         ((n1 - n0 + (float)d) * (e->q[i + 1] - e->q[i]) / (n2 - n1) +
+                          (n2 - n1 - (float)d) * (e->q[i] - e->q[i - 1]) / (n1 - n0));
+}
+
+// Linear prediction of a P-square marker height
+static float p2Linear(const t_p2 *e, uint8_t i, int32_t d)
+{
+    return e->q[i] + (float)d * (e->q[i + d] - e->q[i]) / (float)(e->n[i + d] - e->n[i]);
+}
+
+// Places the P-square markers on the sorted observations
+static void p2Start(t_p2 *e)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Last index of the sorted buffer
+    const float last = (float)(STATS_P2_EXACT - 1);
+
+    /* ------------------- MARKER PLACEMENT ------------------- */
+
+    e->np[0] = 0.0f;
+    e->np[1] = last * e->p / 2.0f;
+    e->np[2] = last * e->p;
+    e->np[3] = last * (1.0f + e->p) / 2.0f;
+    e->np[4] = last;
+
+    // Each marker at the rank it should have, kept strictly increasing
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        e->n[i] = (int32_t)(e->np[i] + 0.5f);
+
+        if (i > 0 && e->n[i] <= e->n[i - 1])
+        {
+            e->n[i] = e->n[i - 1] + 1;
+        }
+    }
+
+    for (uint8_t i = 5; i-- > 0;)
+    {
+        if (i < 4 && e->n[i] >= e->n[i + 1])
+        {
+            e->n[i] = e->n[i + 1] - 1;
+        }
+
+        e->q[i] = e->exact[e->n[i]];
+    }
+}
@@ -0,0 +1,165 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef STATISTICS_hpp
+#define STATISTICS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Channel definitions and sample sets
+#include "Channels.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Length of the aggregation window in milliseconds
+#define STATS_WINDOW_MS 10000UL
+
+// Maximum number of entries kept by each min/max deque
+#define STATS_DEQUE_SIZE 32
+
+// Default smoothing factor of the exponential moving average
+#define STATS_EMA_ALPHA 0.2f
+
+// Percentiles tracked with the P-square estimator
+#define STATS_P_LOW  0.50f
+#define STATS_P_HIGH 0.95f
+
+// Observations kept sorted before the P-square estimator takes over. A
+// summary window holds about 5 samples, the five markers alone would
+// report the median for every percentile
+#define STATS_P2_EXACT 32
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Running mean and variance (Welford's algorithm)
+typedef struct
+{
+    uint32_t count;
+    float mean;
+    float m2;
+
+} t_welford;
+
+// Sliding-window minimum or maximum kept in a monotonic deque
+typedef struct
+{
+    float value[STATS_DEQUE_SIZE];
+    uint32_t time[STATS_DEQUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+
+    // 1 to track the maximum, 0 to track the minimum
+    uint8_t isMax;
+
+} t_extremum;
+
+// Exponential moving average
+typedef struct
+{
+    float value;
+    float alpha;
+    uint8_t primed;
+
+} t_ema;
+
+// P-square streaming percentile estimator (Jain & Chlamtac), exact over
+// the first STATS_P2_EXACT observations
+typedef struct
+{
+    float p;
+    float exact[STATS_P2_EXACT];
+    float q[5];
+    float np[5];
+    int32_t n[5];
+    uint32_t count;
+
+} t_p2;
+
+// Statistics tracked for one channel
+typedef struct
+{
+    t_welford window;
+    t_extremum min;
+    t_extremum max;
+    t_ema ema;
+    t_p2 pLow;
+    t_p2 pHigh;
+
+} t_channelStats;
+
+// Summary of one channel over the current window
+typedef struct
+{
+    uint32_t count;
+    float mean;
+    float stddev;
+    float min;
+    float max;
+    float ema;
+    float pLow;
+    float pHigh;
+
+} t_channelSummary;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Resets a Welford accumulator
+void resetWelford(t_welford *w);
+
+// Adds a value to a Welford accumulator
+void updateWelford(t_welford *w, float x);
+
+// Returns the sample variance of a Welford accumulator
+float getWelfordVariance(const t_welford *w);
+
+// Initializes a sliding-window extremum
+// @param isMax: 1 to track the maximum, 0 for the minimum
+void initExtremum(t_extremum *e, uint8_t isMax);
+
+// Adds a timestamped value to a sliding-window extremum
+void pushExtremum(t_extremum *e, float x, uint32_t nowMs);
+
+// Returns the extremum over the last windowMs milliseconds
+// @return: 1 if the window holds at least one value, 0 otherwise
+uint8_t getExtremum(t_extremum *e, uint32_t nowMs, uint32_t windowMs, float *out);
+
+// Initializes an exponential moving average
+void initEma(t_ema *e, float alpha);
+
+// Adds a value to an exponential moving average and returns it
+float updateEma(t_ema *e, float x);
+
+// Initializes a P-square estimator for percentile p (0..1)
+void initP2(t_p2 *e, float p);
+
+// Adds a value to a P-square estimator
+void updateP2(t_p2 *e, float x);
+
+// Returns the current percentile estimate
+float getP2(const t_p2 *e);
+
+// Initializes the statistics of every channel
+// @param emaAlpha: Smoothing factor of the moving averages
+void initStatistics(float emaAlpha);
+
+// Adds the valid channels of a sample set to the statistics
+// @param set: Sample set taken during the last measurement cycle
+// @param nowMs: Time of the measurement in milliseconds
+void updateStatistics(const t_sampleSet *set, uint32_t nowMs);
+
+// Builds the summary of a channel over the current window
+// @param channel: Channel to summarise
+// @param nowMs: Current time in milliseconds
+// @param summary: Pointer to structure where the summary will be stored
+// @return: 1 if the window holds samples for this channel, 0 otherwise
+uint8_t getStatisticsSummary(e_channel channel, uint32_t nowMs, t_channelSummary *summary);
+
+// Starts a new aggregation window (mean, variance and percentiles)
+void resetStatisticsWindow();
+
+#endif // STATISTICS_hpp
@@ -4,6 +4,7 @@
 
     This file handles Bluetooth communication for the AeroSense system.
     It initializes the Bluetooth module, manages commands, and sends data.
+    Each new connection starts with a hello line identifying the unit.
 
 */
 
@@ -21,11 +22,77 @@
 #include "esp_bt.h"
 #endif
 
+// strtoull(), strtoul() and strtol() to parse the time replies and the command arguments
+#include <stdlib.h>
+
+// Unique name of the unit
+#include "../system/Identity.hpp"
+
+// Soft-AP server of the recorded sessions
+#include "LogServer.hpp"
+
+// Boot steps and their timing
+#include "../system/Boot.hpp"
+
+// Burst window of the plume detector, set with the 'E' command
+#include "../processing/Events.hpp"
+
+// Mission profile, frame version and compression, reported in the hello line
+#include "../config/Profile.hpp"
+#include "Frame.hpp"
+#include "Compress.hpp"
+
+// Recorded sessions, used by the compression benchmark
+#include "../storage/Recorder.hpp"
+
+// Parity level of the swarm frames, set with the 'F' command
+#include "Fec.hpp"
+
+// Compensation matrix of the MQ sensors, uploaded with the 'M' command
+#include "../processing/Compensation.hpp"
+
+// Timing of the sampler tick, reported with the 'J' command
+#include "../system/Sampler.hpp"
+
 /* ---------------------- GLOBAL VARIABLES ---------------------- */
 
 // Bluetooth serial object for communication
 BluetoothSerial SerialBT;
 
+// Set while a host is connected, and number of connections since boot
+static uint8_t clientConnected = 0;
+static uint16_t connectionCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Parses the reply of the host to a time synchronisation ping
+// @param receivedUs: Local time the reply started to arrive
+static void handleTimePong(uint64_t receivedUs);
+
+// Starts or stops the log download server and reports where to reach it
+// @param enable: 1 to start the server, 0 to stop it
+static void handleLogServer(uint8_t enable);
+
+// Sets the burst window of the plume detector from "E<seconds>"
+static void handleEventWindow();
+
+// Switches the compression of the recorded and uplinked frames from "Z<0|1>"
+static void handleCompression();
+
+// Benchmarks the compression on the last complete recorded session
+static void handleCompressionBench();
+
+// Sets the parity level of the swarm frames from "F<group size>,<depth>"
+static void handleFecLevel();
+
+// Uploads one gas of the compensation matrix from "M<gas>,<c0>,...,<c6>",
+// restores the default one from "MD" or reports it from a bare 'M'
+static void handleGasMatrix();
+
+// Reports the jitter of the sampler tick and the skew of each analog input
+// since the last report
+static void handleSamplerReport();
+
 
 /* *****************************************************************
     *                      INIT COMMUNICATION                     *
@@ -54,12 +121,19 @@ int initCommBT()
     }
 #endif
 
-    // Start Bluetooth communication with the name "AeroSense"
-    if (!SerialBT.begin("AeroSense"))
+    // Each unit advertises its own name ("AeroSense-XXXX") so several
+    // units can be told apart by the host
+    char deviceName[DEVICE_NAME_SIZE];
+    getDeviceName(deviceName, sizeof(deviceName));
+
+    if (!SerialBT.begin(deviceName))
     {
         return 0;
     }
 
+    // Command arguments follow the command byte immediately
+    SerialBT.setTimeout(BT_LINE_TIMEOUT_MS);
+
     // Indicate successful startup
     SerialBT.print("STARTED");
 
@@ -81,6 +155,23 @@ void handleBT(uint8_t *xEnableMeasuring)
     // Temporary variable to hold incoming data
     uint8_t data;
 
+    // Arrival time of the command, used by the time synchronisation
+    uint64_t receivedUs;
+
+    /* ------------------- CONNECTION HANDLING ------------------- */
+
+    // A new host learns who it talks to before any data
+    if (SerialBT.hasClient() != (bool)clientConnected)
+    {
+        clientConnected = !clientConnected;
+
+        if (clientConnected)
+        {
+            connectionCount++;
+            sendHello();
+        }
+    }
+
     /* --------------------- DATA HANDLING ------------------------ */
 
     // Check if data is available from Bluetooth
@@ -90,6 +181,7 @@ void handleBT(uint8_t *xEnableMeasuring)
     }
 
     // Read incoming data
+    receivedUs = getTimeUs();
     data = SerialBT.read();
 
     // Process data if it is not a line break
@@ -101,13 +193,80 @@ void handleBT(uint8_t *xEnableMeasuring)
     // Map commands to corresponding actions
     if (data == '1')
     {
-        *xEnableMeasuring = 1;
+        *xEnableMeasuring = MEASURE_RAW;
         SerialBT.print("START MEASURING \n");
     }
 
+    else if (data == '2')
+    {
+        *xEnableMeasuring = MEASURE_SUMMARY;
+        SerialBT.print("START SUMMARY \n");
+    }
+
+    else if (data == '3')
+    {
+        *xEnableMeasuring = MEASURE_SCAN;
+        SerialBT.print("START GAS SCAN \n");
+    }
+
+    else if (data == 'P')
+    {
+        handleTimePong(receivedUs);
+    }
+
+    else if (data == 'W')
+    {
+        handleLogServer(1);
+    }
+
+    else if (data == 'w')
+    {
+        handleLogServer(0);
+    }
+
+    else if (data == 'B')
+    {
+        sendBootReport();
+    }
+
+    else if (data == 'H')
+    {
+        sendHello();
+    }
+
+    else if (data == 'E')
+    {
+        handleEventWindow();
+    }
+
+    else if (data == 'Z')
+    {
+        handleCompression();
+    }
+
+    else if (data == 'C')
+    {
+        handleCompressionBench();
+    }
+
+    else if (data == 'F')
+    {
+        handleFecLevel();
+    }
+
+    else if (data == 'M')
+    {
+        handleGasMatrix();
+    }
+
+    else if (data == 'J')
+    {
+        handleSamplerReport();
+    }
+
     else if (data == '0')
     {
-        *xEnableMeasuring = 0;
+        *xEnableMeasuring = MEASURE_OFF;
         SerialBT.print("STOP MEASURING \n");
     }
 }
@@ -154,6 +313,267 @@ void sendData(String nom, uint16_t data, String unidad, uint8_t CR)
 }
 
 
+// Sends a signed or 32-bit value via Bluetooth, sendData() only carries 16 bits
+// Parameters:
+// - nom: Name of the data
+// - data: Data value
+// - unidad: Unit of the data, "" for none
+// - CR: Flag to indicate whether to add a newline (1) or separator (0)
+void sendLongData(const char *nom, int64_t data, const char *unidad, uint8_t CR)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[60];
+
+    // Same layout as sendData(), no space between the name and the value
+    snprintf(buffer, sizeof(buffer), "%s%lld%s", nom, (long long)data, unidad);
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+
+    if (CR)
+    {
+        SerialBT.println();
+        Serial.println();
+    }
+}
+
+
+/* *****************************************************************
+    *                    SEND SUMMARY FUNCTION                    *
+   ***************************************************************** */
+
+// Sends the summary of a channel via Bluetooth
+// Parameters:
+// - nom: Name of the data
+// - summary: Statistics of the channel over the last window
+// - unidad: Unit of the data
+void sendSummary(const char *nom, const t_channelSummary *summary, const char *unidad)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[160];
+
+    snprintf(buffer, sizeof(buffer),
+             "%s n=%lu mean=%.1f sd=%.1f min=%.1f max=%.1f ema=%.1f p50=%.1f p95=%.1f %s",
+             nom, (unsigned long)summary->count, summary->mean, summary->stddev,
+             summary->min, summary->max, summary->ema, summary->pLow, summary->pHigh, unidad);
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+}
+
+
+/* *****************************************************************
+    *                     SEND STATUS FUNCTION                    *
+   ***************************************************************** */
+
+// Sends a status text in place of a value via Bluetooth
+// Parameters:
+// - nom: Name of the data
+// - status: Status text replacing the value (e.g. "PREHEAT")
+// - CR: Flag to indicate whether to add a newline (1) or separator (0)
+void sendStatus(const char *nom, const char *status, uint8_t CR)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[60];
+
+    snprintf(buffer, sizeof(buffer), "%s%s", nom, status);
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+
+    // Optional blank line when CR is set
+    if (CR)
+    {
+        SerialBT.println();
+        Serial.println();
+    }
+}
+
+
+/* *****************************************************************
+    *                     SEND SCAN FUNCTION                      *
+   ***************************************************************** */
+
+// Sends a gas resistance vector, one value per heater temperature
+// Parameters:
+// - nom: Name of the data
+// - temps: Heater temperature of each step in degrees Celsius
+// - values: Gas resistance of each step in ohms
+// - count: Number of steps
+// - validMask: One bit per step, steps with invalid readings are marked '?'
+void sendScan(const char *nom, const uint16_t *temps, const uint32_t *values,
+              uint8_t count, uint16_t validMask)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[200];
+
+    // Number of characters already written
+    int length;
+
+    length = snprintf(buffer, sizeof(buffer), "%s", nom);
+
+    for (uint8_t i = 0; i < count && length < (int)sizeof(buffer); i++)
+    {
+        length += snprintf(buffer + length, sizeof(buffer) - length, " %uC=%lu%s",
+                           temps[i], (unsigned long)values[i],
+                           (validMask & (1U << i)) ? "" : "?");
+    }
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+}
+
+
+/* *****************************************************************
+    *                   SEND TIMESTAMP FUNCTION                   *
+   ***************************************************************** */
+
+// Sends a 64-bit time in microseconds via Bluetooth
+// Parameters:
+// - nom: Name of the data
+// - timeUs: Time in microseconds
+// - CR: Flag to indicate whether to add a newline (1) or separator (0)
+void sendTimestamp(const char *nom, uint64_t timeUs, uint8_t CR)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[60];
+
+    snprintf(buffer, sizeof(buffer), "%s%llu", nom, (unsigned long long)timeUs);
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+
+    // Optional blank line when CR is set
+    if (CR)
+    {
+        SerialBT.println();
+        Serial.println();
+    }
+}
+
+
+/* *****************************************************************
+    *                   SEND TIME PING FUNCTION                   *
+   ***************************************************************** */
+
+// Sends a time synchronisation ping, answered by "P<sent>,<host UTC>"
+// Parameters:
+// - sentUs: Local time of the ping, echoed back by the host
+void sendTimePing(uint64_t sentUs)
+{
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    // Create the buffer for formatting
+    char buffer[40];
+
+    // Only sent over Bluetooth, the host is the one answering
+    snprintf(buffer, sizeof(buffer), "PING:%llu", (unsigned long long)sentUs);
+    SerialBT.println(buffer);
+}
+
+
+/* *****************************************************************
+    *                  SEND BOOT REPORT FUNCTION                  *
+   ***************************************************************** */
+
+// Sends the duration of every boot step and the time of the first sample
+void sendBootReport()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Step being reported and its label
+    const t_bootStep *step;
+    char label[24];
+
+    // End of the last step
+    uint32_t bootMs = 0;
+
+    /* ------------------- REPORT TRANSMISSION ------------------- */
+
+    sendSectionHeader("BOOT");
+
+    for (uint8_t i = 0; i < getBootStepCount(); i++)
+    {
+        step = getBootStep(i);
+        snprintf(label, sizeof(label), "%s:", step->name);
+
+        // Steps run side by side, so durations do not add up
+        if (step->state == BOOT_READY)
+        {
+            sendLongData(label, step->endMs - step->startMs, "ms", 0);
+        }
+        else
+        {
+            sendStatus(label, getBootStateName((e_bootState)step->state), 0);
+        }
+
+        if (step->state != BOOT_PENDING && step->state != BOOT_RUNNING && step->endMs > bootMs)
+        {
+            bootMs = step->endMs;
+        }
+    }
+
+    // Times since power-on
+    if (getFirstSampleMs())
+    {
+        sendLongData("FIRST SAMPLE:", getFirstSampleMs(), "ms", 0);
+    }
+    else
+    {
+        sendStatus("FIRST SAMPLE:", "NONE", 0);
+    }
+
+    if (isBootComplete())
+    {
+        sendLongData("BOOT:", bootMs, "ms", 1);
+    }
+    else
+    {
+        sendStatus("BOOT:", "RUNNING", 1);
+    }
+}
+
+
+/* *****************************************************************
+    *                     SEND HELLO FUNCTION                     *
+   ***************************************************************** */
+
+// Sends the identification line of the unit, on every new connection and
+// on the 'H' command, so a host reading many units can tell the streams apart
+void sendHello()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Name of the unit and the line sent
+    char name[DEVICE_NAME_SIZE];
+    char buffer[128];
+
+    /* ------------------- DATA TRANSMISSION ------------------- */
+
+    getDeviceName(name, sizeof(name));
+
+    // One line of comma-separated key=value fields, the local time lets
+    // the host map the sample times to its own clock
+    snprintf(buffer, sizeof(buffer),
+             "HELLO:%s,node=%04X,profile=%s,frame=%u,lz=%u,build=%s,conn=%u,time=%llu", name,
+             getNodeId(), PROFILE_NAME, FRAME_VERSION, isCompressionEnabled(), BT_FIRMWARE_BUILD,
+             connectionCount, (unsigned long long)getTimeUs());
+
+    SerialBT.println(buffer);
+    Serial.println(buffer);
+}
+
+
 /* *****************************************************************
     *                    SECTION HEADER FUNCTION                  *
    ***************************************************************** */
@@ -176,3 +596,284 @@ void sendSectionHeader(const char *sectionName)
     Serial.println(divider);
 }
 
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Parses the reply of the host to a time synchronisation ping
+static void handleTimePong(uint64_t receivedUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rest of the command line: "<sent>,<host UTC>"
+    char line[48];
+
+    // Length of the line and end of the first number
+    size_t length;
+    char *end;
+
+    // Times carried by the reply
+    uint64_t sentUs, hostUs;
+
+    /* -------------------- REPLY PARSING -------------------- */
+
+    length = SerialBT.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+
+    sentUs = strtoull(line, &end, 10);
+    if (end == line || *end != ',')
+    {
+        return;
+    }
+
+    hostUs = strtoull(end + 1, NULL, 10);
+
+    submitTimePong(sentUs, hostUs, receivedUs);
+}
+
+// Starts or stops the log download server and reports where to reach it
+static void handleLogServer(uint8_t enable)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Name of the soft-AP and address of the server
+    char ssid[DEVICE_NAME_SIZE];
+    char address[16];
+
+    /* -------------------- SERVER CONTROL -------------------- */
+
+    if (!enable)
+    {
+        stopLogServer();
+        SerialBT.print("LOG SERVER OFF \n");
+        return;
+    }
+
+    if (!startLogServer())
+    {
+        SerialBT.print("LOG SERVER FAILED \n");
+        return;
+    }
+
+    getDeviceName(ssid, sizeof(ssid));
+    getLogServerAddress(address, sizeof(address));
+    SerialBT.printf("LOG SERVER %s http://%s/sessions \n", ssid, address);
+}
+
+// Sets the burst window of the plume detector from "E<seconds>"
+static void handleEventWindow()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rest of the command line and window in seconds
+    char line[12];
+    size_t length;
+    unsigned long seconds;
+
+    /* -------------------- WINDOW PARSING -------------------- */
+
+    length = SerialBT.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+
+    // 0 or no number restores the default window
+    seconds = strtoul(line, NULL, 10);
+    setEventBurstWindow(seconds * 1000UL);
+
+    SerialBT.printf("EVENT WINDOW %lu s \n",
+                    seconds ? seconds : (unsigned long)(EVENT_BURST_MS / 1000UL));
+}
+
+// Switches the compression of the recorded and uplinked frames from "Z<0|1>"
+static void handleCompression()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rest of the command line
+    char line[4];
+    size_t length;
+
+    /* -------------------- SETTING -------------------- */
+
+    length = SerialBT.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+
+    // A bare 'Z' only reports the setting, the host reads it before decoding
+    if (line[0] == '0' || line[0] == '1')
+    {
+        setCompressionEnabled(line[0] == '1');
+    }
+
+    SerialBT.printf("COMPRESSION %s \n", isCompressionEnabled() ? "ON" : "OFF");
+}
+
+// Benchmarks the compression on the last complete recorded session
+static void handleCompressionBench()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Two most recent sessions, the newest may still be recording
+    t_sessionInfo sessions[2];
+    uint8_t count;
+    uint8_t index;
+
+    // Results of the benchmark
+    t_compressStats stats;
+
+    /* -------------------- BENCHMARK -------------------- */
+
+    count = listSessions(sessions, 2);
+    index = count - 1;
+
+    if (count > 1 && sessions[index].active)
+    {
+        index--;
+    }
+
+    if (count == 0 || !benchmarkSession(sessions[index].id, &stats) || stats.rawBytes == 0)
+    {
+        SerialBT.print("COMPRESSION BENCH UNAVAILABLE \n");
+        return;
+    }
+
+    // Bytes per millisecond are KB/s
+    SerialBT.printf("COMPRESSION BENCH session=%u blocks=%lu raw=%lu packed=%lu ratio=%.2f "
+                    "compress=%lu KB/s decompress=%lu KB/s errors=%lu \n",
+                    sessions[index].id, (unsigned long)stats.blocks,
+                    (unsigned long)stats.rawBytes, (unsigned long)stats.packedBytes,
+                    (float)stats.rawBytes / stats.packedBytes,
+                    (unsigned long)(stats.rawBytes * 1000ULL / (stats.compressUs + 1)),
+                    (unsigned long)(stats.rawBytes * 1000ULL / (stats.decompressUs + 1)),
+                    (unsigned long)stats.errors);
+}
+
+// Sets the parity level of the swarm frames from "F<group size>,<depth>"
+static void handleFecLevel()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rest of the command line and its fields
+    char line[12];
+    size_t length;
+    char *end;
+    unsigned long groupSize, depth = 1;
+
+    /* -------------------- LEVEL PARSING -------------------- */
+
+    length = SerialBT.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+
+    // "F0" stops the parity, a missing depth means no interleaving
+    groupSize = strtoul(line, &end, 10);
+    if (*end == ',')
+    {
+        depth = strtoul(end + 1, NULL, 10);
+    }
+
+    if (end == line || groupSize > 255 || depth > 255 || !setFecLevel(groupSize, depth))
+    {
+        SerialBT.print("FEC INVALID \n");
+        return;
+    }
+
+    // Overhead is one parity frame per group size frames
+    SerialBT.printf("FEC GROUP %u DEPTH %u \n", getFecGroupSize(), getFecDepth());
+}
+
+// Uploads one gas of the compensation matrix from "M<gas>,<c0>,...,<c6>",
+// restores the default one from "MD" or reports it from a bare 'M'
+static void handleGasMatrix()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rest of the command line and its fields
+    char line[96];
+    size_t length;
+    char *field;
+    char *end;
+    unsigned long gas;
+
+    // Coefficients of one gas, Q16 as fitted on the host
+    int32_t coeffs[COMP_INPUTS];
+    uint8_t count = 0;
+
+    /* -------------------- ROW PARSING -------------------- */
+
+    length = SerialBT.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+
+    if (line[0] == 'D')
+    {
+        resetCompensation();
+    }
+
+    else if (length > 0 && line[0] != '\r')
+    {
+        gas = strtoul(line, &end, 10);
+        field = (end == line) ? NULL : end;
+
+        // The fit sends every input, a missing one is an error, not a zero
+        while (field && *field == ',' && count < COMP_INPUTS)
+        {
+            coeffs[count++] = strtol(field + 1, &end, 10);
+            field = (end == field + 1) ? NULL : end;
+        }
+
+        if (!field || count != COMP_INPUTS || gas > 255 || !setCompensationRow(gas, coeffs))
+        {
+            SerialBT.print("GAS MATRIX INVALID \n");
+            return;
+        }
+    }
+
+    /* -------------------- REPORT -------------------- */
+
+    for (uint8_t row = 0; row < COMP_OUTPUTS; row++)
+    {
+        getCompensationRow(row, coeffs);
+        SerialBT.printf("GAS MATRIX %u", row);
+
+        for (uint8_t in = 0; in < COMP_INPUTS; in++)
+        {
+            SerialBT.printf(",%ld", (long)coeffs[in]);
+        }
+
+        SerialBT.print(" \n");
+    }
+}
+
+// Reports the jitter of the sampler tick and the skew of each analog input
+// since the last report
+static void handleSamplerReport()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Timing since the last report
+    t_samplerStats stats;
+
+    /* -------------------- REPORT -------------------- */
+
+    getSamplerStats(&stats);
+    resetSamplerStats();
+
+    if (stats.ticks == 0)
+    {
+        SerialBT.print("SAMPLER UNAVAILABLE \n");
+        return;
+    }
+
+    // Jitter of the tick period, then age of the snapshots when measured
+    SerialBT.printf("SAMPLER ticks=%lu period=%u ms jitter=%ld..%ld mean=%lu us "
+                    "latch=%lu max=%lu us \n",
+                    (unsigned long)stats.ticks, (unsigned)SAMPLER_TICK_MS, (long)stats.jitterMinUs,
+                    (long)stats.jitterMaxUs, (unsigned long)stats.jitterMeanUs,
+                    (unsigned long)stats.latchAgeMeanUs, (unsigned long)stats.latchAgeMaxUs);
+
+    // Skew of each conversion from the tick
+    for (uint8_t i = 0; i < stats.pinCount; i++)
+    {
+        SerialBT.printf("SAMPLER GPIO%d skew=%lu max=%lu us \n", stats.pins[i].pin,
+                        (unsigned long)stats.pins[i].skewMeanUs,
+                        (unsigned long)stats.pins[i].skewMaxUs);
+    }
+}
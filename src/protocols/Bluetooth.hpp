@@ -14,6 +14,26 @@
 // Provides fixed-width integer types
 #include <stdint.h>
 
+// Channel summaries sent in summary mode
+#include "../processing/Statistics.hpp"
+
+// Time base synchronised with the host pings
+#include "../system/Timebase.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Longest time spent waiting for the rest of a command line
+#define BT_LINE_TIMEOUT_MS 20
+
+// Build of the firmware, reported in the hello line
+#define BT_FIRMWARE_BUILD __DATE__ " " __TIME__
+
+// Measurement modes selected with the Bluetooth commands '0' to '3'
+#define MEASURE_OFF     0
+#define MEASURE_RAW     1
+#define MEASURE_SUMMARY 2
+#define MEASURE_SCAN    3
+
 /* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
 
 // Initializes the Bluetooth communication module
@@ -25,6 +45,32 @@ void handleBT(uint8_t *xEnableMeasuring);
 // Sends data via Bluetooth
 void sendData(String nom, uint16_t data, String unidad, uint8_t CR);
 
+// Sends a signed or 32-bit value via Bluetooth, sendData() only carries 16 bits
+void sendLongData(const char *nom, int64_t data, const char *unidad, uint8_t CR);
+
+// Sends the summary of a channel via Bluetooth
+void sendSummary(const char *nom, const t_channelSummary *summary, const char *unidad);
+
+// Sends a status text in place of a value via Bluetooth
+void sendStatus(const char *nom, const char *status, uint8_t CR);
+
+// Sends a gas resistance vector, one value per heater temperature
+void sendScan(const char *nom, const uint16_t *temps, const uint32_t *values,
+              uint8_t count, uint16_t validMask);
+
+// Sends a 64-bit time in microseconds via Bluetooth
+void sendTimestamp(const char *nom, uint64_t timeUs, uint8_t CR);
+
+// Sends a time synchronisation ping, answered by "P<sent>,<host UTC>"
+void sendTimePing(uint64_t sentUs);
+
+// Sends the duration of every boot step and the time of the first sample
+void sendBootReport();
+
+// Sends the identification line of the unit, on every new connection and
+// on the 'H' command, so a host reading many units can tell the streams apart
+void sendHello();
+
 // Prints a section header to Serial and Bluetooth outputs
 void sendSectionHeader(const char *sectionName);
 
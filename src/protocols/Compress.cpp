@@ -0,0 +1,261 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file compresses blocks of frames before they are written
+    to flash or sent over Wi-Fi, where bandwidth and space run out
+    long before the CPU does. It is a small LZSS: the match finder
+    keeps the last position of each 3-byte sequence in a fixed hash
+    table, with no search chains, so both the memory and the time
+    per byte are bounded. The format is simple enough to decode on
+    the host in a few lines, and this file builds there unchanged.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the block compressor
+#include "Compress.hpp"
+
+// memset() to clear the match finder
+#include <string.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Compression of the recorded and uplinked frames
+static uint8_t enabled = COMPRESS_DEFAULT_ENABLED;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Hashes the 3 bytes starting at a position
+// @param data: First byte of the sequence
+// @return: Entry of the match finder
+static uint16_t hashSequence(const uint8_t *data);
+
+
+/* *****************************************************************
+    *                     COMPRESSION FUNCTION                    *
+   ***************************************************************** */
+
+// Compresses a block with LZSS: groups of 8 tokens behind a flag byte,
+// each token a literal byte or a 2-byte back reference
+// @param input: Data to compress
+// @param length: Number of bytes, below 65535
+// @param output: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the compressed block, 0 if it does not fit or is not
+// smaller than the input
+uint16_t compressBlock(const uint8_t *input, uint16_t length, uint8_t *output, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Last position of each hashed sequence plus one, 0 if none yet
+    uint16_t head[COMPRESS_HASH_SIZE];
+
+    // Read and write positions
+    uint16_t in = 0;
+    uint16_t out = 0;
+
+    // Flag byte of the current group and its next bit, 8 opens a new group
+    uint16_t flagPos = 0;
+    uint8_t flagBit = 8;
+
+    // Match found at the read position
+    uint16_t candidate, distance = 0, match, maxMatch, token, hash;
+
+    /* -------------------- TOKENS -------------------- */
+
+    memset(head, 0, sizeof(head));
+
+    while (in < length)
+    {
+        if (flagBit == 8)
+        {
+            if (out >= size)
+            {
+                return 0;
+            }
+
+            flagPos = out;
+            output[out++] = 0;
+            flagBit = 0;
+        }
+
+        match = 0;
+
+        if (length - in >= COMPRESS_MIN_MATCH)
+        {
+            hash = hashSequence(input + in);
+            candidate = head[hash];
+            head[hash] = in + 1;
+
+            // A single candidate, checked rather than trusted
+            if (candidate && in - (candidate - 1) <= COMPRESS_WINDOW_SIZE)
+            {
+                candidate--;
+                distance = in - candidate;
+                maxMatch = (length - in < COMPRESS_MAX_MATCH) ? length - in : COMPRESS_MAX_MATCH;
+
+                while (match < maxMatch && input[candidate + match] == input[in + match])
+                {
+                    match++;
+                }
+            }
+        }
+
+        if (match >= COMPRESS_MIN_MATCH)
+        {
+            if (out + 2 > size)
+            {
+                return 0;
+            }
+
+            token = ((distance - 1) << 4) | (match - COMPRESS_MIN_MATCH);
+            output[out++] = token & 0xFF;
+            output[out++] = token >> 8;
+
+            // The sequences inside the match can be referred to as well
+            for (uint16_t i = 1; i < match && in + i + COMPRESS_MIN_MATCH <= length; i++)
+            {
+                head[hashSequence(input + in + i)] = in + i + 1;
+            }
+
+            in += match;
+        }
+
+        else
+        {
+            if (out >= size)
+            {
+                return 0;
+            }
+
+            output[flagPos] |= 1 << flagBit;
+            output[out++] = input[in++];
+        }
+
+        flagBit++;
+    }
+
+    // Not worth it, the caller keeps the input as it is
+    return (out < length) ? out : 0;
+}
+
+
+/* *****************************************************************
+    *                    DECOMPRESSION FUNCTION                   *
+   ***************************************************************** */
+
+// Decompresses a block made by compressBlock()
+// @param input: Compressed block
+// @param length: Length of the compressed block
+// @param output: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the data, 0 if the block is corrupted or does not fit
+uint16_t decompressBlock(const uint8_t *input, uint16_t length, uint8_t *output, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Read and write positions
+    uint16_t in = 0;
+    uint16_t out = 0;
+
+    // Flag byte of the current group and its next bit
+    uint8_t flags = 0;
+    uint8_t flagBit = 8;
+
+    // Back reference being copied
+    uint16_t token, distance, match;
+
+    /* -------------------- TOKENS -------------------- */
+
+    while (in < length)
+    {
+        if (flagBit == 8)
+        {
+            flags = input[in++];
+            flagBit = 0;
+            continue;
+        }
+
+        if (flags & (1 << flagBit))
+        {
+            if (out >= size)
+            {
+                return 0;
+            }
+
+            output[out++] = input[in++];
+        }
+
+        else
+        {
+            if (in + 2 > length)
+            {
+                return 0;
+            }
+
+            token = input[in] | ((uint16_t)input[in + 1] << 8);
+            in += 2;
+
+            distance = (token >> 4) + 1;
+            match = (token & 0x0F) + COMPRESS_MIN_MATCH;
+
+            if (distance > out || out + match > size)
+            {
+                return 0;
+            }
+
+            // Byte by byte, a match may overlap the bytes it produces
+            for (uint16_t i = 0; i < match; i++, out++)
+            {
+                output[out] = output[out - distance];
+            }
+        }
+
+        flagBit++;
+    }
+
+    return out;
+}
+
+
+/* *****************************************************************
+    *                      SETTING FUNCTIONS                      *
+   ***************************************************************** */
+
+// Selects whether the frames recorded and uplinked are compressed
+void setCompressionEnabled(uint8_t enable)
+{
+    enabled = enable ? 1 : 0;
+}
+
+// Returns whether the frames recorded and uplinked are compressed
+uint8_t isCompressionEnabled()
+{
+    return enabled;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Hashes the 3 bytes starting at a position
+static uint16_t hashSequence(const uint8_t *data)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Multiplicative hash, the top bits are the best mixed
+    uint32_t product =
+        ((uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | data[2]) * 2654435761UL;
+
+    /* -------------------- ENTRY -------------------- */
+
+    return (uint16_t)(product >> (32 - COMPRESS_HASH_BITS));
+}
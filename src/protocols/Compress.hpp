@@ -0,0 +1,83 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef COMPRESS_hpp
+#define COMPRESS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// A match refers back at most this many bytes, on 12 bits
+#define COMPRESS_WINDOW_SIZE 4096
+
+// Shortest and longest match, the length is sent on 4 bits
+#define COMPRESS_MIN_MATCH 3
+#define COMPRESS_MAX_MATCH 18
+
+// Entries of the match finder, a power of two. The table is the only
+// working memory, 2 bytes per entry on the stack of the caller
+#define COMPRESS_HASH_BITS 9
+#define COMPRESS_HASH_SIZE (1 << COMPRESS_HASH_BITS)
+
+// Largest output for an input of n bytes, one flag byte per 8 literals
+#define COMPRESS_BOUND(n) ((n) + ((n) + 7) / 8)
+
+// Compression of the recorded and uplinked frames at boot, until the
+// saved setting is restored
+#define COMPRESS_DEFAULT_ENABLED 0
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Results of a compression benchmark
+typedef struct
+{
+    // Blocks tested and those not giving their input back
+    uint32_t blocks;
+    uint32_t errors;
+
+    // Bytes before and after compression, blocks that do not shrink are
+    // counted at their raw size as they would be stored
+    uint32_t rawBytes;
+    uint32_t packedBytes;
+
+    // Time spent compressing and decompressing
+    uint32_t compressUs;
+    uint32_t decompressUs;
+
+} t_compressStats;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Compresses a block with LZSS: groups of 8 tokens behind a flag byte,
+// each token a literal byte or a 2-byte back reference
+// @param input: Data to compress
+// @param length: Number of bytes, below 65535
+// @param output: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the compressed block, 0 if it does not fit or is not
+// smaller than the input
+uint16_t compressBlock(const uint8_t *input, uint16_t length, uint8_t *output, uint16_t size);
+
+// Decompresses a block made by compressBlock()
+// @param input: Compressed block
+// @param length: Length of the compressed block
+// @param output: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the data, 0 if the block is corrupted or does not fit
+uint16_t decompressBlock(const uint8_t *input, uint16_t length, uint8_t *output, uint16_t size);
+
+// Selects whether the frames recorded and uplinked are compressed
+// @param enable: 1 to compress, 0 to send them as they are
+void setCompressionEnabled(uint8_t enable);
+
+// Returns whether the frames recorded and uplinked are compressed
+// @return: 1 if enabled, 0 otherwise
+uint8_t isCompressionEnabled();
+
+#endif // COMPRESS_hpp
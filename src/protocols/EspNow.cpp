@@ -0,0 +1,212 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file connects the swarm logic to the ESP-NOW radio. Frames
+    are broadcast on a fixed channel, so nodes need no pairing with
+    the gateway. Received frames are copied into a small buffer by
+    the WiFi task and processed later from the main loop.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the ESP-NOW link
+#include "EspNow.hpp"
+
+// Swarm logic fed with the received frames
+#include "Swarm.hpp"
+
+// Arduino core, WiFi station and ESP-NOW driver
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+
+// Critical sections shared with the WiFi task
+#include <freertos/FreeRTOS.h>
+
+// memcpy() of the received frames
+#include <string.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Frame waiting to be processed by the loop
+typedef struct
+{
+    uint8_t length;
+    uint8_t data[SWARM_MAX_FRAME_SIZE];
+
+} t_espNowSlot;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Every unit of the swarm listens to the broadcast address
+static const uint8_t broadcastAddress[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF,
+                                                           0xFF, 0xFF, 0xFF};
+
+// Received frames, written by the WiFi task and read by the loop
+static t_espNowSlot rxSlots[ESPNOW_RX_SLOTS];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+static portMUX_TYPE rxMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Frames dropped because the loop did not keep up
+static volatile uint32_t overflowCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Stores a received frame until the loop processes it
+// @param data: Received frame
+// @param length: Length of the received frame
+static void storeFrame(const uint8_t *data, int length);
+
+// Receive callback, its signature changed with the 3.x core
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+static void onReceive(const esp_now_recv_info_t *info, const uint8_t *data, int length);
+#else
+static void onReceive(const uint8_t *mac, const uint8_t *data, int length);
+#endif
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Starts ESP-NOW and registers the broadcast peer
+// @return: 1 if successful, 0 otherwise
+int initEspNow()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Broadcast peer description
+    esp_now_peer_info_t peer;
+
+    /* -------------------- RADIO STARTUP -------------------- */
+
+    // ESP-NOW runs on the station interface, without joining a network
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();
+
+    if (esp_now_init() != ESP_OK)
+    {
+        return 0;
+    }
+
+    esp_now_register_recv_cb(onReceive);
+
+    /* -------------------- BROADCAST PEER -------------------- */
+
+    memset(&peer, 0, sizeof(peer));
+    memcpy(peer.peer_addr, broadcastAddress, ESP_NOW_ETH_ALEN);
+    peer.channel = ESPNOW_CHANNEL;
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+
+    if (!esp_now_is_peer_exist(broadcastAddress) && esp_now_add_peer(&peer) != ESP_OK)
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                       RADIO FUNCTIONS                       *
+   ***************************************************************** */
+
+// Broadcasts a frame to the swarm (t_swarmSend)
+// @param frame: Frame to send
+// @param length: Length of the frame
+// @return: 1 if the frame was queued, 0 otherwise
+uint8_t sendEspNow(const uint8_t *frame, uint8_t length)
+{
+    return esp_now_send(broadcastAddress, frame, length) == ESP_OK;
+}
+
+// Returns the number of frames dropped because the buffer was full
+uint32_t getEspNowOverflowCount()
+{
+    return overflowCount;
+}
+
+
+/* *****************************************************************
+    *                      SERVICE FUNCTION                       *
+   ***************************************************************** */
+
+// Hands the frames received since the last call to the gateway logic
+void serviceEspNow()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Copy of the frame, so the WiFi task can reuse the slot
+    t_espNowSlot slot;
+
+    /* -------------------- BUFFER DRAIN -------------------- */
+
+    while (rxTail != rxHead)
+    {
+        portENTER_CRITICAL(&rxMux);
+        slot = rxSlots[rxTail];
+        rxTail = (rxTail + 1) % ESPNOW_RX_SLOTS;
+        portEXIT_CRITICAL(&rxMux);
+
+        swarmGatewayReceive(slot.data, slot.length, millis());
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Stores a received frame until the loop processes it
+static void storeFrame(const uint8_t *data, int length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Slot following the head
+    uint8_t next;
+
+    /* -------------------- FRAME STORAGE -------------------- */
+
+    // Not one of our frames, skip it before taking the lock
+    if (length <= 0 || length > SWARM_MAX_FRAME_SIZE)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&rxMux);
+
+    next = (rxHead + 1) % ESPNOW_RX_SLOTS;
+
+    if (next == rxTail)
+    {
+        overflowCount++;
+    }
+
+    else
+    {
+        rxSlots[rxHead].length = (uint8_t)length;
+        memcpy(rxSlots[rxHead].data, data, length);
+        rxHead = next;
+    }
+
+    portEXIT_CRITICAL(&rxMux);
+}
+
+// Receive callback, runs in the WiFi task
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+static void onReceive(const esp_now_recv_info_t *info, const uint8_t *data, int length)
+#else
+static void onReceive(const uint8_t *mac, const uint8_t *data, int length)
+#endif
+{
+    storeFrame(data, length);
+}
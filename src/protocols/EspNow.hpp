@@ -0,0 +1,40 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef ESPNOW_hpp
+#define ESPNOW_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// WiFi channel shared by every unit of the swarm
+#define ESPNOW_CHANNEL 1
+
+// Frames buffered between the radio callback and the loop
+#define ESPNOW_RX_SLOTS 8
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Starts ESP-NOW and registers the broadcast peer
+// @return: 1 if successful, 0 otherwise
+int initEspNow();
+
+// Broadcasts a frame to the swarm (t_swarmSend)
+// @param frame: Frame to send
+// @param length: Length of the frame
+// @return: 1 if the frame was queued, 0 otherwise
+uint8_t sendEspNow(const uint8_t *frame, uint8_t length);
+
+// Hands the frames received since the last call to the gateway logic
+void serviceEspNow();
+
+// Returns the number of frames dropped because the buffer was full
+uint32_t getEspNowOverflowCount();
+
+#endif // ESPNOW_hpp
@@ -0,0 +1,434 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file protects the swarm frames against the losses of the
+    radio, which never retransmits. Nodes send, after each block of
+    frames, one parity frame per group: the XOR of the frames of the
+    group. Groups are interleaved so a burst of lost frames is
+    spread over several of them. The gateway keeps the last frames
+    of each node and rebuilds a frame when it is the only one of its
+    group missing, without asking the node for anything. Like the
+    swarm logic, this file does not depend on the radio.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the forward error correction
+#include "Fec.hpp"
+
+// memset() and memcpy() on the parities and the kept frames
+#include <string.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Parity of a group being sent
+typedef struct
+{
+    // XOR of the frames of the group, shorter frames padded with zeros
+    uint8_t data[FRAME_MAX_SIZE];
+
+    // Longest frame and XOR of the lengths
+    uint8_t length;
+    uint8_t lengthXor;
+
+    // Frames added to the group (bit n for its n-th frame)
+    uint8_t members;
+
+} t_fecGroup;
+
+// Frame kept by the gateway
+typedef struct
+{
+    uint16_t seq;
+    uint8_t length;
+    uint8_t data[FRAME_MAX_SIZE];
+
+} t_fecEntry;
+
+// Last frames of a node, indexed by sequence number
+typedef struct
+{
+    uint16_t nodeId;
+    uint8_t used;
+
+    // Order of the last use, to replace the least recently heard node
+    uint32_t lastUse;
+
+    t_fecEntry frames[FEC_MAX_BLOCK];
+
+} t_fecHistory;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Protection level of the frames sent
+static uint8_t sendGroupSize = FEC_DEFAULT_GROUP_SIZE;
+static uint8_t sendDepth = FEC_DEFAULT_DEPTH;
+
+// Block being sent: set while open, and sequence of its first frame
+static uint8_t blockOpen = 0;
+static uint16_t blockSeq = 0;
+
+// Parity of each group of the block
+static t_fecGroup groups[FEC_MAX_DEPTH];
+
+// Frames kept by the gateway and use counter of the nodes
+static t_fecHistory histories[FEC_MAX_NODES];
+static uint32_t useCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Returns the frames kept for a node, replacing the least recently heard one if new
+// @param nodeId: Identifier of the node
+// @param create: 1 to give a new node a history, 0 to only look it up
+// @return: Frames of the node, NULL if unknown and not created
+static t_fecHistory *findHistory(uint16_t nodeId, uint8_t create);
+
+
+/* *****************************************************************
+    *                       LEVEL FUNCTIONS                       *
+   ***************************************************************** */
+
+// Sets the protection of the frames sent, from the next frame on
+// @param groupSize: Frames per parity frame, 0 to send no parity
+// @param depth: Interleaving depth, groupSize x depth at most FEC_MAX_BLOCK
+// @return: 1 if the level is valid, 0 otherwise
+uint8_t setFecLevel(uint8_t groupSize, uint8_t depth)
+{
+    if (groupSize > FEC_MAX_GROUP_SIZE || depth == 0 || depth > FEC_MAX_DEPTH ||
+        groupSize * depth > FEC_MAX_BLOCK)
+    {
+        return 0;
+    }
+
+    // The open block is dropped, its parity would mix both levels
+    sendGroupSize = groupSize;
+    sendDepth = depth;
+    blockOpen = 0;
+
+    return 1;
+}
+
+// Returns the frames per parity frame, 0 when disabled
+uint8_t getFecGroupSize()
+{
+    return sendGroupSize;
+}
+
+// Returns the interleaving depth
+uint8_t getFecDepth()
+{
+    return sendDepth;
+}
+
+
+/* *****************************************************************
+    *                        NODE FUNCTIONS                       *
+   ***************************************************************** */
+
+// Adds a sent frame to the parity of its group
+// @param frame: Frame sent, or that failed to be sent
+// @param length: Length of the frame
+// @param seq: Sequence number of the frame
+// @return: 1 if the frame closes its block, the parity frames can then be encoded
+uint8_t addFecFrame(const uint8_t *frame, uint8_t length, uint16_t seq)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Position of the frame in the block
+    uint16_t offset = (uint16_t)(seq - blockSeq);
+
+    // Group of the frame
+    t_fecGroup *group;
+
+    /* -------------------- BLOCK -------------------- */
+
+    if (sendGroupSize == 0 || length > FRAME_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    // New block, or a jump in the sequence: start over from this frame
+    if (!blockOpen || offset >= sendGroupSize * sendDepth)
+    {
+        memset(groups, 0, sizeof(groups));
+        blockSeq = seq;
+        blockOpen = 1;
+        offset = 0;
+    }
+
+    /* -------------------- PARITY -------------------- */
+
+    group = &groups[offset % sendDepth];
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        group->data[i] ^= frame[i];
+    }
+
+    if (length > group->length)
+    {
+        group->length = length;
+    }
+
+    group->lengthXor ^= length;
+    group->members |= 1 << (offset / sendDepth);
+
+    // Last frame of the block, the parities stay readable until the next frame
+    if (offset == sendGroupSize * sendDepth - 1)
+    {
+        blockOpen = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Encodes the parity frame of a group of the block just closed
+// @param group: Group, below getFecDepth()
+// @param nodeId: Identifier of the sender
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if the group is empty or the buffer too small
+uint8_t encodeFecParity(uint8_t group, uint16_t nodeId, uint8_t *buffer, uint8_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the frame without its CRC
+    uint8_t length;
+
+    // CRC of the frame
+    uint16_t crc;
+
+    /* -------------------- ENCODING -------------------- */
+
+    if (group >= sendDepth || !groups[group].members)
+    {
+        return 0;
+    }
+
+    length = FEC_PARITY_HEADER_SIZE + groups[group].length;
+    if (length + FRAME_CRC_SIZE > size)
+    {
+        return 0;
+    }
+
+    buffer[0] = FRAME_MAGIC;
+    buffer[1] = FRAME_VERSION;
+    buffer[2] = FRAME_TYPE_PARITY;
+    buffer[3] = 0;
+    buffer[4] = nodeId & 0xFF;
+    buffer[5] = nodeId >> 8;
+    buffer[6] = blockSeq & 0xFF;
+    buffer[7] = blockSeq >> 8;
+    buffer[8] = sendGroupSize;
+    buffer[9] = sendDepth;
+    buffer[10] = group;
+    buffer[11] = groups[group].members;
+    buffer[12] = groups[group].lengthXor;
+    memcpy(buffer + FEC_PARITY_HEADER_SIZE, groups[group].data, groups[group].length);
+
+    crc = calculateFrameCrc(buffer, length);
+    buffer[length] = crc & 0xFF;
+    buffer[length + 1] = crc >> 8;
+
+    return length + FRAME_CRC_SIZE;
+}
+
+
+/* *****************************************************************
+    *                      GATEWAY FUNCTIONS                      *
+   ***************************************************************** */
+
+// Keeps a received frame so a later parity frame can rebuild its lost neighbours
+// @param frame: Received frame, checked by the caller
+// @param length: Length of the frame
+void storeFecFrame(const uint8_t *frame, uint8_t length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sequence number of the frame and its entry
+    uint16_t seq;
+    t_fecEntry *entry;
+
+    /* -------------------- STORAGE -------------------- */
+
+    if (length < FRAME_HEADER_SIZE || length > FRAME_MAX_SIZE)
+    {
+        return;
+    }
+
+    seq = frame[6] | ((uint16_t)frame[7] << 8);
+
+    // A block spans at most FEC_MAX_BLOCK consecutive frames, they never collide
+    entry = &findHistory(frame[4] | ((uint16_t)frame[5] << 8), 1)->frames[seq % FEC_MAX_BLOCK];
+    entry->seq = seq;
+    entry->length = length;
+    memcpy(entry->data, frame, length);
+}
+
+// Rebuilds the frame of a group missing at the gateway
+// @param parity: Received parity frame
+// @param length: Length of the parity frame
+// @param frame: Destination of the rebuilt frame, FRAME_MAX_SIZE bytes
+// @return: Length of the rebuilt frame, to be checked by its decoder, 0 if
+// no frame or more than one is missing
+uint8_t recoverFecFrame(const uint8_t *parity, uint8_t length, uint8_t *frame)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Fields of the parity frame
+    uint16_t firstSeq;
+    uint8_t size, stride, group, members, dataLength;
+
+    // Frames kept for the sender and the one being checked
+    t_fecHistory *history;
+    const t_fecEntry *entry;
+    uint16_t seq;
+
+    // Missing frames of the group and length of the rebuilt one
+    uint8_t missing = 0;
+    uint16_t missingSeq = 0;
+    uint8_t rebuiltLength;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    if (length < FEC_PARITY_HEADER_SIZE + FRAME_CRC_SIZE || length > FEC_PARITY_MAX_SIZE ||
+        parity[0] != FRAME_MAGIC || parity[1] != FRAME_VERSION || parity[2] != FRAME_TYPE_PARITY)
+    {
+        return 0;
+    }
+
+    if (calculateFrameCrc(parity, length - FRAME_CRC_SIZE) !=
+        (parity[length - 2] | ((uint16_t)parity[length - 1] << 8)))
+    {
+        return 0;
+    }
+
+    firstSeq = parity[6] | ((uint16_t)parity[7] << 8);
+    size = parity[8];
+    stride = parity[9];
+    group = parity[10];
+    members = parity[11];
+    rebuiltLength = parity[12];
+    dataLength = length - FEC_PARITY_HEADER_SIZE - FRAME_CRC_SIZE;
+
+    if (size == 0 || stride == 0 || group >= stride || size * stride > FEC_MAX_BLOCK)
+    {
+        return 0;
+    }
+
+    /* -------------------- REBUILD -------------------- */
+
+    // No frame of the sender kept, nothing cancels out of the parity
+    history = findHistory(parity[4] | ((uint16_t)parity[5] << 8), 0);
+    if (!history)
+    {
+        return 0;
+    }
+
+    memset(frame, 0, FRAME_MAX_SIZE);
+    memcpy(frame, parity + FEC_PARITY_HEADER_SIZE, dataLength);
+
+    // The frames received cancel out of the parity, leaving the missing one
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (!(members & (1 << i)))
+        {
+            continue;
+        }
+
+        seq = firstSeq + group + i * stride;
+        entry = &history->frames[seq % FEC_MAX_BLOCK];
+
+        if (entry->length && entry->seq == seq)
+        {
+            for (uint8_t j = 0; j < entry->length; j++)
+            {
+                frame[j] ^= entry->data[j];
+            }
+
+            rebuiltLength ^= entry->length;
+        }
+
+        else
+        {
+            missing++;
+            missingSeq = seq;
+        }
+    }
+
+    // Nothing to do, or beyond what a single parity can rebuild
+    if (missing != 1 || rebuiltLength == 0 || rebuiltLength > dataLength)
+    {
+        return 0;
+    }
+
+    // Its sequence number must match, whatever the CRC of the frame says
+    if ((frame[6] | ((uint16_t)frame[7] << 8)) != missingSeq)
+    {
+        return 0;
+    }
+
+    return rebuiltLength;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the frames kept for a node, replacing the least recently heard one if new
+static t_fecHistory *findHistory(uint16_t nodeId, uint8_t create)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Entry given to a new node
+    uint8_t slot = 0;
+
+    /* -------------------- LOOKUP -------------------- */
+
+    useCount++;
+
+    for (uint8_t i = 0; i < FEC_MAX_NODES; i++)
+    {
+        if (histories[i].used && histories[i].nodeId == nodeId)
+        {
+            histories[i].lastUse = useCount;
+            return &histories[i];
+        }
+    }
+
+    /* -------------------- CREATION -------------------- */
+
+    if (!create)
+    {
+        return NULL;
+    }
+
+    for (uint8_t i = 1; i < FEC_MAX_NODES; i++)
+    {
+        if (!histories[slot].used)
+        {
+            break;
+        }
+
+        if (!histories[i].used || histories[i].lastUse < histories[slot].lastUse)
+        {
+            slot = i;
+        }
+    }
+
+    memset(&histories[slot], 0, sizeof(histories[slot]));
+    histories[slot].nodeId = nodeId;
+    histories[slot].used = 1;
+    histories[slot].lastUse = useCount;
+
+    return &histories[slot];
+}
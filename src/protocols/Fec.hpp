@@ -0,0 +1,84 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef FEC_hpp
+#define FEC_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Sample frames protected by the parity frames
+#include "Frame.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Parity: magic, version, type, flags, node, first sequence of the block,
+// group size, depth, group, members, length parity, then the XOR of the
+// member frames and a CRC
+#define FEC_PARITY_HEADER_SIZE 13
+#define FEC_PARITY_MAX_SIZE    (FEC_PARITY_HEADER_SIZE + FRAME_MAX_SIZE + FRAME_CRC_SIZE)
+
+// Frames per parity group and interleaving depth. A block of
+// groupSize x depth consecutive frames has one parity frame per group,
+// group g holding every depth-th frame from g on, so a burst of up to
+// depth lost frames costs at most one frame per group
+#define FEC_MAX_GROUP_SIZE 8
+#define FEC_MAX_DEPTH      4
+#define FEC_MAX_BLOCK      16
+
+// Level at boot: 25% more frames, bursts of 2 recovered
+#define FEC_DEFAULT_GROUP_SIZE 4
+#define FEC_DEFAULT_DEPTH      2
+
+// Nodes whose recent frames the gateway keeps, one per node of the swarm
+// (SWARM_MAX_NODES): a replaced history loses the frames the next parity
+// needs. Each costs FEC_MAX_BLOCK frames, about 2.3 KB of RAM, 37 KB in all
+#define FEC_MAX_NODES 16
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Sets the protection of the frames sent, from the next frame on
+// @param groupSize: Frames per parity frame, 0 to send no parity
+// @param depth: Interleaving depth, groupSize x depth at most FEC_MAX_BLOCK
+// @return: 1 if the level is valid, 0 otherwise
+uint8_t setFecLevel(uint8_t groupSize, uint8_t depth);
+
+// Returns the frames per parity frame, 0 when disabled
+uint8_t getFecGroupSize();
+
+// Returns the interleaving depth
+uint8_t getFecDepth();
+
+// Adds a sent frame to the parity of its group
+// @param frame: Frame sent, or that failed to be sent
+// @param length: Length of the frame
+// @param seq: Sequence number of the frame
+// @return: 1 if the frame closes its block, the parity frames can then be encoded
+uint8_t addFecFrame(const uint8_t *frame, uint8_t length, uint16_t seq);
+
+// Encodes the parity frame of a group of the block just closed
+// @param group: Group, below getFecDepth()
+// @param nodeId: Identifier of the sender
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if the group is empty or the buffer too small
+uint8_t encodeFecParity(uint8_t group, uint16_t nodeId, uint8_t *buffer, uint8_t size);
+
+// Keeps a received frame so a later parity frame can rebuild its lost neighbours
+// @param frame: Received frame, checked by the caller
+// @param length: Length of the frame
+void storeFecFrame(const uint8_t *frame, uint8_t length);
+
+// Rebuilds the frame of a group missing at the gateway
+// @param parity: Received parity frame
+// @param length: Length of the parity frame
+// @param frame: Destination of the rebuilt frame, FRAME_MAX_SIZE bytes
+// @return: Length of the rebuilt frame, to be checked by its decoder, 0 if
+// no frame or more than one is missing
+uint8_t recoverFecFrame(const uint8_t *parity, uint8_t length, uint8_t *frame);
+
+#endif // FEC_hpp
@@ -0,0 +1,798 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file packs a sample set into a compact binary frame and
+    back. Only the valid channels are carried, each with its age
+    relative to the frame time, and the frame ends with a CRC so
+    corrupted radio packets are dropped. Several sample sets can
+    also be packed column by column into a single batch, and a
+    schema frame describes the channels so decoders can build typed
+    columns directly. Encoded frames can be compressed together into
+    a packed frame. Every type decodes back here too, for the host
+    tools. All fields are little endian.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the binary frames
+#include "Frame.hpp"
+
+// strlen(), strcmp(), memcpy() and memset() for the schema texts
+#include <string.h>
+
+// Compressor of the packed frames
+#include "Compress.hpp"
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Writes a little endian field
+// @param buffer: Destination of the field
+// @param value: Value to write
+// @param size: Size of the field in bytes
+static void putField(uint8_t *buffer, uint64_t value, uint8_t size);
+
+// Reads a little endian field
+// @param buffer: Source of the field
+// @param size: Size of the field in bytes
+// @return: Value of the field
+static uint64_t getField(const uint8_t *buffer, uint8_t size);
+
+// Checks the magic, version, type, minimum length and CRC of a frame
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param type: Expected frame type (FRAME_TYPE_x)
+// @return: 1 if the frame can be decoded, 0 otherwise
+static uint8_t checkFrame(const uint8_t *buffer, uint16_t length, uint8_t type);
+
+// Reads the header fields common to every frame
+// @param buffer: Checked frame
+// @param header: Pointer where the header fields will be stored
+static void getHeader(const uint8_t *buffer, t_frameHeader *header);
+
+// Reads a text preceded by its length
+// @param buffer: Frame being read
+// @param position: Pointer to the read position, advanced past the text
+// @param end: End of the texts, the CRC excluded
+// @param text: Destination of FRAME_TEXT_SIZE bytes, null terminated
+// @return: 1 if the text is complete and fits, 0 otherwise
+static uint8_t getText(const uint8_t *buffer, uint8_t *position, uint8_t end, char *text);
+
+// Appends a text preceded by its length, without a trailing ':'
+// @param buffer: Frame being built
+// @param length: Pointer to the write position, advanced past the text
+// @param size: Size of the frame, the CRC included
+// @param text: Text to append
+// @return: 1 if the text fits, 0 otherwise
+static uint8_t putText(uint8_t *buffer, uint8_t *length, uint8_t size, const char *text);
+
+
+/* *****************************************************************
+    *                       FRAME ENCODING                        *
+   ***************************************************************** */
+
+// Encodes the valid channels of a sample set into a binary frame
+// @param set: Sample set to encode
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_SAMPLES)
+// @param timeOffsetUs: Added to the capture times, to express them in the frame time base
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if the buffer is too small
+uint8_t encodeSampleFrame(const t_sampleSet *set, const t_frameHeader *header,
+                          int64_t timeOffsetUs, uint8_t *buffer, uint8_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Write position in the buffer
+    uint8_t length = FRAME_HEADER_SIZE;
+
+    // Age of a value relative to the frame time
+    int64_t age;
+
+    /* -------------------- HEADER -------------------- */
+
+    if (size < FRAME_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    buffer[0] = FRAME_MAGIC;
+    buffer[1] = FRAME_VERSION;
+    buffer[2] = FRAME_TYPE_SAMPLES;
+    buffer[3] = header->flags;
+    putField(buffer + 4, header->nodeId, 2);
+    putField(buffer + 6, header->seq, 2);
+    putField(buffer + 8, header->timeUs, 8);
+    putField(buffer + 16, set->validMask, 4);
+
+    /* -------------------- VALUES -------------------- */
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (!(set->validMask & (1UL << i)))
+        {
+            continue;
+        }
+
+        // Samples are a few seconds old at most, 32 bits are plenty
+        age = (int64_t)(header->timeUs - (set->timeUs[i] + timeOffsetUs));
+        if (age > INT32_MAX)
+        {
+            age = INT32_MAX;
+        }
+
+        else if (age < INT32_MIN)
+        {
+            age = INT32_MIN;
+        }
+
+        putField(buffer + length, (uint32_t)set->value[i], 4);
+        putField(buffer + length + 4, (uint32_t)(int32_t)age, 4);
+        length += FRAME_VALUE_SIZE;
+    }
+
+    /* -------------------- CHECKSUM -------------------- */
+
+    putField(buffer + length, calculateFrameCrc(buffer, length), 2);
+    return length + FRAME_CRC_SIZE;
+}
+
+
+// Encodes several sample sets into a columnar batch: the time offsets of
+// all samples, then their valid masks, then one column per channel present
+// @param sets: Sample sets to encode
+// @param timesUs: Time of each sample set
+// @param count: Number of sample sets, at most FRAME_BATCH_MAX_SAMPLES
+// @param header: Header fields of the batch, timeUs is the base of the offsets
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the batch, 0 if it does not fit
+uint16_t encodeSampleBatch(const t_sampleSet *sets, const uint64_t *timesUs, uint8_t count,
+                           const t_frameHeader *header, uint8_t *buffer, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Channels valid in at least one sample
+    uint32_t channelMask = 0;
+
+    // Write position in the buffer
+    uint16_t length = FRAME_BATCH_HEADER_SIZE;
+
+    /* -------------------- HEADER -------------------- */
+
+    if (count == 0 || count > FRAME_BATCH_MAX_SAMPLES || size < FRAME_BATCH_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        channelMask |= sets[i].validMask;
+    }
+
+    buffer[0] = FRAME_MAGIC;
+    buffer[1] = FRAME_VERSION;
+    buffer[2] = FRAME_TYPE_BATCH;
+    buffer[3] = header->flags;
+    putField(buffer + 4, header->nodeId, 2);
+    putField(buffer + 6, header->seq, 2);
+    putField(buffer + 8, header->timeUs, 8);
+    putField(buffer + 16, channelMask, 4);
+    buffer[20] = count;
+
+    /* -------------------- COLUMNS -------------------- */
+
+    // Grouping each channel keeps similar values together, which the
+    // transports and any later compression handle far better
+    for (uint8_t i = 0; i < count; i++)
+    {
+        putField(buffer + length, (uint32_t)(timesUs[i] - header->timeUs), 4);
+        length += 4;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        putField(buffer + length, sets[i].validMask, 2);
+        length += 2;
+    }
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            putField(buffer + length, (uint32_t)sets[i].value[ch], 4);
+            length += 4;
+        }
+    }
+
+    /* -------------------- CHECKSUM -------------------- */
+
+    putField(buffer + length, calculateFrameCrc(buffer, length), 2);
+    return length + FRAME_CRC_SIZE;
+}
+
+
+// Encodes the description of the channels, sent ahead of the samples so
+// a decoder can lay out typed columns without parsing the text output
+// @param channelMask: Channels to describe (bit n for channel n)
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_SCHEMA)
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if it does not fit
+uint8_t encodeSchemaFrame(uint32_t channelMask, const t_frameHeader *header, uint8_t *buffer,
+                          uint8_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sensors of the dictionary, their index is sent with each channel
+    const char *sensors[CH_COUNT];
+    uint8_t sensorIndex[CH_COUNT];
+    uint8_t sensorCount = 0;
+
+    // Write position in the buffer
+    uint8_t length = FRAME_HEADER_SIZE + 1;
+
+    // Dictionary entry of the channel being described
+    uint8_t entry;
+
+    /* -------------------- HEADER -------------------- */
+
+    channelMask &= (1UL << CH_COUNT) - 1;
+
+    if (size < FRAME_HEADER_SIZE + 1 + FRAME_CRC_SIZE)
+    {
+        return 0;
+    }
+
+    buffer[0] = FRAME_MAGIC;
+    buffer[1] = FRAME_VERSION;
+    buffer[2] = FRAME_TYPE_SCHEMA;
+    buffer[3] = header->flags;
+    putField(buffer + 4, header->nodeId, 2);
+    putField(buffer + 6, header->seq, 2);
+    putField(buffer + 8, header->timeUs, 8);
+    putField(buffer + 16, channelMask, 4);
+
+    /* -------------------- SENSOR DICTIONARY -------------------- */
+
+    // Each sensor is named once, the channels refer to it by index
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        for (entry = 0; entry < sensorCount; entry++)
+        {
+            if (strcmp(sensors[entry], getChannelSource((e_channel)ch)) == 0)
+            {
+                break;
+            }
+        }
+
+        if (entry == sensorCount)
+        {
+            sensors[sensorCount++] = getChannelSource((e_channel)ch);
+
+            if (!putText(buffer, &length, size, sensors[entry]))
+            {
+                return 0;
+            }
+        }
+
+        sensorIndex[ch] = entry;
+    }
+
+    buffer[FRAME_HEADER_SIZE] = sensorCount;
+
+    /* -------------------- COLUMNS -------------------- */
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        if (length + 2 + FRAME_CRC_SIZE > size)
+        {
+            return 0;
+        }
+
+        buffer[length++] = FRAME_COLUMN_INT32;
+        buffer[length++] = sensorIndex[ch];
+
+        if (!putText(buffer, &length, size, getChannelName((e_channel)ch)) ||
+            !putText(buffer, &length, size, getChannelUnit((e_channel)ch)))
+        {
+            return 0;
+        }
+    }
+
+    /* -------------------- CHECKSUM -------------------- */
+
+    putField(buffer + length, calculateFrameCrc(buffer, length), 2);
+    return length + FRAME_CRC_SIZE;
+}
+
+
+// Compresses one or more encoded frames into a packed frame
+// @param data: Frames to pack
+// @param length: Length of the frames
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_PACKED)
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer, the frame is only built if it fits
+// @return: Length of the frame, 0 if it does not fit
+uint16_t encodePackedFrame(const uint8_t *data, uint16_t length, const t_frameHeader *header,
+                           uint8_t *buffer, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the compressed frames
+    uint16_t packed;
+
+    /* -------------------- COMPRESSION -------------------- */
+
+    if (size <= FRAME_PACKED_OVERHEAD)
+    {
+        return 0;
+    }
+
+    packed = compressBlock(data, length, buffer + FRAME_HEADER_SIZE, size - FRAME_PACKED_OVERHEAD);
+    if (!packed)
+    {
+        return 0;
+    }
+
+    /* -------------------- HEADER -------------------- */
+
+    buffer[0] = FRAME_MAGIC;
+    buffer[1] = FRAME_VERSION;
+    buffer[2] = FRAME_TYPE_PACKED;
+    buffer[3] = header->flags;
+    putField(buffer + 4, header->nodeId, 2);
+    putField(buffer + 6, header->seq, 2);
+    putField(buffer + 8, header->timeUs, 8);
+    putField(buffer + 16, length, 4);
+
+    /* -------------------- CHECKSUM -------------------- */
+
+    putField(buffer + FRAME_HEADER_SIZE + packed,
+             calculateFrameCrc(buffer, FRAME_HEADER_SIZE + packed), 2);
+    return FRAME_HEADER_SIZE + packed + FRAME_CRC_SIZE;
+}
+
+
+/* *****************************************************************
+    *                       FRAME DECODING                        *
+   ***************************************************************** */
+
+// Decodes and checks a binary sample frame
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param set: Pointer where the samples will be stored, times in the frame time base
+// @return: 1 if the frame is valid, 0 otherwise
+uint8_t decodeSampleFrame(const uint8_t *buffer, uint8_t length, t_frameHeader *header,
+                          t_sampleSet *set)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Channels carried by the frame
+    uint32_t validMask;
+
+    // Expected length of the frame
+    uint8_t expected = FRAME_HEADER_SIZE + FRAME_CRC_SIZE;
+
+    // Read position in the buffer
+    uint8_t position = FRAME_HEADER_SIZE;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    if (!checkFrame(buffer, length, FRAME_TYPE_SAMPLES))
+    {
+        return 0;
+    }
+
+    validMask = (uint32_t)getField(buffer + 16, 4);
+
+    // Channels unknown to this firmware cannot be decoded
+    if (validMask >> CH_COUNT)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (validMask & (1UL << i))
+        {
+            expected += FRAME_VALUE_SIZE;
+        }
+    }
+
+    if (length != expected)
+    {
+        return 0;
+    }
+
+    /* -------------------- HEADER -------------------- */
+
+    getHeader(buffer, header);
+
+    /* -------------------- VALUES -------------------- */
+
+    clearSampleSet(set);
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (!(validMask & (1UL << i)))
+        {
+            continue;
+        }
+
+        setSampleValue(set, (e_channel)i, (int32_t)(uint32_t)getField(buffer + position, 4),
+                       header->timeUs - (int32_t)(uint32_t)getField(buffer + position + 4, 4));
+        position += FRAME_VALUE_SIZE;
+    }
+
+    return 1;
+}
+
+
+// Decodes and checks a columnar batch
+// @param buffer: Received batch
+// @param length: Length of the received batch
+// @param header: Pointer where the header fields will be stored
+// @param sets: Array where the samples will be stored, times in the frame time base
+// @param timesUs: Array where the time of each sample set will be stored
+// @param maxCount: Size of both arrays
+// @return: Number of sample sets, 0 if the batch is invalid or does not fit
+uint8_t decodeSampleBatch(const uint8_t *buffer, uint16_t length, t_frameHeader *header,
+                          t_sampleSet *sets, uint64_t *timesUs, uint8_t maxCount)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Channels valid in at least one sample and number of samples
+    uint32_t channelMask;
+    uint8_t count;
+
+    // Expected length of the batch
+    uint16_t expected;
+
+    // Start of the valid masks and read position in the value columns
+    uint16_t masks, position;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    if (!checkFrame(buffer, length, FRAME_TYPE_BATCH) ||
+        length < FRAME_BATCH_HEADER_SIZE + FRAME_CRC_SIZE)
+    {
+        return 0;
+    }
+
+    channelMask = (uint32_t)getField(buffer + 16, 4);
+    count = buffer[20];
+
+    if ((channelMask >> CH_COUNT) || count == 0 || count > maxCount)
+    {
+        return 0;
+    }
+
+    expected = FRAME_BATCH_HEADER_SIZE + FRAME_CRC_SIZE + count * 6;
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (channelMask & (1UL << ch))
+        {
+            expected += count * 4;
+        }
+    }
+
+    if (length != expected)
+    {
+        return 0;
+    }
+
+    /* -------------------- HEADER -------------------- */
+
+    getHeader(buffer, header);
+
+    /* -------------------- COLUMNS -------------------- */
+
+    masks = FRAME_BATCH_HEADER_SIZE + count * 4;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        timesUs[i] = header->timeUs +
+                     (uint32_t)getField(buffer + FRAME_BATCH_HEADER_SIZE + i * 4, 4);
+        clearSampleSet(&sets[i]);
+    }
+
+    position = masks + count * 2;
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        // Values of the samples where the channel is not valid are skipped
+        for (uint8_t i = 0; i < count; i++, position += 4)
+        {
+            if (getField(buffer + masks + i * 2, 2) & (1UL << ch))
+            {
+                setSampleValue(&sets[i], (e_channel)ch,
+                               (int32_t)(uint32_t)getField(buffer + position, 4), timesUs[i]);
+            }
+        }
+    }
+
+    return count;
+}
+
+
+// Decodes and checks a schema frame
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param schema: Pointer where the description of the channels will be stored
+// @return: 1 if the frame is valid, 0 otherwise
+uint8_t decodeSchemaFrame(const uint8_t *buffer, uint8_t length, t_frameHeader *header,
+                          t_frameSchema *schema)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Read position in the buffer and end of the descriptions
+    uint8_t position = FRAME_HEADER_SIZE + 1;
+    uint8_t end = length - FRAME_CRC_SIZE;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    if (!checkFrame(buffer, length, FRAME_TYPE_SCHEMA) ||
+        length < FRAME_HEADER_SIZE + 1 + FRAME_CRC_SIZE)
+    {
+        return 0;
+    }
+
+    memset(schema, 0, sizeof(*schema));
+    schema->channelMask = (uint32_t)getField(buffer + 16, 4);
+    schema->sensorCount = buffer[FRAME_HEADER_SIZE];
+
+    if ((schema->channelMask >> CH_COUNT) || schema->sensorCount > CH_COUNT)
+    {
+        return 0;
+    }
+
+    /* -------------------- SENSOR DICTIONARY -------------------- */
+
+    for (uint8_t i = 0; i < schema->sensorCount; i++)
+    {
+        if (!getText(buffer, &position, end, schema->sensors[i]))
+        {
+            return 0;
+        }
+    }
+
+    /* -------------------- COLUMNS -------------------- */
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(schema->channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        if (position + 2 > end)
+        {
+            return 0;
+        }
+
+        schema->columnType[ch] = buffer[position++];
+        schema->sensor[ch] = buffer[position++];
+
+        if (schema->sensor[ch] >= schema->sensorCount ||
+            !getText(buffer, &position, end, schema->name[ch]) ||
+            !getText(buffer, &position, end, schema->unit[ch]))
+        {
+            return 0;
+        }
+    }
+
+    if (position != end)
+    {
+        return 0;
+    }
+
+    getHeader(buffer, header);
+    return 1;
+}
+
+
+// Checks a packed frame and decompresses the frames it holds
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param data: Destination of the unpacked frames
+// @param size: Size of the destination buffer
+// @return: Length of the unpacked frames, 0 if the frame is invalid or does not fit
+uint16_t decodePackedFrame(const uint8_t *buffer, uint16_t length, t_frameHeader *header,
+                           uint8_t *data, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the frames before compression, as announced
+    uint32_t unpacked;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    if (!checkFrame(buffer, length, FRAME_TYPE_PACKED))
+    {
+        return 0;
+    }
+
+    unpacked = (uint32_t)getField(buffer + 16, 4);
+
+    if (unpacked == 0 || unpacked > size ||
+        decompressBlock(buffer + FRAME_HEADER_SIZE, length - FRAME_PACKED_OVERHEAD, data,
+                        (uint16_t)unpacked) != unpacked)
+    {
+        return 0;
+    }
+
+    getHeader(buffer, header);
+    return (uint16_t)unpacked;
+}
+
+
+/* *****************************************************************
+    *                       FRAME CHECKSUM                        *
+   ***************************************************************** */
+
+// Calculates the CRC-16/CCITT-FALSE of a buffer
+// @param data: Data to check
+// @param length: Number of bytes
+// @return: CRC of the data
+uint16_t calculateFrameCrc(const uint8_t *data, uint16_t length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Running CRC
+    uint16_t crc = 0xFFFF;
+
+    /* -------------------- CRC CALCULATION -------------------- */
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Writes a little endian field
+static void putField(uint8_t *buffer, uint64_t value, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Reads a little endian field
+static uint64_t getField(const uint8_t *buffer, uint8_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Value being assembled
+    uint64_t value = 0;
+
+    /* -------------------- FIELD ASSEMBLY -------------------- */
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        value |= (uint64_t)buffer[i] << (8 * i);
+    }
+
+    return value;
+}
+
+// Checks the magic, version, type, minimum length and CRC of a frame
+static uint8_t checkFrame(const uint8_t *buffer, uint16_t length, uint8_t type)
+{
+    if (length < FRAME_HEADER_SIZE + FRAME_CRC_SIZE || buffer[0] != FRAME_MAGIC ||
+        buffer[1] != FRAME_VERSION || buffer[2] != type)
+    {
+        return 0;
+    }
+
+    return getField(buffer + length - FRAME_CRC_SIZE, 2) ==
+           calculateFrameCrc(buffer, length - FRAME_CRC_SIZE);
+}
+
+// Reads the header fields common to every frame
+static void getHeader(const uint8_t *buffer, t_frameHeader *header)
+{
+    header->type = buffer[2];
+    header->flags = buffer[3];
+    header->nodeId = (uint16_t)getField(buffer + 4, 2);
+    header->seq = (uint16_t)getField(buffer + 6, 2);
+    header->timeUs = getField(buffer + 8, 8);
+}
+
+// Reads a text preceded by its length
+static uint8_t getText(const uint8_t *buffer, uint8_t *position, uint8_t end, char *text)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the text
+    uint8_t textLength;
+
+    /* -------------------- TEXT -------------------- */
+
+    if (*position >= end)
+    {
+        return 0;
+    }
+
+    textLength = buffer[(*position)++];
+
+    if (textLength >= FRAME_TEXT_SIZE || *position + textLength > end)
+    {
+        return 0;
+    }
+
+    memcpy(text, buffer + *position, textLength);
+    text[textLength] = '\0';
+    *position += textLength;
+
+    return 1;
+}
+
+// Appends a text preceded by its length, without a trailing ':'
+static uint8_t putText(uint8_t *buffer, uint8_t *length, uint8_t size, const char *text)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the text, the labels end with ':' for the text output
+    size_t textLength = strlen(text);
+
+    /* -------------------- TEXT -------------------- */
+
+    if (textLength > 0 && text[textLength - 1] == ':')
+    {
+        textLength--;
+    }
+
+    if (*length + 1 + textLength + FRAME_CRC_SIZE > size)
+    {
+        return 0;
+    }
+
+    buffer[(*length)++] = (uint8_t)textLength;
+    memcpy(buffer + *length, text, textLength);
+    *length += textLength;
+
+    return 1;
+}
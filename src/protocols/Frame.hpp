@@ -0,0 +1,202 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef FRAME_hpp
+#define FRAME_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Sample set carried by the frames
+#include "../processing/Channels.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// First byte of every frame and current layout version
+#define FRAME_MAGIC   0xA5
+#define FRAME_VERSION 1
+
+// Frame types
+#define FRAME_TYPE_SAMPLES 1
+#define FRAME_TYPE_BATCH   2
+#define FRAME_TYPE_SCHEMA  3
+#define FRAME_TYPE_PACKED  4
+#define FRAME_TYPE_PARITY  5
+
+// Flags: the frame time is UTC instead of the local time of the sender,
+// the samples were taken at the burst rate of a detected plume, packed
+// frames may follow this schema
+#define FRAME_FLAG_UTC    0x01
+#define FRAME_FLAG_EVENT  0x02
+#define FRAME_FLAG_PACKED 0x04
+
+// Header: magic, version, type, flags, node, sequence, time, valid mask
+#define FRAME_HEADER_SIZE 20
+
+// Each valid channel: value and age relative to the frame time
+#define FRAME_VALUE_SIZE 8
+
+// Trailing CRC-16/CCITT-FALSE
+#define FRAME_CRC_SIZE 2
+
+// Largest frame, with every channel valid
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + CH_COUNT * FRAME_VALUE_SIZE + FRAME_CRC_SIZE)
+
+// Batch header: sample frame header followed by the number of samples
+#define FRAME_BATCH_HEADER_SIZE (FRAME_HEADER_SIZE + 1)
+
+// Each sample of a batch: time offset, valid mask and one value per channel
+#define FRAME_BATCH_SAMPLE_SIZE (4 + 2 + CH_COUNT * 4)
+
+// Largest number of samples in a batch and largest batch
+#define FRAME_BATCH_MAX_SAMPLES 10
+#define FRAME_BATCH_MAX_SIZE \
+    (FRAME_BATCH_HEADER_SIZE + FRAME_BATCH_MAX_SAMPLES * FRAME_BATCH_SAMPLE_SIZE + FRAME_CRC_SIZE)
+
+// Schema: sample frame header, the sensor dictionary, then each channel
+// of the mask with its column type, sensor index, name and unit. It fits
+// in one recorder record
+#define FRAME_SCHEMA_MAX_SIZE 255
+
+// Column types of the schema, every channel is a signed 32-bit integer
+#define FRAME_COLUMN_INT32 1
+
+// Longest sensor, channel or unit text of a decoded schema, the
+// terminating null included
+#define FRAME_TEXT_SIZE 16
+
+// Packed: header with the unpacked length in place of the valid mask,
+// then frames compressed with compressBlock(), then the CRC
+#define FRAME_PACKED_OVERHEAD (FRAME_HEADER_SIZE + FRAME_CRC_SIZE)
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Header fields of a decoded frame
+typedef struct
+{
+    // Frame type (FRAME_TYPE_x) and flags (FRAME_FLAG_x)
+    uint8_t type;
+    uint8_t flags;
+
+    // Sender of the frame and its sequence number
+    uint16_t nodeId;
+    uint16_t seq;
+
+    // Time the frame was built, local to the sender or UTC (FRAME_FLAG_UTC)
+    uint64_t timeUs;
+
+} t_frameHeader;
+
+// Channels described by a decoded schema frame
+typedef struct
+{
+    // Channels described (bit n for channel n)
+    uint32_t channelMask;
+
+    // Sensor dictionary, the channels refer to it by index
+    uint8_t sensorCount;
+    char sensors[CH_COUNT][FRAME_TEXT_SIZE];
+
+    // Each described channel: column type (FRAME_COLUMN_x), sensor index,
+    // name and unit
+    uint8_t columnType[CH_COUNT];
+    uint8_t sensor[CH_COUNT];
+    char name[CH_COUNT][FRAME_TEXT_SIZE];
+    char unit[CH_COUNT][FRAME_TEXT_SIZE];
+
+} t_frameSchema;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Encodes the valid channels of a sample set into a binary frame
+// @param set: Sample set to encode
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_SAMPLES)
+// @param timeOffsetUs: Added to the capture times, to express them in the frame time base
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if the buffer is too small
+uint8_t encodeSampleFrame(const t_sampleSet *set, const t_frameHeader *header,
+                          int64_t timeOffsetUs, uint8_t *buffer, uint8_t size);
+
+// Decodes and checks a binary sample frame
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param set: Pointer where the samples will be stored, times in the frame time base
+// @return: 1 if the frame is valid, 0 otherwise
+uint8_t decodeSampleFrame(const uint8_t *buffer, uint8_t length, t_frameHeader *header,
+                          t_sampleSet *set);
+
+// Encodes several sample sets into a columnar batch: the time offsets of
+// all samples, then their valid masks, then one column per channel present
+// @param sets: Sample sets to encode
+// @param timesUs: Time of each sample set
+// @param count: Number of sample sets, at most FRAME_BATCH_MAX_SAMPLES
+// @param header: Header fields of the batch, timeUs is the base of the offsets
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the batch, 0 if it does not fit
+uint16_t encodeSampleBatch(const t_sampleSet *sets, const uint64_t *timesUs, uint8_t count,
+                           const t_frameHeader *header, uint8_t *buffer, uint16_t size);
+
+// Encodes the description of the channels, sent ahead of the samples so
+// a decoder can lay out typed columns without parsing the text output
+// @param channelMask: Channels to describe (bit n for channel n)
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_SCHEMA)
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer
+// @return: Length of the frame, 0 if it does not fit
+uint8_t encodeSchemaFrame(uint32_t channelMask, const t_frameHeader *header, uint8_t *buffer,
+                          uint8_t size);
+
+// Compresses one or more encoded frames into a packed frame
+// @param data: Frames to pack
+// @param length: Length of the frames
+// @param header: Header fields of the frame (type is set to FRAME_TYPE_PACKED)
+// @param buffer: Destination buffer
+// @param size: Size of the destination buffer, the frame is only built if it fits
+// @return: Length of the frame, 0 if it does not fit
+uint16_t encodePackedFrame(const uint8_t *data, uint16_t length, const t_frameHeader *header,
+                           uint8_t *buffer, uint16_t size);
+
+// Decodes and checks a columnar batch
+// @param buffer: Received batch
+// @param length: Length of the received batch
+// @param header: Pointer where the header fields will be stored
+// @param sets: Array where the samples will be stored, times in the frame time base
+// @param timesUs: Array where the time of each sample set will be stored
+// @param maxCount: Size of both arrays
+// @return: Number of sample sets, 0 if the batch is invalid or does not fit
+uint8_t decodeSampleBatch(const uint8_t *buffer, uint16_t length, t_frameHeader *header,
+                          t_sampleSet *sets, uint64_t *timesUs, uint8_t maxCount);
+
+// Decodes and checks a schema frame
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param schema: Pointer where the description of the channels will be stored
+// @return: 1 if the frame is valid, 0 otherwise
+uint8_t decodeSchemaFrame(const uint8_t *buffer, uint8_t length, t_frameHeader *header,
+                          t_frameSchema *schema);
+
+// Checks a packed frame and decompresses the frames it holds
+// @param buffer: Received frame
+// @param length: Length of the received frame
+// @param header: Pointer where the header fields will be stored
+// @param data: Destination of the unpacked frames
+// @param size: Size of the destination buffer
+// @return: Length of the unpacked frames, 0 if the frame is invalid or does not fit
+uint16_t decodePackedFrame(const uint8_t *buffer, uint16_t length, t_frameHeader *header,
+                           uint8_t *data, uint16_t size);
+
+// Calculates the CRC-16/CCITT-FALSE of a buffer
+// @param data: Data to check
+// @param length: Number of bytes
+// @return: CRC of the data
+uint16_t calculateFrameCrc(const uint8_t *data, uint16_t length);
+
+#endif // FRAME_hpp
@@ -0,0 +1,161 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file manages the I2C bus shared by the I2C sensors. It
+    runs the bus in fast mode, serializes access between tasks,
+    probes devices and recovers the bus when a slave is left
+    holding SDA low.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the I2C bus manager
+#include "I2CBus.hpp"
+
+// FreeRTOS mutex used to share the bus between tasks
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Recursive mutex protecting the bus
+static SemaphoreHandle_t busMutex = NULL;
+
+// Bus clock requested at initialization
+static uint32_t busClock = I2C_BUS_CLOCK;
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Starts the I2C bus shared by all I2C sensors
+// @param clockHz: Bus clock in Hz
+// @return: 1 if successful, 0 otherwise
+int initI2CBus(uint32_t clockHz)
+{
+    if (!busMutex)
+    {
+        busMutex = xSemaphoreCreateRecursiveMutex();
+    }
+
+    busClock = clockHz;
+
+    if (!Wire.begin(P_I2C_SDA, P_I2C_SCL, busClock))
+    {
+        return 0;
+    }
+
+    // Never let a stuck slave block the caller for long
+    Wire.setTimeOut(I2C_BUS_TIMEOUT_MS);
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                      BUS ACCESS CONTROL                     *
+   ***************************************************************** */
+
+// Takes exclusive access to the bus, blocks until available
+void lockI2CBus()
+{
+    if (busMutex)
+    {
+        xSemaphoreTakeRecursive(busMutex, portMAX_DELAY);
+    }
+}
+
+// Releases the bus taken with lockI2CBus()
+void unlockI2CBus()
+{
+    if (busMutex)
+    {
+        xSemaphoreGiveRecursive(busMutex);
+    }
+}
+
+
+/* *****************************************************************
+    *                       TRANSACTIONS                          *
+   ***************************************************************** */
+
+// Checks that a device acknowledges its address
+// @param address: 7-bit I2C address
+// @return: 1 if the device answered, 0 otherwise
+uint8_t probeI2CDevice(uint8_t address)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Result of the transaction
+    uint8_t ok;
+
+    /* ------------------- ADDRESS PROBING ------------------- */
+
+    lockI2CBus();
+    Wire.beginTransmission(address);
+    ok = (Wire.endTransmission() == 0);
+    unlockI2CBus();
+
+    return ok;
+}
+
+/* *****************************************************************
+    *                        BUS RECOVERY                         *
+   ***************************************************************** */
+
+// Frees a locked bus by clocking SCL until SDA is released
+// @return: 1 if the bus is free afterwards, 0 otherwise
+uint8_t recoverI2CBus()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // State of SDA after recovery
+    uint8_t sdaFree;
+
+    /* ------------------ SCL TOGGLE SEQUENCE ------------------ */
+
+    lockI2CBus();
+
+    // Take the pins back from the I2C peripheral
+    Wire.end();
+    pinMode(P_I2C_SDA, INPUT_PULLUP);
+    pinMode(P_I2C_SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(P_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+
+    // A slave in the middle of a read releases SDA within 9 clocks
+    for (uint8_t i = 0; i < I2C_RECOVERY_PULSES && !digitalRead(P_I2C_SDA); i++)
+    {
+        digitalWrite(P_I2C_SCL, LOW);
+        delayMicroseconds(5);
+        digitalWrite(P_I2C_SCL, HIGH);
+        delayMicroseconds(5);
+    }
+
+    // Generate a STOP condition: SDA rises while SCL is high
+    pinMode(P_I2C_SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(P_I2C_SDA, LOW);
+    delayMicroseconds(5);
+    digitalWrite(P_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(P_I2C_SDA, HIGH);
+    delayMicroseconds(5);
+
+    pinMode(P_I2C_SDA, INPUT_PULLUP);
+    sdaFree = digitalRead(P_I2C_SDA);
+
+    // Hand the pins back to the peripheral
+    Wire.begin(P_I2C_SDA, P_I2C_SCL, busClock);
+    Wire.setTimeOut(I2C_BUS_TIMEOUT_MS);
+
+    unlockI2CBus();
+
+    return sdaFree;
+}
@@ -0,0 +1,53 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef I2CBUS_hpp
+#define I2CBUS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Arduino I2C "Wire" library
+#include <Wire.h>
+
+// Pins of the mission profile
+#include "../config/Profile.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Bus clock used by the sensors (fast mode)
+#define I2C_BUS_CLOCK 400000UL
+
+// Maximum time a transaction may stretch the clock, in milliseconds
+#define I2C_BUS_TIMEOUT_MS 20
+
+// Clock pulses sent to release a slave holding SDA low
+#define I2C_RECOVERY_PULSES 9
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Starts the I2C bus shared by all I2C sensors
+// @param clockHz: Bus clock in Hz
+// @return: 1 if successful, 0 otherwise
+int initI2CBus(uint32_t clockHz);
+
+// Takes exclusive access to the bus, blocks until available
+void lockI2CBus();
+
+// Releases the bus taken with lockI2CBus()
+void unlockI2CBus();
+
+// Checks that a device acknowledges its address
+// @param address: 7-bit I2C address
+// @return: 1 if the device answered, 0 otherwise
+uint8_t probeI2CDevice(uint8_t address);
+
+// Frees a locked bus by clocking SCL until SDA is released
+// @return: 1 if the bus is free afterwards, 0 otherwise
+uint8_t recoverI2CBus();
+
+#endif // I2CBUS_hpp
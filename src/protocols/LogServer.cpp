@@ -0,0 +1,552 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file serves the recorded sessions over HTTP on a soft-AP,
+    for bulk download at Wi-Fi speed instead of Bluetooth. Files
+    are streamed from flash one chunk at a time, with byte range
+    support so interrupted downloads can resume. The cells of the
+    pollution grid are served too, for live maps. The server runs in
+    its own task on the other core, so a long download does not
+    stall the measurements.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the log server
+#include "LogServer.hpp"
+
+// Sessions recorded on flash
+#include "../storage/Recorder.hpp"
+
+// Cells of the pollution grid
+#include "../processing/Grid.hpp"
+
+// Unique name of the unit, used as the soft-AP name
+#include "../system/Identity.hpp"
+
+// Arduino core, soft-AP, HTTP server and flash file system
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#include <uri/UriBraces.h>
+#include <LittleFS.h>
+
+// Server task
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// strtoul() and strncmp() to parse the session numbers and the ranges
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// HTTP server, only used by the server task
+static WebServer server(LOGSERVER_PORT);
+
+// Set while the server task runs, and to ask it to stop
+static volatile uint8_t running = 0;
+static volatile uint8_t stopRequested = 0;
+
+// Handlers are registered once, the server keeps them across restarts
+static uint8_t routesRegistered = 0;
+
+// Chunk of file being sent
+static uint8_t chunk[LOGSERVER_CHUNK_SIZE];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Runs the server until a stop is requested
+// @param parameter: Unused
+static void serverLoop(void *parameter);
+
+// Sends the JSON index of the sessions
+static void handleIndex();
+
+// Sends a session file, whole or the requested byte range
+static void handleDownload();
+
+// Sends the cells of a grid level lying in the requested tile, in JSON
+static void handleGrid();
+
+// Answers requests to unknown paths
+static void handleNotFound();
+
+// Parses a "bytes=start-end" range header
+// @param header: Value of the Range header
+// @param size: Size of the file
+// @param start: Pointer where the first byte will be stored
+// @param end: Pointer where the last byte will be stored
+// @return: 1 if the range is satisfiable, 0 otherwise
+static uint8_t parseRange(const char *header, uint32_t size, uint32_t *start, uint32_t *end);
+
+// Streams part of a file to the client
+// @param file: File positioned at the first byte
+// @param length: Number of bytes to send
+static void streamFile(File &file, uint32_t length);
+
+
+/* *****************************************************************
+    *                       SERVER CONTROL                        *
+   ***************************************************************** */
+
+// Brings up the soft-AP and serves the recorded sessions over HTTP:
+// GET /sessions lists them in JSON, GET /sessions/<id> downloads one,
+// GET /grid/<level>?x0=&y0=&x1=&y1= sends the grid cells of a tile. A server still
+// stopping is waited for, LOGSERVER_STOP_WAIT_MS at most
+// @return: 1 if the server runs, 0 otherwise
+int startLogServer()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Name of the soft-AP
+    char ssid[DEVICE_NAME_SIZE];
+
+    // Request headers kept by the server
+    const char *headers[] = {"Range"};
+
+    /* -------------------- SOFT-AP -------------------- */
+
+    // A stopping task would bring the soft-AP down after this start, let it
+    // finish before starting a new one
+    for (uint16_t waitedMs = 0; running && stopRequested && waitedMs < LOGSERVER_STOP_WAIT_MS;
+         waitedMs += 10)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (running)
+    {
+        // Still stopping: not up, whatever the caller reports
+        return !stopRequested;
+    }
+
+    // The station, if any, keeps running next to the soft-AP
+    getDeviceName(ssid, sizeof(ssid));
+    if (!WiFi.softAP(ssid, LOGSERVER_AP_PASSWORD))
+    {
+        return 0;
+    }
+
+    /* -------------------- HTTP SERVER -------------------- */
+
+    if (!routesRegistered)
+    {
+        server.on("/sessions", HTTP_GET, handleIndex);
+        server.on(UriBraces("/sessions/{}"), HTTP_GET, handleDownload);
+        server.on(UriBraces("/grid/{}"), HTTP_GET, handleGrid);
+        server.onNotFound(handleNotFound);
+        server.collectHeaders(headers, 1);
+        routesRegistered = 1;
+    }
+
+    server.begin();
+
+    stopRequested = 0;
+    running = 1;
+
+    if (xTaskCreatePinnedToCore(serverLoop, "logserver", LOGSERVER_TASK_STACK, NULL,
+                                LOGSERVER_TASK_PRIORITY, NULL, LOGSERVER_TASK_CORE) != pdPASS)
+    {
+        server.stop();
+        WiFi.softAPdisconnect(true);
+        running = 0;
+        return 0;
+    }
+
+    return 1;
+}
+
+// Stops the server and the soft-AP
+void stopLogServer()
+{
+    // The task finishes the request in progress and shuts down
+    if (running)
+    {
+        stopRequested = 1;
+    }
+}
+
+// Tells whether the server is running
+uint8_t isLogServerRunning()
+{
+    return running;
+}
+
+// Returns the address of the server, e.g. "192.168.4.1"
+// @param address: Destination buffer
+// @param size: Size of the destination buffer
+void getLogServerAddress(char *address, uint8_t size)
+{
+    snprintf(address, size, "%s", WiFi.softAPIP().toString().c_str());
+}
+
+
+/* *****************************************************************
+    *                      REQUEST HANDLERS                       *
+   ***************************************************************** */
+
+// Runs the server until a stop is requested
+static void serverLoop(void *parameter)
+{
+    while (!stopRequested)
+    {
+        server.handleClient();
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+
+    server.stop();
+    WiFi.softAPdisconnect(true);
+
+    running = 0;
+    vTaskDelete(NULL);
+}
+
+// Sends the JSON index of the sessions
+static void handleIndex()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sessions on flash
+    t_sessionInfo sessions[LOGSERVER_MAX_SESSIONS];
+    uint8_t count;
+
+    // Name of the unit and one entry of the index
+    char name[DEVICE_NAME_SIZE];
+    char entry[96];
+
+    /* -------------------- INDEX -------------------- */
+
+    count = listSessions(sessions, LOGSERVER_MAX_SESSIONS);
+
+    // Sent entry by entry with chunked encoding
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    getDeviceName(name, sizeof(name));
+    snprintf(entry, sizeof(entry), "{\"device\":\"%s\",\"sessions\":[", name);
+    server.sendContent(entry);
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // The active session grows, its last seconds are still in RAM
+        snprintf(entry, sizeof(entry),
+                 "%s{\"id\":%u,\"size\":%lu,\"active\":%s,\"href\":\"/sessions/%u\"}",
+                 i ? "," : "", sessions[i].id, (unsigned long)sessions[i].size,
+                 sessions[i].active ? "true" : "false", sessions[i].id);
+        server.sendContent(entry);
+    }
+
+    server.sendContent("]}");
+
+    // Empty chunk: end of the response
+    server.sendContent("");
+}
+
+// Sends a session file, whole or the requested byte range
+static void handleDownload()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Session requested and its file
+    char path[RECORDER_PATH_SIZE];
+    unsigned long id;
+    File file;
+
+    // Byte range to send
+    uint32_t size, start, end;
+
+    // Formatted header values
+    char value[64];
+
+    /* -------------------- SESSION LOOKUP -------------------- */
+
+    id = strtoul(server.pathArg(0).c_str(), NULL, 10);
+    getSessionPath((uint16_t)id, path);
+
+    file = LittleFS.open(path, FILE_READ);
+    if (id == 0 || id > UINT16_MAX || !file || file.isDirectory())
+    {
+        handleNotFound();
+        return;
+    }
+
+    size = file.size();
+
+    snprintf(value, sizeof(value), "attachment; filename=\"%05lu.bin\"", id);
+    server.sendHeader("Content-Disposition", value);
+    server.sendHeader("Accept-Ranges", "bytes");
+
+    /* -------------------- RANGE REQUEST -------------------- */
+
+    if (server.hasHeader("Range"))
+    {
+        if (!parseRange(server.header("Range").c_str(), size, &start, &end))
+        {
+            snprintf(value, sizeof(value), "bytes */%lu", (unsigned long)size);
+            server.sendHeader("Content-Range", value);
+            server.send(416, "text/plain", "Range Not Satisfiable");
+            file.close();
+            return;
+        }
+
+        snprintf(value, sizeof(value), "bytes %lu-%lu/%lu", (unsigned long)start,
+                 (unsigned long)end, (unsigned long)size);
+        server.sendHeader("Content-Range", value);
+        server.setContentLength(end - start + 1);
+        server.send(206, "application/octet-stream", "");
+
+        file.seek(start);
+        streamFile(file, end - start + 1);
+        file.close();
+        return;
+    }
+
+    /* -------------------- WHOLE FILE -------------------- */
+
+    // Chunked: the active session may grow while it is sent
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/octet-stream", "");
+    streamFile(file, size);
+    server.sendContent("");
+    file.close();
+}
+
+// Sends the cells of a grid level lying in the requested tile, in JSON.
+// The tile is given in cells by x0, y0, x1 and y1, the whole level by default
+static void handleGrid()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Level and tile requested
+    unsigned long level;
+    int16_t xMin, yMin, xMax, yMax;
+
+    // Page of cells and position of the next page
+    t_gridCell cells[LOGSERVER_GRID_PAGE];
+    uint16_t cursor = 0;
+    uint16_t count;
+
+    // Origin and cell sizes of the grid
+    double latitude, longitude;
+    float altitude;
+    uint16_t cellSize, altSize;
+
+    // Channel label without its trailing ':'
+    const char *name;
+
+    // One entry of the response and its length
+    char entry[256];
+    int length;
+
+    // Set once a cell has been sent
+    uint8_t first = 1;
+
+    /* -------------------- REQUEST -------------------- */
+
+    level = strtoul(server.pathArg(0).c_str(), NULL, 10);
+    cellSize = getGridCellSize((uint8_t)level, &altSize);
+
+    if (level >= GRID_LEVELS || cellSize == 0)
+    {
+        handleNotFound();
+        return;
+    }
+
+    xMin = server.hasArg("x0") ? (int16_t)atoi(server.arg("x0").c_str()) : INT16_MIN;
+    yMin = server.hasArg("y0") ? (int16_t)atoi(server.arg("y0").c_str()) : INT16_MIN;
+    xMax = server.hasArg("x1") ? (int16_t)atoi(server.arg("x1").c_str()) : INT16_MAX;
+    yMax = server.hasArg("y1") ? (int16_t)atoi(server.arg("y1").c_str()) : INT16_MAX;
+
+    /* -------------------- DESCRIPTION -------------------- */
+
+    // Sent page by page with chunked encoding
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    if (!getGridOrigin(&latitude, &longitude, &altitude))
+    {
+        server.sendContent("{\"origin\":null,\"cells\":[]}");
+        server.sendContent("");
+        return;
+    }
+
+    snprintf(entry, sizeof(entry),
+             "{\"origin\":{\"lat\":%.7f,\"lon\":%.7f,\"alt\":%.1f},\"level\":%lu,"
+             "\"size\":%u,\"altSize\":%u,\"channels\":[",
+             latitude, longitude, altitude, level, cellSize, altSize);
+    server.sendContent(entry);
+
+    for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+    {
+        name = getChannelName(getGridChannel(i));
+        snprintf(entry, sizeof(entry), "%s\"%.*s\"", i ? "," : "", (int)strlen(name) - 1, name);
+        server.sendContent(entry);
+    }
+
+    server.sendContent("],\"cells\":[");
+
+    /* -------------------- CELLS -------------------- */
+
+    // Samples keep being added between two pages
+    while ((count = queryGridTile((uint8_t)level, xMin, yMin, xMax, yMax, &cursor, cells,
+                                  LOGSERVER_GRID_PAGE)) > 0)
+    {
+        for (uint16_t c = 0; c < count; c++)
+        {
+            length = snprintf(entry, sizeof(entry), "%s{\"x\":%d,\"y\":%d,\"z\":%d,\"n\":[",
+                              first ? "" : ",", cells[c].x, cells[c].y, cells[c].z);
+
+            for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+            {
+                length += snprintf(entry + length, sizeof(entry) - length, "%s%u", i ? "," : "",
+                                   cells[c].count[i]);
+            }
+
+            length += snprintf(entry + length, sizeof(entry) - length, "],\"mean\":[");
+
+            // Channels without samples in the cell are null
+            for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+            {
+                if (cells[c].count[i])
+                {
+                    length += snprintf(entry + length, sizeof(entry) - length, "%s%ld",
+                                       i ? "," : "", (long)(cells[c].sum[i] / cells[c].count[i]));
+                }
+
+                else
+                {
+                    length += snprintf(entry + length, sizeof(entry) - length, "%snull",
+                                       i ? "," : "");
+                }
+            }
+
+            length += snprintf(entry + length, sizeof(entry) - length, "],\"max\":[");
+
+            for (uint8_t i = 0; i < GRID_CHANNELS; i++)
+            {
+                if (cells[c].count[i])
+                {
+                    length += snprintf(entry + length, sizeof(entry) - length, "%s%ld",
+                                       i ? "," : "", (long)cells[c].max[i]);
+                }
+
+                else
+                {
+                    length += snprintf(entry + length, sizeof(entry) - length, "%snull",
+                                       i ? "," : "");
+                }
+            }
+
+            snprintf(entry + length, sizeof(entry) - length, "]}");
+            server.sendContent(entry);
+            first = 0;
+        }
+    }
+
+    server.sendContent("]}");
+
+    // Empty chunk: end of the response
+    server.sendContent("");
+}
+
+// Answers requests to unknown paths
+static void handleNotFound()
+{
+    server.send(404, "text/plain", "Not Found");
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Parses a "bytes=start-end" range header
+static uint8_t parseRange(const char *header, uint32_t size, uint32_t *start, uint32_t *end)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // End of each number
+    char *stop;
+
+    // Numbers of the range
+    unsigned long first, last;
+
+    /* -------------------- RANGE PARSING -------------------- */
+
+    if (strncmp(header, "bytes=", 6) != 0 || size == 0)
+    {
+        return 0;
+    }
+
+    header += 6;
+
+    // Suffix range: the last bytes of the file
+    if (*header == '-')
+    {
+        last = strtoul(header + 1, &stop, 10);
+        if (stop == header + 1 || last == 0)
+        {
+            return 0;
+        }
+
+        *start = (last >= size) ? 0 : size - last;
+        *end = size - 1;
+        return 1;
+    }
+
+    first = strtoul(header, &stop, 10);
+    if (stop == header || *stop != '-' || first >= size)
+    {
+        return 0;
+    }
+
+    header = stop + 1;
+    last = strtoul(header, &stop, 10);
+
+    // Open range: up to the end of the file
+    if (stop == header || last >= size)
+    {
+        last = size - 1;
+    }
+
+    if (last < first)
+    {
+        return 0;
+    }
+
+    *start = first;
+    *end = last;
+    return 1;
+}
+
+// Streams part of a file to the client
+static void streamFile(File &file, uint32_t length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bytes read for the current chunk
+    size_t count;
+
+    /* -------------------- STREAMING -------------------- */
+
+    // Straight from flash, never more than one chunk in RAM
+    while (length > 0)
+    {
+        count = file.read(chunk, length < sizeof(chunk) ? length : sizeof(chunk));
+        if (count == 0)
+        {
+            break;
+        }
+
+        server.sendContent((const char *)chunk, count);
+        length -= count;
+    }
+}
@@ -0,0 +1,62 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef LOGSERVER_hpp
+#define LOGSERVER_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Password of the soft-AP, at least 8 characters
+#ifndef LOGSERVER_AP_PASSWORD
+#define LOGSERVER_AP_PASSWORD "aerosense"
+#endif
+
+// HTTP port of the server
+#define LOGSERVER_PORT 80
+
+// Bytes read from flash and sent at once
+#define LOGSERVER_CHUNK_SIZE 1460
+
+// Largest number of sessions listed in the index
+#define LOGSERVER_MAX_SESSIONS 32
+
+// Grid cells read from the aggregator at once
+#define LOGSERVER_GRID_PAGE 8
+
+// Server task: stack, priority and core (the loop runs on core 1)
+#define LOGSERVER_TASK_STACK    6144
+#define LOGSERVER_TASK_PRIORITY 1
+#define LOGSERVER_TASK_CORE     0
+
+// Longest wait for a stopping server before it can start again, the
+// request in progress is finished first
+#define LOGSERVER_STOP_WAIT_MS 3000
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Brings up the soft-AP and serves the recorded sessions over HTTP:
+// GET /sessions lists them in JSON, GET /sessions/<id> downloads one,
+// GET /grid/<level>?x0=&y0=&x1=&y1= sends the grid cells of a tile. A server still
+// stopping is waited for, LOGSERVER_STOP_WAIT_MS at most
+// @return: 1 if the server runs, 0 otherwise
+int startLogServer();
+
+// Stops the server and the soft-AP
+void stopLogServer();
+
+// Tells whether the server is running
+uint8_t isLogServerRunning();
+
+// Returns the address of the server, e.g. "192.168.4.1"
+// @param address: Destination buffer
+// @param size: Size of the destination buffer
+void getLogServerAddress(char *address, uint8_t size);
+
+#endif // LOGSERVER_hpp
@@ -0,0 +1,413 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file implements the small part of MQTT 3.1.1 needed to
+    publish telemetry: connection, QoS 0 and QoS 1 publishing and
+    keep alive. Incoming packets are parsed byte by byte from the
+    loop, so waiting for the broker never blocks the sensors.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the MQTT client
+#include "Mqtt.hpp"
+
+// TCP connection to the broker
+#include <WiFi.h>
+
+// strlen() and memcpy() of the topics and identifiers
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Control packet types, upper nibble of the first byte
+#define MQTT_PACKET_CONNECT    0x10
+#define MQTT_PACKET_CONNACK    0x20
+#define MQTT_PACKET_PUBLISH    0x30
+#define MQTT_PACKET_PUBACK     0x40
+#define MQTT_PACKET_PINGREQ    0xC0
+#define MQTT_PACKET_PINGRESP   0xD0
+#define MQTT_PACKET_DISCONNECT 0xE0
+
+// Head of a packet built before a single write: fixed header, then the
+// protocol name and flags of a CONNECT or the topic of a PUBLISH
+#define MQTT_HEAD_SIZE 128
+
+// Largest fixed header, 4 bytes of remaining length
+#define MQTT_FIXED_HEADER_SIZE 5
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// TCP connection to the broker
+static WiFiClient client;
+
+// State of the connection
+static e_mqttState state = MQTT_DISCONNECTED;
+
+// Times of the connection request, of the last packet sent and received
+static uint32_t connectMs = 0;
+static uint32_t lastTxMs = 0;
+static uint32_t lastRxMs = 0;
+
+// Identifier of the next QoS 1 message and of the last one acknowledged
+static uint16_t nextPacketId = 1;
+static uint16_t ackedPacketId = 0;
+
+// Incoming packet being parsed
+static uint8_t rxType = 0;
+static uint32_t rxRemaining = 0;
+static uint8_t rxLengthShift = 0;
+static uint8_t rxStage = 0;
+static uint8_t rxBody[MQTT_RX_BODY_SIZE];
+static uint8_t rxBodyLength = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Encodes a fixed header with its remaining length
+// @param buffer: Destination, MQTT_FIXED_HEADER_SIZE bytes at least
+// @param type: First byte of the packet
+// @param remaining: Number of bytes following the fixed header
+// @return: Length of the header
+static uint8_t putFixedHeader(uint8_t *buffer, uint8_t type, uint32_t remaining);
+
+// Encodes a length-prefixed string
+// @param buffer: Destination, length + 2 bytes at least
+// @param text: String to encode
+// @param length: Length of the string
+// @return: Length of the encoded string
+static uint8_t putString(uint8_t *buffer, const char *text, uint8_t length);
+
+// Sends a packet made of its fixed header only (PINGREQ, DISCONNECT)
+// @param type: First byte of the packet
+static void writeEmptyPacket(uint8_t type);
+
+// Feeds one received byte to the packet parser
+// @param data: Received byte
+// @param nowMs: Current time in milliseconds
+static void parseByte(uint8_t data, uint32_t nowMs);
+
+// Handles a complete incoming packet
+// @param nowMs: Current time in milliseconds
+static void handlePacket(uint32_t nowMs);
+
+
+/* *****************************************************************
+    *                    CONNECTION FUNCTIONS                     *
+   ***************************************************************** */
+
+// Opens the connection to a broker (MQTT 3.1.1, clean session)
+// @param host: Host name or address of the broker
+// @param port: TCP port of the broker
+// @param clientId: Client identifier, unique on the broker
+// @param nowMs: Current time in milliseconds
+// @return: 1 if the request was sent, 0 otherwise
+int mqttConnect(const char *host, uint16_t port, const char *clientId, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Whole CONNECT packet and its length
+    uint8_t head[MQTT_HEAD_SIZE];
+    uint8_t used;
+
+    // Length of the client identifier
+    size_t idLength = strlen(clientId);
+
+    /* -------------------- CONNECT PACKET -------------------- */
+
+    mqttDisconnect();
+
+    if (idLength > MQTT_HEAD_SIZE - MQTT_FIXED_HEADER_SIZE - 12)
+    {
+        return 0;
+    }
+
+    if (!client.connect(host, port, MQTT_TCP_TIMEOUT_MS))
+    {
+        return 0;
+    }
+
+    // Small packets, do not wait to fill a TCP segment. Each packet is
+    // built first so it leaves in one or two writes, not one per field
+    client.setNoDelay(true);
+
+    // Protocol name, level 4, clean session, keep alive, client identifier
+    used = putFixedHeader(head, MQTT_PACKET_CONNECT, 10 + 2 + idLength);
+    used += putString(head + used, "MQTT", 4);
+    head[used++] = 4;
+    head[used++] = 0x02;
+    head[used++] = MQTT_KEEPALIVE_S >> 8;
+    head[used++] = MQTT_KEEPALIVE_S & 0xFF;
+    used += putString(head + used, clientId, idLength);
+
+    if (client.write(head, used) != used)
+    {
+        client.stop();
+        return 0;
+    }
+
+    state = MQTT_CONNECTING;
+    connectMs = nowMs;
+    lastTxMs = nowMs;
+    lastRxMs = nowMs;
+    rxStage = 0;
+
+    return 1;
+}
+
+// Closes the connection to the broker
+void mqttDisconnect()
+{
+    if (state == MQTT_CONNECTED)
+    {
+        writeEmptyPacket(MQTT_PACKET_DISCONNECT);
+    }
+
+    client.stop();
+    state = MQTT_DISCONNECTED;
+}
+
+// Processes the packets of the broker and keeps the connection alive
+// @param nowMs: Current time in milliseconds
+void serviceMqtt(uint32_t nowMs)
+{
+    if (state == MQTT_DISCONNECTED)
+    {
+        return;
+    }
+
+    /* -------------------- LINK CHECK -------------------- */
+
+    if (!client.connected() ||
+        (state == MQTT_CONNECTING && nowMs - connectMs > MQTT_CONNECT_TIMEOUT_MS) ||
+        (nowMs - lastRxMs > MQTT_KEEPALIVE_S * 1500UL))
+    {
+        mqttDisconnect();
+        return;
+    }
+
+    /* -------------------- INCOMING PACKETS -------------------- */
+
+    while (client.available())
+    {
+        parseByte((uint8_t)client.read(), nowMs);
+    }
+
+    /* -------------------- KEEP ALIVE -------------------- */
+
+    // Ping at half the keep alive, the broker drops us at 1.5 times. Pings
+    // are sent even while publishing, they also prove the broker answers
+    if (state == MQTT_CONNECTED && nowMs - lastTxMs > MQTT_KEEPALIVE_S * 500UL)
+    {
+        writeEmptyPacket(MQTT_PACKET_PINGREQ);
+        lastTxMs = nowMs;
+    }
+}
+
+// Returns the state of the connection to the broker
+e_mqttState getMqttState()
+{
+    return state;
+}
+
+
+/* *****************************************************************
+    *                      PUBLISH FUNCTIONS                      *
+   ***************************************************************** */
+
+// Publishes a message
+// @param topic: Topic of the message
+// @param payload: Content of the message
+// @param length: Length of the content
+// @param qos: Quality of service, 0 or 1
+// @return: Packet identifier to wait for with QoS 1, non-zero when sent with QoS 0, 0 on failure
+uint16_t mqttPublish(const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Identifier of the message
+    uint16_t packetId = 1;
+
+    // Fixed header, topic and packet identifier, and their length
+    uint8_t head[MQTT_HEAD_SIZE];
+    uint8_t used;
+
+    // Length of the topic
+    size_t topicLength = strlen(topic);
+
+    /* -------------------- PUBLISH PACKET -------------------- */
+
+    if (state != MQTT_CONNECTED || topicLength > MQTT_HEAD_SIZE - MQTT_FIXED_HEADER_SIZE - 4)
+    {
+        return 0;
+    }
+
+    used = putFixedHeader(head, MQTT_PACKET_PUBLISH | (qos ? 0x02 : 0x00),
+                          2 + topicLength + (qos ? 2 : 0) + length);
+    used += putString(head + used, topic, topicLength);
+
+    if (qos)
+    {
+        packetId = nextPacketId;
+
+        // Zero is not a valid identifier
+        nextPacketId = (nextPacketId == 0xFFFF) ? 1 : nextPacketId + 1;
+
+        head[used++] = packetId >> 8;
+        head[used++] = packetId & 0xFF;
+    }
+
+    // Two writes, two segments at most with Nagle off
+    if (client.write(head, used) != used || client.write(payload, length) != length)
+    {
+        mqttDisconnect();
+        return 0;
+    }
+
+    return packetId;
+}
+
+// Tells whether the broker acknowledged a QoS 1 message
+// @param packetId: Identifier returned by mqttPublish()
+// @return: 1 if acknowledged, 0 otherwise
+uint8_t isMqttAcked(uint16_t packetId)
+{
+    return packetId != 0 && packetId == ackedPacketId;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Encodes a fixed header with its remaining length
+static uint8_t putFixedHeader(uint8_t *buffer, uint8_t type, uint32_t remaining)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Next byte of the variable length encoding, and bytes written
+    uint8_t encoded;
+    uint8_t used = 0;
+
+    /* -------------------- HEADER -------------------- */
+
+    buffer[used++] = type;
+
+    // 7 bits per byte, the high bit flags a following byte
+    do
+    {
+        encoded = remaining & 0x7F;
+        remaining >>= 7;
+        buffer[used++] = remaining ? (encoded | 0x80) : encoded;
+    } while (remaining);
+
+    return used;
+}
+
+// Encodes a length-prefixed string
+static uint8_t putString(uint8_t *buffer, const char *text, uint8_t length)
+{
+    buffer[0] = 0;
+    buffer[1] = length;
+    memcpy(buffer + 2, text, length);
+
+    return length + 2;
+}
+
+// Sends a packet made of its fixed header only (PINGREQ, DISCONNECT)
+static void writeEmptyPacket(uint8_t type)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Type and a remaining length of 0
+    uint8_t packet[2] = {type, 0};
+
+    /* -------------------- PACKET -------------------- */
+
+    client.write(packet, sizeof(packet));
+}
+
+// Feeds one received byte to the packet parser
+static void parseByte(uint8_t data, uint32_t nowMs)
+{
+    switch (rxStage)
+    {
+        // Packet type
+        case 0:
+            rxType = data & 0xF0;
+            rxRemaining = 0;
+            rxLengthShift = 0;
+            rxBodyLength = 0;
+            rxStage = 1;
+            break;
+
+        // Remaining length, 7 bits at a time
+        case 1:
+            rxRemaining |= (uint32_t)(data & 0x7F) << rxLengthShift;
+            rxLengthShift += 7;
+
+            if (!(data & 0x80))
+            {
+                rxStage = 2;
+
+                if (rxRemaining == 0)
+                {
+                    handlePacket(nowMs);
+                }
+            }
+            break;
+
+        // Body, only the first bytes are kept
+        default:
+            if (rxBodyLength < MQTT_RX_BODY_SIZE)
+            {
+                rxBody[rxBodyLength++] = data;
+            }
+
+            if (--rxRemaining == 0)
+            {
+                handlePacket(nowMs);
+            }
+            break;
+    }
+}
+
+// Handles a complete incoming packet
+static void handlePacket(uint32_t nowMs)
+{
+    rxStage = 0;
+    lastRxMs = nowMs;
+
+    switch (rxType)
+    {
+        case MQTT_PACKET_CONNACK:
+            // Return code 0 means accepted
+            if (rxBodyLength >= 2 && rxBody[1] == 0)
+            {
+                state = MQTT_CONNECTED;
+            }
+
+            else
+            {
+                mqttDisconnect();
+            }
+            break;
+
+        case MQTT_PACKET_PUBACK:
+            if (rxBodyLength >= 2)
+            {
+                ackedPacketId = ((uint16_t)rxBody[0] << 8) | rxBody[1];
+            }
+            break;
+
+        // PINGRESP and anything else only prove the link is alive
+        default:
+            break;
+    }
+}
@@ -0,0 +1,72 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef MQTT_hpp
+#define MQTT_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Keep alive announced to the broker in seconds
+#define MQTT_KEEPALIVE_S 30
+
+// Longest wait for the broker to accept the connection
+#define MQTT_CONNECT_TIMEOUT_MS 5000
+
+// Timeout of the TCP connection to the broker
+#define MQTT_TCP_TIMEOUT_MS 2000
+
+// Bytes of an incoming packet kept, longer packets are skipped
+#define MQTT_RX_BODY_SIZE 4
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// State of the connection to the broker
+typedef enum
+{
+    MQTT_DISCONNECTED,
+    MQTT_CONNECTING,
+    MQTT_CONNECTED
+
+} e_mqttState;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Opens the connection to a broker (MQTT 3.1.1, clean session)
+// @param host: Host name or address of the broker
+// @param port: TCP port of the broker
+// @param clientId: Client identifier, unique on the broker
+// @param nowMs: Current time in milliseconds
+// @return: 1 if the request was sent, 0 otherwise
+int mqttConnect(const char *host, uint16_t port, const char *clientId, uint32_t nowMs);
+
+// Closes the connection to the broker
+void mqttDisconnect();
+
+// Processes the packets of the broker and keeps the connection alive
+// @param nowMs: Current time in milliseconds
+void serviceMqtt(uint32_t nowMs);
+
+// Returns the state of the connection to the broker
+e_mqttState getMqttState();
+
+// Publishes a message
+// @param topic: Topic of the message
+// @param payload: Content of the message
+// @param length: Length of the content
+// @param qos: Quality of service, 0 or 1
+// @return: Packet identifier to wait for with QoS 1, non-zero when sent with QoS 0, 0 on failure
+uint16_t mqttPublish(const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos);
+
+// Tells whether the broker acknowledged a QoS 1 message
+// @param packetId: Identifier returned by mqttPublish()
+// @return: 1 if acknowledged, 0 otherwise
+uint8_t isMqttAcked(uint16_t packetId);
+
+#endif // MQTT_hpp
@@ -0,0 +1,333 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file holds the logic of a swarm of AeroSense units: nodes
+    send their sample sets as binary frames, followed by parity
+    frames, and a gateway tracks the sequence of every node before
+    forwarding its frames, rebuilding the lost ones it can. The radio
+    is reached through callbacks only, so the same code runs on
+    ESP-NOW or against a simulated radio on a host.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the swarm logic
+#include "Swarm.hpp"
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Identifier of this unit and sequence number of its next frame
+static uint16_t localId = 0;
+static uint16_t nextSeq = 0;
+
+// Radio and uplink callbacks
+static t_swarmSend sendFrame = 0;
+static t_swarmDeliver deliverFrame = 0;
+
+// Nodes heard by the gateway
+static t_swarmNode nodes[SWARM_MAX_NODES];
+static uint8_t nodeCount = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Returns the entry of a node, creating it if needed
+// @param nodeId: Identifier of the node
+// @param created: Set to 1 when the entry was just created
+// @return: Entry of the node
+static t_swarmNode *findNode(uint16_t nodeId, uint8_t *created);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Initializes the swarm logic, independent of the radio used
+// @param nodeId: Identifier of this unit
+// @param send: Function transmitting the frames of a node
+// @param deliver: Function receiving the frames accepted by a gateway
+void initSwarm(uint16_t nodeId, t_swarmSend send, t_swarmDeliver deliver)
+{
+    localId = nodeId;
+    nextSeq = 0;
+    sendFrame = send;
+    deliverFrame = deliver;
+    nodeCount = 0;
+}
+
+
+/* *****************************************************************
+    *                       NODE FUNCTIONS                        *
+   ***************************************************************** */
+
+// Sends a sample set to the gateway
+// @param set: Sample set to send
+// @param timeUs: Time of the frame
+// @param timeOffsetUs: Converts the capture times to the time base of the frame
+// @param flags: Frame flags (FRAME_FLAG_x)
+// @return: 1 if the frame was queued, 0 otherwise
+uint8_t swarmNodeSend(const t_sampleSet *set, uint64_t timeUs, int64_t timeOffsetUs,
+                      uint8_t flags)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Frame being built
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t length;
+
+    // Header of the frame
+    t_frameHeader header;
+
+    // Parity frame closing a block
+    uint8_t parity[FEC_PARITY_MAX_SIZE];
+    uint8_t parityLength;
+
+    // Result of the frame transmission
+    uint8_t sent;
+
+    /* -------------------- TRANSMISSION -------------------- */
+
+    if (!sendFrame)
+    {
+        return 0;
+    }
+
+    header.type = FRAME_TYPE_SAMPLES;
+    header.flags = flags;
+    header.nodeId = localId;
+    header.seq = nextSeq;
+    header.timeUs = timeUs;
+
+    length = encodeSampleFrame(set, &header, timeOffsetUs, frame, sizeof(frame));
+
+    // The sequence advances even on failure, the gateway counts it as lost
+    nextSeq++;
+
+    if (!length)
+    {
+        return 0;
+    }
+
+    sent = sendFrame(frame, length);
+
+    /* -------------------- PARITY -------------------- */
+
+    // A frame the radio refused is in the parity too, the gateway can rebuild it
+    if (addFecFrame(frame, length, header.seq))
+    {
+        for (uint8_t group = 0; group < getFecDepth(); group++)
+        {
+            parityLength = encodeFecParity(group, localId, parity, sizeof(parity));
+
+            if (parityLength)
+            {
+                sendFrame(parity, parityLength);
+            }
+        }
+    }
+
+    return sent;
+}
+
+
+/* *****************************************************************
+    *                      GATEWAY FUNCTIONS                      *
+   ***************************************************************** */
+
+// Processes a frame received by the gateway
+// @param frame: Received frame
+// @param length: Length of the received frame
+// @param nowMs: Current time in milliseconds
+// @return: 1 if the frame was delivered, 0 if it was invalid or a duplicate
+uint8_t swarmGatewayReceive(const uint8_t *frame, uint8_t length, uint32_t nowMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Decoded frame
+    t_frameHeader header;
+    t_sampleSet set;
+
+    // Frame rebuilt from a parity frame
+    uint8_t rebuilt[FRAME_MAX_SIZE];
+    uint8_t rebuiltLength = 0;
+
+    // Entry of the sender
+    t_swarmNode *node;
+    uint8_t created;
+
+    // Distance from the last accepted sequence number, modulo 2^16
+    uint16_t gap;
+
+    /* -------------------- FRAME CHECK -------------------- */
+
+    // A parity frame only brings the frame of its group that was lost
+    if (length > 2 && frame[2] == FRAME_TYPE_PARITY)
+    {
+        rebuiltLength = recoverFecFrame(frame, length, rebuilt);
+
+        if (!rebuiltLength)
+        {
+            return 0;
+        }
+
+        frame = rebuilt;
+        length = rebuiltLength;
+    }
+
+    if (!decodeSampleFrame(frame, length, &header, &set) || header.nodeId == localId)
+    {
+        return 0;
+    }
+
+    if (!rebuiltLength)
+    {
+        storeFecFrame(frame, length);
+    }
+
+    node = findNode(header.nodeId, &created);
+
+    /* -------------------- SEQUENCE TRACKING -------------------- */
+
+    if (rebuiltLength)
+    {
+        node->recovered++;
+    }
+
+    if (!created)
+    {
+        gap = (uint16_t)(header.seq - node->lastSeq);
+
+        // A rebuilt frame is usually behind the last one, it was counted as lost
+        if (rebuiltLength && gap > 0x8000 && (uint16_t)(0 - gap) < SWARM_RESTART_GAP)
+        {
+            if (node->lost > 0)
+            {
+                node->lost--;
+            }
+
+            node->received++;
+
+            if (deliverFrame)
+            {
+                deliverFrame(&header, &set, node);
+            }
+
+            return 1;
+        }
+
+        // Repeated or late frame, already delivered or counted as lost
+        if (gap == 0 || (gap > 0x8000 && (uint16_t)(0 - gap) < SWARM_RESTART_GAP))
+        {
+            node->duplicates++;
+            return 0;
+        }
+
+        // Ahead: the frames in between were lost. Far behind: the node
+        // restarted its sequence, resynchronise without counting losses
+        if (gap < 0x8000)
+        {
+            node->lost += gap - 1;
+        }
+    }
+
+    node->lastSeq = header.seq;
+    node->received++;
+    node->lastSeenMs = nowMs;
+
+    /* -------------------- DELIVERY -------------------- */
+
+    if (deliverFrame)
+    {
+        deliverFrame(&header, &set, node);
+    }
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                         NODE TABLE                          *
+   ***************************************************************** */
+
+// Returns the number of nodes tracked by the gateway
+uint8_t getSwarmNodeCount()
+{
+    return nodeCount;
+}
+
+// Retrieves the reception statistics of a tracked node
+// @param index: Index of the node, below getSwarmNodeCount()
+// @param node: Pointer to structure where the statistics will be stored
+// @return: 1 if the node exists, 0 otherwise
+uint8_t getSwarmNode(uint8_t index, t_swarmNode *node)
+{
+    if (index >= nodeCount)
+    {
+        return 0;
+    }
+
+    *node = nodes[index];
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the entry of a node, creating it if needed
+static t_swarmNode *findNode(uint16_t nodeId, uint8_t *created)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Entry given to a new node
+    uint8_t slot = 0;
+
+    /* -------------------- LOOKUP -------------------- */
+
+    *created = 0;
+
+    for (uint8_t i = 0; i < nodeCount; i++)
+    {
+        if (nodes[i].nodeId == nodeId)
+        {
+            return &nodes[i];
+        }
+    }
+
+    /* -------------------- CREATION -------------------- */
+
+    if (nodeCount < SWARM_MAX_NODES)
+    {
+        slot = nodeCount++;
+    }
+
+    else
+    {
+        // Table full: reuse the node silent for the longest time
+        for (uint8_t i = 1; i < SWARM_MAX_NODES; i++)
+        {
+            if (nodes[i].lastSeenMs < nodes[slot].lastSeenMs)
+            {
+                slot = i;
+            }
+        }
+    }
+
+    nodes[slot].nodeId = nodeId;
+    nodes[slot].lastSeq = 0;
+    nodes[slot].received = 0;
+    nodes[slot].lost = 0;
+    nodes[slot].duplicates = 0;
+    nodes[slot].recovered = 0;
+    nodes[slot].lastSeenMs = 0;
+
+    *created = 1;
+    return &nodes[slot];
+}
@@ -0,0 +1,115 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef SWARM_hpp
+#define SWARM_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Sample sets and binary frames exchanged by the nodes
+#include "../processing/Channels.hpp"
+#include "Frame.hpp"
+
+// Parity frames protecting them
+#include "Fec.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Roles of a unit in a swarm
+#define SWARM_ROLE_STANDALONE 0
+#define SWARM_ROLE_NODE       1
+#define SWARM_ROLE_GATEWAY    2
+
+// Role of this unit, chosen at build time (-DSWARM_ROLE=...)
+#ifndef SWARM_ROLE
+#define SWARM_ROLE SWARM_ROLE_STANDALONE
+#endif
+
+// Number of nodes tracked by a gateway
+#define SWARM_MAX_NODES 16
+
+// Every node tracked keeps its frames for the FEC
+static_assert(FEC_MAX_NODES >= SWARM_MAX_NODES, "FEC histories must cover every swarm node");
+
+// Frames this far behind the last one mean the node restarted
+#define SWARM_RESTART_GAP 64
+
+// Largest frame on the radio, a parity frame
+#define SWARM_MAX_FRAME_SIZE FEC_PARITY_MAX_SIZE
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Reception statistics of one node, kept by the gateway
+typedef struct
+{
+    // Identifier of the node
+    uint16_t nodeId;
+
+    // Sequence number of the last accepted frame
+    uint16_t lastSeq;
+
+    // Frames accepted, missing from the sequence and received twice
+    uint32_t received;
+    uint32_t lost;
+    uint32_t duplicates;
+
+    // Frames rebuilt from parity frames, counted as received, not lost
+    uint32_t recovered;
+
+    // Time of the last accepted frame in milliseconds
+    uint32_t lastSeenMs;
+
+} t_swarmNode;
+
+// Transmits a frame over the radio
+// @param frame: Frame to send
+// @param length: Length of the frame
+// @return: 1 if the frame was queued, 0 otherwise
+typedef uint8_t (*t_swarmSend)(const uint8_t *frame, uint8_t length);
+
+// Hands a frame accepted by the gateway to the uplink
+// @param header: Header of the frame
+// @param set: Samples of the frame, times in the frame time base
+// @param node: Reception statistics of the sender
+typedef void (*t_swarmDeliver)(const t_frameHeader *header, const t_sampleSet *set,
+                               const t_swarmNode *node);
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Initializes the swarm logic, independent of the radio used
+// @param nodeId: Identifier of this unit
+// @param send: Function transmitting the frames of a node
+// @param deliver: Function receiving the frames accepted by a gateway
+void initSwarm(uint16_t nodeId, t_swarmSend send, t_swarmDeliver deliver);
+
+// Sends a sample set to the gateway
+// @param set: Sample set to send
+// @param timeUs: Time of the frame
+// @param timeOffsetUs: Converts the capture times to the time base of the frame
+// @param flags: Frame flags (FRAME_FLAG_x)
+// @return: 1 if the frame was queued, 0 otherwise
+uint8_t swarmNodeSend(const t_sampleSet *set, uint64_t timeUs, int64_t timeOffsetUs,
+                      uint8_t flags);
+
+// Processes a frame received by the gateway
+// @param frame: Received frame
+// @param length: Length of the received frame
+// @param nowMs: Current time in milliseconds
+// @return: 1 if the frame was delivered, 0 if it was invalid or a duplicate
+uint8_t swarmGatewayReceive(const uint8_t *frame, uint8_t length, uint32_t nowMs);
+
+// Returns the number of nodes tracked by the gateway
+uint8_t getSwarmNodeCount();
+
+// Retrieves the reception statistics of a tracked node
+// @param index: Index of the node, below getSwarmNodeCount()
+// @param node: Pointer to structure where the statistics will be stored
+// @return: 1 if the node exists, 0 otherwise
+uint8_t getSwarmNode(uint8_t index, t_swarmNode *node);
+
+#endif // SWARM_hpp
@@ -0,0 +1,607 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file sends the samples of a ground station over Wi-Fi.
+    Samples are grouped in columnar batches published over MQTT or
+    sent as UDP datagrams, after a schema frame describing the
+    channels. When enabled, the batches are compressed into packed
+    frames, which the schema announces. While the network or the
+    collector is down, batches wait in RAM and the oldest ones are
+    moved to a backlog file in flash, sent first once the link is
+    back.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the Wi-Fi uplink
+#include "Uplink.hpp"
+
+// MQTT client used by the MQTT transport
+#include "Mqtt.hpp"
+
+// Identity of the unit, used in the batches and the topic
+#include "../system/Identity.hpp"
+
+// Compression of the batches
+#include "Compress.hpp"
+
+// Arduino core, Wi-Fi station and flash file system
+#include <Arduino.h>
+#include <WiFi.h>
+#include <LittleFS.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Encoded batch waiting to be sent
+typedef struct
+{
+    uint16_t length;
+    uint8_t data[FRAME_BATCH_MAX_SIZE];
+
+} t_uplinkBatch;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Samples of the batch being filled
+static t_sampleSet batchSets[FRAME_BATCH_MAX_SAMPLES];
+static uint64_t batchTimes[FRAME_BATCH_MAX_SAMPLES];
+static uint8_t batchCount = 0;
+static uint8_t batchFlags = 0;
+static uint32_t batchStartMs = 0;
+static uint16_t batchSeq = 0;
+
+// Closed batches, oldest at ramHead
+static t_uplinkBatch ramQueue[UPLINK_RAM_BATCHES];
+static uint8_t ramHead = 0;
+static uint8_t ramCount = 0;
+
+// Flash backlog: mounted, size of the file and read position
+static uint8_t backlogMounted = 0;
+static uint32_t backlogSize = 0;
+static uint32_t backlogRead = 0;
+
+// Batch being sent, kept until it is confirmed
+static t_uplinkBatch sending;
+static uint8_t sendingValid = 0;
+static uint16_t sendingPacketId = 0;
+static uint32_t sendingMs = 0;
+
+// Connection state and reconnection delay
+static e_uplinkState state = UPLINK_DISABLED;
+static uint32_t retryMs = 0;
+static uint32_t backoffMs = UPLINK_RETRY_MIN_MS;
+
+// Schema frame sent ahead of the batches, time it was last sent and
+// whether it announced packed batches
+static uint8_t schema[FRAME_SCHEMA_MAX_SIZE];
+static uint8_t schemaSent = 0;
+static uint32_t schemaMs = 0;
+static uint8_t schemaPacked = 0;
+
+// Counters reported by getUplinkStatus()
+static uint32_t sentCount = 0;
+static uint32_t droppedCount = 0;
+
+// Topic of the batches and client identifier of the unit
+static char topic[DEVICE_NAME_SIZE + sizeof(UPLINK_TOPIC_PREFIX) + sizeof(UPLINK_TOPIC_SUFFIX)];
+static char clientId[DEVICE_NAME_SIZE];
+
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_UDP
+// Socket used to send the datagrams
+static WiFiUDP udp;
+#endif
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Encodes the batch being filled and queues it
+static void closeBatch();
+
+// Appends a batch to the flash backlog
+// @param batch: Batch to store
+static void spillBatch(const t_uplinkBatch *batch);
+
+// Takes the oldest waiting batch, from flash first
+// @return: 1 if a batch was loaded into the sending buffer, 0 otherwise
+static uint8_t loadNextBatch();
+
+// Brings the Wi-Fi station and the transport up, with exponential backoff
+// @param nowMs: Current time in milliseconds
+// @return: 1 if batches can be sent, 0 otherwise
+static uint8_t maintainLink(uint32_t nowMs);
+
+// Sends the batch of the sending buffer
+// @param nowMs: Current time in milliseconds
+// @return: 1 once the batch is confirmed, 0 otherwise
+static uint8_t transmitBatch(uint32_t nowMs);
+
+// Sends the schema frame, without waiting for an acknowledgement
+// @return: 1 if the schema was handed to the transport, 0 otherwise
+static uint8_t transmitSchema();
+
+// Schedules the next connection attempt after a failure
+// @param nowMs: Current time in milliseconds
+static void scheduleRetry(uint32_t nowMs);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Starts the Wi-Fi station and mounts the backlog, after ESP-NOW if both are used
+// @return: 1 if the uplink is configured, 0 if it stays disabled
+int initUplink()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Backlog left by the previous run
+    File file;
+
+    /* -------------------- CONFIGURATION -------------------- */
+
+    if (UPLINK_WIFI_SSID[0] == '\0' || UPLINK_HOST[0] == '\0')
+    {
+        state = UPLINK_DISABLED;
+        return 0;
+    }
+
+    getDeviceName(clientId, sizeof(clientId));
+    snprintf(topic, sizeof(topic), "%s%s%s", UPLINK_TOPIC_PREFIX, clientId, UPLINK_TOPIC_SUFFIX);
+
+    /* -------------------- BACKLOG -------------------- */
+
+    // Format on first use, the partition holds nothing else yet
+    backlogMounted = LittleFS.begin(true);
+
+    if (backlogMounted && LittleFS.exists(UPLINK_BACKLOG_PATH))
+    {
+        // Batches of the previous run are sent again from the start
+        file = LittleFS.open(UPLINK_BACKLOG_PATH, FILE_READ);
+        backlogSize = file ? file.size() : 0;
+        file.close();
+    }
+
+    /* -------------------- WI-FI STATION -------------------- */
+
+    // Reconnections are handled here, with a backoff
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+    WiFi.begin(UPLINK_WIFI_SSID, UPLINK_WIFI_PASSWORD);
+
+    state = UPLINK_WIFI_CONNECTING;
+    retryMs = millis() + backoffMs;
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                       BATCH FUNCTIONS                       *
+   ***************************************************************** */
+
+// Adds a sample set to the current batch
+// @param set: Sample set to add
+// @param timeUs: Time of the sample set
+// @param flags: Frame flags matching the time (FRAME_FLAG_x)
+void addUplinkSample(const t_sampleSet *set, uint64_t timeUs, uint8_t flags)
+{
+    if (state == UPLINK_DISABLED)
+    {
+        return;
+    }
+
+    // All the samples of a batch share the same time base
+    if (batchCount > 0 && flags != batchFlags)
+    {
+        closeBatch();
+    }
+
+    if (batchCount == 0)
+    {
+        batchFlags = flags;
+        batchStartMs = millis();
+    }
+
+    batchSets[batchCount] = *set;
+    batchTimes[batchCount] = timeUs;
+    batchCount++;
+
+    if (batchCount == FRAME_BATCH_MAX_SAMPLES)
+    {
+        closeBatch();
+    }
+}
+
+
+/* *****************************************************************
+    *                      SERVICE FUNCTION                       *
+   ***************************************************************** */
+
+// Closes due batches, keeps the links up and sends the queued batches
+void serviceUplink()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of this service
+    uint32_t nowMs = millis();
+
+    /* -------------------- BATCH TIMEOUT -------------------- */
+
+    if (state == UPLINK_DISABLED)
+    {
+        return;
+    }
+
+    if (batchCount > 0 && nowMs - batchStartMs >= UPLINK_BATCH_MS)
+    {
+        closeBatch();
+    }
+
+    /* -------------------- TRANSMISSION -------------------- */
+
+    if (!maintainLink(nowMs))
+    {
+        schemaSent = 0;
+        return;
+    }
+
+    // The schema goes first on a new connection, then now and then, and
+    // again when the compression is switched
+    if (!schemaSent || nowMs - schemaMs >= UPLINK_SCHEMA_PERIOD_MS ||
+        schemaPacked != isCompressionEnabled())
+    {
+        schemaSent = transmitSchema();
+        schemaMs = nowMs;
+        return;
+    }
+
+    // One batch per service, the loop keeps running between them
+    if (!sendingValid && !loadNextBatch())
+    {
+        return;
+    }
+
+    if (transmitBatch(nowMs))
+    {
+        sendingValid = 0;
+        sentCount++;
+    }
+}
+
+
+/* *****************************************************************
+    *                      STATUS FUNCTIONS                       *
+   ***************************************************************** */
+
+// Retrieves the counters of the uplink
+// @param status: Pointer to structure where the counters will be stored
+void getUplinkStatus(t_uplinkStatus *status)
+{
+    status->state = state;
+    status->sent = sentCount;
+    status->queued = ramCount;
+    status->dropped = droppedCount;
+    status->backlogBytes = backlogSize - backlogRead;
+}
+
+// Returns a short printable name for an uplink state
+// @param state: Uplink state
+// @return: Constant string describing the state
+const char *getUplinkStateName(e_uplinkState state)
+{
+    switch (state)
+    {
+        case UPLINK_WIFI_CONNECTING:
+            return "WIFI";
+
+        case UPLINK_LINK_CONNECTING:
+            return "LINK";
+
+        case UPLINK_READY:
+            return "READY";
+
+        default:
+            return "DISABLED";
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Encodes the batch being filled and queues it
+static void closeBatch()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Header of the batch
+    t_frameHeader header;
+
+    // Slot receiving the batch
+    t_uplinkBatch *slot;
+
+    // Batch compressed into a packed frame
+    uint8_t packed[FRAME_BATCH_MAX_SIZE];
+    uint16_t packedLength;
+
+    /* -------------------- QUEUE SLOT -------------------- */
+
+    if (ramCount == UPLINK_RAM_BATCHES)
+    {
+        // Outage: the oldest batch goes to flash to make room
+        spillBatch(&ramQueue[ramHead]);
+        ramHead = (ramHead + 1) % UPLINK_RAM_BATCHES;
+        ramCount--;
+    }
+
+    slot = &ramQueue[(ramHead + ramCount) % UPLINK_RAM_BATCHES];
+
+    /* -------------------- ENCODING -------------------- */
+
+    header.type = FRAME_TYPE_BATCH;
+    header.flags = batchFlags;
+    header.nodeId = getNodeId();
+    header.seq = batchSeq++;
+    header.timeUs = batchTimes[0];
+
+    slot->length = encodeSampleBatch(batchSets, batchTimes, batchCount, &header,
+                                     slot->data, sizeof(slot->data));
+    batchCount = 0;
+
+    // Kept only if smaller than the batch, the collector accepts both
+    if (slot->length && isCompressionEnabled())
+    {
+        packedLength = encodePackedFrame(slot->data, slot->length, &header, packed,
+                                         slot->length - 1);
+
+        if (packedLength)
+        {
+            memcpy(slot->data, packed, packedLength);
+            slot->length = packedLength;
+        }
+    }
+
+    if (slot->length)
+    {
+        ramCount++;
+    }
+}
+
+// Appends a batch to the flash backlog
+static void spillBatch(const t_uplinkBatch *batch)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Backlog file
+    File file;
+
+    /* -------------------- APPEND -------------------- */
+
+    if (!backlogMounted || backlogSize + 2 + batch->length > UPLINK_BACKLOG_MAX_BYTES)
+    {
+        droppedCount++;
+        return;
+    }
+
+    file = LittleFS.open(UPLINK_BACKLOG_PATH, FILE_APPEND);
+    if (!file)
+    {
+        droppedCount++;
+        return;
+    }
+
+    // Records are the length on 2 bytes followed by the batch
+    file.write((uint8_t)(batch->length & 0xFF));
+    file.write((uint8_t)(batch->length >> 8));
+    file.write(batch->data, batch->length);
+    file.close();
+
+    backlogSize += 2 + batch->length;
+}
+
+// Takes the oldest waiting batch, from flash first
+static uint8_t loadNextBatch()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Backlog file
+    File file;
+
+    // Length prefix of the record
+    uint8_t prefix[2];
+
+    /* -------------------- FLASH BACKLOG -------------------- */
+
+    if (backlogRead < backlogSize)
+    {
+        file = LittleFS.open(UPLINK_BACKLOG_PATH, FILE_READ);
+
+        if (file && file.seek(backlogRead) && file.read(prefix, 2) == 2)
+        {
+            sending.length = prefix[0] | ((uint16_t)prefix[1] << 8);
+
+            if (sending.length <= FRAME_BATCH_MAX_SIZE &&
+                file.read(sending.data, sending.length) == sending.length)
+            {
+                file.close();
+                backlogRead += 2 + sending.length;
+                sendingValid = 1;
+                sendingPacketId = 0;
+                return 1;
+            }
+        }
+
+        // Unreadable record, nothing after it can be trusted
+        if (file)
+        {
+            file.close();
+        }
+
+        backlogRead = backlogSize;
+    }
+
+    // Backlog fully sent, start a new file
+    if (backlogSize > 0)
+    {
+        LittleFS.remove(UPLINK_BACKLOG_PATH);
+        backlogSize = 0;
+        backlogRead = 0;
+    }
+
+    /* -------------------- RAM QUEUE -------------------- */
+
+    if (ramCount == 0)
+    {
+        return 0;
+    }
+
+    sending = ramQueue[ramHead];
+    ramHead = (ramHead + 1) % UPLINK_RAM_BATCHES;
+    ramCount--;
+
+    sendingValid = 1;
+    sendingPacketId = 0;
+    return 1;
+}
+
+// Brings the Wi-Fi station and the transport up, with exponential backoff
+static uint8_t maintainLink(uint32_t nowMs)
+{
+    /* -------------------- WI-FI STATION -------------------- */
+
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        state = UPLINK_WIFI_CONNECTING;
+
+        if ((int32_t)(nowMs - retryMs) >= 0)
+        {
+            WiFi.disconnect();
+            WiFi.begin(UPLINK_WIFI_SSID, UPLINK_WIFI_PASSWORD);
+            scheduleRetry(nowMs);
+        }
+
+        return 0;
+    }
+
+    /* -------------------- TRANSPORT -------------------- */
+
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+    serviceMqtt(nowMs);
+
+    if (getMqttState() == MQTT_DISCONNECTED)
+    {
+        state = UPLINK_LINK_CONNECTING;
+
+        // A batch left unacknowledged is published again
+        sendingPacketId = 0;
+
+        // Backoff also applies to brokers accepting TCP but not MQTT
+        if ((int32_t)(nowMs - retryMs) >= 0)
+        {
+            mqttConnect(UPLINK_HOST, UPLINK_PORT, clientId, nowMs);
+            scheduleRetry(nowMs);
+        }
+
+        return 0;
+    }
+
+    if (getMqttState() == MQTT_CONNECTING)
+    {
+        return 0;
+    }
+#endif
+
+    // Link up, the next failure starts again from the shortest delay
+    state = UPLINK_READY;
+    backoffMs = UPLINK_RETRY_MIN_MS;
+    retryMs = nowMs;
+
+    return 1;
+}
+
+// Sends the batch of the sending buffer
+static uint8_t transmitBatch(uint32_t nowMs)
+{
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+    if (!sendingPacketId)
+    {
+        sendingPacketId = mqttPublish(topic, sending.data, sending.length, UPLINK_MQTT_QOS);
+        sendingMs = nowMs;
+
+        return sendingPacketId && !UPLINK_MQTT_QOS;
+    }
+
+    if (isMqttAcked(sendingPacketId))
+    {
+        return 1;
+    }
+
+    // No acknowledgement: reconnect, the batch is published again
+    if (nowMs - sendingMs > UPLINK_ACK_TIMEOUT_MS)
+    {
+        mqttDisconnect();
+        sendingPacketId = 0;
+    }
+
+    return 0;
+#else
+    // Datagrams are not acknowledged, a failure only comes from the stack
+    return udp.beginPacket(UPLINK_HOST, UPLINK_PORT) &&
+           udp.write(sending.data, sending.length) == sending.length && udp.endPacket();
+#endif
+}
+
+// Sends the schema frame, without waiting for an acknowledgement
+static uint8_t transmitSchema()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Header of the schema frame and its length
+    t_frameHeader header;
+    uint8_t schemaLength;
+
+    /* -------------------- ENCODING -------------------- */
+
+    // Built on every send, the flags follow the compression setting
+    schemaPacked = isCompressionEnabled();
+
+    header.type = FRAME_TYPE_SCHEMA;
+    header.flags = schemaPacked ? FRAME_FLAG_PACKED : 0;
+    header.nodeId = getNodeId();
+    header.seq = 0;
+    header.timeUs = 0;
+
+    schemaLength = encodeSchemaFrame((1UL << CH_COUNT) - 1, &header, schema, sizeof(schema));
+    if (!schemaLength)
+    {
+        return 1;
+    }
+
+    /* -------------------- TRANSMISSION -------------------- */
+
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+    return mqttPublish(topic, schema, schemaLength, 0) != 0;
+#else
+    return udp.beginPacket(UPLINK_HOST, UPLINK_PORT) &&
+           udp.write(schema, schemaLength) == schemaLength && udp.endPacket();
+#endif
+}
+
+// Schedules the next connection attempt after a failure
+static void scheduleRetry(uint32_t nowMs)
+{
+    retryMs = nowMs + backoffMs;
+    backoffMs *= 2;
+
+    if (backoffMs > UPLINK_RETRY_MAX_MS)
+    {
+        backoffMs = UPLINK_RETRY_MAX_MS;
+    }
+}
@@ -0,0 +1,132 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef UPLINK_hpp
+#define UPLINK_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Sample sets and batches sent to the ground station
+#include "../processing/Channels.hpp"
+#include "Frame.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Network and collector, set at build time. An empty SSID disables the uplink
+#ifndef UPLINK_WIFI_SSID
+#define UPLINK_WIFI_SSID ""
+#endif
+
+#ifndef UPLINK_WIFI_PASSWORD
+#define UPLINK_WIFI_PASSWORD ""
+#endif
+
+#ifndef UPLINK_HOST
+#define UPLINK_HOST ""
+#endif
+
+#ifndef UPLINK_PORT
+#define UPLINK_PORT 1883
+#endif
+
+// Transports: one UDP datagram or one MQTT message per batch
+#define UPLINK_TRANSPORT_UDP  0
+#define UPLINK_TRANSPORT_MQTT 1
+
+#ifndef UPLINK_TRANSPORT
+#define UPLINK_TRANSPORT UPLINK_TRANSPORT_MQTT
+#endif
+
+// MQTT quality of service, 1 retransmits until the broker acknowledges
+#ifndef UPLINK_MQTT_QOS
+#define UPLINK_MQTT_QOS 1
+#endif
+
+// Topic of the batches: prefix, device name, suffix
+#define UPLINK_TOPIC_PREFIX "aerosense/"
+#define UPLINK_TOPIC_SUFFIX "/batch"
+
+// A batch is closed when full or when its first sample is this old
+#define UPLINK_BATCH_MS 10000UL
+
+// Period of the uplink service task
+#define UPLINK_SERVICE_MS 100
+
+// Batches kept in RAM, older ones are moved to flash during outages
+#define UPLINK_RAM_BATCHES 6
+
+// Backlog file in flash and its largest size, the newest batches are
+// dropped beyond it
+#define UPLINK_BACKLOG_PATH      "/uplink.bin"
+#define UPLINK_BACKLOG_MAX_BYTES 262144UL
+
+// Reconnection delays, doubled after every failure. Joining a network
+// takes a few seconds, shorter delays would restart every attempt
+#define UPLINK_RETRY_MIN_MS 5000UL
+#define UPLINK_RETRY_MAX_MS 60000UL
+
+// Longest wait for the acknowledgement of a QoS 1 batch
+#define UPLINK_ACK_TIMEOUT_MS 5000UL
+
+// The schema frame is sent on every connection and again at this period,
+// so a collector started later can still decode the batches
+#define UPLINK_SCHEMA_PERIOD_MS 300000UL
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Progress of the uplink towards sending batches
+typedef enum
+{
+    UPLINK_DISABLED,
+    UPLINK_WIFI_CONNECTING,
+    UPLINK_LINK_CONNECTING,
+    UPLINK_READY
+
+} e_uplinkState;
+
+// Counters of the uplink
+typedef struct
+{
+    // Current state (e_uplinkState)
+    uint8_t state;
+
+    // Batches sent, waiting in RAM and dropped because the backlog was full
+    uint32_t sent;
+    uint8_t queued;
+    uint32_t dropped;
+
+    // Bytes waiting in the flash backlog
+    uint32_t backlogBytes;
+
+} t_uplinkStatus;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Starts the Wi-Fi station and mounts the backlog, after ESP-NOW if both are used
+// @return: 1 if the uplink is configured, 0 if it stays disabled
+int initUplink();
+
+// Adds a sample set to the current batch
+// @param set: Sample set to add
+// @param timeUs: Time of the sample set
+// @param flags: Frame flags matching the time (FRAME_FLAG_x)
+void addUplinkSample(const t_sampleSet *set, uint64_t timeUs, uint8_t flags);
+
+// Closes due batches, keeps the links up and sends the queued batches
+void serviceUplink();
+
+// Retrieves the counters of the uplink
+// @param status: Pointer to structure where the counters will be stored
+void getUplinkStatus(t_uplinkStatus *status);
+
+// Returns a short printable name for an uplink state
+// @param state: Uplink state
+// @return: Constant string describing the state
+const char *getUplinkStateName(e_uplinkState state);
+
+#endif // UPLINK_hpp
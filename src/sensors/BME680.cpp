@@ -4,7 +4,12 @@
    
     This file manages the initialization and data retrieval 
     from the BME680 sensor, including temperature, humidity, 
-    pressure, and gas resistance. VOC calculation has also been added.
+    pressure, and gas resistance. The gas resistance is turned into
+    an air quality index by the IAQ estimator. The calibration read
+    at the first boot is kept in the state store, later boots only
+    read back one block of it to check it still matches the chip.
+    A scan mode cycles the heater through a temperature ladder and
+    returns one gas resistance per step.
    
 */
 
@@ -18,17 +23,76 @@
 // Includes the header file for the BME680 sensor class
 #include "BME680.hpp"
 
+// Includes the health layer to report read errors
+#include "../system/Health.hpp"
+
+// Includes the shared I2C bus manager
+#include "../protocols/I2CBus.hpp"
+
+// Includes the air quality estimator
+#include "../processing/IAQ.hpp"
+
+// Includes the altitude filter fed with the full resolution pressure
+#include "../processing/Altitude.hpp"
+
+// Includes the time base used to timestamp the samples
+#include "../system/Timebase.hpp"
+
+// Includes the state store keeping the calibration across reboots
+#include "../storage/State.hpp"
+
 /* ---------------------- GLOBAL VARIABLES ---------------------- */
 
 // Object for interfacing with the BME680 sensor
 BME680_Class BME680;
 
+// Set once the sensor has been found and configured
+static uint8_t sensorReady = 0;
+
+// Set once the saved calibration has been looked up
+static uint8_t calibrationLoaded = 0;
+
+// Local time the conversion being read was triggered
+static uint64_t conversionUs = 0;
+
+// Heater ladder of the profile scan
+static uint16_t ladderTemps[BME680_HEATER_PROFILES];
+static uint16_t ladderDurations[BME680_HEATER_PROFILES];
+static uint8_t ladderSteps = 0;
+
+// Last measured ambient temperature, in hundredths of a degree
+static int32_t ambientTemp = 0;
+
+// Ambient temperature the heater registers were computed for
+static int32_t ladderAmbient = 0;
+
+// Ladder step giving the IAQ index, the one closest to BME680_GAS_TEMP
+static uint8_t vocStep = 0;
+
+// 1 while the profile scan is running
+static uint8_t scanning = 0;
+
+// Step whose measurement is in progress and when it was started
+static uint8_t scanStep = 0;
+static uint32_t stepMillis = 0;
+
+// Scan being filled and last complete scan
+static t_scanBME680 currentScan;
+static t_scanBME680 lastScan;
+static uint8_t newScan = 0;
+
+// Environmental values read by the scan, returned by getDataBME680()
+static t_dataBME680 scanData;
+static uint8_t scanDataValid = 0;
+
 /* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
 
-// Calculates VOC index from gas resistance
-// @param gasResistance: The measured gas resistance
-// @return: Calculated VOC index
-static int calculateVOCIndex(uint32_t gasResistance);
+// Writes the heater ladder and selects its first step, bus must be locked
+static void programLadder();
+
+// Copies the altitude estimate of the sample just filtered
+// @param data: Sample receiving the estimate
+static void storeAltitude(t_dataBME680 *data);
 
 
 /* *****************************************************************
@@ -39,36 +103,71 @@ static int calculateVOCIndex(uint32_t gasResistance);
 // @return: 1 if successful, 0 otherwise
 int initBME680()
 {
-    /* ------------------ LOCAL VARIABLES ------------------ */
+    /* ----------------- LOCAL VARIABLES ----------------- */
 
-    // Number of connection attempts remaining
-    uint8_t connectTry = 1;
+    // Raw calibration registers
+    uint8_t calibration[BME680_CALIBRATION_SIZE];
 
     /* ------------------ INITIALIZATION ------------------ */
 
-    // Attempt to initialize the sensor in I2C standard mode
-    while (!BME680.begin(I2C_STANDARD_MODE) && connectTry != 0)
+    sensorReady = 0;
+
+    if (!initI2CBus(I2C_BUS_CLOCK))
     {
-        // Wait before retrying
-        delay(2000);
-        connectTry--;
+        return 0;
+    }
+
+    // Offered once, begin() checks it against the chip and falls back
+    // to a full read when another sensor was fitted
+    if (!calibrationLoaded)
+    {
+        if (loadState(STATE_BME680_CALIBRATION, BME680_CALIBRATION_VERSION, calibration,
+                      sizeof(calibration)))
+        {
+            BME680.setCalibrationImage(calibration);
+        }
+
+        calibrationLoaded = 1;
     }
 
-    // Check if initialization was unsuccessful
-    if (!connectTry)
+    lockI2CBus();
+
+    // Single attempt, retries are scheduled by the health layer
+    if (!BME680.begin(I2C_FAST_MODE))
     {
+        unlockI2CBus();
+
+        // A slave left mid-transfer by a reset can hold SDA low
+        recoverI2CBus();
         return 0;
     }
 
-    // Configure sensor settings for oversampling and filters
-    BME680.setOversampling(TemperatureSensor, Oversample16);
-    BME680.setOversampling(HumiditySensor, Oversample16);
-    BME680.setOversampling(PressureSensor, Oversample16);
-    BME680.setIIRFilter(IIR4);
+    // Unchanged images are not written again
+    if (BME680.getCalibrationImage(calibration))
+    {
+        saveState(STATE_BME680_CALIBRATION, BME680_CALIBRATION_VERSION, calibration,
+                  sizeof(calibration));
+    }
+
+    // Oversampling and filter are written in a single transaction
+    BME680.setMeasurementConfig(Oversample16, Oversample16, Oversample16, IIR4);
+
+    // Configure gas settings for heater temperature and duration,
+    // a re-initialization during a scan restarts the ladder
+    if (scanning)
+    {
+        programLadder();
+    }
+
+    else
+    {
+        BME680.setGas(BME680_GAS_TEMP, BME680_GAS_HEAT_MS);
+    }
 
-    // Configure gas settings for heater temperature and duration
-    BME680.setGas(320, 150);
+    unlockI2CBus();
 
+    conversionUs = getTimeUs();
+    sensorReady = 1;
     return 1;
 }
 
@@ -79,17 +178,57 @@ int initBME680()
 
 // Retrieves data from the BME680 sensor
 // @param newData: Pointer to structure where data will be stored
-void getDataBME680(t_dataBME680 *newData)
+// @return: 1 if new data was read, 0 otherwise
+int getDataBME680(t_dataBME680 *newData)
 {
     /* ----------------- LOCAL VARIABLES ----------------- */
 
     // Temporary variables for raw sensor data
-    static int32_t temp, humidity, pressure, gas;
+    int32_t temp, humidity, pressure, gas;
 
     /* ----------------- DATA RETRIEVAL ----------------- */
 
-    // Retrieve sensor data
+    // The scan owns the sensor, return what its last step measured
+    if (scanning)
+    {
+        if (!sensorReady || !scanDataValid)
+        {
+            return 0;
+        }
+
+        *newData = scanData;
+        return 1;
+    }
+
+    // Make sure the sensor still answers before polling its status,
+    // a missing device would otherwise read as "measuring" forever
+    if (sensorReady)
+    {
+        sensorReady = probeI2CDevice(BME680.getI2CAddress());
+    }
+
+    if (!sensorReady)
+    {
+        reportSensorRead(SENSOR_BME680, 0);
+        return 0;
+    }
+
+    // Retrieve sensor data, this also triggers the next conversion
+    lockI2CBus();
     BME680.getSensorData(temp, humidity, pressure, gas);
+    unlockI2CBus();
+
+    // The values were sampled by the conversion triggered last time
+    newData->timestamp = conversionUs;
+    conversionUs = getTimeUs();
+
+    // Check the full resolution pressure for range and stuck values
+    if (!checkSensorValue(SENSOR_BME680, pressure))
+    {
+        return 0;
+    }
+
+    ambientTemp = temp;
 
     // Temperature in degrees Celsius
     newData->temp = (int16_t)(temp / 100);
@@ -100,42 +239,274 @@ void getDataBME680(t_dataBME680 *newData)
     // Pressure in hPa
     newData->pressure = (uint16_t)(pressure / 100);
 
-    newData->vocIndex = calculateVOCIndex((uint32_t)gas);
+    // Altitude from the pressure in Pa, before it is truncated
+    updateAltitudeBaro(pressure, temp, newData->timestamp);
+    storeAltitude(newData);
+
+    // Air quality from the resistance and the humidity of the same sample
+    newData->vocIndex = updateIAQ((uint32_t)gas, newData->humidity, millis());
+    newData->iaqAccuracy = getIAQAccuracy();
+
+    return 1;
 }
 
 
 /* *****************************************************************
-    *                CALCULATE VOC INDEX FUNCTION                 *
+    *                     HEATER PROFILE SCAN                     *
    ***************************************************************** */
 
-// Calculates VOC index from gas resistance
-// @param gasResistance: The measured gas resistance
-// @return: Calculated VOC index
-static int calculateVOCIndex(uint32_t gasResistance)
+// Starts cycling the heater through a temperature ladder, one step per
+// forced measurement
+// @param temps: Heater temperatures in degrees Celsius
+// @param durations: Heating times in milliseconds
+// @param steps: Number of steps, at most BME680_HEATER_PROFILES
+// @return: 1 if successful, 0 otherwise
+int startScanBME680(const uint16_t *temps, const uint16_t *durations, uint8_t steps)
 {
-    /* --------------- LOCAL VARIABLES --------------- */
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Distance of the closest step to the VOC set-point
+    uint16_t bestDistance = UINT16_MAX;
+
+    // Distance of the step being checked
+    uint16_t distance;
 
-    // VOC index, initially set to zero
-    int vocIndex = 0;
+    /* -------------------- LADDER SETUP -------------------- */
 
-    /* --------------- VOC CALCULATION ----------------- */
+    if (!sensorReady || steps == 0 || steps > BME680_HEATER_PROFILES)
+    {
+        return 0;
+    }
 
-    // Example linear mapping of gas resistance to VOC index
-    if (gasResistance > 0)
+    for (uint8_t i = 0; i < steps; i++)
     {
-        vocIndex = 500 - (int)(gasResistance / 1000);
+        ladderTemps[i] = temps[i];
+        ladderDurations[i] = durations[i];
+
+        distance = (temps[i] > BME680_GAS_TEMP) ? temps[i] - BME680_GAS_TEMP
+                                                : BME680_GAS_TEMP - temps[i];
 
-        // Ensure the VOC index is within valid range
-        if (vocIndex < 0)
+        if (distance < bestDistance)
         {
-            vocIndex = 0;
+            bestDistance = distance;
+            vocStep = i;
         }
+    }
+
+    ladderSteps = steps;
+
+    lockI2CBus();
+    programLadder();
+    unlockI2CBus();
+
+    scanDataValid = 0;
+    newScan = 0;
+    lastScan.scanCount = 0;
+    scanning = 1;
+
+    return 1;
+}
+
+// Returns to the single set-point mode
+void stopScanBME680()
+{
+    if (!scanning)
+    {
+        return;
+    }
+
+    scanning = 0;
 
-        else if (vocIndex > 500)
+    if (sensorReady)
+    {
+        lockI2CBus();
+        BME680.setGas(BME680_GAS_TEMP, BME680_GAS_HEAT_MS);
+        unlockI2CBus();
+    }
+}
+
+// Reads the finished step and starts the next one, called every
+// BME680_SCAN_SERVICE_MS
+void serviceScanBME680()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Raw values of the finished step
+    int32_t temp, humidity, pressure, gas;
+
+    // Heat stabilization and gas validity bits of the finished step
+    uint8_t status;
+
+    // Heater profile the finished step actually used
+    uint8_t index;
+
+    // Step to measure next
+    uint8_t nextStep;
+
+    /* -------------------- STEP HANDLING -------------------- */
+
+    if (!scanning || !sensorReady)
+    {
+        return;
+    }
+
+    lockI2CBus();
+
+    // Wait for the heater and the conversion without blocking
+    if (BME680.measuring())
+    {
+        unlockI2CBus();
+
+        // A missing device reads as "measuring" forever
+        if (millis() - stepMillis > BME680_SCAN_TIMEOUT_MS)
+        {
+            sensorReady = probeI2CDevice(BME680.getI2CAddress());
+            scanDataValid = 0;
+            reportSensorRead(SENSOR_BME680, 0);
+            stepMillis = millis();
+        }
+
+        return;
+    }
+
+    nextStep = scanStep + 1;
+    if (nextStep >= ladderSteps)
+    {
+        nextStep = 0;
+
+        // Heater registers depend on the ambient temperature, the
+        // last step is not read yet so nothing is triggered here
+        if (ambientTemp - ladderAmbient >= BME680_SCAN_RECALC_TEMP ||
+            ladderAmbient - ambientTemp >= BME680_SCAN_RECALC_TEMP)
+        {
+            BME680.setHeaterProfiles(ladderTemps, ladderDurations, ladderSteps);
+            ladderAmbient = ambientTemp;
+        }
+    }
+
+    // Written with the trigger that follows the read
+    BME680.selectHeaterProfile(nextStep);
+    status = BME680.getSensorData(temp, humidity, pressure, gas, false);
+    index = BME680.getGasIndex();
+
+    unlockI2CBus();
+
+    scanData.timestamp = conversionUs;
+    conversionUs = getTimeUs();
+    stepMillis = millis();
+    scanStep = nextStep;
+
+    if (!checkSensorValue(SENSOR_BME680, pressure))
+    {
+        scanDataValid = 0;
+        return;
+    }
+
+    ambientTemp = temp;
+
+    // Same units as the single set-point mode
+    scanData.temp = (int16_t)(temp / 100);
+    scanData.humidity = (uint16_t)(humidity / 1000);
+    scanData.pressure = (uint16_t)(pressure / 100);
+    updateAltitudeBaro(pressure, temp, scanData.timestamp);
+    storeAltitude(&scanData);
+    scanDataValid = 1;
+
+    /* -------------------- RESISTANCE VECTOR -------------------- */
+
+    if (index >= ladderSteps)
+    {
+        return;
+    }
+
+    currentScan.resistance[index] = (uint32_t)gas;
+
+    // Both gas_valid and heat_stab must be set
+    if ((status & 0x30) == 0x30)
+    {
+        currentScan.validMask |= (1U << index);
+    }
+
+    if (index == vocStep)
+    {
+        scanData.vocIndex = updateIAQ((uint32_t)gas, scanData.humidity, millis());
+        scanData.iaqAccuracy = getIAQAccuracy();
+    }
+
+    // Publish the vector once the last step has been read
+    if (index == ladderSteps - 1)
+    {
+        for (uint8_t i = 0; i < ladderSteps; i++)
         {
-            vocIndex = 500;
+            currentScan.heaterTemp[i] = ladderTemps[i];
         }
+
+        currentScan.steps = ladderSteps;
+        currentScan.scanCount = lastScan.scanCount + 1;
+        lastScan = currentScan;
+        newScan = 1;
+
+        currentScan.validMask = 0;
+    }
+}
+
+// Retrieves the last complete scan
+// @param scan: Pointer to structure where the scan will be stored
+// @return: 1 if a new scan was completed since the last call, 0 otherwise
+int getScanBME680(t_scanBME680 *scan)
+{
+    if (!newScan)
+    {
+        return 0;
+    }
+
+    *scan = lastScan;
+    newScan = 0;
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                   PROGRAM LADDER FUNCTION                   *
+   ***************************************************************** */
+
+// Writes the heater ladder and selects its first step, bus must be locked
+static void programLadder()
+{
+    // Set-points are computed once for the current ambient temperature
+    BME680.setHeaterProfiles(ladderTemps, ladderDurations, ladderSteps);
+    BME680.selectHeaterProfile(0);
+    BME680.triggerMeasurement();
+
+    ladderAmbient = ambientTemp;
+    scanStep = 0;
+    conversionUs = getTimeUs();
+    stepMillis = millis();
+    currentScan.validMask = 0;
+}
+
+
+/* *****************************************************************
+    *                   STORE ALTITUDE FUNCTION                   *
+   ***************************************************************** */
+
+// Copies the altitude estimate of the sample just filtered
+static void storeAltitude(t_dataBME680 *data)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Estimate of the filter
+    t_altitude estimate;
+
+    /* -------------------- COPY -------------------- */
+
+    if (!getAltitude(&estimate))
+    {
+        estimate.altitude = 0;
+        estimate.climbRate = 0;
     }
 
-    return vocIndex;
+    data->altitude = estimate.altitude;
+    data->climbRate = estimate.climbRate;
 }
@@ -14,6 +14,32 @@
 // Library for standard integer types
 #include <stdint.h>
 
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Default heater ladder of the profile scan, in degrees Celsius
+#define BME680_SCAN_STEPS 6
+#define BME680_SCAN_TEMPS {200, 240, 280, 320, 360, 400}
+
+// Heating time of each scan step in milliseconds
+#define BME680_SCAN_DURATIONS {150, 150, 150, 150, 150, 150}
+
+// Set-point of the single profile mode, also used for the VOC index
+#define BME680_GAS_TEMP    320
+#define BME680_GAS_HEAT_MS 150
+
+// Ambient change, in hundredths of a degree, that triggers a
+// recomputation of the heater registers
+#define BME680_SCAN_RECALC_TEMP 300
+
+// A step taking longer than this means the sensor stopped answering
+#define BME680_SCAN_TIMEOUT_MS 1000
+
+// Period at which serviceScanBME680() should be called
+#define BME680_SCAN_SERVICE_MS 50
+
+// Layout version of the calibration kept in the state store
+#define BME680_CALIBRATION_VERSION 1
+
 /* ------------------ PUBLIC FUNCTIONS PROTOTYPES ------------------ */
 
 // Structure to hold BME680 sensor data
@@ -28,17 +54,68 @@ typedef struct
     // Pressure in hPa, scaled by 1000
     int32_t pressure;
 
-    // VOC index (calculated from gas resistance)
+    // Filtered altitude in cm and vertical speed in cm/s (see getAltitude())
+    int32_t altitude;
+    int32_t climbRate;
+
+    // Air quality index (0-500) computed from the gas resistance
     int32_t vocIndex;
 
+    // Confidence of the index (e_iaqAccuracy)
+    uint8_t iaqAccuracy;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataBME680;
 
+// Gas resistance vector produced by one pass over the heater ladder
+typedef struct
+{
+    // Heater temperature of each step in degrees Celsius
+    uint16_t heaterTemp[BME680_HEATER_PROFILES];
+
+    // Gas resistance measured at each step in ohms
+    uint32_t resistance[BME680_HEATER_PROFILES];
+
+    // One bit per step, set when the heater was stable and the reading valid
+    uint16_t validMask;
+
+    // Number of steps in the ladder
+    uint8_t steps;
+
+    // Number of complete scans since the scan was started
+    uint32_t scanCount;
+
+} t_scanBME680;
+
 // Initializes the BME680 sensor
 // @return: 1 if successful, 0 otherwise
 int initBME680();
 
 // Retrieves data from the BME680 sensor
 // @param newData: Pointer to structure where data will be stored
-void getDataBME680(t_dataBME680 *newData);
+// @return: 1 if new data was read, 0 otherwise
+int getDataBME680(t_dataBME680 *newData);
+
+// Starts cycling the heater through a temperature ladder, one step per
+// forced measurement
+// @param temps: Heater temperatures in degrees Celsius
+// @param durations: Heating times in milliseconds
+// @param steps: Number of steps, at most BME680_HEATER_PROFILES
+// @return: 1 if successful, 0 otherwise
+int startScanBME680(const uint16_t *temps, const uint16_t *durations, uint8_t steps);
+
+// Returns to the single set-point mode
+void stopScanBME680();
+
+// Reads the finished step and starts the next one, called every
+// BME680_SCAN_SERVICE_MS
+void serviceScanBME680();
+
+// Retrieves the last complete scan
+// @param scan: Pointer to structure where the scan will be stored
+// @return: 1 if a new scan was completed since the last call, 0 otherwise
+int getScanBME680(t_scanBME680 *scan);
 
 #endif // BME680_HPP
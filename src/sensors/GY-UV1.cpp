@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 
+#include "../system/Sampler.hpp"
+
 static bool pinsConfigured = false;
 
 int initGYUV1()
@@ -20,6 +22,10 @@ void getDataGYUV1(t_dataGYUV1 *newData)
         initGYUV1();
     }
 
-    uint16_t uvRaw = analogRead(P_UV);
-    newData->uvRaw = (int32_t)uvRaw;
+    t_adcReading reading;
+    readSampledAdc(P_UV, &reading, &newData->timestamp);
+
+    newData->uvRaw = (int32_t)reading.raw;
+    newData->uvMillivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
 }
@@ -4,12 +4,16 @@
 
 #include <stdint.h>
 
-#define P_UV 39
+// Pin of the mission profile
+#include "../config/Profile.hpp"
 
 typedef struct
 {
     int32_t uvIndex;
     int32_t uvRaw;
+    uint16_t uvMillivolts;
+    uint8_t clipped;
+    uint64_t timestamp;
 
 } t_dataGYUV1;
 
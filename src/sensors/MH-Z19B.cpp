@@ -18,6 +18,12 @@
 // Includes the header for the MH-Z19B sensor
 #include "MH-Z19B.hpp"
 
+// Includes the health layer to report faulty readings
+#include "../system/Health.hpp"
+
+// Includes the coherent sampler holding the reading and its capture time
+#include "../system/Sampler.hpp"
+
 /* ---------------------- GLOBAL VARIABLES ---------------------- */
 
 
@@ -43,5 +49,29 @@ int initMHZ19B()
 // @param newData: Pointer to structure where data will be stored
 void getDataMHZ19B(t_dataMHZ19B *newData)
 {
-    newData->CO2 = analogRead(P_MH);
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Reading of the analog output, with its calibrated voltage
+    t_adcReading reading;
+
+    /* ------------------ PROCESS SENSOR DATA ------------------ */
+
+    readSampledAdc(P_MH, &reading, &newData->timestamp);
+
+    // The output is linear in the concentration above its zero voltage
+    if (reading.millivolts > MHZ19B_ZERO_MV)
+    {
+        newData->CO2 = (int32_t)(reading.millivolts - MHZ19B_ZERO_MV) * MHZ19B_RANGE_PPM /
+                       MHZ19B_SPAN_MV;
+    }
+    else
+    {
+        newData->CO2 = 0;
+    }
+
+    newData->millivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
+
+    // Detect a disconnected or frozen input
+    checkSensorValue(SENSOR_MHZ19B, reading.raw);
 }
\ No newline at end of file
@@ -12,10 +12,16 @@
 #include <stdint.h>
 #include <Arduino.h>
 
-/* -------------------- MACROS AND CONSTANTS ------------------------- */
+// Pin of the mission profile
+#include "../config/Profile.hpp"
 
-// Pin definitions for RX and TX
-#define P_MH 15
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Analog output: MHZ19B_ZERO_MV at 0 ppm, MHZ19B_ZERO_MV + MHZ19B_SPAN_MV
+// at the full range of the sensor
+#define MHZ19B_ZERO_MV   400
+#define MHZ19B_SPAN_MV   1600
+#define MHZ19B_RANGE_PPM 5000
 
 /* ---------------------- DATA STRUCTURES ------------------------ */
 
@@ -24,6 +30,15 @@ typedef struct
 {
     // CO2 concentration in ppm
     int32_t CO2;
+
+    // Voltage of the analog output in mV
+    uint16_t millivolts;
+
+    // 1 when the reading sat at an end of the ADC range
+    uint8_t clipped;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
     
 } t_dataMHZ19B;
 
@@ -17,6 +17,12 @@
 // Includes the header for the MQ-131 sensor
 #include "MQ-131.hpp"
 
+// Includes the health layer to report faulty readings
+#include "../system/Health.hpp"
+
+// Includes the coherent sampler holding the reading and its capture time
+#include "../system/Sampler.hpp"
+
 
 /* *****************************************************************
     *                        INIT FUNCTION                        *
@@ -28,6 +34,9 @@ int initMQ131()
 {
     // Set the sensor pin as input
     pinMode(P_MQ131, INPUT); 
+
+    // Start tracking the heater warm-up time
+    startMQHeater(MQ131_HEATER);
     return 1;
 }
 
@@ -42,20 +51,40 @@ void getDataMQ131(t_dataMQ131 *newData)
 {
     /* -------------------- LOCAL VARIABLES -------------------- */
 
-    // Raw data from the sensor
-    uint16_t rawData = analogRead(P_MQ131);
+    // Reading of the sensor, with its calibrated voltage
+    t_adcReading reading;
+
+    // Capture time of the conversion
+    uint64_t timestamp;
 
     /* ------------------ PROCESS SENSOR DATA ------------------ */
 
+    // Reading of the tick latched by this measurement
+    readSampledAdc(P_MQ131, &reading, &timestamp);
+
     // Placeholder formula for Ozone (O3) calculation (in ppb)
-    newData->ozone = (int32_t)(rawData); 
+    newData->ozone = (int32_t)(reading.raw); 
 
     // Ensure no negative values
     if (newData->ozone < 0) newData->ozone = 0;       
 
     // Placeholder formula for Nitrogen Dioxide (NO2) calculation (in ppb)
-    newData->no2 = (int32_t)(rawData);
+    newData->no2 = (int32_t)(reading.raw);
 
     // Ensure no negative values
     if (newData->no2 < 0) newData->no2 = 0;          
+
+    // Keep the voltage for the gas compensation, it means nothing once
+    // the ADC has clipped
+    newData->millivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
+
+    // Flag the sample with the heater state
+    newData->readiness = getMQReadiness(MQ131_HEATER);
+
+    // Tag the sample with its capture time
+    newData->timestamp = timestamp;
+
+    // Detect a disconnected or frozen input
+    checkSensorValue(SENSOR_MQ131, reading.raw);
 }
@@ -14,10 +14,11 @@
 // Pull in Arduino core for pin helpers
 #include <Arduino.h>
 
-/* -------------------- MACROS AND CONSTANTS -------------------- */
+// Heater manager providing the readiness state of each sample
+#include "../system/MQHeater.hpp"
 
-// Pin for O3 and NO2 measurement
-#define P_MQ131 35
+// Pins of the mission profile
+#include "../config/Profile.hpp"
 
 /* ----------------- PUBLIC FUNCTIONS PROTOTYPES ----------------- */
 
@@ -30,6 +31,18 @@ typedef struct
     // Nitrogen dioxide level (NO2) in parts per billion (ppb)
     int32_t no2;
 
+    // Calibrated voltage of the reading in mV, input of the gas compensation
+    uint16_t millivolts;
+
+    // 1 when the reading sat at an end of the ADC range
+    uint8_t clipped;
+
+    // Heater readiness state when the sample was taken (e_mqReadiness)
+    uint8_t readiness;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataMQ131;
 
 // Initializes the MQ-131 sensor
@@ -17,6 +17,12 @@
 // Includes the header for the MQ-137 sensor
 #include "MQ-137.hpp"
 
+// Includes the health layer to report faulty readings
+#include "../system/Health.hpp"
+
+// Includes the coherent sampler holding the reading and its capture time
+#include "../system/Sampler.hpp"
+
 
 /* *****************************************************************
     *                        INIT FUNCTION                        *
@@ -28,6 +34,9 @@ int initMQ137()
 {
     // Set the sensor pin as input
     pinMode(P_MQ137, INPUT); 
+
+    // Start tracking the heater warm-up time
+    startMQHeater(MQ137_HEATER);
     return 1;
 }
 
@@ -42,15 +51,21 @@ void getDataMQ137(t_dataMQ137 *newData)
 {
     /* -------------------- LOCAL VARIABLES -------------------- */
 
-    // Raw data from the sensor
-    uint16_t rawData = analogRead(P_MQ137);
+    // Reading of the sensor, with its calibrated voltage
+    t_adcReading reading;
+
+    // Capture time of the conversion
+    uint64_t timestamp;
 
     /* ------------------ PROCESS SENSOR DATA ------------------ */
 
+    // Reading of the tick latched by this measurement
+    readSampledAdc(P_MQ137, &reading, &timestamp);
+
     // Formula for Ammonia (NH3) calculation (in ppm)
     // MQ-137 range: 5-500 ppm for NH3
     // Placeholder linear mapping - should be calibrated with actual sensor
-    newData->nh3 = (int32_t)((rawData)); 
+    newData->nh3 = (int32_t)((reading.raw)); 
 
     // Ensure NH3 is within valid range
     if (newData->nh3 < 5) newData->nh3 = 5;       
@@ -58,8 +73,22 @@ void getDataMQ137(t_dataMQ137 *newData)
 
     // Formula for Carbon Monoxide (CO) calculation (in ppm)
     // Placeholder linear mapping - should be calibrated with actual sensor
-    newData->co = (int32_t)((rawData));
+    newData->co = (int32_t)((reading.raw));
 
     // Ensure no negative CO values
     if (newData->co < 0) newData->co = 0;          
+
+    // Keep the voltage for the gas compensation, it means nothing once
+    // the ADC has clipped
+    newData->millivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
+
+    // Flag the sample with the heater state
+    newData->readiness = getMQReadiness(MQ137_HEATER);
+
+    // Tag the sample with its capture time
+    newData->timestamp = timestamp;
+
+    // Detect a disconnected or frozen input
+    checkSensorValue(SENSOR_MQ137, reading.raw);
 }
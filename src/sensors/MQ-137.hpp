@@ -14,10 +14,11 @@
 // Arduino core functions for GPIO access
 #include <Arduino.h>
 
-/* -------------------- MACROS AND CONSTANTS -------------------- */
+// Heater manager providing the readiness state of each sample
+#include "../system/MQHeater.hpp"
 
-// Pin for NH3 and CO measurement
-#define P_MQ137 32
+// Pins of the mission profile
+#include "../config/Profile.hpp"
 
 /* ----------------- PUBLIC FUNCTIONS PROTOTYPES ----------------- */
 
@@ -30,6 +31,18 @@ typedef struct
     // Carbon monoxide level (CO) in parts per million (ppm)
     int32_t co;
 
+    // Calibrated voltage of the reading in mV, input of the gas compensation
+    uint16_t millivolts;
+
+    // 1 when the reading sat at an end of the ADC range
+    uint8_t clipped;
+
+    // Heater readiness state when the sample was taken (e_mqReadiness)
+    uint8_t readiness;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataMQ137;
 
 // Initializes the MQ-137 sensor
@@ -18,6 +18,12 @@
 // Includes the header for the MQ-4 sensor
 #include "MQ-4.hpp"
 
+// Includes the health layer to report faulty readings
+#include "../system/Health.hpp"
+
+// Includes the coherent sampler holding the reading and its capture time
+#include "../system/Sampler.hpp"
+
 
 /* *****************************************************************
     *                        INIT FUNCTION                        *
@@ -29,6 +35,9 @@ int initMQ4()
 {
     // Configure the pin for the MQ-4 sensor as input
     pinMode(P_MQ4, INPUT);
+
+    // Start tracking the heater warm-up time
+    startMQHeater(MQ4_HEATER);
     return 1;
 }
 
@@ -43,11 +52,31 @@ void getDataMQ4(t_dataMQ4 *newData)
 {
     /* -------------------- LOCAL VARIABLES -------------------- */
 
-    // Raw data from the sensor
-    uint16_t rawData = analogRead(P_MQ4);
+    // Reading of the sensor, with its calibrated voltage
+    t_adcReading reading;
+
+    // Capture time of the conversion
+    uint64_t timestamp;
 
     /* --------------------- PROCESS DATA --------------------- */
 
+    // Reading of the tick latched by this measurement
+    readSampledAdc(P_MQ4, &reading, &timestamp);
+
     // Scale raw data to obtain methane concentration
-    newData->methane = static_cast<uint16_t>(rawData);
+    newData->methane = static_cast<uint16_t>(reading.raw);
+
+    // Keep the voltage for the gas compensation, it means nothing once
+    // the ADC has clipped
+    newData->millivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
+
+    // Flag the sample with the heater state
+    newData->readiness = getMQReadiness(MQ4_HEATER);
+
+    // Tag the sample with its capture time
+    newData->timestamp = timestamp;
+
+    // Detect a disconnected or frozen input
+    checkSensorValue(SENSOR_MQ4, reading.raw);
 }
@@ -14,10 +14,11 @@
 // Arduino core definitions for pin constants live in Arduino.h
 #include <Arduino.h>
 
-/* -------------------- MACROS AND CONSTANTS -------------------- */
+// Heater manager providing the readiness state of each sample
+#include "../system/MQHeater.hpp"
 
-// GPIO pin connected to the MQ-4 sensor
-#define P_MQ4 33
+// Pins of the mission profile
+#include "../config/Profile.hpp"
 
 /* ----------------- PUBLIC FUNCTIONS PROTOTYPES ----------------- */
 
@@ -26,6 +27,18 @@ typedef struct
 {
     // Methane concentration
     int32_t methane; 
+
+    // Calibrated voltage of the reading in mV, input of the gas compensation
+    uint16_t millivolts;
+
+    // 1 when the reading sat at an end of the ADC range
+    uint8_t clipped;
+
+    // Heater readiness state when the sample was taken (e_mqReadiness)
+    uint8_t readiness;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
   
 } t_dataMQ4;
 
@@ -18,6 +18,12 @@
 // Includes the header for the MQ-7 sensor
 #include "MQ-7.hpp"
 
+// Includes the health layer to report faulty readings
+#include "../system/Health.hpp"
+
+// Includes the coherent sampler holding the reading and its capture time
+#include "../system/Sampler.hpp"
+
 
 /* *****************************************************************
     *                        INIT FUNCTION                        *
@@ -29,6 +35,9 @@ int initMQ7()
 {
     // Configure the sensor pin as input
     pinMode(P_MQ7, INPUT);
+
+    // Start the high/low heater cycle
+    startMQHeater(MQ7_HEATER);
     return 1;
 }
 
@@ -43,12 +52,32 @@ void getDataMQ7(t_dataMQ7 *newData)
 {
     /* -------------------- LOCAL VARIABLES -------------------- */
 
-    // Raw analog data from the sensor
-    uint16_t rawData = analogRead(P_MQ7);
+    // Reading of the sensor, with its calibrated voltage
+    t_adcReading reading;
+
+    // Capture time of the conversion
+    uint64_t timestamp;
 
     /* ------------------ SCALING AND STORAGE ------------------ */
 
+    // Reading of the tick latched by this measurement
+    readSampledAdc(P_MQ7, &reading, &timestamp);
+
     // Scale raw data and store in the structure
-    newData->carbonMonoxyde = (uint16_t) rawData;
+    newData->carbonMonoxyde = (uint16_t) reading.raw;
+
+    // Keep the voltage for the gas compensation, it means nothing once
+    // the ADC has clipped
+    newData->millivolts = reading.millivolts;
+    newData->clipped = (reading.range != ADC_IN_RANGE);
+
+    // Flag the sample with the heater cycle state
+    newData->readiness = getMQReadiness(MQ7_HEATER);
+
+    // Tag the sample with its capture time
+    newData->timestamp = timestamp;
+
+    // Detect a disconnected or frozen input
+    checkSensorValue(SENSOR_MQ7, reading.raw);
 }
 
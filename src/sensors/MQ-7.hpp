@@ -12,10 +12,11 @@
 #include <stdint.h>
 #include <Arduino.h>
 
-/* -------------------- MACROS AND CONSTANTS -------------------- */
+// Heater manager providing the readiness state of each sample
+#include "../system/MQHeater.hpp"
 
-// Pin connected to the MQ-7 sensor
-#define P_MQ7 34
+// Pins of the mission profile
+#include "../config/Profile.hpp"
 
 /* ------------------- PUBLIC STRUCTURE TYPES ------------------- */
 
@@ -25,6 +26,18 @@ typedef struct
     // Carbon monoxide level in ppm
     int32_t carbonMonoxyde;
 
+    // Calibrated voltage of the reading in mV, input of the gas compensation
+    uint16_t millivolts;
+
+    // 1 when the reading sat at an end of the ADC range
+    uint8_t clipped;
+
+    // Heater readiness state when the sample was taken (e_mqReadiness)
+    uint8_t readiness;
+
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataMQ7;
 
 /* ----------------- PUBLIC FUNCTIONS PROTOTYPES ----------------- */
@@ -1,49 +1,147 @@
 // Handles initialization and data retrieval for the PMS5003 sensor.
+// The sensor runs in passive mode: it only sends a frame when asked, and its
+// fan sleeps between reads that are further apart than its spin-up time.
 
 #include "PMS5003.hpp"
+#include "../system/Health.hpp"
+#include "../system/Timebase.hpp"
 #include <Arduino.h>
 
 static HardwareSerial pmsSerial(PMS5003_SERIAL_INDEX);
 static bool serialReady = false;
 
+// Frames are ignored until the sensor has settled after (re)initialization.
+static uint32_t readyMillis = 0;
+
+// Fan state, the counts are only trusted PMS5003_SPINUP_MS after a wake-up.
+static bool asleep = false;
+static uint32_t wakeMillis = 0;
+
+// Passive mode is lost on wake-up, it is set again before the next request.
+static bool passiveMode = false;
+
+// Read request waiting for its answer, and the time the reading was taken.
+static bool requestPending = false;
+static uint32_t requestMillis = 0;
+static uint64_t requestUs = 0;
+
 static bool readFrame(t_dataPMS5003 *out);
+static void sendCommand(uint8_t command, uint8_t data);
+static void setFanRunning(bool running);
 
 int initPMS5003()
 {
+    // Re-initialization restarts the UART from scratch.
     if (serialReady)
     {
-        return 1;
+        pmsSerial.end();
+    }
+
+    // Both lines are active low, released they keep the sensor running.
+    if (P_PMS5003_RESET != PIN_NONE)
+    {
+        pinMode(P_PMS5003_RESET, OUTPUT);
+        digitalWrite(P_PMS5003_RESET, HIGH);
+    }
+
+    if (P_PMS5003_SLEEP != PIN_NONE)
+    {
+        pinMode(P_PMS5003_SLEEP, OUTPUT);
+        digitalWrite(P_PMS5003_SLEEP, HIGH);
     }
 
     pmsSerial.begin(PMS5003_BAUD, SERIAL_8N1, P_PMS5003_RX, P_PMS5003_TX);
-    pmsSerial.setTimeout(1000);
+    pmsSerial.setTimeout(100);
     serialReady = true;
 
-    // Give the sensor a moment after power-up before the first read.
-    delay(1000);
+    // Give the sensor a moment after power-up before the first command,
+    // without blocking the caller. The fan starts spinning with it.
+    readyMillis = millis() + PMS5003_STARTUP_MS;
+    wakeMillis = millis();
+    asleep = false;
+    passiveMode = false;
+    requestPending = false;
     return 1;
 }
 
-void getDataPMS5003(t_dataPMS5003 *newData)
+int getDataPMS5003(t_dataPMS5003 *newData)
 {
     if (!newData)
+    {
+        return 0;
+    }
+
+    // Nothing was asked, the fan is asleep or the sensor is starting.
+    if (!serialReady || !requestPending)
+    {
+        return 0;
+    }
+
+    // Values are left untouched on failure so callers can tell stale from new.
+    if (!readFrame(newData))
+    {
+        // An answer still on the wire is read on the next call.
+        if (millis() - requestMillis > PMS5003_ANSWER_MS)
+        {
+            requestPending = false;
+            reportSensorRead(SENSOR_PMS5003, 0);
+        }
+
+        return 0;
+    }
+
+    requestPending = false;
+
+    // The counts of a fan still spinning up are not representative.
+    if (millis() - wakeMillis < PMS5003_SPINUP_MS)
+    {
+        return 0;
+    }
+
+    return checkSensorValue(SENSOR_PMS5003, newData->pm10);
+}
+
+void servicePMS5003(uint32_t untilReadMs)
+{
+    if (!serialReady || (int32_t)(millis() - readyMillis) < 0)
     {
         return;
     }
 
-    if (!serialReady && !initPMS5003())
+    // Reads closer than a spin-up keep the fan running, the service period
+    // is added so it wakes at least PMS5003_SPINUP_MS before the read.
+    bool needed = untilReadMs <= PMS5003_SPINUP_MS + PMS5003_SERVICE_MS;
+
+    if (needed == asleep)
+    {
+        setFanRunning(needed);
+    }
+
+    if (asleep)
     {
-        newData->pm1_0 = 0;
-        newData->pm2_5 = 0;
-        newData->pm10 = 0;
         return;
     }
 
-    if (!readFrame(newData))
+    if (!passiveMode)
+    {
+        sendCommand(PMS5003_CMD_MODE, PMS5003_MODE_PASSIVE);
+        passiveMode = true;
+    }
+
+    // Ask for the reading during the last service period before the read,
+    // the answer waits in the UART buffer.
+    if (untilReadMs <= PMS5003_SERVICE_MS && !requestPending)
     {
-        newData->pm1_0 = 0;
-        newData->pm2_5 = 0;
-        newData->pm10 = 0;
+        // Drop the mode answer and any frame left from active mode.
+        while (pmsSerial.available())
+        {
+            pmsSerial.read();
+        }
+
+        sendCommand(PMS5003_CMD_READ, 0);
+        requestPending = true;
+        requestMillis = millis();
+        requestUs = getTimeUs();
     }
 }
 
@@ -54,24 +152,32 @@ static bool readFrame(t_dataPMS5003 *out)
         return false;
     }
 
-    while (pmsSerial.available() >= 32)
+    while (pmsSerial.available() >= 4)
     {
-        uint8_t frame[32];
+        uint8_t frame[PMS5003_FRAME_SIZE];
         int startByte = pmsSerial.read();
 
-        if (startByte != 0x42)
+        if (startByte != 0x42 || pmsSerial.peek() != 0x4D)
         {
             continue;
         }
 
         frame[0] = static_cast<uint8_t>(startByte);
-        size_t readBytes = pmsSerial.readBytes(&frame[1], 31);
-        if (readBytes != 31)
+        if (pmsSerial.readBytes(&frame[1], 3) != 3)
+        {
+            continue;
+        }
+
+        // Command answers are shorter than a data frame, skip them whole.
+        uint16_t length = (static_cast<uint16_t>(frame[2]) << 8) | frame[3];
+        if (length < PMS5003_FRAME_LENGTH)
         {
+            pmsSerial.readBytes(&frame[4], length);
             continue;
         }
 
-        if (frame[1] != 0x4D)
+        if (length != PMS5003_FRAME_LENGTH ||
+            pmsSerial.readBytes(&frame[4], PMS5003_FRAME_LENGTH) != PMS5003_FRAME_LENGTH)
         {
             continue;
         }
@@ -91,8 +197,48 @@ static bool readFrame(t_dataPMS5003 *out)
         out->pm1_0 = (static_cast<uint16_t>(frame[10]) << 8) | frame[11];
         out->pm2_5 = (static_cast<uint16_t>(frame[12]) << 8) | frame[13];
         out->pm10 = (static_cast<uint16_t>(frame[14]) << 8) | frame[15];
+
+        // The frame holds the counts of the moment it was requested.
+        out->timestamp = requestUs;
         return true;
     }
 
     return false;
 }
+
+static void sendCommand(uint8_t command, uint8_t data)
+{
+    uint8_t message[PMS5003_COMMAND_SIZE] = {0x42, 0x4D, command, 0x00, data, 0, 0};
+    uint16_t sum = 0;
+
+    for (uint8_t i = 0; i < PMS5003_COMMAND_SIZE - 2; ++i)
+    {
+        sum += message[i];
+    }
+
+    message[5] = sum >> 8;
+    message[6] = sum & 0xFF;
+    pmsSerial.write(message, sizeof(message));
+}
+
+static void setFanRunning(bool running)
+{
+    // The SET line is cheaper than a command when it is wired.
+    if (P_PMS5003_SLEEP != PIN_NONE)
+    {
+        digitalWrite(P_PMS5003_SLEEP, running ? HIGH : LOW);
+    }
+    else
+    {
+        sendCommand(PMS5003_CMD_SLEEP, running ? PMS5003_WAKEUP : PMS5003_SLEEP);
+    }
+
+    asleep = !running;
+    requestPending = false;
+
+    if (running)
+    {
+        wakeMillis = millis();
+        passiveMode = false;
+    }
+}
@@ -7,18 +7,43 @@
 // Standard integer types for portability
 #include <stdint.h>
 
+// Pins and UART of the mission profile
+#include "../config/Profile.hpp"
+
 /* -------------------- MACROS AND CONSTANTS -------------------- */
 
 // UART configuration for the PMS5003 sensor
 #define PMS5003_BAUD 9600
-#define PMS5003_SERIAL_INDEX 2
 
-// Pin definitions (can be overridden at build time)
-#define P_PMS5003_RX 16
-#define P_PMS5003_TX 17
+// Time after power-up before the first frame is trusted
+#define PMS5003_STARTUP_MS 1000
+
+// Transmission time of one byte (10 bits at 9600 baud) in microseconds
+#define PMS5003_BYTE_US 1042
+
+// Fan run time after a wake-up before the counts are trusted (datasheet: 30 s)
+#define PMS5003_SPINUP_MS 30000UL
+
+// Period at which servicePMS5003() should be called
+#define PMS5003_SERVICE_MS 1000
+
+// Longest time for the answer to a read request (32 bytes at 9600 baud)
+#define PMS5003_ANSWER_MS 50
 
-#define P_PMS5003_RESET -1
-#define P_PMS5003_SLEEP -1
+// Commands: 0x42 0x4D, command, 2 data bytes, 2 checksum bytes
+#define PMS5003_COMMAND_SIZE 7
+#define PMS5003_CMD_READ     0xE2
+#define PMS5003_CMD_MODE     0xE1
+#define PMS5003_CMD_SLEEP    0xE4
+
+// Data of the mode and sleep commands
+#define PMS5003_MODE_PASSIVE 0x00
+#define PMS5003_SLEEP        0x00
+#define PMS5003_WAKEUP       0x01
+
+// Data frame: 0x42 0x4D, length of 28, 13 values and a checksum
+#define PMS5003_FRAME_SIZE   32
+#define PMS5003_FRAME_LENGTH 28
 
 /* ---------------------- DATA STRUCTURES ---------------------- */
 
@@ -34,6 +59,9 @@ typedef struct
     // PM10 concentration in micrograms per cubic meter
     int32_t pm10;
 
+    // Local time the sample was taken (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataPMS5003;
 
 /* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
@@ -44,6 +72,12 @@ int initPMS5003();
 
 // Retrieves data from the PMS5003 sensor
 // @param newData: Pointer to structure where data will be stored
-void getDataPMS5003(t_dataPMS5003 *newData);
+// @return: 1 if a valid frame was read, 0 otherwise
+int getDataPMS5003(t_dataPMS5003 *newData);
+
+// Wakes the fan ahead of the next read and puts it to sleep when no read
+// is close, then requests the reading in passive mode
+// @param untilReadMs: Time before the next getDataPMS5003() call, UINT32_MAX if none is planned
+void servicePMS5003(uint32_t untilReadMs);
 
 #endif // PMS5003_hpp
@@ -18,10 +18,19 @@
 // Includes the header for the Pixhawk interface
 #include "Pixhawk.hpp"
 
+// Includes the time base disciplined by the GPS time
+#include "../system/Timebase.hpp"
+
+// Includes the altitude filter whose offset the GPS corrects
+#include "../processing/Altitude.hpp"
+
+// memcpy() for unaligned payload fields, strncpy() for the value names
+#include <string.h>
+
 /* ---------------------- GLOBAL VARIABLES ---------------------- */
 
 // HardwareSerial object for UART communication with Pixhawk
-HardwareSerial uartPixhawk(2);
+HardwareSerial uartPixhawk(PIXHAWK_SERIAL_INDEX);
 
 // Buffer for incoming MAVLink messages
 uint8_t mavlink_buffer[300];
@@ -30,13 +39,21 @@ uint16_t buffer_index = 0;
 // Latest GPS data
 t_dataPixhawk latest_gps_data;
 
+// System ID of the autopilot, and sequence number of the next message sent
+uint8_t autopilot_system_id = PIXHAWK_DEFAULT_SYSTEM_ID;
+uint8_t tx_sequence = 0;
+
+// Telemetry token bucket, in thousandths of a message
+uint32_t telemetry_tokens = PIXHAWK_TELEMETRY_BURST * 1000UL;
+uint32_t telemetry_refill_ms = 0;
+
 /* ------------------ PRIVATE FUNCTIONS PROTOTYPES ----------------- */
 
-// Parses a complete MAVLink message
+// Parses a complete MAVLink v1 or v2 message
 // @param buffer: Buffer containing the message
-// @param length: Length of the message
+// @param headerSize: Header size of the MAVLink version of the message
 // @return: 1 if GPS data was updated, 0 otherwise
-int parseMAVLinkMessage(uint8_t* buffer, uint16_t length);
+int parseMAVLinkMessage(uint8_t* buffer, uint8_t headerSize);
 
 // Extracts GPS data from GPS_RAW_INT message
 // @param payload: Message payload
@@ -46,16 +63,36 @@ void parseGPSRawInt(uint8_t* payload);
 // @param payload: Message payload
 void parseGlobalPositionInt(uint8_t* payload);
 
+// Extracts the UTC time from SYSTEM_TIME message
+// @param payload: Message payload
+void parseSystemTime(uint8_t* payload);
+
 // Converts int32_t to float for coordinates
 // @param value: Integer value scaled by 1e7
 // @return: Float value in degrees
 double int32ToCoordinate(int32_t value);
 
-// Calculates MAVLink checksum
+// Calculates MAVLink checksum (CRC-16/MCRF4XX followed by CRC_EXTRA)
 // @param data: Data to calculate checksum for
 // @param length: Length of data
+// @param crcExtra: CRC_EXTRA seed of the message
 // @return: Calculated checksum
-uint8_t calculateChecksum(uint8_t* data, uint16_t length);
+uint16_t calculateChecksum(uint8_t* data, uint16_t length, uint8_t crcExtra);
+
+// Returns the CRC_EXTRA seed of a message
+// @param messageId: MAVLink message ID
+// @param crcExtra: Pointer where the seed will be stored
+// @return: 1 if the message is handled, 0 otherwise
+int getCrcExtra(uint32_t messageId, uint8_t* crcExtra);
+
+// Returns the message ID from the header of a v1 or v2 message
+// @param buffer: Buffer containing the message
+// @param headerSize: Header size of the MAVLink version of the message
+// @return: MAVLink message ID
+uint32_t getMessageId(uint8_t* buffer, uint8_t headerSize);
+
+// Local time the message being parsed was received
+uint64_t message_time_us = 0;
 
 /* *****************************************************************
     *                        INIT FUNCTION                        *
@@ -77,6 +114,8 @@ int initPixhawk()
     latest_gps_data.fix_type = 0;
     latest_gps_data.hdop = 65535;
     latest_gps_data.data_valid = 0;
+    latest_gps_data.gps_time_usec = 0;
+    latest_gps_data.timestamp = 0;
     
     buffer_index = 0;
     
@@ -113,8 +152,9 @@ int processMAVLinkMessages()
     {
         uint8_t byte = uartPixhawk.read();
         
-        // Look for MAVLink start byte (0xFE for MAVLink v1.0)
-        if (buffer_index == 0 && byte != 0xFE)
+        // Look for a MAVLink start byte: the autopilot switches the link to
+        // v2 (0xFD) once it receives the v2 telemetry, v1 (0xFE) until then
+        if (buffer_index == 0 && byte != MAVLINK_V1_MAGIC && byte != MAVLINK_V2_MAGIC)
         {
             continue; // Skip until we find start byte
         }
@@ -125,23 +165,43 @@ int processMAVLinkMessages()
             mavlink_buffer[buffer_index++] = byte;
         }
         
+        uint8_t header_size = (mavlink_buffer[0] == MAVLINK_V2_MAGIC) ? MAVLINK_V2_HEADER_SIZE
+                                                                      : MAVLINK_V1_HEADER_SIZE;
+
         // Check if we have enough bytes for header
-        if (buffer_index >= 6)
+        if (buffer_index >= header_size)
         {
             uint8_t payload_length = mavlink_buffer[1];
-            uint16_t expected_length = payload_length + 8; // Header + payload + checksum
+            uint16_t checksum_index = header_size + payload_length;
+            uint16_t expected_length = checksum_index + 2; // Header + payload + checksum
+
+            // A signed v2 message ends with its signature
+            if (header_size == MAVLINK_V2_HEADER_SIZE && (mavlink_buffer[2] & MAVLINK_IFLAG_SIGNED))
+            {
+                expected_length += MAVLINK_SIGNATURE_SIZE;
+            }
             
             // Check if we have complete message
             if (buffer_index >= expected_length)
             {
-                // Verify checksum
-                uint8_t received_checksum = mavlink_buffer[expected_length - 1];
-                uint8_t calculated_checksum = calculateChecksum(mavlink_buffer + 1, expected_length - 2);
-                
-                if (received_checksum == calculated_checksum)
+                // Timestamp the message as soon as it is complete
+                message_time_us = getTimeUs();
+
+                // Verify checksum, sent little-endian after the payload
+                uint8_t crc_extra;
+                uint16_t received_checksum = mavlink_buffer[checksum_index] |
+                                             (mavlink_buffer[checksum_index + 1] << 8);
+
+                // Unknown incompatible flags mean a layout this parser cannot read
+                uint8_t readable = (header_size == MAVLINK_V1_HEADER_SIZE ||
+                                    (mavlink_buffer[2] & ~MAVLINK_IFLAG_SIGNED) == 0) &&
+                                   getCrcExtra(getMessageId(mavlink_buffer, header_size), &crc_extra);
+
+                if (readable && received_checksum == calculateChecksum(mavlink_buffer + 1,
+                                                                       checksum_index - 1, crc_extra))
                 {
                     // Parse the message
-                    if (parseMAVLinkMessage(mavlink_buffer, expected_length))
+                    if (parseMAVLinkMessage(mavlink_buffer, header_size))
                     {
                         gps_updated = 1;
                     }
@@ -162,17 +222,116 @@ int processMAVLinkMessages()
     return gps_updated;
 }
 
+/* *****************************************************************
+    *                      MAVLINK TELEMETRY                      *
+   ***************************************************************** */
+
+// Sends a reading to the autopilot as a NAMED_VALUE_INT message, which it
+// logs and forwards over its telemetry radio
+// @param name: Name of the value, cut to 10 characters
+// @param value: Value to send
+// @param timeMs: Time of the value in milliseconds since boot
+// @return: 1 if the message was queued, 0 if the rate limit or a full UART held it back
+uint8_t sendPixhawkValue(const char *name, int32_t value, uint32_t timeMs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Whole message: header, payload and checksum
+    uint8_t frame[MAVLINK_V2_HEADER_SIZE + MAVLINK_NAMED_VALUE_SIZE + 2];
+    uint8_t* payload = frame + MAVLINK_V2_HEADER_SIZE;
+    uint8_t payload_length = MAVLINK_NAMED_VALUE_SIZE;
+    uint16_t checksum;
+
+    // Time since the bucket was last refilled
+    uint32_t now_ms = millis();
+    uint32_t elapsed_ms = now_ms - telemetry_refill_ms;
+
+    /* -------------------- RATE LIMIT -------------------- */
+
+    telemetry_refill_ms = now_ms;
+
+    if (elapsed_ms > PIXHAWK_TELEMETRY_BURST * 1000UL / PIXHAWK_TELEMETRY_RATE)
+    {
+        elapsed_ms = PIXHAWK_TELEMETRY_BURST * 1000UL / PIXHAWK_TELEMETRY_RATE;
+    }
+
+    telemetry_tokens += elapsed_ms * PIXHAWK_TELEMETRY_RATE;
+
+    if (telemetry_tokens > PIXHAWK_TELEMETRY_BURST * 1000UL)
+    {
+        telemetry_tokens = PIXHAWK_TELEMETRY_BURST * 1000UL;
+    }
+
+    if (telemetry_tokens < 1000)
+    {
+        return 0;
+    }
+
+    /* -------------------- PAYLOAD -------------------- */
+
+    // Fields sorted by size on the wire, the name is not terminated at 10 characters
+    memcpy(payload, &timeMs, sizeof(timeMs));
+    memcpy(payload + 4, &value, sizeof(value));
+    memset(payload + 8, 0, MAVLINK_NAME_SIZE);
+    strncpy((char*)payload + 8, name, MAVLINK_NAME_SIZE);
+
+    // MAVLink v2 drops the trailing zero bytes of the payload, keeping one
+    while (payload_length > 1 && payload[payload_length - 1] == 0)
+    {
+        payload_length--;
+    }
+
+    /* -------------------- FRAMING -------------------- */
+
+    frame[0] = MAVLINK_V2_MAGIC;
+    frame[1] = payload_length;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = tx_sequence;
+    frame[5] = autopilot_system_id;
+    frame[6] = PIXHAWK_COMPONENT_ID;
+    frame[7] = MAVLINK_MSG_ID_NAMED_VALUE_INT & 0xFF;
+    frame[8] = (MAVLINK_MSG_ID_NAMED_VALUE_INT >> 8) & 0xFF;
+    frame[9] = (MAVLINK_MSG_ID_NAMED_VALUE_INT >> 16) & 0xFF;
+
+    // Checksum of everything after the magic byte
+    checksum = calculateChecksum(frame + 1, MAVLINK_V2_HEADER_SIZE - 1 + payload_length,
+                                 MAVLINK_CRC_EXTRA_NAMED_VALUE_INT);
+    frame[MAVLINK_V2_HEADER_SIZE + payload_length] = checksum & 0xFF;
+    frame[MAVLINK_V2_HEADER_SIZE + payload_length + 1] = checksum >> 8;
+
+    /* -------------------- TRANSMISSION -------------------- */
+
+    // Never wait for the UART, the measurement cycle goes on
+    if (uartPixhawk.availableForWrite() < MAVLINK_V2_HEADER_SIZE + payload_length + 2)
+    {
+        return 0;
+    }
+
+    uartPixhawk.write(frame, MAVLINK_V2_HEADER_SIZE + payload_length + 2);
+    tx_sequence++;
+    telemetry_tokens -= 1000;
+
+    return 1;
+}
+
 /* *****************************************************************
     *                    PRIVATE FUNCTIONS                        *
    ***************************************************************** */
 
-// Parses a complete MAVLink message
-int parseMAVLinkMessage(uint8_t* buffer, uint16_t length)
+// Parses a complete MAVLink v1 or v2 message
+int parseMAVLinkMessage(uint8_t* buffer, uint8_t headerSize)
 {
-    if (length < 8) return 0;
-    
-    uint8_t message_id = buffer[5];
-    uint8_t* payload = buffer + 6;
+    uint32_t message_id = getMessageId(buffer, headerSize);
+
+    // v2 drops the trailing zero bytes of the payload, the parsers read the
+    // full length, zero-filled
+    uint8_t payload[MAVLINK_MAX_PAYLOAD_SIZE];
+    memset(payload, 0, sizeof(payload));
+    memcpy(payload, buffer + headerSize, buffer[1]);
+
+    // Messages sent to the autopilot carry its system ID
+    autopilot_system_id = (headerSize == MAVLINK_V2_HEADER_SIZE) ? buffer[5] : buffer[3];
     
     switch (message_id)
     {
@@ -183,6 +342,10 @@ int parseMAVLinkMessage(uint8_t* buffer, uint16_t length)
         case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
             parseGlobalPositionInt(payload);
             return 1;
+
+        case MAVLINK_MSG_ID_SYSTEM_TIME:
+            parseSystemTime(payload);
+            return 0;
             
         default:
             return 0;
@@ -192,34 +355,51 @@ int parseMAVLinkMessage(uint8_t* buffer, uint16_t length)
 // Extracts GPS data from GPS_RAW_INT message
 void parseGPSRawInt(uint8_t* payload)
 {
-    // GPS_RAW_INT message structure (simplified)
+    // GPS_RAW_INT payload, fields sorted by size on the wire
     // uint64_t time_usec      - offset 0
-    // uint8_t fix_type        - offset 8  
-    // int32_t lat             - offset 9
-    // int32_t lon             - offset 13
-    // int32_t alt             - offset 17
-    // uint16_t eph            - offset 21
-    // uint16_t epv            - offset 23
-    // uint16_t vel            - offset 25
-    // uint16_t cog            - offset 27
+    // int32_t lat             - offset 8
+    // int32_t lon             - offset 12
+    // int32_t alt             - offset 16
+    // uint16_t eph            - offset 20
+    // uint16_t epv            - offset 22
+    // uint16_t vel            - offset 24
+    // uint16_t cog            - offset 26
+    // uint8_t fix_type        - offset 28
     // uint8_t satellites_visible - offset 29
-    
-    latest_gps_data.fix_type = payload[8];
-    
-    // Extract coordinates (scaled by 1e7)
-    int32_t lat_raw = *((int32_t*)(payload + 9));
-    int32_t lon_raw = *((int32_t*)(payload + 13));
-    int32_t alt_raw = *((int32_t*)(payload + 17));
-    
+
+    uint64_t time_usec;
+    int32_t lat_raw, lon_raw, alt_raw;
+
+    // Fields are not aligned in the buffer
+    memcpy(&time_usec, payload, sizeof(time_usec));
+    memcpy(&lat_raw, payload + 8, sizeof(lat_raw));
+    memcpy(&lon_raw, payload + 12, sizeof(lon_raw));
+    memcpy(&alt_raw, payload + 16, sizeof(alt_raw));
+    memcpy(&latest_gps_data.hdop, payload + 20, sizeof(latest_gps_data.hdop));
+
+    latest_gps_data.fix_type = payload[28];
+    latest_gps_data.satellites_visible = payload[29];
+
     latest_gps_data.latitude = int32ToCoordinate(lat_raw);
     latest_gps_data.longitude = int32ToCoordinate(lon_raw);
     latest_gps_data.altitude = alt_raw / 1000.0f; // Convert mm to m
-    
-    latest_gps_data.hdop = *((uint16_t*)(payload + 21));
-    latest_gps_data.satellites_visible = payload[29];
-    
+    latest_gps_data.timestamp = message_time_us;
+
     // Mark data as valid if we have a 3D fix
     latest_gps_data.data_valid = (latest_gps_data.fix_type >= 3) ? 1 : 0;
+
+    // Raw GPS altitude, GLOBAL_POSITION_INT already mixes in the autopilot barometer
+    if (latest_gps_data.data_valid)
+    {
+        updateAltitudeGps(alt_raw, message_time_us);
+    }
+
+    // With a fix, time_usec is the UTC time of the GPS solution
+    if (latest_gps_data.data_valid && time_usec >= TIME_MIN_UNIX_US)
+    {
+        latest_gps_data.gps_time_usec = time_usec;
+        submitTimeSync(message_time_us, time_usec, TIME_SOURCE_GPS, TIME_GPS_UNCERTAINTY_US);
+    }
 }
 
 // Extracts position data from GLOBAL_POSITION_INT message
@@ -231,35 +411,96 @@ void parseGlobalPositionInt(uint8_t* payload)
     // int32_t lon             - offset 8
     // int32_t alt             - offset 12
     // int32_t relative_alt    - offset 16
-    
-    int32_t lat_raw = *((int32_t*)(payload + 4));
-    int32_t lon_raw = *((int32_t*)(payload + 8));
-    int32_t alt_raw = *((int32_t*)(payload + 12));
-    int32_t rel_alt_raw = *((int32_t*)(payload + 16));
-    
+
+    int32_t lat_raw, lon_raw, alt_raw, rel_alt_raw;
+
+    memcpy(&lat_raw, payload + 4, sizeof(lat_raw));
+    memcpy(&lon_raw, payload + 8, sizeof(lon_raw));
+    memcpy(&alt_raw, payload + 12, sizeof(alt_raw));
+    memcpy(&rel_alt_raw, payload + 16, sizeof(rel_alt_raw));
+
     latest_gps_data.latitude = int32ToCoordinate(lat_raw);
     latest_gps_data.longitude = int32ToCoordinate(lon_raw);
     latest_gps_data.altitude = alt_raw / 1000.0f; // Convert mm to m
     latest_gps_data.relative_altitude = rel_alt_raw / 1000.0f; // Convert mm to m
-    
+    latest_gps_data.timestamp = message_time_us;
+
     latest_gps_data.data_valid = 1;
 }
 
+// Extracts the UTC time from SYSTEM_TIME message
+void parseSystemTime(uint8_t* payload)
+{
+    // SYSTEM_TIME message structure
+    // uint64_t time_unix_usec - offset 0
+    // uint32_t time_boot_ms   - offset 8
+
+    uint64_t time_unix_usec;
+
+    memcpy(&time_unix_usec, payload, sizeof(time_unix_usec));
+
+    // Zero until the autopilot has received the time from its GPS
+    if (time_unix_usec >= TIME_MIN_UNIX_US)
+    {
+        latest_gps_data.gps_time_usec = time_unix_usec;
+        submitTimeSync(message_time_us, time_unix_usec, TIME_SOURCE_GPS, TIME_GPS_UNCERTAINTY_US);
+    }
+}
+
 // Converts int32_t to float for coordinates
 double int32ToCoordinate(int32_t value)
 {
     return (double)value / 1e7;
 }
 
-// Calculates MAVLink checksum
-uint8_t calculateChecksum(uint8_t* data, uint16_t length)
+// Calculates MAVLink checksum (CRC-16/MCRF4XX followed by CRC_EXTRA)
+uint16_t calculateChecksum(uint8_t* data, uint16_t length, uint8_t crcExtra)
 {
-    uint8_t checksum = 0xFF;
-    
-    for (uint16_t i = 0; i < length; i++)
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i <= length; i++)
     {
-        checksum ^= data[i];
+        // The CRC_EXTRA seed is accumulated after the message bytes
+        uint8_t tmp = (i < length) ? data[i] : crcExtra;
+
+        tmp ^= (uint8_t)(crc & 0xFF);
+        tmp ^= (tmp << 4);
+        crc = (crc >> 8) ^ ((uint16_t)tmp << 8) ^ ((uint16_t)tmp << 3) ^ (tmp >> 4);
     }
-    
-    return checksum;
+
+    return crc;
+}
+
+// Returns the CRC_EXTRA seed of a message
+int getCrcExtra(uint32_t messageId, uint8_t* crcExtra)
+{
+    switch (messageId)
+    {
+        case MAVLINK_MSG_ID_SYSTEM_TIME:
+            *crcExtra = MAVLINK_CRC_EXTRA_SYSTEM_TIME;
+            return 1;
+
+        case MAVLINK_MSG_ID_GPS_RAW_INT:
+            *crcExtra = MAVLINK_CRC_EXTRA_GPS_RAW_INT;
+            return 1;
+
+        case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+            *crcExtra = MAVLINK_CRC_EXTRA_GLOBAL_POSITION_INT;
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+// Returns the message ID from the header of a v1 or v2 message
+uint32_t getMessageId(uint8_t* buffer, uint8_t headerSize)
+{
+    // v2 sends a 24-bit ID little-endian, v1 a single byte
+    if (headerSize == MAVLINK_V2_HEADER_SIZE)
+    {
+        return buffer[7] | ((uint32_t)buffer[8] << 8) | ((uint32_t)buffer[9] << 16);
+    }
+
+    return buffer[5];
 }
@@ -14,19 +14,60 @@
 // Provides the HardwareSerial class for UART communication
 #include <HardwareSerial.h>
 
+// Pins and UART of the mission profile
+#include "../config/Profile.hpp"
+
 /* -------------------- MACROS AND CONSTANTS -------------------- */
 
 // UART baud rate for Pixhawk communication (standard MAVLink rate)
 #define PIXHAWK_BAUD 57600
 
-// Pin definitions for RX and TX (Serial2 on ESP32)
-#define PIXHAWK_RX 16
-#define PIXHAWK_TX 17
-
 // MAVLink message IDs we're interested in
+#define MAVLINK_MSG_ID_SYSTEM_TIME 2
 #define MAVLINK_MSG_ID_GPS_RAW_INT 24
 #define MAVLINK_MSG_ID_GLOBAL_POSITION_INT 33
 
+// CRC_EXTRA seeds of these messages (from the MAVLink definitions)
+#define MAVLINK_CRC_EXTRA_SYSTEM_TIME 137
+#define MAVLINK_CRC_EXTRA_GPS_RAW_INT 24
+#define MAVLINK_CRC_EXTRA_GLOBAL_POSITION_INT 104
+
+// Message carrying the readings sent to the autopilot, and its CRC_EXTRA seed
+#define MAVLINK_MSG_ID_NAMED_VALUE_INT 252
+#define MAVLINK_CRC_EXTRA_NAMED_VALUE_INT 44
+
+// MAVLink v1 framing: magic, payload length, sequence, system, component
+// and 1-byte message ID
+#define MAVLINK_V1_MAGIC 0xFE
+#define MAVLINK_V1_HEADER_SIZE 6
+
+// MAVLink v2 framing: magic, payload length, incompatible and compatible
+// flags, sequence, system, component and 3-byte message ID
+#define MAVLINK_V2_MAGIC 0xFD
+#define MAVLINK_V2_HEADER_SIZE 10
+
+// Only incompatible flag defined by MAVLink v2: the message is followed
+// by a 13-byte signature, which is not checked
+#define MAVLINK_IFLAG_SIGNED 0x01
+#define MAVLINK_SIGNATURE_SIZE 13
+
+// Largest payload, v2 payloads are truncated on the wire and zero-filled back
+#define MAVLINK_MAX_PAYLOAD_SIZE 255
+
+// NAMED_VALUE_INT payload: time_boot_ms, value and a 10-character name
+#define MAVLINK_NAMED_VALUE_SIZE 18
+#define MAVLINK_NAME_SIZE 10
+
+// The unit is an onboard computer of the vehicle, it takes the system ID
+// of the autopilot once heard
+#define PIXHAWK_COMPONENT_ID 191
+#define PIXHAWK_DEFAULT_SYSTEM_ID 1
+
+// Telemetry sent to the autopilot: messages per second, and largest burst,
+// a full sample set
+#define PIXHAWK_TELEMETRY_RATE 10
+#define PIXHAWK_TELEMETRY_BURST 16
+
 /* ---------------------- DATA STRUCTURES ---------------------- */
 
 // Structure to hold GPS and altitude data from Pixhawk
@@ -56,6 +97,12 @@ typedef struct
     // Data validity flag
     uint8_t data_valid;
 
+    // UTC time reported by the autopilot in microseconds, 0 if unknown
+    uint64_t gps_time_usec;
+
+    // Local time the last position was received (see getTimeUs())
+    uint64_t timestamp;
+
 } t_dataPixhawk;
 
 /* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
@@ -72,4 +119,12 @@ void getDataPixhawk(t_dataPixhawk *newData);
 // @return: 1 if valid GPS message received, 0 otherwise
 int processMAVLinkMessages();
 
+// Sends a reading to the autopilot as a NAMED_VALUE_INT message, which it
+// logs and forwards over its telemetry radio
+// @param name: Name of the value, cut to 10 characters
+// @param value: Value to send
+// @param timeMs: Time of the value in milliseconds since boot
+// @return: 1 if the message was queued, 0 if the rate limit or a full UART held it back
+uint8_t sendPixhawkValue(const char *name, int32_t value, uint32_t timeMs);
+
 #endif // PIXHAWK_HPP
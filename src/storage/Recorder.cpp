@@ -0,0 +1,507 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file records every measurement cycle to flash, one file
+    per session (boot). Each record is a frame preceded by its
+    length on one byte: a schema frame describing the channels,
+    then one sample frame per cycle. Records are gathered in RAM and written
+    in blocks to limit flash wear, compressed into a single packed
+    record when enabled, and the oldest sessions are deleted when
+    the file system fills up.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the session recorder
+#include "Recorder.hpp"
+
+// Identity of the unit, written in the frames
+#include "../system/Identity.hpp"
+
+// Arduino core and flash file system
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// strrchr() and strtoul() to parse the file names, memset() and memcmp()
+// for the benchmark
+#include <string.h>
+#include <stdlib.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Set once the file system is mounted and the session created
+static uint8_t recording = 0;
+
+// Number of the current session and sequence of its next frame
+static uint16_t sessionId = 0;
+static uint16_t frameSeq = 0;
+
+// Records waiting to be written and arrival time of the first one
+static uint8_t buffer[RECORDER_BUFFER_SIZE];
+static uint16_t bufferLength = 0;
+static uint32_t bufferStartMs = 0;
+
+// Block compressed before it is written
+static uint8_t packedBlock[RECORDER_BUFFER_SIZE];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Extracts the session number from a file name
+// @param name: Name or path of the file
+// @param id: Pointer where the session number will be stored
+// @return: 1 if the name is a session file, 0 otherwise
+static uint8_t parseSessionName(const char *name, uint16_t *id);
+
+// Finds the oldest and the newest recorded sessions
+// @param oldest: Pointer where the oldest session number will be stored
+// @param newest: Pointer where the newest session number will be stored
+// @return: Number of recorded sessions
+static uint16_t findSessions(uint16_t *oldest, uint16_t *newest);
+
+// Deletes the oldest sessions until enough flash is free
+static void pruneSessions();
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Mounts the file system and opens a new session
+// @return: 1 if samples can be recorded, 0 otherwise
+int initRecorder()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sessions already recorded
+    uint16_t oldest, newest;
+
+    // Path and file of the new session
+    char path[RECORDER_PATH_SIZE];
+    File file;
+
+    // Schema record opening the session
+    uint8_t frame[FRAME_SCHEMA_MAX_SIZE];
+    uint8_t length;
+    t_frameHeader header;
+
+    /* -------------------- FILE SYSTEM -------------------- */
+
+    // Format on first use, the partition only holds our files
+    if (!LittleFS.begin(true))
+    {
+        return 0;
+    }
+
+    if (!LittleFS.exists(RECORDER_DIR))
+    {
+        LittleFS.mkdir(RECORDER_DIR);
+    }
+
+    /* -------------------- NEW SESSION -------------------- */
+
+    sessionId = findSessions(&oldest, &newest) ? newest + 1 : 1;
+    frameSeq = 0;
+    bufferLength = 0;
+
+    pruneSessions();
+
+    // Created right away so the session is listed from the start, the
+    // schema lets a decoder lay out its columns before the first sample
+    getSessionPath(sessionId, path);
+    file = LittleFS.open(path, FILE_WRITE);
+    if (!file)
+    {
+        return 0;
+    }
+
+    header.type = FRAME_TYPE_SCHEMA;
+    header.flags = 0;
+    header.nodeId = getNodeId();
+    header.seq = frameSeq++;
+    header.timeUs = 0;
+
+    length = encodeSchemaFrame((1UL << CH_COUNT) - 1, &header, frame, sizeof(frame));
+    if (length)
+    {
+        file.write(&length, 1);
+        file.write(frame, length);
+    }
+
+    file.close();
+    recording = 1;
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                     RECORDING FUNCTIONS                     *
+   ***************************************************************** */
+
+// Appends a sample set to the current session as a sample frame
+// @param set: Sample set to record
+// @param timeUs: Time of the sample set
+// @param timeOffsetUs: Converts the capture times to the time base of the frame
+// @param flags: Frame flags matching the time (FRAME_FLAG_x)
+void recordSample(const t_sampleSet *set, uint64_t timeUs, int64_t timeOffsetUs, uint8_t flags)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Frame being recorded
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t length;
+
+    // Header of the frame
+    t_frameHeader header;
+
+    /* -------------------- ENCODING -------------------- */
+
+    if (!recording)
+    {
+        return;
+    }
+
+    header.type = FRAME_TYPE_SAMPLES;
+    header.flags = flags;
+    header.nodeId = getNodeId();
+    header.seq = frameSeq++;
+    header.timeUs = timeUs;
+
+    length = encodeSampleFrame(set, &header, timeOffsetUs, frame, sizeof(frame));
+    if (!length)
+    {
+        return;
+    }
+
+    /* -------------------- BUFFERING -------------------- */
+
+    if (bufferLength + 1 + length > RECORDER_BUFFER_SIZE)
+    {
+        flushRecorder();
+    }
+
+    if (bufferLength == 0)
+    {
+        bufferStartMs = millis();
+    }
+
+    buffer[bufferLength++] = length;
+    memcpy(buffer + bufferLength, frame, length);
+    bufferLength += length;
+}
+
+// Writes the buffered samples when they have waited long enough
+void serviceRecorder()
+{
+    if (bufferLength > 0 && millis() - bufferStartMs >= RECORDER_FLUSH_MS)
+    {
+        flushRecorder();
+    }
+}
+
+// Writes the buffered samples to flash now
+void flushRecorder()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Path and file of the current session
+    char path[RECORDER_PATH_SIZE];
+    File file;
+
+    // Packed record replacing the block, its length 0 if not used
+    t_frameHeader header;
+    uint16_t packedLength = 0;
+
+    /* -------------------- COMPRESSION -------------------- */
+
+    if (!recording || bufferLength == 0)
+    {
+        return;
+    }
+
+    if (isCompressionEnabled())
+    {
+        header.flags = 0;
+        header.nodeId = getNodeId();
+        header.seq = frameSeq++;
+        header.timeUs = 0;
+
+        // Kept only if the record is smaller than the block
+        packedLength = encodePackedFrame(buffer, bufferLength, &header, packedBlock,
+                                         bufferLength - 3);
+    }
+
+    /* -------------------- BLOCK WRITE -------------------- */
+
+    pruneSessions();
+
+    getSessionPath(sessionId, path);
+    file = LittleFS.open(path, FILE_APPEND);
+
+    // On failure the block is lost rather than blocking the next ones
+    if (file && packedLength)
+    {
+        file.write((uint8_t)RECORDER_PACKED_RECORD);
+        file.write((uint8_t)(packedLength & 0xFF));
+        file.write((uint8_t)(packedLength >> 8));
+        file.write(packedBlock, packedLength);
+        file.close();
+    }
+
+    else if (file)
+    {
+        file.write(buffer, bufferLength);
+        file.close();
+    }
+
+    bufferLength = 0;
+}
+
+
+/* *****************************************************************
+    *                      SESSION FUNCTIONS                      *
+   ***************************************************************** */
+
+// Lists the most recent sessions, oldest first
+// @param sessions: Array receiving the sessions
+// @param maxSessions: Size of the array
+// @return: Number of sessions stored in the array
+uint8_t listSessions(t_sessionInfo *sessions, uint8_t maxSessions)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Directory of the sessions and file being listed
+    File dir;
+    File file;
+
+    // Session being inserted and its position
+    t_sessionInfo info;
+    int16_t j;
+
+    // Number of sessions in the array
+    uint8_t count = 0;
+
+    /* -------------------- DIRECTORY SCAN -------------------- */
+
+    dir = LittleFS.open(RECORDER_DIR);
+    if (!dir || !dir.isDirectory() || maxSessions == 0)
+    {
+        return 0;
+    }
+
+    for (file = dir.openNextFile(); file; file = dir.openNextFile())
+    {
+        if (!parseSessionName(file.name(), &info.id))
+        {
+            continue;
+        }
+
+        info.size = file.size();
+        info.active = recording && info.id == sessionId;
+        file.close();
+
+        // Array full: keep the newest sessions only
+        if (count == maxSessions)
+        {
+            if (info.id < sessions[0].id)
+            {
+                continue;
+            }
+
+            memmove(sessions, sessions + 1, (count - 1) * sizeof(t_sessionInfo));
+            count--;
+        }
+
+        // Insertion sort by session number
+        for (j = (int16_t)count - 1; j >= 0 && sessions[j].id > info.id; j--)
+        {
+            sessions[j + 1] = sessions[j];
+        }
+
+        sessions[j + 1] = info;
+        count++;
+    }
+
+    dir.close();
+    return count;
+}
+
+// Compresses a recorded session block by block, as the recorder would,
+// and checks and times every block. Meant for sessions recorded uncompressed
+// @param id: Session number
+// @param stats: Pointer to structure where the results will be stored
+// @return: 1 if the session could be read, 0 otherwise
+uint8_t benchmarkSession(uint16_t id, t_compressStats *stats)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Path and file of the session
+    char path[RECORDER_PATH_SIZE];
+    File file;
+
+    // Block read from the session and its round trip, too large for the stack
+    static uint8_t block[RECORDER_BUFFER_SIZE];
+    static uint8_t check[RECORDER_BUFFER_SIZE];
+    uint16_t length, packedLength;
+
+    // Start of the timed step
+    uint32_t startUs;
+
+    /* -------------------- BENCHMARK -------------------- */
+
+    memset(stats, 0, sizeof(*stats));
+
+    getSessionPath(id, path);
+    file = LittleFS.open(path, FILE_READ);
+    if (!file)
+    {
+        return 0;
+    }
+
+    // The write buffer holds the pending records, the packed block is free
+    // outside flushRecorder()
+    while ((length = file.read(block, sizeof(block))) > 0)
+    {
+        startUs = micros();
+        packedLength = compressBlock(block, length, packedBlock, length);
+        stats->compressUs += micros() - startUs;
+
+        stats->blocks++;
+        stats->rawBytes += length;
+        stats->packedBytes += packedLength ? packedLength : length;
+
+        if (!packedLength)
+        {
+            continue;
+        }
+
+        startUs = micros();
+        if (decompressBlock(packedBlock, packedLength, check, sizeof(check)) != length ||
+            memcmp(block, check, length) != 0)
+        {
+            stats->errors++;
+        }
+        stats->decompressUs += micros() - startUs;
+    }
+
+    file.close();
+    return 1;
+}
+
+// Builds the path of a session file
+// @param id: Session number
+// @param path: Destination buffer of RECORDER_PATH_SIZE bytes
+void getSessionPath(uint16_t id, char *path)
+{
+    snprintf(path, RECORDER_PATH_SIZE, "%s/%05u.bin", RECORDER_DIR, id);
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Extracts the session number from a file name
+static uint8_t parseSessionName(const char *name, uint16_t *id)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Start of the file name and end of the number
+    const char *base = strrchr(name, '/');
+    char *end;
+
+    // Parsed number
+    unsigned long value;
+
+    /* -------------------- NAME PARSING -------------------- */
+
+    // Depending on the core, names come with or without their directory
+    base = base ? base + 1 : name;
+
+    value = strtoul(base, &end, 10);
+    if (end == base || strcmp(end, ".bin") != 0 || value == 0 || value > UINT16_MAX)
+    {
+        return 0;
+    }
+
+    *id = (uint16_t)value;
+    return 1;
+}
+
+// Finds the oldest and the newest recorded sessions
+static uint16_t findSessions(uint16_t *oldest, uint16_t *newest)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Directory of the sessions and file being checked
+    File dir;
+    File file;
+
+    // Session number of the file
+    uint16_t id;
+
+    // Number of sessions found
+    uint16_t count = 0;
+
+    /* -------------------- DIRECTORY SCAN -------------------- */
+
+    dir = LittleFS.open(RECORDER_DIR);
+    if (!dir || !dir.isDirectory())
+    {
+        return 0;
+    }
+
+    for (file = dir.openNextFile(); file; file = dir.openNextFile())
+    {
+        if (parseSessionName(file.name(), &id))
+        {
+            if (count == 0 || id < *oldest)
+            {
+                *oldest = id;
+            }
+
+            if (count == 0 || id > *newest)
+            {
+                *newest = id;
+            }
+
+            count++;
+        }
+
+        file.close();
+    }
+
+    dir.close();
+    return count;
+}
+
+// Deletes the oldest sessions until enough flash is free
+static void pruneSessions()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sessions on flash
+    uint16_t oldest, newest;
+
+    // Path of the session to delete
+    char path[RECORDER_PATH_SIZE];
+
+    /* -------------------- CLEAN-UP -------------------- */
+
+    // The current session is never deleted
+    while (LittleFS.totalBytes() - LittleFS.usedBytes() < RECORDER_MIN_FREE_BYTES &&
+           findSessions(&oldest, &newest) && oldest != sessionId)
+    {
+        getSessionPath(oldest, path);
+        if (!LittleFS.remove(path))
+        {
+            break;
+        }
+    }
+}
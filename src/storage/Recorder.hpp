@@ -0,0 +1,98 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef RECORDER_hpp
+#define RECORDER_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Sample sets and the frames they are stored as
+#include "../processing/Channels.hpp"
+#include "../protocols/Frame.hpp"
+
+// Compression of the blocks and its benchmark
+#include "../protocols/Compress.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Directory holding one file per session, named after its number
+#define RECORDER_DIR "/sessions"
+
+// Samples are written to flash in blocks of this size
+#define RECORDER_BUFFER_SIZE 1024
+
+// Longest time a sample waits in RAM, bounds the loss on power cut
+#define RECORDER_FLUSH_MS 30000UL
+
+// Period of the recorder service task
+#define RECORDER_SERVICE_MS 1000
+
+// Oldest sessions are deleted to keep this much flash free
+#define RECORDER_MIN_FREE_BYTES 65536UL
+
+// Longest session path, e.g. "/sessions/00042.bin"
+#define RECORDER_PATH_SIZE 24
+
+// Frames are at least a header long, a zero length instead introduces a
+// packed block: its length on 2 bytes, then a packed frame
+#define RECORDER_PACKED_RECORD 0
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Description of a recorded session
+typedef struct
+{
+    // Session number, increasing from one boot to the next
+    uint16_t id;
+
+    // Size of the session file in bytes
+    uint32_t size;
+
+    // Set for the session being recorded
+    uint8_t active;
+
+} t_sessionInfo;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Mounts the file system and opens a new session
+// @return: 1 if samples can be recorded, 0 otherwise
+int initRecorder();
+
+// Appends a sample set to the current session as a sample frame
+// @param set: Sample set to record
+// @param timeUs: Time of the sample set
+// @param timeOffsetUs: Converts the capture times to the time base of the frame
+// @param flags: Frame flags matching the time (FRAME_FLAG_x)
+void recordSample(const t_sampleSet *set, uint64_t timeUs, int64_t timeOffsetUs, uint8_t flags);
+
+// Writes the buffered samples when they have waited long enough
+void serviceRecorder();
+
+// Writes the buffered samples to flash now
+void flushRecorder();
+
+// Lists the most recent sessions, oldest first
+// @param sessions: Array receiving the sessions
+// @param maxSessions: Size of the array
+// @return: Number of sessions stored in the array
+uint8_t listSessions(t_sessionInfo *sessions, uint8_t maxSessions);
+
+// Compresses a recorded session block by block, as the recorder would,
+// and checks and times every block. Meant for sessions recorded uncompressed
+// @param id: Session number
+// @param stats: Pointer to structure where the results will be stored
+// @return: 1 if the session could be read, 0 otherwise
+uint8_t benchmarkSession(uint16_t id, t_compressStats *stats);
+
+// Builds the path of a session file
+// @param id: Session number
+// @param path: Destination buffer of RECORDER_PATH_SIZE bytes
+void getSessionPath(uint16_t id, char *path);
+
+#endif // RECORDER_hpp
@@ -0,0 +1,271 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file keeps small records across reboots in NVS: sensor
+    calibrations, learnt baselines and runtime settings. Each record
+    carries its layout version, its length and a CRC, so a record
+    from another firmware or a torn write is ignored. Writes are
+    delayed until a record stops changing and are rate-limited per
+    record, and unchanged records are never rewritten.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the state store
+#include "State.hpp"
+
+// Same CRC as the frames
+#include "../protocols/Frame.hpp"
+
+// Arduino core for millis()
+#include <Arduino.h>
+
+// Non-volatile storage of the records
+#include <Preferences.h>
+
+// memcmp() and memcpy() on the record images
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Size of the header in front of each record
+#define STATE_HEADER_SIZE 8
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Record image as stored in flash: header, then the record
+// [0] format version, [1] reserved, [2..3] record version,
+// [4..5] record length, [6..7] CRC of the image with this field at 0
+typedef struct
+{
+    // Header and record
+    uint8_t image[STATE_HEADER_SIZE + STATE_MAX_DATA_SIZE];
+    uint16_t length;
+
+    // Set while the image differs from the one in flash
+    uint8_t dirty;
+
+    // Last change and last write of the record
+    uint32_t changedMs;
+    uint32_t writtenMs;
+    uint8_t written;
+
+} t_stateSlot;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Keys of the records, in e_stateRecord order
+static const char *const stateKeys[STATE_RECORD_COUNT] = {"bme680", "iaq", "config", "gasmatrix"};
+
+// Latest image of every record
+static t_stateSlot slots[STATE_RECORD_COUNT];
+
+// Preferences handle, open for the whole run
+static Preferences prefs;
+static uint8_t opened = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Builds the image of a record, header included
+// @param image: Destination buffer
+// @param version: Layout version of the record
+// @param data: Record
+// @param size: Size of the record
+// @return: Size of the image
+static uint16_t buildImage(uint8_t *image, uint16_t version, const void *data, uint16_t size);
+
+// Writes the image of a record to flash
+// @param record: Record to write
+static void writeSlot(uint8_t record);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Opens the store, must run before the records are loaded
+// @return: 1 if the store is usable, 0 otherwise
+int initStateStore()
+{
+    if (!opened)
+    {
+        opened = prefs.begin(STATE_NVS_NAMESPACE, false);
+    }
+
+    return opened;
+}
+
+
+/* *****************************************************************
+    *                       RECORD FUNCTIONS                      *
+   ***************************************************************** */
+
+// Loads a record saved by an earlier run
+// @param record: Record to load
+// @param version: Layout version expected by the caller
+// @param data: Destination of the record
+// @param size: Size of the record
+// @return: 1 if a record of this version, size and valid CRC was loaded, 0 otherwise
+uint8_t loadState(e_stateRecord record, uint16_t version, void *data, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Image read from flash and the one it should be
+    uint8_t image[STATE_HEADER_SIZE + STATE_MAX_DATA_SIZE];
+    uint8_t expected[STATE_HEADER_SIZE + STATE_MAX_DATA_SIZE];
+    size_t length;
+
+    /* -------------------- RECORD CHECK -------------------- */
+
+    if (!opened || record >= STATE_RECORD_COUNT || size > STATE_MAX_DATA_SIZE)
+    {
+        return 0;
+    }
+
+    length = prefs.getBytes(stateKeys[record], image, sizeof(image));
+
+    // Header and length first, they tell whether the data can be used
+    if (length != (size_t)STATE_HEADER_SIZE + size || image[0] != STATE_FORMAT_VERSION ||
+        (image[2] | (image[3] << 8)) != version || (image[4] | (image[5] << 8)) != size)
+    {
+        return 0;
+    }
+
+    // Rebuilding the image recomputes the CRC over the same bytes
+    buildImage(expected, version, image + STATE_HEADER_SIZE, size);
+    if (memcmp(image, expected, length) != 0)
+    {
+        return 0;
+    }
+
+    memcpy(data, image + STATE_HEADER_SIZE, size);
+
+    // Saving the same record again is then recognised and skipped
+    memcpy(slots[record].image, image, length);
+    slots[record].length = length;
+    return 1;
+}
+
+// Saves a record, the write to flash is delayed and merged with later changes
+// @param record: Record to save
+// @param version: Layout version of the record
+// @param data: Record to save
+// @param size: Size of the record, at most STATE_MAX_DATA_SIZE
+void saveState(e_stateRecord record, uint16_t version, const void *data, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // New image of the record
+    uint8_t image[STATE_HEADER_SIZE + STATE_MAX_DATA_SIZE];
+    uint16_t length;
+
+    /* -------------------- CHANGE TRACKING -------------------- */
+
+    if (record >= STATE_RECORD_COUNT || size > STATE_MAX_DATA_SIZE)
+    {
+        return;
+    }
+
+    length = buildImage(image, version, data, size);
+
+    // Same as the latest image, nothing to write
+    if (length == slots[record].length && memcmp(image, slots[record].image, length) == 0)
+    {
+        return;
+    }
+
+    memcpy(slots[record].image, image, length);
+    slots[record].length = length;
+    slots[record].dirty = 1;
+    slots[record].changedMs = millis();
+}
+
+// Writes the records whose delay has elapsed
+void serviceStateStore()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Current time
+    uint32_t now = millis();
+
+    /* -------------------- DELAYED WRITES -------------------- */
+
+    for (uint8_t i = 0; i < STATE_RECORD_COUNT; i++)
+    {
+        if (slots[i].dirty && now - slots[i].changedMs >= STATE_SETTLE_MS &&
+            (!slots[i].written || now - slots[i].writtenMs >= STATE_MIN_INTERVAL_MS))
+        {
+            writeSlot(i);
+        }
+    }
+}
+
+// Writes every changed record now
+void flushStateStore()
+{
+    for (uint8_t i = 0; i < STATE_RECORD_COUNT; i++)
+    {
+        if (slots[i].dirty)
+        {
+            writeSlot(i);
+        }
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Builds the image of a record, header included
+static uint16_t buildImage(uint8_t *image, uint16_t version, const void *data, uint16_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // CRC of the image
+    uint16_t crc;
+
+    /* -------------------- IMAGE -------------------- */
+
+    image[0] = STATE_FORMAT_VERSION;
+    image[1] = 0;
+    image[2] = (uint8_t)version;
+    image[3] = (uint8_t)(version >> 8);
+    image[4] = (uint8_t)size;
+    image[5] = (uint8_t)(size >> 8);
+    image[6] = 0;
+    image[7] = 0;
+    memcpy(image + STATE_HEADER_SIZE, data, size);
+
+    crc = calculateFrameCrc(image, STATE_HEADER_SIZE + size);
+    image[6] = (uint8_t)crc;
+    image[7] = (uint8_t)(crc >> 8);
+
+    return STATE_HEADER_SIZE + size;
+}
+
+// Writes the image of a record to flash
+static void writeSlot(uint8_t record)
+{
+    if (!opened)
+    {
+        return;
+    }
+
+    // On failure the record stays dirty and is tried again later
+    if (prefs.putBytes(stateKeys[record], slots[record].image, slots[record].length) ==
+        slots[record].length)
+    {
+        slots[record].dirty = 0;
+    }
+
+    slots[record].written = 1;
+    slots[record].writtenMs = millis();
+}
@@ -0,0 +1,83 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef STATE_hpp
+#define STATE_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Preferences namespace holding one key per record
+#define STATE_NVS_NAMESPACE "state"
+
+// Layout of the record header, records of another layout are ignored
+#define STATE_FORMAT_VERSION 1
+
+// Largest record, without its header
+#define STATE_MAX_DATA_SIZE 120
+
+// A changed record is written once it has not changed for this long,
+// so a burst of changes costs one write
+#define STATE_SETTLE_MS 5000UL
+
+// Shortest time between two writes of the same record
+#define STATE_MIN_INTERVAL_MS 60000UL
+
+// Period of the state store service task
+#define STATE_SERVICE_MS 1000
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Records kept across reboots
+typedef enum
+{
+    // Raw calibration registers of the BME680
+    STATE_BME680_CALIBRATION,
+
+    // Clean-air baseline learnt by the IAQ estimator
+    STATE_IAQ_BASELINE,
+
+    // Settings changed at runtime, such as the measurement mode
+    STATE_RUNTIME_CONFIG,
+
+    // Compensation matrix of the MQ gas sensors, fitted on the host
+    STATE_GAS_COMPENSATION,
+
+    STATE_RECORD_COUNT
+
+} e_stateRecord;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Opens the store, must run before the records are loaded
+// @return: 1 if the store is usable, 0 otherwise
+int initStateStore();
+
+// Loads a record saved by an earlier run
+// @param record: Record to load
+// @param version: Layout version expected by the caller
+// @param data: Destination of the record
+// @param size: Size of the record
+// @return: 1 if a record of this version, size and valid CRC was loaded, 0 otherwise
+uint8_t loadState(e_stateRecord record, uint16_t version, void *data, uint16_t size);
+
+// Saves a record, the write to flash is delayed and merged with later changes
+// @param record: Record to save
+// @param version: Layout version of the record
+// @param data: Record to save
+// @param size: Size of the record, at most STATE_MAX_DATA_SIZE
+void saveState(e_stateRecord record, uint16_t version, const void *data, uint16_t size);
+
+// Writes the records whose delay has elapsed
+void serviceStateStore();
+
+// Writes every changed record now
+void flushStateStore();
+
+#endif // STATE_hpp
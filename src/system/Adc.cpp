@@ -0,0 +1,232 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file turns the raw counts of the analog pins into voltages.
+    The ESP32 ADC bends away from a straight line near both ends of
+    its range, and its gain differs from one chip to the next. The
+    calibration burnt in the eFuse at the factory is read once at
+    boot and sampled into a small table per ADC, so each conversion
+    is a lookup and an interpolation, and the same voltage gives the
+    same millivolts on every unit.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the ADC characterisation
+#include "Adc.hpp"
+
+// Arduino core for analogRead() and its settings
+#include <Arduino.h>
+
+// ESP-IDF characterisation of the ADC from the eFuse
+#include <esp_adc_cal.h>
+
+// Wi-Fi mode, ADC2 is shared with the radio
+#include <WiFi.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// ADC1 and ADC2
+#define ADC_UNITS 2
+
+// GPIO 32 to 39 are on ADC1, the other analog pins on ADC2
+#define ADC1_FIRST_PIN 32
+#define ADC1_LAST_PIN  39
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Voltage in mV every ADC_TABLE_STEP counts, one table per ADC
+static uint16_t voltageTable[ADC_UNITS][ADC_TABLE_POINTS];
+
+// Source of the characterisation of each ADC
+static e_adcCalibration calibration[ADC_UNITS];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Characterises one ADC and fills its table
+// @param unit: ADC to characterise
+// @return: Source of the characterisation
+static e_adcCalibration buildTable(adc_unit_t unit);
+
+// Returns the index of the table of the ADC a pin is on
+// @param pin: Analog pin
+// @return: 0 for ADC1, 1 for ADC2
+static uint8_t getUnitIndex(int8_t pin);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Characterises both ADCs from the eFuse and builds their voltage tables,
+// before any analog pin is read
+// @return: 1 if ADC1 was calibrated at the factory, 0 if the nominal Vref is used
+int initAdc()
+{
+    // Every pin is read with the settings the tables are built for
+    analogReadResolution(ADC_RESOLUTION_BITS);
+    analogSetAttenuation(ADC_11db);
+
+    calibration[0] = buildTable(ADC_UNIT_1);
+    calibration[1] = buildTable(ADC_UNIT_2);
+
+    return calibration[0] != ADC_CAL_DEFAULT;
+}
+
+
+/* *****************************************************************
+    *                    CONVERSION FUNCTIONS                     *
+   ***************************************************************** */
+
+// Reads an analog pin and converts the count with the table of its ADC,
+// a pin that cannot be read gives 0 flagged as clipped
+// @param pin: Analog pin to read
+// @param reading: Pointer to structure where the reading will be stored
+void readAdc(int8_t pin, t_adcReading *reading)
+{
+    if (!isAdcAvailable(pin))
+    {
+        reading->raw = 0;
+        reading->millivolts = 0;
+        reading->range = ADC_CLIPPED_LOW;
+        return;
+    }
+
+    reading->raw = analogRead(pin);
+    reading->millivolts = adcToMillivolts(pin, reading->raw);
+    reading->range = getAdcRange(reading->raw);
+}
+
+// Tells whether a pin can be converted now: ADC2 belongs to Wi-Fi while
+// the radio runs, even on a profile that leaves it off (the 'W' soft-AP)
+// @param pin: Analog pin
+// @return: 1 if the pin can be read, 0 otherwise
+uint8_t isAdcAvailable(int8_t pin)
+{
+    return getUnitIndex(pin) == 0 || WiFi.getMode() == WIFI_OFF;
+}
+
+// Converts a raw count of a pin to a voltage
+// @param pin: Analog pin the count was read from
+// @param raw: Raw count
+// @return: Voltage in mV, 0 before initAdc()
+uint16_t adcToMillivolts(int8_t pin, uint16_t raw)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Table of the ADC of the pin
+    const uint16_t *table = voltageTable[getUnitIndex(pin)];
+
+    // Segment holding the count, and the position of the count in it
+    uint16_t index;
+    uint16_t offset;
+
+    /* -------------------- INTERPOLATION -------------------- */
+
+    if (raw > ADC_MAX_COUNT)
+    {
+        raw = ADC_MAX_COUNT;
+    }
+
+    index = raw >> ADC_TABLE_SHIFT;
+    offset = raw & (ADC_TABLE_STEP - 1);
+
+    // The characterisation never decreases, the segment slope is positive
+    return table[index] +
+           (uint16_t)(((uint32_t)(table[index + 1] - table[index]) * offset + ADC_TABLE_STEP / 2) >>
+                      ADC_TABLE_SHIFT);
+}
+
+// Tells whether a raw count lies near either end of the range
+// @param raw: Raw count
+// @return: Position of the count (e_adcRange)
+e_adcRange getAdcRange(uint16_t raw)
+{
+    if (raw < ADC_CLIP_MARGIN)
+    {
+        return ADC_CLIPPED_LOW;
+    }
+
+    if (raw > ADC_MAX_COUNT - ADC_CLIP_MARGIN)
+    {
+        return ADC_CLIPPED_HIGH;
+    }
+
+    return ADC_IN_RANGE;
+}
+
+// Returns a short printable name for the characterisation of ADC1
+// @return: Constant string describing the calibration source
+const char *getAdcCalibrationName()
+{
+    switch (calibration[0])
+    {
+        case ADC_CAL_TWO_POINT:
+            return "TWO POINT";
+
+        case ADC_CAL_EFUSE_VREF:
+            return "EFUSE VREF";
+
+        default:
+            return "DEFAULT VREF";
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Characterises one ADC and fills its table
+static e_adcCalibration buildTable(adc_unit_t unit)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Characteristics read from the eFuse
+    esp_adc_cal_characteristics_t characteristics;
+    esp_adc_cal_value_t source;
+
+    // Table being filled
+    uint16_t *table = voltageTable[unit == ADC_UNIT_1 ? 0 : 1];
+
+    /* -------------------- TABLE -------------------- */
+
+    source = esp_adc_cal_characterize(unit, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF_MV,
+                                      &characteristics);
+
+    // The last point lies past the largest count, it continues the
+    // segment below it rather than asking the IDF for an unknown count
+    for (uint8_t i = 0; i < ADC_TABLE_POINTS - 1; i++)
+    {
+        table[i] = esp_adc_cal_raw_to_voltage((uint32_t)i << ADC_TABLE_SHIFT, &characteristics);
+    }
+
+    table[ADC_TABLE_POINTS - 1] = 2 * table[ADC_TABLE_POINTS - 2] - table[ADC_TABLE_POINTS - 3];
+
+    /* -------------------- SOURCE -------------------- */
+
+    switch (source)
+    {
+        case ESP_ADC_CAL_VAL_EFUSE_TP:
+            return ADC_CAL_TWO_POINT;
+
+        case ESP_ADC_CAL_VAL_EFUSE_VREF:
+            return ADC_CAL_EFUSE_VREF;
+
+        default:
+            return ADC_CAL_DEFAULT;
+    }
+}
+
+// Returns the index of the table of the ADC a pin is on
+static uint8_t getUnitIndex(int8_t pin)
+{
+    return (pin >= ADC1_FIRST_PIN && pin <= ADC1_LAST_PIN) ? 0 : 1;
+}
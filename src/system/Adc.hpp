@@ -0,0 +1,110 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef ADC_hpp
+#define ADC_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Resolution of the conversions, and the largest count it gives
+#define ADC_RESOLUTION_BITS 12
+#define ADC_MAX_COUNT       4095
+
+// Vref assumed when the eFuse holds no calibration, in mV
+#define ADC_DEFAULT_VREF_MV 1100
+
+// The table holds a voltage every 2^ADC_TABLE_SHIFT counts, the counts
+// in between are interpolated. The last point closes the top segment
+#define ADC_TABLE_SHIFT  5
+#define ADC_TABLE_STEP   (1U << ADC_TABLE_SHIFT)
+#define ADC_TABLE_POINTS ((ADC_MAX_COUNT >> ADC_TABLE_SHIFT) + 2)
+
+// Counts this close to either end may hide a voltage out of the range,
+// 0 covers everything up to about 100 mV and the top flattens out
+#define ADC_CLIP_MARGIN 16
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Source of the characterisation of an ADC
+typedef enum
+{
+    // Nominal Vref, the chip was never calibrated
+    ADC_CAL_DEFAULT,
+
+    // Vref measured at the factory and burnt in the eFuse
+    ADC_CAL_EFUSE_VREF,
+
+    // Two readings of known voltages burnt in the eFuse
+    ADC_CAL_TWO_POINT
+
+} e_adcCalibration;
+
+// Position of a reading in the range of the ADC
+typedef enum
+{
+    ADC_IN_RANGE,
+
+    // Near 0, the voltage may be lower than the reading says
+    ADC_CLIPPED_LOW,
+
+    // Near full scale, the voltage may be higher than the reading says
+    ADC_CLIPPED_HIGH
+
+} e_adcRange;
+
+// One conversion of an analog pin
+typedef struct
+{
+    // Raw count
+    uint16_t raw;
+
+    // Voltage at the pin from the characterisation of its ADC, in mV
+    uint16_t millivolts;
+
+    // Position of the count in the range (e_adcRange)
+    uint8_t range;
+
+} t_adcReading;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Characterises both ADCs from the eFuse and builds their voltage tables,
+// before any analog pin is read
+// @return: 1 if ADC1 was calibrated at the factory, 0 if the nominal Vref is used
+int initAdc();
+
+// Reads an analog pin and converts the count with the table of its ADC,
+// a pin that cannot be read gives 0 flagged as clipped
+// @param pin: Analog pin to read
+// @param reading: Pointer to structure where the reading will be stored
+void readAdc(int8_t pin, t_adcReading *reading);
+
+// Tells whether a pin can be converted now: ADC2 belongs to Wi-Fi while
+// the radio runs, even on a profile that leaves it off (the 'W' soft-AP)
+// @param pin: Analog pin
+// @return: 1 if the pin can be read, 0 otherwise
+uint8_t isAdcAvailable(int8_t pin);
+
+// Converts a raw count of a pin to a voltage
+// @param pin: Analog pin the count was read from
+// @param raw: Raw count
+// @return: Voltage in mV, 0 before initAdc()
+uint16_t adcToMillivolts(int8_t pin, uint16_t raw);
+
+// Tells whether a raw count lies near either end of the range
+// @param raw: Raw count
+// @return: Position of the count (e_adcRange)
+e_adcRange getAdcRange(uint16_t raw);
+
+// Returns a short printable name for the characterisation of ADC1
+// @return: Constant string describing the calibration source
+const char *getAdcCalibrationName();
+
+#endif // ADC_hpp
@@ -0,0 +1,233 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file runs the boot sequence. Modules are initialized in
+    lanes: the sensors in setup() so sampling starts as soon as they
+    answer, the Bluetooth stack and the storage and Wi-Fi modules in
+    their own tasks on the other core. The time taken by every step
+    is kept for the boot-timing report.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the boot sequence
+#include "Boot.hpp"
+
+// Arduino core for millis()
+#include <Arduino.h>
+
+// Lane tasks
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Table of registered steps
+static t_bootStep steps[BOOT_MAX_STEPS];
+
+// Number of registered steps
+static uint8_t stepCount = 0;
+
+// Time of the first sample, 0 until one is taken
+static uint32_t firstSampleMs = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Runs the steps of a lane in order
+// @param lane: Lane to run
+static void runLane(uint8_t lane);
+
+// Task running a background lane, then deleting itself
+// @param parameter: Lane to run
+static void laneTask(void *parameter);
+
+
+/* *****************************************************************
+    *                       STEP MANAGEMENT                       *
+   ***************************************************************** */
+
+// Adds a step to the boot sequence, before startBoot()
+// @param name: Short name shown in the boot report
+// @param function: Function initializing the module
+// @param lane: Lane the step runs in (BOOT_LANE_x)
+// @return: Step identifier, BOOT_NO_STEP if the table is full
+int8_t addBootStep(const char *name, t_bootFunction function, uint8_t lane)
+{
+    if (stepCount >= BOOT_MAX_STEPS || !function || lane >= BOOT_LANES)
+    {
+        return BOOT_NO_STEP;
+    }
+
+    steps[stepCount].name = name;
+    steps[stepCount].function = function;
+    steps[stepCount].lane = lane;
+    steps[stepCount].state = BOOT_PENDING;
+    steps[stepCount].startMs = 0;
+    steps[stepCount].endMs = 0;
+
+    return (int8_t)stepCount++;
+}
+
+// Starts the background lanes, then runs the inline lane before returning
+void startBoot()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Set when the lane has at least one step
+    uint8_t used;
+
+    /* -------------------- BACKGROUND LANES -------------------- */
+
+    for (uint8_t lane = BOOT_LANE_INLINE + 1; lane < BOOT_LANES; lane++)
+    {
+        used = 0;
+
+        for (uint8_t i = 0; i < stepCount; i++)
+        {
+            used |= (steps[i].lane == lane);
+        }
+
+        // Without a task the lane still runs, after the inline one
+        if (used && xTaskCreatePinnedToCore(laneTask, "boot", BOOT_TASK_STACK,
+                                            (void *)(uintptr_t)lane, BOOT_TASK_PRIORITY,
+                                            NULL, BOOT_TASK_CORE) != pdPASS)
+        {
+            for (uint8_t i = 0; i < stepCount; i++)
+            {
+                if (steps[i].lane == lane)
+                {
+                    steps[i].lane = BOOT_LANE_INLINE;
+                }
+            }
+        }
+    }
+
+    /* -------------------- INLINE LANE -------------------- */
+
+    runLane(BOOT_LANE_INLINE);
+}
+
+
+/* *****************************************************************
+    *                        STATE QUERIES                        *
+   ***************************************************************** */
+
+// Tells whether a step has finished successfully
+uint8_t isBootStepReady(int8_t id)
+{
+    return id >= 0 && id < stepCount && steps[id].state == BOOT_READY;
+}
+
+// Tells whether every step has finished, successfully or not
+uint8_t isBootComplete()
+{
+    for (uint8_t i = 0; i < stepCount; i++)
+    {
+        if (steps[i].state == BOOT_PENDING || steps[i].state == BOOT_RUNNING)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Records the time of the first sample, only the first call counts
+void markFirstSample()
+{
+    if (firstSampleMs == 0)
+    {
+        firstSampleMs = millis();
+    }
+}
+
+// Returns the time of the first sample in milliseconds since power-on
+uint32_t getFirstSampleMs()
+{
+    return firstSampleMs;
+}
+
+// Returns the number of boot steps
+uint8_t getBootStepCount()
+{
+    return stepCount;
+}
+
+// Returns a boot step
+const t_bootStep *getBootStep(int8_t id)
+{
+    if (id < 0 || id >= stepCount)
+    {
+        return NULL;
+    }
+
+    return &steps[id];
+}
+
+// Returns a short printable name for a boot state
+const char *getBootStateName(e_bootState state)
+{
+    switch (state)
+    {
+        case BOOT_PENDING:
+            return "PENDING";
+
+        case BOOT_RUNNING:
+            return "RUNNING";
+
+        case BOOT_READY:
+            return "READY";
+
+        case BOOT_FAILED:
+            return "FAILED";
+
+        default:
+            return "UNKNOWN";
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Runs the steps of a lane in order
+static void runLane(uint8_t lane)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Result of the step
+    uint8_t ok;
+
+    /* -------------------- STEP EXECUTION -------------------- */
+
+    for (uint8_t i = 0; i < stepCount; i++)
+    {
+        if (steps[i].lane != lane)
+        {
+            continue;
+        }
+
+        steps[i].startMs = millis();
+        steps[i].state = BOOT_RUNNING;
+
+        // The times are written before the state other tasks look at
+        ok = steps[i].function() ? 1 : 0;
+        steps[i].endMs = millis();
+        steps[i].state = ok ? BOOT_READY : BOOT_FAILED;
+    }
+}
+
+// Task running a background lane, then deleting itself
+static void laneTask(void *parameter)
+{
+    runLane((uint8_t)(uintptr_t)parameter);
+    vTaskDelete(NULL);
+}
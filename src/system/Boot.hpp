@@ -0,0 +1,110 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef BOOT_hpp
+#define BOOT_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Maximum number of boot steps
+#define BOOT_MAX_STEPS 12
+
+// Value returned when a step cannot be added
+#define BOOT_NO_STEP -1
+
+// Lanes of steps. Steps of a lane run one after the other, lanes run
+// side by side: the inline lane in setup(), the others in their own task
+#define BOOT_LANE_INLINE  0
+#define BOOT_LANE_LINK    1
+#define BOOT_LANE_NETWORK 2
+#define BOOT_LANES        3
+
+// Lane tasks: stack, priority and core (the loop runs on core 1)
+#define BOOT_TASK_STACK    8192
+#define BOOT_TASK_PRIORITY 1
+#define BOOT_TASK_CORE     0
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Function run by a boot step
+// @return: 1 if the step succeeded, 0 otherwise
+typedef int (*t_bootFunction)();
+
+// Progress of a boot step
+typedef enum
+{
+    BOOT_PENDING,
+    BOOT_RUNNING,
+    BOOT_READY,
+    BOOT_FAILED
+
+} e_bootState;
+
+// Boot step descriptor
+typedef struct
+{
+    // Short name shown in the boot report
+    const char *name;
+
+    // Function initializing the module
+    t_bootFunction function;
+
+    // Lane the step runs in (BOOT_LANE_x)
+    uint8_t lane;
+
+    // Current state (e_bootState), written by the lane task
+    volatile uint8_t state;
+
+    // Start and end of the step in milliseconds since power-on
+    uint32_t startMs;
+    uint32_t endMs;
+
+} t_bootStep;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Adds a step to the boot sequence, before startBoot()
+// @param name: Short name shown in the boot report
+// @param function: Function initializing the module
+// @param lane: Lane the step runs in (BOOT_LANE_x)
+// @return: Step identifier, BOOT_NO_STEP if the table is full
+int8_t addBootStep(const char *name, t_bootFunction function, uint8_t lane);
+
+// Starts the background lanes, then runs the inline lane before returning
+void startBoot();
+
+// Tells whether a step has finished successfully
+// @param id: Step identifier
+uint8_t isBootStepReady(int8_t id);
+
+// Tells whether every step has finished, successfully or not
+uint8_t isBootComplete();
+
+// Records the time of the first sample, only the first call counts
+void markFirstSample();
+
+// Returns the time of the first sample in milliseconds since power-on
+// @return: Time of the first sample, 0 if none was taken yet
+uint32_t getFirstSampleMs();
+
+// Returns the number of boot steps
+uint8_t getBootStepCount();
+
+// Returns a boot step
+// @param id: Step identifier
+// @return: Pointer to the step, NULL if the identifier is invalid
+const t_bootStep *getBootStep(int8_t id);
+
+// Returns a short printable name for a boot state
+// @param state: Boot state
+// @return: Constant string describing the state
+const char *getBootStateName(e_bootState state);
+
+#endif // BOOT_hpp
@@ -0,0 +1,292 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file implements the sensor health monitoring layer. Each
+    driver reports its reads, which feed per-sensor error counters
+    and the stuck-value and out-of-range detectors. Failed sensors
+    are re-initialized from the scheduler with an exponential
+    back-off, so a faulty sensor never blocks the main loop.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the health layer
+#include "Health.hpp"
+
+// Includes the sensor drivers for their init functions
+#include "../sensors/BME680.hpp"
+#include "../sensors/MH-Z19B.hpp"
+#include "../sensors/MQ-4.hpp"
+#include "../sensors/MQ-7.hpp"
+#include "../sensors/MQ-131.hpp"
+#include "../sensors/MQ-137.hpp"
+#include "../sensors/GY-UV1.hpp"
+#include "../sensors/PMS5003.hpp"
+#include "../sensors/Pixhawk.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Valid range of a raw 12-bit ADC reading
+#define ADC_MIN_VALID HEALTH_ADC_RAIL_MARGIN
+#define ADC_MAX_VALID (4095 - HEALTH_ADC_RAIL_MARGIN)
+
+// Init function of a driver, NULL when the profile leaves it out
+#define SENSOR_INIT(has, init) SENSOR_INIT_(has, init)
+#define SENSOR_INIT_(has, init) SENSOR_INIT_##has(init)
+#define SENSOR_INIT_0(init) NULL
+#define SENSOR_INIT_1(init) init
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Static configuration of the detectors for one sensor
+typedef struct
+{
+    // Function used to re-initialize the sensor, NULL if not compiled in
+    int (*init)();
+
+    // Valid range of the checked value, disabled when equal
+    int32_t minValue;
+    int32_t maxValue;
+
+    // Identical values in a row considered stuck, 0 to disable
+    uint16_t stuckLimit;
+
+} t_healthConfig;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Detector configuration, in e_sensor order
+static const t_healthConfig healthConfig[SENSOR_COUNT] = {
+    // BME680 checks the full resolution pressure in Pa
+    {initBME680, 30000, 110000, 60},
+    {SENSOR_INIT(PROFILE_HAS_MHZ19B, initMHZ19B), ADC_MIN_VALID, ADC_MAX_VALID, 30},
+    {SENSOR_INIT(PROFILE_HAS_MQ4, initMQ4), ADC_MIN_VALID, ADC_MAX_VALID, 30},
+    {SENSOR_INIT(PROFILE_HAS_MQ7, initMQ7), ADC_MIN_VALID, ADC_MAX_VALID, 30},
+    {SENSOR_INIT(PROFILE_HAS_MQ131, initMQ131), ADC_MIN_VALID, ADC_MAX_VALID, 30},
+    {SENSOR_INIT(PROFILE_HAS_MQ137, initMQ137), ADC_MIN_VALID, ADC_MAX_VALID, 30},
+    {SENSOR_INIT(PROFILE_HAS_GYUV1, initGYUV1), 0, 4095, 0},
+    // PMS5003 checks PM10, which may stay at 0 in clean air
+    {SENSOR_INIT(PROFILE_HAS_PMS5003, initPMS5003), 0, 1000, 0},
+    {SENSOR_INIT(PROFILE_HAS_PIXHAWK, initPixhawk), 0, 0, 0}};
+
+// Health record of every sensor
+static t_sensorHealth health[SENSOR_COUNT];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Marks a sensor as failed and schedules its re-initialization
+// @param sensor: Sensor that failed
+static void markFailed(e_sensor sensor);
+
+
+/* *****************************************************************
+    *                      REPORT FUNCTIONS                       *
+   ***************************************************************** */
+
+// Records the result of a sensor initialization
+// @param sensor: Sensor that was initialized
+// @param ok: Result returned by the init function
+// @return: The value of ok, so the call can wrap the init function
+int reportSensorInit(e_sensor sensor, int ok)
+{
+    if (sensor >= SENSOR_COUNT)
+    {
+        return ok;
+    }
+
+    if (health[sensor].state == HEALTH_UNUSED)
+    {
+        health[sensor].backoffMs = HEALTH_BACKOFF_MIN_MS;
+    }
+
+    if (ok)
+    {
+        // The back-off is only reset once a good reading comes in
+        health[sensor].state = HEALTH_OK;
+        health[sensor].consecutiveErrors = 0;
+        health[sensor].stuckCount = 0;
+    }
+
+    else
+    {
+        health[sensor].errorCount++;
+        markFailed(sensor);
+    }
+
+    return ok;
+}
+
+// Records the result of a sensor read
+// @param sensor: Sensor that was read
+// @param ok: 1 if the read succeeded, 0 otherwise
+void reportSensorRead(e_sensor sensor, uint8_t ok)
+{
+    if (sensor >= SENSOR_COUNT || health[sensor].state == HEALTH_UNUSED ||
+        health[sensor].state == HEALTH_FAILED)
+    {
+        return;
+    }
+
+    if (ok)
+    {
+        health[sensor].consecutiveErrors = 0;
+        health[sensor].backoffMs = HEALTH_BACKOFF_MIN_MS;
+        health[sensor].state = HEALTH_OK;
+        return;
+    }
+
+    health[sensor].errorCount++;
+    health[sensor].consecutiveErrors++;
+
+    if (health[sensor].consecutiveErrors >= HEALTH_MAX_CONSECUTIVE_ERRORS)
+    {
+        markFailed(sensor);
+    }
+
+    else
+    {
+        health[sensor].state = HEALTH_DEGRADED;
+    }
+}
+
+// Runs the out-of-range and stuck-value detectors on a reading
+// @param sensor: Sensor that produced the value
+// @param value: Raw value read from the sensor
+// @return: 1 if the value passed both detectors, 0 otherwise
+uint8_t checkSensorValue(e_sensor sensor, int32_t value)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Result of the detectors
+    uint8_t ok = 1;
+
+    /* ------------------ OUT-OF-RANGE DETECTOR ------------------ */
+
+    if (sensor >= SENSOR_COUNT)
+    {
+        return 0;
+    }
+
+    if (healthConfig[sensor].minValue != healthConfig[sensor].maxValue &&
+        (value < healthConfig[sensor].minValue || value > healthConfig[sensor].maxValue))
+    {
+        ok = 0;
+    }
+
+    /* ------------------ STUCK-VALUE DETECTOR ------------------ */
+
+    if (value == health[sensor].lastValue)
+    {
+        if (health[sensor].stuckCount < UINT16_MAX)
+        {
+            health[sensor].stuckCount++;
+        }
+    }
+
+    else
+    {
+        health[sensor].stuckCount = 0;
+        health[sensor].lastValue = value;
+    }
+
+    if (healthConfig[sensor].stuckLimit &&
+        health[sensor].stuckCount >= healthConfig[sensor].stuckLimit)
+    {
+        ok = 0;
+    }
+
+    reportSensorRead(sensor, ok);
+    return ok;
+}
+
+
+/* *****************************************************************
+    *                      QUERY FUNCTIONS                        *
+   ***************************************************************** */
+
+// Returns the health record of a sensor
+// @param sensor: Sensor to query
+// @return: Pointer to the health record
+const t_sensorHealth *getSensorHealth(e_sensor sensor)
+{
+    return (sensor < SENSOR_COUNT) ? &health[sensor] : &health[0];
+}
+
+// Returns one bit per sensor, set when the sensor is not healthy
+// @return: Bit mask indexed by e_sensor
+uint16_t getHealthBits()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Health bit mask
+    uint16_t bits = 0;
+
+    /* -------------------- MASK BUILDING -------------------- */
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++)
+    {
+        if (health[i].state == HEALTH_DEGRADED || health[i].state == HEALTH_FAILED)
+        {
+            bits |= (1U << i);
+        }
+    }
+
+    return bits;
+}
+
+
+/* *****************************************************************
+    *                      SERVICE FUNCTION                       *
+   ***************************************************************** */
+
+// Re-initializes failed sensors whose back-off delay has elapsed
+void serviceHealth()
+{
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++)
+    {
+        if (health[i].state != HEALTH_FAILED || !healthConfig[i].init ||
+            (int32_t)(millis() - health[i].retryMs) < 0)
+        {
+            continue;
+        }
+
+        health[i].reinitCount++;
+
+        // Each failed attempt doubles the delay before the next one
+        if (!reportSensorInit((e_sensor)i, healthConfig[i].init()))
+        {
+            health[i].backoffMs *= 2;
+
+            if (health[i].backoffMs > HEALTH_BACKOFF_MAX_MS)
+            {
+                health[i].backoffMs = HEALTH_BACKOFF_MAX_MS;
+            }
+
+            health[i].retryMs = millis() + health[i].backoffMs;
+        }
+
+        // Only one re-initialization per call to keep the loop responsive
+        return;
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Marks a sensor as failed and schedules its re-initialization
+static void markFailed(e_sensor sensor)
+{
+    health[sensor].state = HEALTH_FAILED;
+    health[sensor].consecutiveErrors = 0;
+    health[sensor].stuckCount = 0;
+    health[sensor].retryMs = millis() + health[sensor].backoffMs;
+}
@@ -0,0 +1,127 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef HEALTH_hpp
+#define HEALTH_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Arduino core for millis()
+#include <Arduino.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Consecutive errors after which a sensor is declared failed
+#define HEALTH_MAX_CONSECUTIVE_ERRORS 3
+
+// First and maximum delay between two re-initialization attempts
+#define HEALTH_BACKOFF_MIN_MS 1000UL
+#define HEALTH_BACKOFF_MAX_MS 60000UL
+
+// Period of the re-initialization service task
+#define HEALTH_SERVICE_MS 250
+
+// Raw ADC counts closer than this to a rail mean a disconnected input
+#define HEALTH_ADC_RAIL_MARGIN 8
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Sensors supervised by the health layer
+typedef enum
+{
+    SENSOR_BME680,
+    SENSOR_MHZ19B,
+    SENSOR_MQ4,
+    SENSOR_MQ7,
+    SENSOR_MQ131,
+    SENSOR_MQ137,
+    SENSOR_GYUV1,
+    SENSOR_PMS5003,
+    SENSOR_PIXHAWK,
+    SENSOR_COUNT
+
+} e_sensor;
+
+// Health state of a sensor
+typedef enum
+{
+    // Sensor has never been initialized
+    HEALTH_UNUSED,
+
+    // Sensor is working
+    HEALTH_OK,
+
+    // Recent errors or a stuck value, still being read
+    HEALTH_DEGRADED,
+
+    // Sensor is waiting for a re-initialization
+    HEALTH_FAILED
+
+} e_healthState;
+
+// Health record of a sensor
+typedef struct
+{
+    // Total number of errors since boot
+    uint32_t errorCount;
+
+    // Number of errors without a good reading in between
+    uint8_t consecutiveErrors;
+
+    // Number of identical consecutive values
+    uint16_t stuckCount;
+
+    // Last value seen by the stuck detector
+    int32_t lastValue;
+
+    // Current state (e_healthState)
+    uint8_t state;
+
+    // Number of re-initializations since boot
+    uint16_t reinitCount;
+
+    // Time of the next re-initialization attempt
+    uint32_t retryMs;
+
+    // Current delay between re-initialization attempts
+    uint32_t backoffMs;
+
+} t_sensorHealth;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Records the result of a sensor initialization
+// @param sensor: Sensor that was initialized
+// @param ok: Result returned by the init function
+// @return: The value of ok, so the call can wrap the init function
+int reportSensorInit(e_sensor sensor, int ok);
+
+// Records the result of a sensor read
+// @param sensor: Sensor that was read
+// @param ok: 1 if the read succeeded, 0 otherwise
+void reportSensorRead(e_sensor sensor, uint8_t ok);
+
+// Runs the out-of-range and stuck-value detectors on a reading
+// @param sensor: Sensor that produced the value
+// @param value: Raw value read from the sensor
+// @return: 1 if the value passed both detectors, 0 otherwise
+uint8_t checkSensorValue(e_sensor sensor, int32_t value);
+
+// Returns the health record of a sensor
+// @param sensor: Sensor to query
+// @return: Pointer to the health record
+const t_sensorHealth *getSensorHealth(e_sensor sensor);
+
+// Returns one bit per sensor, set when the sensor is not healthy
+// @return: Bit mask indexed by e_sensor
+uint16_t getHealthBits();
+
+// Re-initializes failed sensors whose back-off delay has elapsed
+void serviceHealth();
+
+#endif // HEALTH_hpp
@@ -0,0 +1,49 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file derives the identity of the unit from the MAC address
+    burnt in its eFuses, so several AeroSense units can share a
+    radio link or be told apart by their Bluetooth name.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the unit identity
+#include "Identity.hpp"
+
+// Arduino core for the ESP object
+#include <Arduino.h>
+
+
+/* *****************************************************************
+    *                      IDENTITY FUNCTIONS                     *
+   ***************************************************************** */
+
+// Returns the identifier of this unit, the last two bytes of its MAC
+uint16_t getNodeId()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // MAC address, first byte in the lowest bits
+    uint64_t mac = ESP.getEfuseMac();
+
+    /* -------------------- IDENTIFIER -------------------- */
+
+    // Same order as the printed MAC, so "..:1A:2B" gives 0x1A2B
+    return (uint16_t)((((mac >> 32) & 0xFF) << 8) | ((mac >> 40) & 0xFF));
+}
+
+// Builds the name advertised by this unit (e.g. "AeroSense-1A2B")
+// @param name: Destination buffer
+// @param size: Size of the destination buffer
+void getDeviceName(char *name, size_t size)
+{
+    snprintf(name, size, "%s-%04X", DEVICE_NAME_PREFIX, getNodeId());
+}
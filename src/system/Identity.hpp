@@ -0,0 +1,35 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef IDENTITY_hpp
+#define IDENTITY_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Size type of the name buffer
+#include <stddef.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Prefix of the device name, followed by the node identifier in hex
+#define DEVICE_NAME_PREFIX "AeroSense"
+
+// Size of a buffer holding the device name
+#define DEVICE_NAME_SIZE 16
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Returns the identifier of this unit, the last two bytes of its MAC
+uint16_t getNodeId();
+
+// Builds the name advertised by this unit (e.g. "AeroSense-1A2B")
+// @param name: Destination buffer
+// @param size: Size of the destination buffer
+void getDeviceName(char *name, size_t size);
+
+#endif // IDENTITY_hpp
@@ -0,0 +1,252 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file manages the heaters of the MQ gas sensors. It keeps
+    track of the time since each heater was powered on and drives
+    the MQ-7 high/low heater cycle through an LEDC PWM channel,
+    so every sample can be flagged with a readiness state.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the MQ heater manager
+#include "MQHeater.hpp"
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Power-on timestamp of each heater
+static uint32_t startMillis[MQ_HEATER_COUNT];
+
+// Flags telling which heaters have been started
+static uint8_t started[MQ_HEATER_COUNT];
+
+// Start of the current MQ-7 heater phase
+static uint32_t mq7PhaseMillis;
+
+// 1 while the MQ-7 heater is in its high (5.0 V) phase
+static uint8_t mq7HighPhase;
+
+// Number of complete MQ-7 heater cycles since power-on
+static uint8_t mq7Cycles;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Applies a duty cycle to the MQ-7 heater PWM output
+// @param duty: Duty cycle for the configured resolution
+static void setMQ7HeaterDuty(uint32_t duty);
+
+// Returns the preheat duration of a continuously powered heater
+// @param heater: Heater to query
+// @return: Preheat duration in milliseconds
+static uint32_t getPreheatMillis(e_mqHeater heater);
+
+
+/* *****************************************************************
+    *                    START HEATER FUNCTION                    *
+   ***************************************************************** */
+
+// Records the power-on time of a heater and starts its drive cycle
+// @param heater: Heater to start
+void startMQHeater(e_mqHeater heater)
+{
+    if (heater >= MQ_HEATER_COUNT || started[heater])
+    {
+        return;
+    }
+
+    startMillis[heater] = millis();
+    started[heater] = 1;
+
+    // Only the MQ-7 heater is driven, the others are wired to 5 V
+    if (heater == MQ7_HEATER)
+    {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        ledcAttach(P_MQ7_HEATER, MQ7_HEATER_PWM_FREQ, MQ7_HEATER_PWM_RES);
+#else
+        ledcSetup(MQ7_HEATER_LEDC_CHANNEL, MQ7_HEATER_PWM_FREQ, MQ7_HEATER_PWM_RES);
+        ledcAttachPin(P_MQ7_HEATER, MQ7_HEATER_LEDC_CHANNEL);
+#endif
+
+        // Every cycle starts with the high phase
+        mq7PhaseMillis = startMillis[heater];
+        mq7HighPhase = 1;
+        mq7Cycles = 0;
+        setMQ7HeaterDuty(MQ7_DUTY_HIGH);
+    }
+}
+
+
+/* *****************************************************************
+    *                      SERVICE FUNCTION                       *
+   ***************************************************************** */
+
+// Drives the MQ-7 high/low heater cycle, called every MQ_HEATER_SERVICE_MS
+void serviceMQHeaters()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time spent in the current MQ-7 phase
+    uint32_t elapsed;
+
+    /* -------------------- MQ-7 HEATER CYCLE -------------------- */
+
+    if (!started[MQ7_HEATER])
+    {
+        return;
+    }
+
+    elapsed = millis() - mq7PhaseMillis;
+
+    if (mq7HighPhase && elapsed >= MQ7_HIGH_PHASE_MS)
+    {
+        // Switch to the 1.4 V measuring phase
+        mq7PhaseMillis += MQ7_HIGH_PHASE_MS;
+        mq7HighPhase = 0;
+        setMQ7HeaterDuty(MQ7_DUTY_LOW);
+    }
+
+    else if (!mq7HighPhase && elapsed >= MQ7_LOW_PHASE_MS)
+    {
+        // Switch back to the 5.0 V cleaning phase
+        mq7PhaseMillis += MQ7_LOW_PHASE_MS;
+        mq7HighPhase = 1;
+        setMQ7HeaterDuty(MQ7_DUTY_HIGH);
+
+        if (mq7Cycles < UINT8_MAX)
+        {
+            mq7Cycles++;
+        }
+    }
+}
+
+
+/* *****************************************************************
+    *                     READINESS FUNCTIONS                     *
+   ***************************************************************** */
+
+// Returns the readiness state of a heater
+// @param heater: Heater to query
+// @return: Current readiness state
+e_mqReadiness getMQReadiness(e_mqHeater heater)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time since the heater was powered on
+    uint32_t age;
+
+    /* -------------------- STATE EVALUATION -------------------- */
+
+    if (heater >= MQ_HEATER_COUNT || !started[heater])
+    {
+        return MQ_OFF;
+    }
+
+    // The MQ-7 is only readable at the end of its low phase
+    if (heater == MQ7_HEATER)
+    {
+        if (mq7Cycles < MQ7_PREHEAT_CYCLES)
+        {
+            return MQ_PREHEAT;
+        }
+
+        if (!mq7HighPhase &&
+            millis() - mq7PhaseMillis >= MQ7_LOW_PHASE_MS - MQ7_SAMPLE_WINDOW_MS)
+        {
+            return MQ_READY;
+        }
+
+        return MQ_HEATING;
+    }
+
+    age = getMQHeaterAge(heater);
+
+    if (age < getPreheatMillis(heater))
+    {
+        return MQ_PREHEAT;
+    }
+
+    if (age < getPreheatMillis(heater) + MQ_STABILISE_MS)
+    {
+        return MQ_STABILISING;
+    }
+
+    return MQ_READY;
+}
+
+// Returns the time elapsed since a heater was started
+// @param heater: Heater to query
+// @return: Milliseconds since power-on, 0 if not started
+uint32_t getMQHeaterAge(e_mqHeater heater)
+{
+    if (heater >= MQ_HEATER_COUNT || !started[heater])
+    {
+        return 0;
+    }
+
+    return millis() - startMillis[heater];
+}
+
+// Returns a short printable name for a readiness state
+// @param state: Readiness state
+// @return: Constant string describing the state
+const char *getMQReadinessName(e_mqReadiness state)
+{
+    switch (state)
+    {
+        case MQ_PREHEAT:
+            return "PREHEAT";
+
+        case MQ_STABILISING:
+            return "STABILISING";
+
+        case MQ_HEATING:
+            return "HEATING";
+
+        case MQ_READY:
+            return "READY";
+
+        default:
+            return "OFF";
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Applies a duty cycle to the MQ-7 heater PWM output
+static void setMQ7HeaterDuty(uint32_t duty)
+{
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledcWrite(P_MQ7_HEATER, duty);
+#else
+    ledcWrite(MQ7_HEATER_LEDC_CHANNEL, duty);
+#endif
+}
+
+// Returns the preheat duration of a continuously powered heater
+static uint32_t getPreheatMillis(e_mqHeater heater)
+{
+    switch (heater)
+    {
+        case MQ4_HEATER:
+            return MQ4_PREHEAT_MS;
+
+        case MQ131_HEATER:
+            return MQ131_PREHEAT_MS;
+
+        case MQ137_HEATER:
+            return MQ137_PREHEAT_MS;
+
+        default:
+            return 0;
+    }
+}
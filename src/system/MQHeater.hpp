@@ -0,0 +1,109 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef MQHEATER_hpp
+#define MQHEATER_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Pins of the mission profile
+#include "../config/Profile.hpp"
+
+// Arduino core for timing and LEDC (PWM) functions
+#include <Arduino.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Warm-up time after power-on before readings are considered usable
+#define MQ4_PREHEAT_MS   180000UL
+#define MQ131_PREHEAT_MS 180000UL
+#define MQ137_PREHEAT_MS 180000UL
+
+// Extra time after preheat while readings are still settling
+#define MQ_STABILISE_MS 60000UL
+
+// MQ-7 heater cycle: 5.0 V for 60 s, then 1.4 V for 90 s
+#define MQ7_HIGH_PHASE_MS 60000UL
+#define MQ7_LOW_PHASE_MS  90000UL
+
+// MQ-7 readings are only valid at the end of the low phase
+#define MQ7_SAMPLE_WINDOW_MS 10000UL
+
+// Number of full MQ-7 cycles to discard after power-on
+#define MQ7_PREHEAT_CYCLES 2
+
+// Period at which serviceMQHeaters() should be called
+#define MQ_HEATER_SERVICE_MS 100
+
+// LEDC channel, frequency and resolution used for the MQ-7 heater
+#define MQ7_HEATER_LEDC_CHANNEL 0
+#define MQ7_HEATER_PWM_FREQ     1000
+#define MQ7_HEATER_PWM_RES      8
+
+// Duty cycles for the high (5.0 V) and low (1.4 V) heater phases
+#define MQ7_DUTY_HIGH 255
+#define MQ7_DUTY_LOW  71
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Heaters managed by this module
+typedef enum
+{
+    MQ4_HEATER,
+    MQ7_HEATER,
+    MQ131_HEATER,
+    MQ137_HEATER,
+    MQ_HEATER_COUNT
+
+} e_mqHeater;
+
+// Readiness state attached to every MQ sample
+typedef enum
+{
+    // Heater has not been started
+    MQ_OFF,
+
+    // Heater is warming up after power-on
+    MQ_PREHEAT,
+
+    // Warm-up finished but readings are still drifting
+    MQ_STABILISING,
+
+    // MQ-7 only: heater is outside the sampling window of its cycle
+    MQ_HEATING,
+
+    // Readings can be used
+    MQ_READY
+
+} e_mqReadiness;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Records the power-on time of a heater and starts its drive cycle
+// @param heater: Heater to start
+void startMQHeater(e_mqHeater heater);
+
+// Drives the MQ-7 high/low heater cycle, called every MQ_HEATER_SERVICE_MS
+void serviceMQHeaters();
+
+// Returns the readiness state of a heater
+// @param heater: Heater to query
+// @return: Current readiness state
+e_mqReadiness getMQReadiness(e_mqHeater heater);
+
+// Returns the time elapsed since a heater was started
+// @param heater: Heater to query
+// @return: Milliseconds since power-on, 0 if not started
+uint32_t getMQHeaterAge(e_mqHeater heater);
+
+// Returns a short printable name for a readiness state
+// @param state: Readiness state
+// @return: Constant string describing the state
+const char *getMQReadinessName(e_mqReadiness state);
+
+#endif // MQHEATER_hpp
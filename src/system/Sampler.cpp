@@ -0,0 +1,358 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file captures the analog inputs together on a hardware
+    tick. An esp_timer fires every SAMPLER_TICK_MS and converts every
+    analog input of the profile back to back, a few tens of
+    microseconds apart, into a snapshot. A measurement latches the
+    last snapshot before reading its sensors, so all its gas
+    readings describe the same instant whatever the time the loop
+    took to reach it. Inputs on ADC2 are left out of a tick while
+    Wi-Fi runs, the radio owns that ADC. The period jitter of the
+    tick, the skew of each conversion and the age of the latched
+    snapshots are kept for the host.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the coherent sampler
+#include "Sampler.hpp"
+
+// Includes the time base used to timestamp the ticks
+#include "Timebase.hpp"
+
+// Analog inputs of the mission profile
+#include "../config/Profile.hpp"
+
+// Arduino core for analogRead()
+#include <Arduino.h>
+
+// ESP32 high resolution timer driving the tick
+#include <esp_timer.h>
+
+// Spinlock shared by the timer task and the loop
+#include <freertos/FreeRTOS.h>
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Analog inputs converted on one tick
+typedef struct
+{
+    // Local time of the tick
+    uint64_t tickUs;
+
+    // Raw count of each input, and the end of its conversion after the tick
+    uint16_t raw[SAMPLER_MAX_PINS];
+    uint16_t offsetUs[SAMPLER_MAX_PINS];
+
+    // Inputs converted on the tick (bit n for the n-th input)
+    uint8_t capturedMask;
+
+    // 1 once a tick filled the snapshot
+    uint8_t valid;
+
+} t_snapshot;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Inputs captured on each tick
+static int8_t pins[SAMPLER_MAX_PINS];
+static uint8_t pinCount = 0;
+
+// Timer driving the tick
+static esp_timer_handle_t tickTimer = NULL;
+
+// Last snapshot written by the tick, and the one the measurement reads
+static t_snapshot latest;
+static t_snapshot latched;
+
+// Guards the last snapshot and the statistics, the tick runs on the
+// timer task of the other core
+static portMUX_TYPE samplerLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Time of the previous tick, 0 before the first one
+static uint64_t lastTickUs = 0;
+
+// Accumulated timing, reduced by getSamplerStats()
+static uint32_t ticks;
+static int32_t jitterMinUs;
+static int32_t jitterMaxUs;
+static uint64_t jitterSumUs;
+static uint32_t jitterCount;
+static uint32_t skewMaxUs[SAMPLER_MAX_PINS];
+static uint64_t skewSumUs[SAMPLER_MAX_PINS];
+static uint32_t latchAgeMaxUs;
+static uint64_t latchAgeSumUs;
+static uint32_t latchCount;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Converts every input into a new snapshot, called by the timer task
+// @param arg: Unused
+static void onTick(void *arg);
+
+// Adds the analog input of a driver to the inputs captured on each tick
+// @param enabled: PROFILE_HAS_x of the driver
+// @param pin: Analog pin of the driver
+static void addPin(uint8_t enabled, int8_t pin);
+
+
+/* *****************************************************************
+    *                        INIT FUNCTION                        *
+   ***************************************************************** */
+
+// Starts the tick capturing the analog input of every driver compiled in, after initAdc()
+// @return: 1 if the timer runs, 0 if the inputs are read on demand
+int initSampler()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // The timer task rather than the ISR: analogRead() takes a lock
+    const esp_timer_create_args_t timerArgs = {onTick, NULL, ESP_TIMER_TASK, "sampler", false};
+
+    /* -------------------- INPUTS -------------------- */
+
+    if (tickTimer)
+    {
+        return 1;
+    }
+
+    pinCount = 0;
+
+    // Only the drivers compiled in, a wired pin may belong to one left out
+    addPin(PROFILE_HAS_MHZ19B, P_MH);
+    addPin(PROFILE_HAS_MQ4, P_MQ4);
+    addPin(PROFILE_HAS_MQ7, P_MQ7);
+    addPin(PROFILE_HAS_MQ131, P_MQ131);
+    addPin(PROFILE_HAS_MQ137, P_MQ137);
+    addPin(PROFILE_HAS_GYUV1, P_UV);
+
+    resetSamplerStats();
+
+    /* -------------------- TIMER -------------------- */
+
+    if (esp_timer_create(&timerArgs, &tickTimer) != ESP_OK)
+    {
+        tickTimer = NULL;
+        return 0;
+    }
+
+    if (esp_timer_start_periodic(tickTimer, SAMPLER_TICK_US) != ESP_OK)
+    {
+        esp_timer_delete(tickTimer);
+        tickTimer = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                     SNAPSHOT FUNCTIONS                      *
+   ***************************************************************** */
+
+// Freezes the last snapshot for the measurement that starts, so all of its
+// analog readings come from the same tick
+// @return: 1 if a snapshot was latched, 0 before the first tick
+uint8_t latchSampler()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of the latch and age of the snapshot
+    uint64_t now = getTimeUs();
+    uint32_t ageUs;
+
+    /* -------------------- LATCH -------------------- */
+
+    portENTER_CRITICAL(&samplerLock);
+
+    latched = latest;
+
+    if (latched.valid)
+    {
+        ageUs = (uint32_t)(now - latched.tickUs);
+        latchAgeSumUs += ageUs;
+        latchCount++;
+
+        if (ageUs > latchAgeMaxUs)
+        {
+            latchAgeMaxUs = ageUs;
+        }
+    }
+
+    portEXIT_CRITICAL(&samplerLock);
+
+    return latched.valid;
+}
+
+// Retrieves the reading of a pin from the latched snapshot, or reads the
+// pin now when it is not captured by the tick
+// @param pin: Analog pin to read
+// @param reading: Pointer to structure where the reading will be stored
+// @param timeUs: Local time of the conversion (see getTimeUs())
+// @return: 1 if the reading comes from the snapshot, 0 if it was read now
+uint8_t readSampledAdc(int8_t pin, t_adcReading *reading, uint64_t *timeUs)
+{
+    for (uint8_t i = 0; latched.valid && i < pinCount; i++)
+    {
+        if (pins[i] == pin && (latched.capturedMask & (1 << i)))
+        {
+            reading->raw = latched.raw[i];
+            reading->millivolts = adcToMillivolts(pin, latched.raw[i]);
+            reading->range = getAdcRange(latched.raw[i]);
+            *timeUs = latched.tickUs + latched.offsetUs[i];
+            return 1;
+        }
+    }
+
+    // Before the first tick, the timer could not start, or an ADC2 input
+    // left out while Wi-Fi runs: readAdc() flags it as clipped
+    readAdc(pin, reading);
+    *timeUs = getTimeUs();
+    return 0;
+}
+
+
+/* *****************************************************************
+    *                    STATISTICS FUNCTIONS                     *
+   ***************************************************************** */
+
+// Retrieves the timing of the tick and of the captures
+// @param stats: Pointer to structure where the statistics will be stored
+void getSamplerStats(t_samplerStats *stats)
+{
+    portENTER_CRITICAL(&samplerLock);
+
+    stats->ticks = ticks;
+    stats->jitterMinUs = jitterCount ? jitterMinUs : 0;
+    stats->jitterMaxUs = jitterCount ? jitterMaxUs : 0;
+    stats->jitterMeanUs = jitterCount ? (uint32_t)(jitterSumUs / jitterCount) : 0;
+    stats->latchAgeMaxUs = latchAgeMaxUs;
+    stats->latchAgeMeanUs = latchCount ? (uint32_t)(latchAgeSumUs / latchCount) : 0;
+    stats->pinCount = pinCount;
+
+    for (uint8_t i = 0; i < pinCount; i++)
+    {
+        stats->pins[i].pin = pins[i];
+        stats->pins[i].skewMaxUs = skewMaxUs[i];
+        stats->pins[i].skewMeanUs = ticks ? (uint32_t)(skewSumUs[i] / ticks) : 0;
+    }
+
+    portEXIT_CRITICAL(&samplerLock);
+}
+
+// Starts new timing statistics
+void resetSamplerStats()
+{
+    portENTER_CRITICAL(&samplerLock);
+
+    ticks = 0;
+    jitterMinUs = INT32_MAX;
+    jitterMaxUs = INT32_MIN;
+    jitterSumUs = 0;
+    jitterCount = 0;
+    latchAgeMaxUs = 0;
+    latchAgeSumUs = 0;
+    latchCount = 0;
+
+    for (uint8_t i = 0; i < SAMPLER_MAX_PINS; i++)
+    {
+        skewMaxUs[i] = 0;
+        skewSumUs[i] = 0;
+    }
+
+    portEXIT_CRITICAL(&samplerLock);
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Converts every input into a new snapshot, called by the timer task
+static void onTick(void *arg)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Snapshot being filled, outside the lock
+    t_snapshot capture;
+
+    // Interval from the previous tick minus the period
+    int32_t jitterUs;
+
+    /* -------------------- CAPTURE -------------------- */
+
+    capture.tickUs = getTimeUs();
+    capture.capturedMask = 0;
+
+    for (uint8_t i = 0; i < pinCount; i++)
+    {
+        capture.raw[i] = 0;
+        capture.offsetUs[i] = 0;
+
+        // ADC2 fails or stalls while the radio holds it
+        if (isAdcAvailable(pins[i]))
+        {
+            capture.raw[i] = analogRead(pins[i]);
+            capture.offsetUs[i] = (uint16_t)(getTimeUs() - capture.tickUs);
+            capture.capturedMask |= 1 << i;
+        }
+    }
+
+    capture.valid = 1;
+
+    /* -------------------- PUBLICATION -------------------- */
+
+    portENTER_CRITICAL(&samplerLock);
+
+    latest = capture;
+    ticks++;
+
+    for (uint8_t i = 0; i < pinCount; i++)
+    {
+        skewSumUs[i] += capture.offsetUs[i];
+
+        if (capture.offsetUs[i] > skewMaxUs[i])
+        {
+            skewMaxUs[i] = capture.offsetUs[i];
+        }
+    }
+
+    if (lastTickUs)
+    {
+        jitterUs = (int32_t)(capture.tickUs - lastTickUs) - (int32_t)SAMPLER_TICK_US;
+        jitterSumUs += (jitterUs < 0) ? -jitterUs : jitterUs;
+        jitterCount++;
+
+        if (jitterUs < jitterMinUs)
+        {
+            jitterMinUs = jitterUs;
+        }
+
+        if (jitterUs > jitterMaxUs)
+        {
+            jitterMaxUs = jitterUs;
+        }
+    }
+
+    portEXIT_CRITICAL(&samplerLock);
+
+    lastTickUs = capture.tickUs;
+}
+
+// Adds the analog input of a driver to the inputs captured on each tick
+static void addPin(uint8_t enabled, int8_t pin)
+{
+    if (enabled && pin != PIN_NONE && pinCount < SAMPLER_MAX_PINS)
+    {
+        pins[pinCount++] = pin;
+    }
+}
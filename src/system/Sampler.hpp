@@ -0,0 +1,95 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef SAMPLER_hpp
+#define SAMPLER_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// ADC characterisation converting the captured counts
+#include "Adc.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Period of the hardware tick capturing the analog inputs. The
+// measurement periods are multiples of it, so they keep their phase
+#define SAMPLER_TICK_MS 100
+#define SAMPLER_TICK_US (SAMPLER_TICK_MS * 1000ULL)
+
+// Delay after a tick at which a measurement starts, far enough from the
+// next tick that the snapshot it latches is never being written
+#define SAMPLER_PHASE_MS (SAMPLER_TICK_MS / 2)
+
+// Analog inputs captured on each tick
+#define SAMPLER_MAX_PINS 8
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Timing of the captures of one analog input
+typedef struct
+{
+    // Pin captured
+    int8_t pin;
+
+    // Time from the tick to the end of its conversion, in us
+    uint32_t skewMaxUs;
+    uint32_t skewMeanUs;
+
+} t_samplerPinStats;
+
+// Timing of the tick since the statistics were last reset
+typedef struct
+{
+    // Ticks counted
+    uint32_t ticks;
+
+    // Interval between two ticks minus the period, in us
+    int32_t jitterMinUs;
+    int32_t jitterMaxUs;
+
+    // Mean of the absolute jitter, in us
+    uint32_t jitterMeanUs;
+
+    // Age of the snapshot when a measurement latched it, in us: the skew
+    // between the analog inputs and the sensors read by the measurement
+    uint32_t latchAgeMaxUs;
+    uint32_t latchAgeMeanUs;
+
+    // Inputs captured on each tick
+    uint8_t pinCount;
+    t_samplerPinStats pins[SAMPLER_MAX_PINS];
+
+} t_samplerStats;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Starts the tick capturing the analog input of every driver compiled in, after initAdc()
+// @return: 1 if the timer runs, 0 if the inputs are read on demand
+int initSampler();
+
+// Freezes the last snapshot for the measurement that starts, so all of its
+// analog readings come from the same tick
+// @return: 1 if a snapshot was latched, 0 before the first tick
+uint8_t latchSampler();
+
+// Retrieves the reading of a pin from the latched snapshot, or reads the
+// pin now when it is not captured by the tick
+// @param pin: Analog pin to read
+// @param reading: Pointer to structure where the reading will be stored
+// @param timeUs: Local time of the conversion (see getTimeUs())
+// @return: 1 if the reading comes from the snapshot, 0 if it was read now
+uint8_t readSampledAdc(int8_t pin, t_adcReading *reading, uint64_t *timeUs);
+
+// Retrieves the timing of the tick and of the captures
+// @param stats: Pointer to structure where the statistics will be stored
+void getSamplerStats(t_samplerStats *stats);
+
+// Starts new timing statistics
+void resetSamplerStats();
+
+#endif // SAMPLER_hpp
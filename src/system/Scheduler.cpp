@@ -0,0 +1,165 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file implements a small cooperative scheduler. Periodic
+    and one-shot tasks are kept in a fixed table and executed from
+    loop() when they are due, so no module needs to call delay().
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the scheduler
+#include "Scheduler.hpp"
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Table of registered tasks
+static t_task tasks[SCHEDULER_MAX_TASKS];
+
+// Number of registered tasks
+static uint8_t taskCount = 0;
+
+
+/* *****************************************************************
+    *                      TASK MANAGEMENT                        *
+   ***************************************************************** */
+
+// Adds a task to the scheduler
+// @param function: Function to call when the task is due
+// @param periodMs: Period in milliseconds, 0 for a one-shot task
+// @param enabled: 1 to schedule the task immediately
+// @return: Task identifier, SCHEDULER_NO_TASK if the table is full
+int8_t addSchedulerTask(t_taskFunction function, uint32_t periodMs, uint8_t enabled)
+{
+    if (taskCount >= SCHEDULER_MAX_TASKS || !function)
+    {
+        return SCHEDULER_NO_TASK;
+    }
+
+    tasks[taskCount].function = function;
+    tasks[taskCount].periodMs = periodMs;
+    tasks[taskCount].nextMs = millis() + periodMs;
+    tasks[taskCount].enabled = enabled;
+
+    return (int8_t)taskCount++;
+}
+
+// Changes the period of a task, effective from its next execution
+// @param id: Task identifier
+// @param periodMs: New period in milliseconds
+void setSchedulerPeriod(int8_t id, uint32_t periodMs)
+{
+    if (id < 0 || id >= taskCount)
+    {
+        return;
+    }
+
+    tasks[id].periodMs = periodMs;
+}
+
+// Enables or disables a task
+// @param id: Task identifier
+// @param enabled: 1 to enable, 0 to disable
+void setSchedulerEnabled(int8_t id, uint8_t enabled)
+{
+    if (id < 0 || id >= taskCount)
+    {
+        return;
+    }
+
+    // Restart the period when the task is re-enabled
+    if (enabled && !tasks[id].enabled)
+    {
+        tasks[id].nextMs = millis() + tasks[id].periodMs;
+    }
+
+    tasks[id].enabled = enabled;
+}
+
+// Schedules the next execution of a task after a delay
+// @param id: Task identifier
+// @param delayMs: Delay from now in milliseconds
+void runSchedulerTaskIn(int8_t id, uint32_t delayMs)
+{
+    if (id < 0 || id >= taskCount)
+    {
+        return;
+    }
+
+    tasks[id].nextMs = millis() + delayMs;
+    tasks[id].enabled = 1;
+}
+
+// Returns the time left before the next execution of a task
+// @param id: Task identifier
+// @return: Delay in milliseconds, 0 if the task is due, UINT32_MAX if it is disabled
+uint32_t getSchedulerDelay(int8_t id)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Signed, a late task is due rather than far in the future
+    int32_t delayMs;
+
+    /* -------------------- DELAY -------------------- */
+
+    if (id < 0 || id >= taskCount || !tasks[id].enabled)
+    {
+        return UINT32_MAX;
+    }
+
+    delayMs = (int32_t)(tasks[id].nextMs - millis());
+    return (delayMs > 0) ? (uint32_t)delayMs : 0;
+}
+
+
+/* *****************************************************************
+    *                       SCHEDULER LOOP                        *
+   ***************************************************************** */
+
+// Runs every task that is due, must be called from loop()
+void runScheduler()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Current time
+    uint32_t now;
+
+    /* -------------------- TASK EXECUTION -------------------- */
+
+    for (uint8_t i = 0; i < taskCount; i++)
+    {
+        now = millis();
+
+        // Signed difference keeps the comparison valid across millis() wrap
+        if (!tasks[i].enabled || (int32_t)(now - tasks[i].nextMs) < 0)
+        {
+            continue;
+        }
+
+        if (tasks[i].periodMs == 0)
+        {
+            // One-shot tasks are disabled before running so they can re-arm themselves
+            tasks[i].enabled = 0;
+        }
+
+        else
+        {
+            // Keep the period phase-aligned unless we fell more than a period behind
+            tasks[i].nextMs += tasks[i].periodMs;
+
+            if ((int32_t)(now - tasks[i].nextMs) >= 0)
+            {
+                tasks[i].nextMs = now + tasks[i].periodMs;
+            }
+        }
+
+        tasks[i].function();
+    }
+}
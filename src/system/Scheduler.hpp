@@ -0,0 +1,79 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef SCHEDULER_hpp
+#define SCHEDULER_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+// Arduino core for millis()
+#include <Arduino.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Maximum number of tasks handled by the scheduler
+#define SCHEDULER_MAX_TASKS 16
+
+// Value returned when a task cannot be added
+#define SCHEDULER_NO_TASK -1
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Function executed by a task
+typedef void (*t_taskFunction)();
+
+// Cooperative task descriptor
+typedef struct
+{
+    // Function called when the task is due
+    t_taskFunction function;
+
+    // Period in milliseconds, 0 for a one-shot task
+    uint32_t periodMs;
+
+    // Time of the next execution
+    uint32_t nextMs;
+
+    // 1 while the task is scheduled
+    uint8_t enabled;
+
+} t_task;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Adds a task to the scheduler
+// @param function: Function to call when the task is due
+// @param periodMs: Period in milliseconds, 0 for a one-shot task
+// @param enabled: 1 to schedule the task immediately
+// @return: Task identifier, SCHEDULER_NO_TASK if the table is full
+int8_t addSchedulerTask(t_taskFunction function, uint32_t periodMs, uint8_t enabled);
+
+// Changes the period of a task, effective from its next execution
+// @param id: Task identifier
+// @param periodMs: New period in milliseconds
+void setSchedulerPeriod(int8_t id, uint32_t periodMs);
+
+// Enables or disables a task
+// @param id: Task identifier
+// @param enabled: 1 to enable, 0 to disable
+void setSchedulerEnabled(int8_t id, uint8_t enabled);
+
+// Schedules the next execution of a task after a delay
+// @param id: Task identifier
+// @param delayMs: Delay from now in milliseconds
+void runSchedulerTaskIn(int8_t id, uint32_t delayMs);
+
+// Returns the time left before the next execution of a task
+// @param id: Task identifier
+// @return: Delay in milliseconds, 0 if the task is due, UINT32_MAX if it is disabled
+uint32_t getSchedulerDelay(int8_t id);
+
+// Runs every task that is due, must be called from loop()
+void runScheduler();
+
+#endif // SCHEDULER_hpp
@@ -0,0 +1,253 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file provides the time base of the system: a monotonic
+    64-bit microsecond clock used to timestamp every sample, and an
+    estimate of UTC disciplined by the GPS time of the Pixhawk or
+    by ping exchanges with the Bluetooth host. The estimate tracks
+    both the offset and the drift of the local oscillator.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the time base
+#include "Timebase.hpp"
+
+// ESP32 high resolution timer
+#include <esp_timer.h>
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Anchor point of the estimate: UTC minus local time at a local time
+static uint64_t refLocalUs = 0;
+static int64_t refOffsetUs = 0;
+
+// Start of the baseline used to measure the drift
+static uint64_t driftLocalUs = 0;
+static int64_t driftOffsetUs = 0;
+
+// Local time of the last GPS synchronisation
+static uint64_t lastGpsUs = 0;
+
+// State reported to the callers
+static t_timeStatus status = {TIME_SOURCE_NONE, 0, 0, 0, 0};
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Extrapolates the offset between UTC and local time from the anchor point
+// @param localUs: Local time of the offset
+// @return: Estimated UTC minus local time
+static int64_t predictOffset(uint64_t localUs);
+
+
+/* *****************************************************************
+    *                       CLOCK FUNCTIONS                       *
+   ***************************************************************** */
+
+// Returns the monotonic local time in microseconds since boot
+uint64_t getTimeUs()
+{
+    // 64-bit counter, does not wrap like millis()
+    return (uint64_t)esp_timer_get_time();
+}
+
+
+/* *****************************************************************
+    *                       SYNCHRONISATION                       *
+   ***************************************************************** */
+
+// Feeds a pair of local and UTC times taken at the same instant
+// @param localUs: Local time of the reference instant
+// @param utcUs: UTC time of the same instant in microseconds since 1970
+// @param source: Reference the UTC time comes from
+// @param uncertaintyUs: Uncertainty of the pair in microseconds
+void submitTimeSync(uint64_t localUs, uint64_t utcUs, e_timeSource source,
+                    uint32_t uncertaintyUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Measured offset between UTC and local time
+    int64_t measured;
+
+    // Difference between the measured and the estimated offset
+    int64_t residual;
+
+    // Length of the drift baseline
+    int64_t interval;
+
+    // New drift estimate
+    int64_t drift;
+
+    /* -------------------- SOURCE SELECTION -------------------- */
+
+    if (utcUs < TIME_MIN_UNIX_US)
+    {
+        return;
+    }
+
+    // GPS is far more accurate than the Bluetooth link, keep it while it lasts
+    if (source == TIME_SOURCE_HOST && lastGpsUs && localUs - lastGpsUs < TIME_GPS_HOLD_US)
+    {
+        return;
+    }
+
+    if (source == TIME_SOURCE_GPS)
+    {
+        lastGpsUs = localUs;
+    }
+
+    /* -------------------- OFFSET -------------------- */
+
+    measured = (int64_t)(utcUs - localUs);
+    residual = measured - predictOffset(localUs);
+
+    if (!status.syncCount || residual > TIME_STEP_THRESHOLD_US ||
+        residual < -TIME_STEP_THRESHOLD_US)
+    {
+        // First synchronisation or a jump of the reference: step
+        refOffsetUs = measured;
+        driftLocalUs = localUs;
+        driftOffsetUs = measured;
+    }
+
+    else
+    {
+        // Move the anchor to this instant, correcting part of the residual
+        refOffsetUs = predictOffset(localUs) + (residual >> TIME_OFFSET_GAIN_SHIFT);
+    }
+
+    refLocalUs = localUs;
+
+    /* -------------------- DRIFT -------------------- */
+
+    // Slope of the filtered offset over a long enough baseline
+    interval = (int64_t)(localUs - driftLocalUs);
+
+    if (interval >= TIME_DRIFT_WINDOW_US)
+    {
+        drift = (refOffsetUs - driftOffsetUs) * 1000000000LL / interval;
+        drift = status.driftPpb + ((drift - status.driftPpb) >> TIME_DRIFT_GAIN_SHIFT);
+
+        if (drift > TIME_MAX_DRIFT_PPB)
+        {
+            drift = TIME_MAX_DRIFT_PPB;
+        }
+
+        else if (drift < -TIME_MAX_DRIFT_PPB)
+        {
+            drift = -TIME_MAX_DRIFT_PPB;
+        }
+
+        status.driftPpb = (int32_t)drift;
+        driftLocalUs = localUs;
+        driftOffsetUs = refOffsetUs;
+    }
+
+    status.source = source;
+    status.uncertaintyUs = uncertaintyUs;
+    status.lastSyncUs = localUs;
+    status.syncCount++;
+}
+
+// Feeds the reply to a ping sent to the host (NTP-style exchange)
+// @param sentUs: Local time the ping was sent, echoed by the host
+// @param hostUs: UTC time of the host when it answered
+// @param receivedUs: Local time the reply was received
+// @return: 1 if the exchange was accepted, 0 otherwise
+uint8_t submitTimePong(uint64_t sentUs, uint64_t hostUs, uint64_t receivedUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Round trip time of the exchange
+    uint64_t rtt;
+
+    /* -------------------- EXCHANGE CHECK -------------------- */
+
+    if (receivedUs < sentUs)
+    {
+        return 0;
+    }
+
+    rtt = receivedUs - sentUs;
+
+    // Long round trips are usually asymmetric, skip them
+    if (rtt > TIME_PING_MAX_RTT_US)
+    {
+        return 0;
+    }
+
+    // The host answered halfway through the round trip
+    submitTimeSync(sentUs + rtt / 2, hostUs, TIME_SOURCE_HOST, (uint32_t)(rtt / 2));
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                    CONVERSION FUNCTIONS                     *
+   ***************************************************************** */
+
+// Converts a local time to the estimated UTC time
+// @param localUs: Local time to convert
+// @param utcUs: Pointer where the UTC time will be stored
+// @return: 1 if the clock has been synchronised, 0 otherwise
+uint8_t getUtcTime(uint64_t localUs, uint64_t *utcUs)
+{
+    if (!status.syncCount)
+    {
+        *utcUs = 0;
+        return 0;
+    }
+
+    *utcUs = localUs + predictOffset(localUs);
+    return 1;
+}
+
+// Retrieves the state of the UTC estimate
+// @param timeStatus: Pointer to structure where the state will be stored
+void getTimeStatus(t_timeStatus *timeStatus)
+{
+    *timeStatus = status;
+}
+
+// Returns a short printable name for a time source
+// @param source: Time source
+// @return: Constant string describing the source
+const char *getTimeSourceName(e_timeSource source)
+{
+    switch (source)
+    {
+        case TIME_SOURCE_HOST:
+            return "HOST";
+
+        case TIME_SOURCE_GPS:
+            return "GPS";
+
+        default:
+            return "NONE";
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Extrapolates the offset between UTC and local time from the anchor point
+static int64_t predictOffset(uint64_t localUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Local time elapsed since the anchor point
+    int64_t elapsed = (int64_t)(localUs - refLocalUs);
+
+    /* -------------------- EXTRAPOLATION -------------------- */
+
+    return refOffsetUs + elapsed * status.driftPpb / 1000000000LL;
+}
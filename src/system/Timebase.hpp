@@ -0,0 +1,110 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef TIMEBASE_hpp
+#define TIMEBASE_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Residual above which the UTC estimate is stepped instead of slewed
+#define TIME_STEP_THRESHOLD_US 100000LL
+
+// Gains of the offset and drift corrections, as right shifts
+#define TIME_OFFSET_GAIN_SHIFT 2
+#define TIME_DRIFT_GAIN_SHIFT  1
+
+// Shortest baseline used to measure the drift, shorter ones are noise
+#define TIME_DRIFT_WINDOW_US 60000000LL
+
+// Largest drift accepted for the local oscillator, in parts per billion
+#define TIME_MAX_DRIFT_PPB 500000L
+
+// Host synchronisations are ignored this long after a GPS one
+#define TIME_GPS_HOLD_US 60000000ULL
+
+// Period of the ping exchanges with the Bluetooth host
+#define TIME_PING_PERIOD_MS 30000
+
+// Ping exchanges with a longer round trip are discarded
+#define TIME_PING_MAX_RTT_US 200000ULL
+
+// Delay between a MAVLink time message and its parsing
+#define TIME_GPS_UNCERTAINTY_US 10000UL
+
+// Earliest UTC time accepted (2020-01-01), older values are time since boot
+#define TIME_MIN_UNIX_US 1577836800000000ULL
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Reference used to discipline the UTC estimate
+typedef enum
+{
+    TIME_SOURCE_NONE,
+    TIME_SOURCE_HOST,
+    TIME_SOURCE_GPS
+
+} e_timeSource;
+
+// State of the UTC estimate
+typedef struct
+{
+    // Source of the last accepted synchronisation (e_timeSource)
+    uint8_t source;
+
+    // Uncertainty of the last accepted synchronisation in microseconds
+    uint32_t uncertaintyUs;
+
+    // Estimated drift of the local clock in parts per billion
+    int32_t driftPpb;
+
+    // Number of accepted synchronisations
+    uint32_t syncCount;
+
+    // Local time of the last accepted synchronisation
+    uint64_t lastSyncUs;
+
+} t_timeStatus;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Returns the monotonic local time in microseconds since boot
+uint64_t getTimeUs();
+
+// Feeds a pair of local and UTC times taken at the same instant
+// @param localUs: Local time of the reference instant
+// @param utcUs: UTC time of the same instant in microseconds since 1970
+// @param source: Reference the UTC time comes from
+// @param uncertaintyUs: Uncertainty of the pair in microseconds
+void submitTimeSync(uint64_t localUs, uint64_t utcUs, e_timeSource source,
+                    uint32_t uncertaintyUs);
+
+// Feeds the reply to a ping sent to the host (NTP-style exchange)
+// @param sentUs: Local time the ping was sent, echoed by the host
+// @param hostUs: UTC time of the host when it answered
+// @param receivedUs: Local time the reply was received
+// @return: 1 if the exchange was accepted, 0 otherwise
+uint8_t submitTimePong(uint64_t sentUs, uint64_t hostUs, uint64_t receivedUs);
+
+// Converts a local time to the estimated UTC time
+// @param localUs: Local time to convert
+// @param utcUs: Pointer where the UTC time will be stored
+// @return: 1 if the clock has been synchronised, 0 otherwise
+uint8_t getUtcTime(uint64_t localUs, uint64_t *utcUs);
+
+// Retrieves the state of the UTC estimate
+// @param timeStatus: Pointer to structure where the state will be stored
+void getTimeStatus(t_timeStatus *timeStatus);
+
+// Returns a short printable name for a time source
+// @param source: Time source
+// @return: Constant string describing the source
+const char *getTimeSourceName(e_timeSource source);
+
+#endif // TIMEBASE_hpp
@@ -0,0 +1,27 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Host stand-in for the FreeRTOS kernel, for the native tests only. The
+// tests run on one thread, locks always succeed at once
+
+// Ensure the header is included only once
+#ifndef FREERTOS_HOST_h
+#define FREERTOS_HOST_h
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types for portability
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define pdTRUE        1
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+
+#endif // FREERTOS_HOST_h
@@ -0,0 +1,38 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Host stand-in for the FreeRTOS semaphores, for the native tests only
+
+// Ensure the header is included only once
+#ifndef SEMPHR_HOST_h
+#define SEMPHR_HOST_h
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+#include "FreeRTOS.h"
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Any non-null handle, nothing is ever held
+typedef void *SemaphoreHandle_t;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    static uint8_t mutex;
+    return &mutex;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return pdTRUE;
+}
+
+#endif // SEMPHR_HOST_h
@@ -0,0 +1,394 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks the block compressor on the host: round trips
+    of the edge cases of the LZSS format, the rejection of corrupted
+    blocks, and the ratio and speed on blocks laid out as the
+    recorder writes them. Run with: pio test -e native
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// PlatformIO test framework
+#include <unity.h>
+
+// Compressor under test and the frames of the fixture
+#include "../../src/protocols/Compress.hpp"
+#include "../../src/protocols/Frame.hpp"
+
+// memcmp(), memset() and snprintf() for the checks and the report
+#include <string.h>
+#include <stdio.h>
+
+// clock() to time the fixture
+#include <time.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Largest block tested, the window plus a few matches
+#define TEST_BLOCK_SIZE 8192
+
+// Recorder blocks of the fixture, over an hour of samples at 2 Hz
+#define FIXTURE_BLOCKS 300
+#define FIXTURE_BLOCK_SIZE 1024
+
+// Random blocks fed to the decompressor
+#define FUZZ_BLOCKS 10000
+
+// Guard bytes after the destination buffer, never written
+#define GUARD_SIZE 16
+#define GUARD_BYTE 0xEE
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Input, compressed block and round trip, too large for the stack
+static uint8_t input[TEST_BLOCK_SIZE];
+static uint8_t packed[COMPRESS_BOUND(TEST_BLOCK_SIZE) + GUARD_SIZE];
+static uint8_t output[TEST_BLOCK_SIZE + GUARD_SIZE];
+
+// State of the pseudo-random generator
+static uint32_t randomState;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Compresses the input, checks it comes back unchanged
+// @return: Length of the compressed block
+static uint16_t checkRoundTrip(uint16_t length);
+
+// Walks the tokens of a compressed block
+static void scanTokens(uint16_t length, uint16_t *maxDistance, uint16_t *maxMatch);
+
+// Builds a recorder block of length-prefixed sample frames of a flight
+static uint16_t buildFixtureBlock(uint32_t *sample, uint8_t *block);
+
+// Returns the next pseudo-random number
+static uint32_t nextRandom();
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Runs before each test
+void setUp()
+{
+    randomState = 12345;
+    memset(input, 0, sizeof(input));
+    memset(packed, GUARD_BYTE, sizeof(packed));
+    memset(output, GUARD_BYTE, sizeof(output));
+}
+
+// Runs after each test
+void tearDown()
+{
+}
+
+// Blocks that cannot shrink are refused, the caller keeps them as they are
+static void test_short_and_incompressible()
+{
+    TEST_ASSERT_EQUAL_UINT16(0, compressBlock(input, 0, packed, sizeof(packed)));
+    TEST_ASSERT_EQUAL_UINT16(0, decompressBlock(packed, 0, output, TEST_BLOCK_SIZE));
+
+    input[0] = 'a';
+    TEST_ASSERT_EQUAL_UINT16(0, compressBlock(input, 1, packed, sizeof(packed)));
+
+    for (uint16_t i = 0; i < FIXTURE_BLOCK_SIZE; i++)
+    {
+        input[i] = nextRandom() >> 24;
+    }
+
+    // Into a buffer as large as the input, as the recorder does
+    TEST_ASSERT_EQUAL_UINT16(0, compressBlock(input, FIXTURE_BLOCK_SIZE, packed,
+                                              FIXTURE_BLOCK_SIZE));
+    TEST_ASSERT_EQUAL_UINT8(GUARD_BYTE, packed[FIXTURE_BLOCK_SIZE]);
+    TEST_ASSERT_EQUAL_UINT16(0, compressBlock(input, FIXTURE_BLOCK_SIZE, packed,
+                                              COMPRESS_BOUND(FIXTURE_BLOCK_SIZE)));
+}
+
+// A match longer than its distance copies the bytes it produces
+static void test_overlapping_matches()
+{
+    uint16_t maxDistance, maxMatch, length;
+
+    for (uint16_t i = 0; i < 180; i++)
+    {
+        input[i] = "abc"[i % 3];
+    }
+
+    length = checkRoundTrip(180);
+    scanTokens(length, &maxDistance, &maxMatch);
+
+    TEST_ASSERT_EQUAL_UINT16(3, maxDistance);
+    TEST_ASSERT_EQUAL_UINT16(COMPRESS_MAX_MATCH, maxMatch);
+}
+
+// A run is cut into matches of the longest length
+static void test_longest_match()
+{
+    uint16_t maxDistance, maxMatch, length;
+
+    memset(input, 'a', 200);
+
+    length = checkRoundTrip(200);
+    scanTokens(length, &maxDistance, &maxMatch);
+
+    TEST_ASSERT_EQUAL_UINT16(1, maxDistance);
+    TEST_ASSERT_EQUAL_UINT16(COMPRESS_MAX_MATCH, maxMatch);
+
+    // A literal, 11 matches of 18, a last literal too short for a match,
+    // behind 2 flag bytes
+    TEST_ASSERT_EQUAL_UINT16(2 + 2 + 11 * 2, length);
+}
+
+// A sequence exactly a window back is found, one byte further it is not
+static void test_window_edge()
+{
+    uint16_t maxDistance, maxMatch, length;
+
+    // A pattern without zeros, zeros up to the window, the pattern again
+    for (uint16_t i = 0; i < COMPRESS_MAX_MATCH; i++)
+    {
+        input[i] = 0x41 + 7 * i;
+        input[COMPRESS_WINDOW_SIZE + i] = input[i];
+    }
+
+    length = checkRoundTrip(COMPRESS_WINDOW_SIZE + COMPRESS_MAX_MATCH);
+    scanTokens(length, &maxDistance, &maxMatch);
+
+    TEST_ASSERT_EQUAL_UINT16(COMPRESS_WINDOW_SIZE, maxDistance);
+
+    // The second copy one byte later is out of reach
+    memset(input + COMPRESS_WINDOW_SIZE, 0, COMPRESS_MAX_MATCH);
+    memcpy(input + COMPRESS_WINDOW_SIZE + 1, input, COMPRESS_MAX_MATCH);
+
+    length = checkRoundTrip(COMPRESS_WINDOW_SIZE + 1 + COMPRESS_MAX_MATCH);
+    scanTokens(length, &maxDistance, &maxMatch);
+
+    TEST_ASSERT_LESS_OR_EQUAL(COMPRESS_WINDOW_SIZE - 1, maxDistance);
+}
+
+// Blocks that cannot be decoded give 0, never a write past the buffer
+static void test_corrupted_blocks()
+{
+    // Reference before the first byte
+    const uint8_t early[] = {0x00, 0x00, 0x00};
+
+    // Literal then a reference cut after its first byte
+    const uint8_t cut[] = {0x01, 'a', 0x00};
+
+    // Literal then a reference further back than the data
+    const uint8_t far[] = {0x01, 'a', 0x10, 0x00};
+
+    uint16_t length, result;
+
+    TEST_ASSERT_EQUAL_UINT16(0, decompressBlock(early, sizeof(early), output, TEST_BLOCK_SIZE));
+    TEST_ASSERT_EQUAL_UINT16(0, decompressBlock(cut, sizeof(cut), output, TEST_BLOCK_SIZE));
+    TEST_ASSERT_EQUAL_UINT16(0, decompressBlock(far, sizeof(far), output, TEST_BLOCK_SIZE));
+
+    // A valid block into a buffer one byte too small
+    memset(input, 'a', 200);
+    length = compressBlock(input, 200, packed, sizeof(packed));
+    TEST_ASSERT_EQUAL_UINT16(0, decompressBlock(packed, length, output, 199));
+    TEST_ASSERT_EQUAL_UINT16(200, decompressBlock(packed, length, output, 200));
+
+    // Random blocks stay inside the buffer whatever they decode to
+    for (uint16_t i = 0; i < FUZZ_BLOCKS; i++)
+    {
+        length = 1 + nextRandom() % 64;
+
+        for (uint16_t j = 0; j < length; j++)
+        {
+            packed[j] = nextRandom() >> 24;
+        }
+
+        result = decompressBlock(packed, length, output, 256);
+        TEST_ASSERT_LESS_OR_EQUAL(256, result);
+        TEST_ASSERT_EQUAL_UINT8(GUARD_BYTE, output[256]);
+    }
+}
+
+// Ratio and speed on recorder blocks of a flight
+static void test_fixture_report()
+{
+    t_compressStats stats;
+    uint32_t sample = 0;
+    uint16_t length, packedLength;
+    clock_t start;
+    char report[160];
+
+    memset(&stats, 0, sizeof(stats));
+
+    for (uint16_t i = 0; i < FIXTURE_BLOCKS; i++)
+    {
+        length = buildFixtureBlock(&sample, input);
+
+        start = clock();
+        packedLength = compressBlock(input, length, packed, length);
+        stats.compressUs += (uint32_t)((clock() - start) * 1000000.0 / CLOCKS_PER_SEC);
+
+        stats.blocks++;
+        stats.rawBytes += length;
+        stats.packedBytes += packedLength ? packedLength : length;
+
+        if (!packedLength)
+        {
+            continue;
+        }
+
+        start = clock();
+        if (decompressBlock(packed, packedLength, output, TEST_BLOCK_SIZE) != length ||
+            memcmp(input, output, length) != 0)
+        {
+            stats.errors++;
+        }
+        stats.decompressUs += (uint32_t)((clock() - start) * 1000000.0 / CLOCKS_PER_SEC);
+    }
+
+    snprintf(report, sizeof(report),
+             "%lu blocks, %lu -> %lu bytes (%.1f %%), compress %lu us, decompress %lu us",
+             (unsigned long)stats.blocks, (unsigned long)stats.rawBytes,
+             (unsigned long)stats.packedBytes, 100.0 * stats.packedBytes / stats.rawBytes,
+             (unsigned long)stats.compressUs, (unsigned long)stats.decompressUs);
+    TEST_MESSAGE(report);
+
+    TEST_ASSERT_EQUAL_UINT32(0, stats.errors);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.rawBytes * 3 / 4, stats.packedBytes);
+}
+
+// Runs every test
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_short_and_incompressible);
+    RUN_TEST(test_overlapping_matches);
+    RUN_TEST(test_longest_match);
+    RUN_TEST(test_window_edge);
+    RUN_TEST(test_corrupted_blocks);
+    RUN_TEST(test_fixture_report);
+
+    return UNITY_END();
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Compresses the input, checks it comes back unchanged
+static uint16_t checkRoundTrip(uint16_t length)
+{
+    uint16_t packedLength = compressBlock(input, length, packed, COMPRESS_BOUND(length));
+
+    TEST_ASSERT_GREATER_THAN(0, packedLength);
+    TEST_ASSERT_EQUAL_UINT16(length, decompressBlock(packed, packedLength, output, length));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(input, output, length);
+    TEST_ASSERT_EQUAL_UINT8(GUARD_BYTE, output[length]);
+
+    return packedLength;
+}
+
+// Walks the tokens of a compressed block
+static void scanTokens(uint16_t length, uint16_t *maxDistance, uint16_t *maxMatch)
+{
+    uint16_t in = 0;
+    uint8_t flags = 0;
+    uint8_t flagBit = 8;
+    uint16_t token;
+
+    *maxDistance = 0;
+    *maxMatch = 0;
+
+    while (in < length)
+    {
+        if (flagBit == 8)
+        {
+            flags = packed[in++];
+            flagBit = 0;
+            continue;
+        }
+
+        if (flags & (1 << flagBit))
+        {
+            in++;
+        }
+
+        else
+        {
+            token = packed[in] | ((uint16_t)packed[in + 1] << 8);
+            in += 2;
+
+            if ((token >> 4) + 1 > *maxDistance)
+            {
+                *maxDistance = (token >> 4) + 1;
+            }
+
+            if ((token & 0x0F) + COMPRESS_MIN_MATCH > *maxMatch)
+            {
+                *maxMatch = (token & 0x0F) + COMPRESS_MIN_MATCH;
+            }
+        }
+
+        flagBit++;
+    }
+}
+
+// Builds a recorder block of length-prefixed sample frames of a flight
+static uint16_t buildFixtureBlock(uint32_t *sample, uint8_t *block)
+{
+    t_sampleSet set;
+    t_frameHeader header;
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t frameLength;
+    uint16_t length = 0;
+    uint64_t timeUs;
+
+    while (1)
+    {
+        // One cycle every 500 ms, the readings a few ms apart
+        timeUs = (uint64_t)*sample * 500000ULL;
+
+        clearSampleSet(&set);
+        setSampleValue(&set, CH_TEMP, 2150 + (int32_t)(*sample / 40) % 50, timeUs);
+        setSampleValue(&set, CH_HUMIDITY, 4800 + (int32_t)(nextRandom() >> 29), timeUs);
+        setSampleValue(&set, CH_PRESSURE, 101325 - (int32_t)(*sample % 600) * 2, timeUs + 2000);
+        setSampleValue(&set, CH_VOC, 120 + (int32_t)(nextRandom() >> 28), timeUs + 4000);
+        setSampleValue(&set, CH_CO2, 415 + (int32_t)(nextRandom() >> 29), timeUs + 4000);
+        setSampleValue(&set, CH_CO, 2, timeUs + 6000);
+        setSampleValue(&set, CH_PM2_5, 8 + (int32_t)(nextRandom() >> 30), timeUs + 8000);
+        setSampleValue(&set, CH_ALTITUDE, 12000 + (int32_t)(*sample % 600) * 20, timeUs + 10000);
+
+        header.type = FRAME_TYPE_SAMPLES;
+        header.flags = 0;
+        header.nodeId = 1;
+        header.seq = (uint16_t)*sample;
+        header.timeUs = timeUs;
+
+        frameLength = encodeSampleFrame(&set, &header, 0, frame, sizeof(frame));
+
+        // The recorder flushes the block before a frame that does not fit
+        if (length + 1 + frameLength > FIXTURE_BLOCK_SIZE)
+        {
+            return length;
+        }
+
+        block[length++] = frameLength;
+        memcpy(block + length, frame, frameLength);
+        length += frameLength;
+        (*sample)++;
+    }
+}
+
+// Returns the next pseudo-random number
+static uint32_t nextRandom()
+{
+    randomState = randomState * 1103515245 + 12345;
+    return randomState;
+}
@@ -0,0 +1,234 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks on the host that the batch, schema and packed
+    frames decode back to what was encoded, as the host tools read
+    them, and that a damaged frame is refused.
+    Run with: pio test -e native
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// PlatformIO test framework
+#include <unity.h>
+
+// Frames under test
+#include "../../src/protocols/Frame.hpp"
+
+// strcmp() and strlen() for the schema texts
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Samples of the batch test, the largest batch
+#define BATCH_SAMPLES FRAME_BATCH_MAX_SAMPLES
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Fills the header of a frame
+static void fillHeader(t_frameHeader *header, uint8_t type);
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Runs before each test
+void setUp()
+{
+}
+
+// Runs after each test
+void tearDown()
+{
+}
+
+// Every value of a batch comes back at its time, the invalid ones stay invalid
+static void test_batch_round_trip()
+{
+    t_sampleSet sets[BATCH_SAMPLES], decoded[BATCH_SAMPLES];
+    uint64_t timesUs[BATCH_SAMPLES], decodedTimesUs[BATCH_SAMPLES];
+    t_frameHeader header, decodedHeader;
+    uint8_t buffer[FRAME_BATCH_MAX_SIZE];
+    uint16_t length;
+
+    fillHeader(&header, FRAME_TYPE_BATCH);
+
+    for (uint8_t i = 0; i < BATCH_SAMPLES; i++)
+    {
+        timesUs[i] = header.timeUs + i * 500000ULL;
+
+        clearSampleSet(&sets[i]);
+        setSampleValue(&sets[i], CH_TEMP, 2150 + i, timesUs[i]);
+        setSampleValue(&sets[i], CH_CO2, 415 - 3 * i, timesUs[i]);
+
+        // A channel valid in some samples only, and a negative value
+        if (i % 3 == 0)
+        {
+            setSampleValue(&sets[i], CH_CLIMB, -120 * i, timesUs[i]);
+        }
+    }
+
+    length = encodeSampleBatch(sets, timesUs, BATCH_SAMPLES, &header, buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_THAN(0, length);
+
+    TEST_ASSERT_EQUAL_UINT8(BATCH_SAMPLES, decodeSampleBatch(buffer, length, &decodedHeader,
+                                                             decoded, decodedTimesUs,
+                                                             BATCH_SAMPLES));
+    TEST_ASSERT_EQUAL_UINT16(header.nodeId, decodedHeader.nodeId);
+    TEST_ASSERT_EQUAL_UINT16(header.seq, decodedHeader.seq);
+    TEST_ASSERT_TRUE(header.timeUs == decodedHeader.timeUs);
+
+    for (uint8_t i = 0; i < BATCH_SAMPLES; i++)
+    {
+        TEST_ASSERT_TRUE(timesUs[i] == decodedTimesUs[i]);
+        TEST_ASSERT_EQUAL_UINT32(sets[i].validMask, decoded[i].validMask);
+
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+        {
+            if (isSampleValid(&sets[i], (e_channel)ch))
+            {
+                TEST_ASSERT_EQUAL_INT32(sets[i].value[ch], decoded[i].value[ch]);
+                TEST_ASSERT_TRUE(timesUs[i] == decoded[i].timeUs[ch]);
+            }
+        }
+    }
+
+    // Too small an array, then a damaged value
+    TEST_ASSERT_EQUAL_UINT8(0, decodeSampleBatch(buffer, length, &decodedHeader, decoded,
+                                                 decodedTimesUs, BATCH_SAMPLES - 1));
+
+    buffer[length / 2] ^= 0x01;
+    TEST_ASSERT_EQUAL_UINT8(0, decodeSampleBatch(buffer, length, &decodedHeader, decoded,
+                                                 decodedTimesUs, BATCH_SAMPLES));
+}
+
+// The schema gives back each channel with its sensor, named once
+static void test_schema_round_trip()
+{
+    t_frameHeader header, decodedHeader;
+    t_frameSchema schema;
+    uint8_t buffer[FRAME_SCHEMA_MAX_SIZE];
+    uint32_t mask = (1UL << CH_COUNT) - 1;
+    uint8_t length;
+    e_channel channel;
+
+    fillHeader(&header, FRAME_TYPE_SCHEMA);
+
+    length = encodeSchemaFrame(mask, &header, buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_THAN(0, length);
+    TEST_ASSERT_TRUE(decodeSchemaFrame(buffer, length, &decodedHeader, &schema));
+
+    TEST_ASSERT_EQUAL_UINT32(mask, schema.channelMask);
+    TEST_ASSERT_EQUAL_UINT16(header.nodeId, decodedHeader.nodeId);
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        channel = (e_channel)ch;
+
+        // The labels lose their trailing ':'
+        TEST_ASSERT_EQUAL_UINT32(strlen(getChannelName(channel)) - 1, strlen(schema.name[ch]));
+        TEST_ASSERT_TRUE(strncmp(getChannelName(channel), schema.name[ch],
+                                 strlen(schema.name[ch])) == 0);
+        TEST_ASSERT_TRUE(strcmp(getChannelUnit(channel), schema.unit[ch]) == 0);
+        TEST_ASSERT_TRUE(strcmp(getChannelSource(channel),
+                                schema.sensors[schema.sensor[ch]]) == 0);
+        TEST_ASSERT_EQUAL_UINT8(FRAME_COLUMN_INT32, schema.columnType[ch]);
+    }
+
+    // Each sensor once in the dictionary
+    for (uint8_t i = 0; i < schema.sensorCount; i++)
+    {
+        for (uint8_t j = 0; j < i; j++)
+        {
+            TEST_ASSERT_TRUE(strcmp(schema.sensors[i], schema.sensors[j]) != 0);
+        }
+    }
+
+    // A subset keeps its own dictionary
+    length = encodeSchemaFrame((1UL << CH_CO2) | (1UL << CH_PM2_5), &header, buffer,
+                               sizeof(buffer));
+    TEST_ASSERT_TRUE(decodeSchemaFrame(buffer, length, &decodedHeader, &schema));
+    TEST_ASSERT_EQUAL_UINT8(2, schema.sensorCount);
+    TEST_ASSERT_TRUE(strcmp("PMS5003", schema.sensors[schema.sensor[CH_PM2_5]]) == 0);
+
+    buffer[length - 1] ^= 0x80;
+    TEST_ASSERT_FALSE(decodeSchemaFrame(buffer, length, &decodedHeader, &schema));
+}
+
+// A packed frame gives back the frames it holds
+static void test_packed_round_trip()
+{
+    t_sampleSet set, decoded;
+    t_frameHeader header, decodedHeader;
+    uint8_t frames[8 * FRAME_MAX_SIZE];
+    uint8_t packed[sizeof(frames)];
+    uint8_t unpacked[sizeof(frames)];
+    uint16_t length = 0, packedLength;
+
+    fillHeader(&header, FRAME_TYPE_SAMPLES);
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        clearSampleSet(&set);
+        setSampleValue(&set, CH_CO2, 415 + i, header.timeUs);
+        setSampleValue(&set, CH_PRESSURE, 101325, header.timeUs);
+
+        length += encodeSampleFrame(&set, &header, 0, frames + length, FRAME_MAX_SIZE);
+        header.seq++;
+    }
+
+    packedLength = encodePackedFrame(frames, length, &header, packed, sizeof(packed));
+    TEST_ASSERT_GREATER_THAN(0, packedLength);
+
+    TEST_ASSERT_EQUAL_UINT16(length, decodePackedFrame(packed, packedLength, &decodedHeader,
+                                                       unpacked, sizeof(unpacked)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frames, unpacked, length);
+    TEST_ASSERT_EQUAL_UINT8(FRAME_TYPE_PACKED, decodedHeader.type);
+
+    // The first frame decodes as it was
+    TEST_ASSERT_TRUE(decodeSampleFrame(unpacked, length / 8, &decodedHeader, &decoded));
+    TEST_ASSERT_EQUAL_INT32(415, decoded.value[CH_CO2]);
+
+    // Too small a buffer, then a damaged frame
+    TEST_ASSERT_EQUAL_UINT16(0, decodePackedFrame(packed, packedLength, &decodedHeader,
+                                                  unpacked, length - 1));
+
+    packed[FRAME_HEADER_SIZE] ^= 0x01;
+    TEST_ASSERT_EQUAL_UINT16(0, decodePackedFrame(packed, packedLength, &decodedHeader,
+                                                  unpacked, sizeof(unpacked)));
+}
+
+// Runs every test
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_batch_round_trip);
+    RUN_TEST(test_schema_round_trip);
+    RUN_TEST(test_packed_round_trip);
+
+    return UNITY_END();
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Fills the header of a frame
+static void fillHeader(t_frameHeader *header, uint8_t type)
+{
+    header->type = type;
+    header->flags = FRAME_FLAG_UTC;
+    header->nodeId = 0x1A2B;
+    header->seq = 42;
+    header->timeUs = 1760000000000000ULL;
+}
@@ -0,0 +1,228 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks the grid aggregator on the host: the cells
+    reused once their probed slots are taken, the paging of tile
+    queries, the clamping of far positions to the 16-bit cell
+    indexes, and a long flight over an area much larger than the
+    grid. Run with: pio test -e native
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// PlatformIO test framework
+#include <unity.h>
+
+// Grid aggregator under test
+#include "../../src/processing/Grid.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Cells of the finest level crossed by the eviction test, each once
+#define DISTINCT_CELLS 1000
+
+// Cells per page, as read by the log server
+#define PAGE_CELLS 8
+
+// Samples of the long flight and its area in metres
+#define FLIGHT_SAMPLES 1000000UL
+#define FLIGHT_WIDTH_M 20000
+#define FLIGHT_DEPTH_M 3000
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Adds a CO2 sample at a position relative to an origin at 0 N 0 E
+static void addSampleAt(double eastMetres, double northMetres, float altitude, uint32_t nowMs);
+
+// Reads every cell of a level lying in a tile, a page at a time
+static uint16_t readTile(uint8_t level, int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                         t_gridCell *cells, uint16_t pageCells);
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Runs before each test
+void setUp()
+{
+    initGrid();
+}
+
+// Runs after each test
+void tearDown()
+{
+}
+
+// Each new cell either takes a free slot or reuses one, never both
+static void test_eviction_count()
+{
+    t_gridCell cells[GRID_CELLS];
+    uint16_t cellSize, altSize;
+    uint32_t created = 0;
+    uint32_t kept = 0;
+
+    // One row of cells along the equator from the origin, every cell of
+    // every level is crossed once, its samples in a row
+    addSampleAt(0.0, 0.0, 0.0f, 0);
+
+    for (uint16_t i = 0; i < DISTINCT_CELLS; i++)
+    {
+        addSampleAt(i * 10.0 + 5.0, 5.0, 5.0f, i);
+    }
+
+    for (uint8_t level = 0; level < GRID_LEVELS; level++)
+    {
+        cellSize = getGridCellSize(level, &altSize);
+        created += (DISTINCT_CELLS * 10 + cellSize - 1) / cellSize;
+        kept += readTile(level, INT16_MIN, INT16_MIN, INT16_MAX, INT16_MAX, cells, GRID_CELLS);
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, getGridEvictions());
+    TEST_ASSERT_EQUAL_UINT32(created - kept, getGridEvictions());
+
+    // The finest level is full, a reused slot still holds a single cell
+    TEST_ASSERT_LESS_OR_EQUAL(GRID_CELLS, readTile(0, INT16_MIN, INT16_MIN, INT16_MAX, INT16_MAX,
+                                                   cells, GRID_CELLS));
+}
+
+// Pages of a tile add up to the whole tile, each cell once and inside it
+static void test_tile_paging()
+{
+    t_gridCell whole[GRID_CELLS];
+    t_gridCell paged[GRID_CELLS];
+    uint16_t wholeCount, pagedCount;
+
+    addSampleAt(0.0, 0.0, 0.0f, 0);
+
+    for (uint16_t i = 0; i < DISTINCT_CELLS; i++)
+    {
+        addSampleAt(i * 10.0 + 5.0, (i % 7) * 10.0 + 5.0, 5.0f, i);
+    }
+
+    wholeCount = readTile(0, 100, 2, 900, 5, whole, GRID_CELLS);
+    pagedCount = readTile(0, 100, 2, 900, 5, paged, PAGE_CELLS);
+
+    TEST_ASSERT_GREATER_THAN(PAGE_CELLS, pagedCount);
+    TEST_ASSERT_EQUAL_UINT16(wholeCount, pagedCount);
+
+    for (uint16_t i = 0; i < pagedCount; i++)
+    {
+        TEST_ASSERT_TRUE(paged[i].x >= 100 && paged[i].x <= 900);
+        TEST_ASSERT_TRUE(paged[i].y >= 2 && paged[i].y <= 5);
+        TEST_ASSERT_EQUAL_INT32(whole[i].x, paged[i].x);
+        TEST_ASSERT_EQUAL_INT32(whole[i].y, paged[i].y);
+
+        for (uint16_t j = 0; j < i; j++)
+        {
+            TEST_ASSERT_FALSE(paged[j].x == paged[i].x && paged[j].y == paged[i].y &&
+                              paged[j].z == paged[i].z);
+        }
+    }
+}
+
+// Positions beyond the 16-bit indexes land in the edge cells
+static void test_index_clamping()
+{
+    t_gridCell cells[GRID_CELLS];
+    uint16_t count;
+
+    // The first sample sets the origin
+    addSampleAt(0.0, 0.0, 0.0f, 0);
+    addSampleAt(1.0e7, -1.0e7, 1.0e6f, 1);
+
+    count = readTile(0, INT16_MAX, INT16_MIN, INT16_MAX, INT16_MIN, cells, GRID_CELLS);
+
+    TEST_ASSERT_EQUAL_UINT16(1, count);
+    TEST_ASSERT_EQUAL_INT32(INT16_MAX, cells[0].x);
+    TEST_ASSERT_EQUAL_INT32(INT16_MIN, cells[0].y);
+    TEST_ASSERT_EQUAL_INT32(INT16_MAX, cells[0].z);
+    TEST_ASSERT_EQUAL_INT32(CH_CO2, getGridChannel(1));
+    TEST_ASSERT_EQUAL_UINT16(1, cells[0].count[1]);
+}
+
+// A long flight over an area far larger than the grid keeps every level bounded
+static void test_long_flight()
+{
+    t_gridCell cells[GRID_CELLS];
+    uint32_t state = 12345;
+    double east = FLIGHT_WIDTH_M / 2, north = FLIGHT_DEPTH_M / 2;
+
+    for (uint32_t i = 0; i < FLIGHT_SAMPLES; i++)
+    {
+        // Random walk of up to 5 m per step, kept inside the area
+        state = state * 1103515245 + 12345;
+        east += (double)((int32_t)((state >> 16) % 11) - 5);
+        state = state * 1103515245 + 12345;
+        north += (double)((int32_t)((state >> 16) % 11) - 5);
+
+        east = (east < 0) ? 0 : (east > FLIGHT_WIDTH_M) ? FLIGHT_WIDTH_M : east;
+        north = (north < 0) ? 0 : (north > FLIGHT_DEPTH_M) ? FLIGHT_DEPTH_M : north;
+
+        addSampleAt(east, north, 100.0f, i);
+    }
+
+    for (uint8_t level = 0; level < GRID_LEVELS; level++)
+    {
+        TEST_ASSERT_LESS_OR_EQUAL(GRID_CELLS, readTile(level, INT16_MIN, INT16_MIN, INT16_MAX,
+                                                       INT16_MAX, cells, PAGE_CELLS));
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, getGridEvictions());
+}
+
+// Runs every test
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_eviction_count);
+    RUN_TEST(test_tile_paging);
+    RUN_TEST(test_index_clamping);
+    RUN_TEST(test_long_flight);
+
+    return UNITY_END();
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Adds a CO2 sample at a position relative to an origin at 0 N 0 E
+static void addSampleAt(double eastMetres, double northMetres, float altitude, uint32_t nowMs)
+{
+    t_sampleSet set;
+
+    clearSampleSet(&set);
+    setSampleValue(&set, CH_CO2, 400, 0);
+
+    // On the equator a degree of longitude is as long as one of latitude
+    addGridSample(&set, northMetres / GRID_METRES_PER_DEGREE, eastMetres / GRID_METRES_PER_DEGREE,
+                  altitude, nowMs);
+}
+
+// Reads every cell of a level lying in a tile, a page at a time
+static uint16_t readTile(uint8_t level, int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                         t_gridCell *cells, uint16_t pageCells)
+{
+    uint16_t cursor = 0;
+    uint16_t count = 0;
+    uint16_t page;
+
+    do
+    {
+        page = queryGridTile(level, xMin, yMin, xMax, yMax, &cursor, cells + count,
+                             (count + pageCells <= GRID_CELLS) ? pageCells : GRID_CELLS - count);
+        count += page;
+    } while (cursor < GRID_CELLS && count < GRID_CELLS);
+
+    return count;
+}
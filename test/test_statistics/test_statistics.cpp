@@ -0,0 +1,132 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks the percentile estimators of the streaming
+    statistics on the host. A summary window holds only a few
+    samples, so the percentiles must be exact there, and the
+    P-square estimate must stay close once it takes over.
+    Run with: pio test -e native
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// PlatformIO test framework
+#include <unity.h>
+
+// Statistics under test
+#include "../../src/processing/Statistics.hpp"
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Runs before each test
+void setUp()
+{
+}
+
+// Runs after each test
+void tearDown()
+{
+}
+
+// A window of 5 rising values gives a p95 above its p50
+static void test_short_window()
+{
+    t_p2 low, high;
+
+    initP2(&low, STATS_P_LOW);
+    initP2(&high, STATS_P_HIGH);
+
+    for (uint8_t i = 1; i <= 5; i++)
+    {
+        updateP2(&low, (float)i);
+        updateP2(&high, (float)i);
+    }
+
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, getP2(&low));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, getP2(&high));
+    TEST_ASSERT_TRUE(getP2(&high) > getP2(&low));
+}
+
+// The sorted buffer gives the exact percentile whatever the arrival order
+static void test_exact_buffer()
+{
+    t_p2 high;
+
+    initP2(&high, STATS_P_HIGH);
+
+    // 0 to STATS_P2_EXACT - 1, shuffled by a stride prime with the count
+    for (uint8_t i = 0; i < STATS_P2_EXACT; i++)
+    {
+        updateP2(&high, (float)((i * 7) % STATS_P2_EXACT));
+    }
+
+    TEST_ASSERT_EQUAL_FLOAT((float)(uint8_t)(STATS_P_HIGH * (STATS_P2_EXACT - 1) + 0.5f),
+                            getP2(&high));
+}
+
+// Past the sorted buffer the P-square estimate follows a uniform stream
+static void test_streaming()
+{
+    t_p2 low, high;
+    uint32_t state = 12345;
+    float x;
+
+    initP2(&low, STATS_P_LOW);
+    initP2(&high, STATS_P_HIGH);
+
+    for (uint16_t i = 0; i < 5000; i++)
+    {
+        state = state * 1103515245 + 12345;
+        x = (float)((state >> 16) % 1000);
+
+        updateP2(&low, x);
+        updateP2(&high, x);
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(30.0f, 500.0f, getP2(&low));
+    TEST_ASSERT_FLOAT_WITHIN(30.0f, 950.0f, getP2(&high));
+}
+
+// The summary of a channel reports both percentiles of its window
+static void test_summary_window()
+{
+    t_sampleSet set;
+    t_channelSummary summary;
+
+    initStatistics(STATS_EMA_ALPHA);
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        clearSampleSet(&set);
+        setSampleValue(&set, CH_CO2, 400 + 10 * i, 0);
+        updateStatistics(&set, 2000UL * i);
+    }
+
+    TEST_ASSERT_TRUE(getStatisticsSummary(CH_CO2, 8000, &summary));
+    TEST_ASSERT_EQUAL_UINT32(5, summary.count);
+    TEST_ASSERT_EQUAL_FLOAT(420.0f, summary.pLow);
+    TEST_ASSERT_EQUAL_FLOAT(440.0f, summary.pHigh);
+}
+
+// Runs every test
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_short_window);
+    RUN_TEST(test_exact_buffer);
+    RUN_TEST(test_streaming);
+    RUN_TEST(test_summary_window);
+
+    return UNITY_END();
+}
@@ -0,0 +1,412 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file runs the swarm logic on the host against a simulated
+    radio. Nodes send their sample sets and parity frames through a
+    radio that drops a share of them and may repeat some, then the
+    gateway receives what got through. The sequence, loss, duplicate
+    and recovery counters of the gateway are checked against what
+    the radio actually did. Run with: pio test -e native
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// PlatformIO test framework
+#include <unity.h>
+
+// Swarm logic under test
+#include "../../src/protocols/Swarm.hpp"
+
+// memcpy() on the frames of the radio
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Identifier of the gateway and of the first node
+#define GATEWAY_ID    0x0100
+#define FIRST_NODE_ID 0x0200
+
+// Sample frames sent by each node, whole FEC blocks
+#define FRAMES_PER_NODE 400
+
+// Frames the simulated radio holds for one node, parity included
+#define RADIO_MAX_FRAMES (FRAMES_PER_NODE * 2)
+
+// Nodes of the largest swarm simulated
+#define MAX_TEST_NODES 6
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Frame that went through the radio
+typedef struct
+{
+    uint8_t length;
+    uint8_t data[SWARM_MAX_FRAME_SIZE];
+
+} t_radioFrame;
+
+// Frames a node got through the radio, and what the radio did to them
+typedef struct
+{
+    t_radioFrame frames[RADIO_MAX_FRAMES];
+    uint16_t count;
+
+    // Set for each sample frame that reached the gateway
+    uint8_t delivered[FRAMES_PER_NODE];
+
+    // Repeated frames, and parity frames lost per block and group
+    uint16_t repeated;
+    uint8_t parityLost[FRAMES_PER_NODE][FEC_MAX_DEPTH];
+
+} t_radioLog;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Loss and repetition of the radio, in % of the frames
+static uint8_t lossPercent;
+static uint8_t repeatPercent;
+
+// State of the pseudo-random sequence, fixed so every run is the same
+static uint32_t randomState;
+
+// Radio log of the node sending, and of every node
+static t_radioLog *currentLog;
+static t_radioLog logs[MAX_TEST_NODES];
+
+// Frames delivered by the gateway to its uplink
+static uint32_t deliveredCount;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Returns a pseudo-random percentage, 0 to 99
+static uint8_t randomPercent();
+
+// Simulated radio: keeps or drops a frame, and may repeat it
+static uint8_t radioSend(const uint8_t *frame, uint8_t length);
+
+// Gateway uplink: counts the delivered frames
+static void uplinkDeliver(const t_frameHeader *header, const t_sampleSet *set,
+                          const t_swarmNode *node);
+
+// Sends the frames of every node through the radio, then hands them to the
+// gateway one node after the other, frame by frame
+static void runSwarm(uint8_t nodeCount, uint8_t groupSize, uint8_t depth);
+
+// Returns the statistics of a node kept by the gateway
+static t_swarmNode getNodeStats(uint16_t nodeId);
+
+// Checks the counters of a node against its radio log
+static void checkNode(uint8_t index, uint8_t groupSize, uint8_t depth);
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Runs before each test
+void setUp()
+{
+    randomState = 12345;
+    repeatPercent = 0;
+    deliveredCount = 0;
+    memset(logs, 0, sizeof(logs));
+}
+
+// Runs after each test
+void tearDown()
+{
+}
+
+// Sequence and loss counting without FEC, at 5, 10 and 20% loss
+static void test_loss_counting()
+{
+    static const uint8_t losses[] = {5, 10, 20};
+
+    for (uint8_t i = 0; i < sizeof(losses); i++)
+    {
+        setUp();
+        lossPercent = losses[i];
+
+        runSwarm(1, 0, 1);
+        checkNode(0, 0, 1);
+
+        TEST_ASSERT_EQUAL_UINT32(getNodeStats(FIRST_NODE_ID).received, deliveredCount);
+    }
+}
+
+// Repeated frames are counted once as duplicates and never delivered twice
+static void test_duplicate_counting()
+{
+    lossPercent = 10;
+    repeatPercent = 10;
+
+    runSwarm(1, 0, 1);
+
+    TEST_ASSERT_GREATER_THAN(0, logs[0].repeated);
+    checkNode(0, 0, 1);
+
+    // Repeated frames are not handed to the uplink
+    TEST_ASSERT_EQUAL_UINT32(getNodeStats(FIRST_NODE_ID).received, deliveredCount);
+}
+
+// Frames alone missing from their group are rebuilt, at 5, 10 and 20% loss
+static void test_fec_recovery()
+{
+    static const uint8_t losses[] = {5, 10, 20};
+
+    for (uint8_t i = 0; i < sizeof(losses); i++)
+    {
+        setUp();
+        lossPercent = losses[i];
+
+        runSwarm(1, FEC_DEFAULT_GROUP_SIZE, FEC_DEFAULT_DEPTH);
+
+        TEST_ASSERT_GREATER_THAN(0, getNodeStats(FIRST_NODE_ID).recovered);
+        checkNode(0, FEC_DEFAULT_GROUP_SIZE, FEC_DEFAULT_DEPTH);
+
+        // Rebuilt frames are handed to the uplink like the others
+        TEST_ASSERT_EQUAL_UINT32(getNodeStats(FIRST_NODE_ID).received, deliveredCount);
+    }
+}
+
+// Recovery keeps working when more nodes than a few are heard together
+static void test_fec_recovery_many_nodes()
+{
+    lossPercent = 10;
+
+    runSwarm(MAX_TEST_NODES, FEC_DEFAULT_GROUP_SIZE, FEC_DEFAULT_DEPTH);
+
+    TEST_ASSERT_EQUAL_UINT8(MAX_TEST_NODES, getSwarmNodeCount());
+
+    for (uint8_t i = 0; i < MAX_TEST_NODES; i++)
+    {
+        TEST_ASSERT_GREATER_THAN(0, getNodeStats(FIRST_NODE_ID + i).recovered);
+        checkNode(i, FEC_DEFAULT_GROUP_SIZE, FEC_DEFAULT_DEPTH);
+    }
+}
+
+// Runs every test
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_loss_counting);
+    RUN_TEST(test_duplicate_counting);
+    RUN_TEST(test_fec_recovery);
+    RUN_TEST(test_fec_recovery_many_nodes);
+
+    return UNITY_END();
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns a pseudo-random percentage, 0 to 99
+static uint8_t randomPercent()
+{
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 16) % 100;
+}
+
+// Simulated radio: keeps or drops a frame, and may repeat it
+static uint8_t radioSend(const uint8_t *frame, uint8_t length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sequence of a sample frame, first sequence of the block of a parity
+    uint16_t seq = frame[6] | ((uint16_t)frame[7] << 8);
+
+    // Copies of the frame handed to the gateway
+    uint8_t copies = 1;
+
+    /* -------------------- CHANNEL -------------------- */
+
+    // The first frame always gets through, the gateway counts from it
+    if (!(frame[2] == FRAME_TYPE_SAMPLES && seq == 0) && randomPercent() < lossPercent)
+    {
+        if (frame[2] == FRAME_TYPE_PARITY)
+        {
+            currentLog->parityLost[seq][frame[10]] = 1;
+        }
+
+        // Lost on the air, the node does not know
+        return 1;
+    }
+
+    if (frame[2] == FRAME_TYPE_SAMPLES)
+    {
+        currentLog->delivered[seq] = 1;
+
+        if (randomPercent() < repeatPercent)
+        {
+            currentLog->repeated++;
+            copies = 2;
+        }
+    }
+
+    for (uint8_t i = 0; i < copies && currentLog->count < RADIO_MAX_FRAMES; i++)
+    {
+        currentLog->frames[currentLog->count].length = length;
+        memcpy(currentLog->frames[currentLog->count].data, frame, length);
+        currentLog->count++;
+    }
+
+    return 1;
+}
+
+// Gateway uplink: counts the delivered frames
+static void uplinkDeliver(const t_frameHeader *header, const t_sampleSet *set,
+                          const t_swarmNode *node)
+{
+    deliveredCount++;
+}
+
+// Sends the frames of every node through the radio, then hands them to the
+// gateway one node after the other, frame by frame
+static void runSwarm(uint8_t nodeCount, uint8_t groupSize, uint8_t depth)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sample set sent by the nodes
+    t_sampleSet set;
+
+    // Next frame of each node handed to the gateway
+    uint16_t next[MAX_TEST_NODES] = {0};
+    uint8_t pending = 1;
+
+    /* -------------------- NODES -------------------- */
+
+    clearSampleSet(&set);
+
+    for (uint8_t n = 0; n < nodeCount; n++)
+    {
+        // Each node starts its own sequence and FEC block
+        initSwarm(FIRST_NODE_ID + n, radioSend, 0);
+        TEST_ASSERT_TRUE(setFecLevel(groupSize, depth));
+        currentLog = &logs[n];
+
+        for (uint16_t i = 0; i < FRAMES_PER_NODE; i++)
+        {
+            setSampleValue(&set, CH_TEMP, -1500 + i, 1000ULL * i);
+            setSampleValue(&set, CH_ALTITUDE, 120000 + i, 1000ULL * i);
+            swarmNodeSend(&set, 1000ULL * i, 0, 0);
+        }
+    }
+
+    /* -------------------- GATEWAY -------------------- */
+
+    initSwarm(GATEWAY_ID, 0, uplinkDeliver);
+
+    while (pending)
+    {
+        pending = 0;
+
+        for (uint8_t n = 0; n < nodeCount; n++)
+        {
+            if (next[n] < logs[n].count)
+            {
+                swarmGatewayReceive(logs[n].frames[next[n]].data, logs[n].frames[next[n]].length,
+                                    next[n]);
+                next[n]++;
+                pending = 1;
+            }
+        }
+    }
+}
+
+// Returns the statistics of a node kept by the gateway
+static t_swarmNode getNodeStats(uint16_t nodeId)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Node being checked
+    t_swarmNode node;
+
+    /* -------------------- LOOKUP -------------------- */
+
+    for (uint8_t i = 0; getSwarmNode(i, &node); i++)
+    {
+        if (node.nodeId == nodeId)
+        {
+            return node;
+        }
+    }
+
+    TEST_FAIL_MESSAGE("node not tracked by the gateway");
+    return node;
+}
+
+// Checks the counters of a node against its radio log
+static void checkNode(uint8_t index, uint8_t groupSize, uint8_t depth)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Radio log and gateway statistics of the node
+    const t_radioLog *log = &logs[index];
+    t_swarmNode node = getNodeStats(FIRST_NODE_ID + index);
+
+    // Frames the gateway should have, directly or rebuilt
+    uint8_t expected[FRAMES_PER_NODE];
+    uint32_t expectedReceived = 0;
+    uint32_t expectedRecovered = 0;
+    uint16_t lastSeq = 0;
+
+    // Frames of a block, and the lost frame of a group
+    uint16_t block = groupSize * depth;
+    uint8_t lost;
+    uint16_t lostSeq = 0;
+
+    /* -------------------- EXPECTED FRAMES -------------------- */
+
+    memcpy(expected, log->delivered, sizeof(expected));
+
+    // A group with a single lost frame is rebuilt when its parity arrives
+    for (uint16_t first = 0; groupSize && first + block <= FRAMES_PER_NODE; first += block)
+    {
+        for (uint8_t group = 0; group < depth; group++)
+        {
+            lost = 0;
+
+            for (uint8_t i = 0; i < groupSize; i++)
+            {
+                if (!log->delivered[first + group + i * depth])
+                {
+                    lost++;
+                    lostSeq = first + group + i * depth;
+                }
+            }
+
+            if (lost == 1 && !log->parityLost[first][group])
+            {
+                expected[lostSeq] = 1;
+                expectedRecovered++;
+            }
+        }
+    }
+
+    for (uint16_t seq = 0; seq < FRAMES_PER_NODE; seq++)
+    {
+        if (expected[seq])
+        {
+            expectedReceived++;
+            lastSeq = seq;
+        }
+    }
+
+    /* -------------------- COUNTERS -------------------- */
+
+    TEST_ASSERT_EQUAL_UINT16(lastSeq, node.lastSeq);
+    TEST_ASSERT_EQUAL_UINT32(expectedReceived, node.received);
+    TEST_ASSERT_EQUAL_UINT32(lastSeq + 1 - expectedReceived, node.lost);
+    TEST_ASSERT_EQUAL_UINT32(expectedRecovered, node.recovered);
+    TEST_ASSERT_EQUAL_UINT32(log->repeated, node.duplicates);
+}
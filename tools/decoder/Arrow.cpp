@@ -0,0 +1,962 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file writes the decoded columns as an Arrow IPC file, the
+    format pandas (read_feather), pyarrow and DuckDB map without
+    parsing. Each column of the store is written as it is, one
+    Arrow buffer per column and batch, so a multi-hour flight loads
+    in milliseconds. The metadata of the format are FlatBuffers,
+    built here back to front as the FlatBuffers library does, so
+    the tool needs no Arrow or FlatBuffers library to build.
+
+    File layout: magic, schema message, one dictionary message per
+    dictionary (sensors, channels, units), the record batches, the
+    end of stream marker, then the footer listing every message.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the Arrow writer
+#include "Arrow.hpp"
+
+// fopen(), fwrite() and fclose() for the file
+#include <stdio.h>
+
+// malloc() and free() for the list of record batches
+#include <stdlib.h>
+
+// memcpy(), memset(), strlen() and strcmp() for the metadata and the units
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Magic at both ends of the file, padded to 8 bytes at the start
+#define ARROW_MAGIC      "ARROW1"
+#define ARROW_MAGIC_SIZE 6
+
+// Every message starts with this marker then the metadata length
+#define ARROW_CONTINUATION 0xFFFFFFFFUL
+
+// Buffers and messages start on 8-byte boundaries
+#define ARROW_ALIGNMENT 8
+
+// Metadata version V5, current since Arrow 1.0
+#define ARROW_METADATA_V5 4
+
+// Message types (MessageHeader union)
+#define ARROW_MESSAGE_SCHEMA     1
+#define ARROW_MESSAGE_DICTIONARY 2
+#define ARROW_MESSAGE_BATCH      3
+
+// Column types (Type union) and time unit
+#define ARROW_TYPE_INT         2
+#define ARROW_TYPE_UTF8        5
+#define ARROW_TYPE_TIMESTAMP   10
+#define ARROW_UNIT_MICROSECOND 2
+
+// Fields of the table and dictionaries: sensors, channels, units
+#define ARROW_FIELDS       8
+#define ARROW_DICTIONARIES 3
+
+// Most fields of a FlatBuffers table written here (Field has 7)
+#define ARROW_MAX_SLOTS 8
+
+// Sizes of the FieldNode, Buffer and Block structures
+#define ARROW_NODE_SIZE  16
+#define ARROW_BUFFER_SIZE 16
+#define ARROW_BLOCK_SIZE 24
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// FlatBuffer built from its end, children before their parents
+typedef struct
+{
+    // Buffer, the used bytes at its end
+    uint8_t data[ARROW_METADATA_SIZE];
+    uint32_t used;
+
+    // Largest alignment required, the finished buffer is aligned to it
+    uint32_t minAlign;
+
+    // Fields of the open table, as positions from the end, 0 if absent
+    uint32_t slots[ARROW_MAX_SLOTS];
+    uint8_t slotCount;
+    uint32_t tableEnd;
+
+    // Set when the metadata did not fit
+    uint8_t overflow;
+
+} t_flatBuilder;
+
+// Position of a message in the file, listed by the footer
+typedef struct
+{
+    int64_t offset;
+    int32_t metadataLength;
+    int64_t bodyLength;
+
+} t_arrowBlock;
+
+// Description of a field of the table
+typedef struct
+{
+    // Column name
+    const char *name;
+
+    // Type (ARROW_TYPE_x), width of the integer or dictionary index
+    uint8_t type;
+    uint8_t bitWidth;
+    uint8_t isSigned;
+
+    // Dictionary of the field, -1 if not dictionary encoded
+    int8_t dictionary;
+
+} t_arrowField;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Fields in column order, dictionary values are UTF-8 texts
+static const t_arrowField fields[ARROW_FIELDS] = {
+    {"time", ARROW_TYPE_TIMESTAMP, 64, 1, -1},
+    {"node", ARROW_TYPE_INT, 16, 0, -1},
+    {"seq", ARROW_TYPE_INT, 16, 0, -1},
+    {"flags", ARROW_TYPE_INT, 8, 0, -1},
+    {"sensor", ARROW_TYPE_UTF8, 8, 1, 0},
+    {"channel", ARROW_TYPE_UTF8, 8, 1, 1},
+    {"unit", ARROW_TYPE_UTF8, 8, 1, 2},
+    {"value", ARROW_TYPE_INT, 32, 1, -1}};
+
+// File being written and the write position
+static FILE *file = NULL;
+static int64_t fileOffset = 0;
+static uint8_t writeError = 0;
+
+// Metadata being built, too large for the stack of the callers
+static t_flatBuilder builder;
+
+// Unit dictionary without repeats (readers such as pandas require
+// distinct values), the unit of each channel, the units of a batch
+static char units[CH_COUNT][FRAME_TEXT_SIZE];
+static uint8_t unitCount = 0;
+static int8_t unitOf[CH_COUNT];
+static int8_t unitColumn[ARROW_BATCH_ROWS];
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Writes the messages of the schema, the dictionaries and the batches
+static uint8_t writeMessages(const t_columns *columns, t_arrowBlock *dictionaries,
+                             t_arrowBlock *batches, size_t batchCount);
+
+// Writes a dictionary message
+static void writeDictionary(int64_t id, const char *texts, size_t stride, size_t count,
+                            t_arrowBlock *block);
+
+// Lists each unit once and the unit of each channel
+static void buildUnits(const t_columns *columns);
+
+// Writes a record batch message for a range of rows
+static void writeBatch(const t_columns *columns, size_t first, size_t rows, t_arrowBlock *block);
+
+// Writes the footer and the closing magic
+static void writeFooter(const t_arrowBlock *dictionaries, const t_arrowBlock *batches,
+                        size_t batchCount);
+
+// Builds the Schema table, in the schema message and in the footer
+static uint32_t buildSchema(t_flatBuilder *b);
+
+// Builds the Message table around a header and writes the metadata
+static void writeMetadata(uint8_t type, uint32_t header, int64_t bodyLength, t_arrowBlock *block);
+
+// Builds a RecordBatch table from its nodes and buffers
+static uint32_t buildRecordBatch(t_flatBuilder *b, int64_t length, const uint8_t *nodes,
+                                 size_t nodeCount, const uint8_t *buffers, size_t bufferCount);
+
+// Returns the start of a column at a row, and the width of its values
+static const uint8_t *getColumn(const t_columns *columns, uint8_t field, size_t row,
+                                uint8_t *width);
+
+// Writes bytes to the file
+static void writeBytes(const void *data, size_t length);
+
+// Writes zeros up to the next 8-byte boundary of the file
+static void writePadding();
+
+// Writes a little endian value into a structure
+static void putValue(uint8_t *buffer, uint64_t value, uint8_t size);
+
+// Rounds a length up to a multiple of 8
+static int64_t alignLength(int64_t length);
+
+// FlatBuffers: starts an empty buffer
+static void fbInit(t_flatBuilder *b);
+
+// FlatBuffers: pads so that after extra bytes the position is aligned
+static void fbPrep(t_flatBuilder *b, uint32_t size, uint32_t extra);
+
+// FlatBuffers: adds bytes in front of the buffer
+static void fbPush(t_flatBuilder *b, const void *data, uint32_t length);
+
+// FlatBuffers: adds an aligned little endian scalar
+static void fbScalar(t_flatBuilder *b, uint64_t value, uint8_t size);
+
+// FlatBuffers: adds an offset to an earlier object
+static void fbOffset(t_flatBuilder *b, uint32_t target);
+
+// FlatBuffers: adds a string, returns its position
+static uint32_t fbString(t_flatBuilder *b, const char *text);
+
+// FlatBuffers: adds a vector of offsets, returns its position
+static uint32_t fbOffsetVector(t_flatBuilder *b, const uint32_t *targets, size_t count);
+
+// FlatBuffers: adds a vector of structures, returns its position
+static uint32_t fbStructVector(t_flatBuilder *b, const uint8_t *data, size_t size, size_t count);
+
+// FlatBuffers: opens a table
+static void fbStartTable(t_flatBuilder *b);
+
+// FlatBuffers: adds a scalar field to the open table
+static void fbField(t_flatBuilder *b, uint8_t slot, uint64_t value, uint8_t size);
+
+// FlatBuffers: adds an offset field to the open table
+static void fbOffsetField(t_flatBuilder *b, uint8_t slot, uint32_t target);
+
+// FlatBuffers: closes the open table with its vtable, returns its position
+static uint32_t fbEndTable(t_flatBuilder *b);
+
+// FlatBuffers: adds the root offset, the buffer is complete
+static void fbFinish(t_flatBuilder *b, uint32_t root);
+
+
+/* *****************************************************************
+    *                        FILE FUNCTION                        *
+   ***************************************************************** */
+
+// Writes the columns to an Arrow IPC file (Feather V2), uncompressed so
+// readers can map the columns straight from the file. Sensors, channels
+// and units are dictionary encoded
+// @param path: File to create
+// @param columns: Columns to write
+// @return: 1 if the file was written, 0 otherwise
+uint8_t writeArrowFile(const char *path, const t_columns *columns)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Messages listed by the footer
+    t_arrowBlock dictionaries[ARROW_DICTIONARIES];
+    t_arrowBlock *batches;
+    size_t batchCount = (columns->rows + ARROW_BATCH_ROWS - 1) / ARROW_BATCH_ROWS;
+
+    // Result of the writes
+    uint8_t written;
+
+    /* -------------------- FILE -------------------- */
+
+    batches = (t_arrowBlock *)malloc((batchCount ? batchCount : 1) * sizeof(*batches));
+    if (!batches)
+    {
+        return 0;
+    }
+
+    file = fopen(path, "wb");
+    if (!file)
+    {
+        free(batches);
+        return 0;
+    }
+
+    fileOffset = 0;
+    writeError = 0;
+
+    written = writeMessages(columns, dictionaries, batches, batchCount);
+    if (written)
+    {
+        writeFooter(dictionaries, batches, batchCount);
+    }
+
+    written = written && !writeError && !builder.overflow;
+
+    if (fclose(file) != 0)
+    {
+        written = 0;
+    }
+
+    file = NULL;
+    free(batches);
+
+    return written;
+}
+
+
+/* *****************************************************************
+    *                      MESSAGE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Writes the messages of the schema, the dictionaries and the batches
+static uint8_t writeMessages(const t_columns *columns, t_arrowBlock *dictionaries,
+                             t_arrowBlock *batches, size_t batchCount)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Schema message, its position is not listed by the footer
+    t_arrowBlock schemaBlock;
+
+    // Rows of the batch being written
+    size_t rows;
+
+    /* -------------------- MESSAGES -------------------- */
+
+    writeBytes(ARROW_MAGIC, ARROW_MAGIC_SIZE);
+    writePadding();
+
+    fbInit(&builder);
+    writeMetadata(ARROW_MESSAGE_SCHEMA, buildSchema(&builder), 0, &schemaBlock);
+
+    writeDictionary(0, columns->sensors[0], FRAME_TEXT_SIZE, columns->sensorCount,
+                    &dictionaries[0]);
+    writeDictionary(1, columns->names[0], FRAME_TEXT_SIZE, CH_COUNT, &dictionaries[1]);
+    buildUnits(columns);
+    writeDictionary(2, units[0], FRAME_TEXT_SIZE, unitCount, &dictionaries[2]);
+
+    for (size_t i = 0; i < batchCount && !writeError && !builder.overflow; i++)
+    {
+        rows = columns->rows - i * ARROW_BATCH_ROWS;
+        writeBatch(columns, i * ARROW_BATCH_ROWS, rows < ARROW_BATCH_ROWS ? rows : ARROW_BATCH_ROWS,
+                   &batches[i]);
+    }
+
+    return !writeError && !builder.overflow;
+}
+
+// Writes a dictionary message
+static void writeDictionary(int64_t id, const char *texts, size_t stride, size_t count,
+                            t_arrowBlock *block)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Offsets of the texts in the data buffer, count + 1 of them
+    int32_t offsets[COLUMNS_MAX_SENSORS + 1];
+    int32_t textLength = 0;
+
+    // Node and buffers of the single column: validity, offsets, data
+    uint8_t node[ARROW_NODE_SIZE];
+    uint8_t buffers[3 * ARROW_BUFFER_SIZE];
+    int64_t offsetsLength = (int64_t)(count + 1) * 4;
+
+    // Tables of the metadata
+    uint32_t batch, dictionary;
+
+    /* -------------------- LAYOUT -------------------- */
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        textLength += (int32_t)strlen(texts + i * stride);
+        offsets[i + 1] = textLength;
+    }
+
+    putValue(node, count, 8);
+    putValue(node + 8, 0, 8);
+
+    // No validity buffer, no text is null
+    memset(buffers, 0, sizeof(buffers));
+    putValue(buffers + 16, 0, 8);
+    putValue(buffers + 24, offsetsLength, 8);
+    putValue(buffers + 32, alignLength(offsetsLength), 8);
+    putValue(buffers + 40, textLength, 8);
+
+    /* -------------------- METADATA -------------------- */
+
+    fbInit(&builder);
+    batch = buildRecordBatch(&builder, count, node, 1, buffers, 3);
+
+    fbStartTable(&builder);
+    fbField(&builder, 0, id, 8);
+    fbOffsetField(&builder, 1, batch);
+    dictionary = fbEndTable(&builder);
+
+    writeMetadata(ARROW_MESSAGE_DICTIONARY, dictionary,
+                  alignLength(offsetsLength) + alignLength(textLength), block);
+
+    /* -------------------- BODY -------------------- */
+
+    writeBytes(offsets, offsetsLength);
+    writePadding();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        writeBytes(texts + i * stride, strlen(texts + i * stride));
+    }
+
+    writePadding();
+}
+
+// Lists each unit once and the unit of each channel
+static void buildUnits(const t_columns *columns)
+{
+    unitCount = 0;
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        unitOf[ch] = -1;
+        for (uint8_t i = 0; i < unitCount && unitOf[ch] < 0; i++)
+        {
+            if (strcmp(units[i], columns->units[ch]) == 0)
+            {
+                unitOf[ch] = i;
+            }
+        }
+
+        if (unitOf[ch] < 0)
+        {
+            memcpy(units[unitCount], columns->units[ch], FRAME_TEXT_SIZE);
+            unitOf[ch] = unitCount++;
+        }
+    }
+}
+
+// Writes a record batch message for a range of rows
+static void writeBatch(const t_columns *columns, size_t first, size_t rows, t_arrowBlock *block)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // One node per field, a validity and a data buffer per field
+    uint8_t nodes[ARROW_FIELDS * ARROW_NODE_SIZE];
+    uint8_t buffers[2 * ARROW_FIELDS * ARROW_BUFFER_SIZE];
+
+    // Column of a field and the width of its values
+    const uint8_t *column;
+    uint8_t width;
+
+    // Position of the next buffer in the body
+    int64_t bodyLength = 0;
+
+    /* -------------------- LAYOUT -------------------- */
+
+    for (size_t row = 0; row < rows; row++)
+    {
+        unitColumn[row] = unitOf[columns->channel[first + row]];
+    }
+
+    memset(buffers, 0, sizeof(buffers));
+
+    for (uint8_t i = 0; i < ARROW_FIELDS; i++)
+    {
+        getColumn(columns, i, first, &width);
+
+        putValue(nodes + i * ARROW_NODE_SIZE, rows, 8);
+        putValue(nodes + i * ARROW_NODE_SIZE + 8, 0, 8);
+
+        // No validity buffer, every field is required
+        putValue(buffers + (2 * i + 1) * ARROW_BUFFER_SIZE, bodyLength, 8);
+        putValue(buffers + (2 * i + 1) * ARROW_BUFFER_SIZE + 8, rows * width, 8);
+        putValue(buffers + 2 * i * ARROW_BUFFER_SIZE, bodyLength, 8);
+
+        bodyLength += alignLength(rows * width);
+    }
+
+    /* -------------------- METADATA -------------------- */
+
+    fbInit(&builder);
+    writeMetadata(ARROW_MESSAGE_BATCH,
+                  buildRecordBatch(&builder, rows, nodes, ARROW_FIELDS, buffers, 2 * ARROW_FIELDS),
+                  bodyLength, block);
+
+    /* -------------------- BODY -------------------- */
+
+    // The columns go out as they are stored, the units as mapped above
+    for (uint8_t i = 0; i < ARROW_FIELDS; i++)
+    {
+        column = getColumn(columns, i, first, &width);
+        writeBytes(column, rows * width);
+        writePadding();
+    }
+}
+
+// Writes the footer and the closing magic
+static void writeFooter(const t_arrowBlock *dictionaries, const t_arrowBlock *batches,
+                        size_t batchCount)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Blocks of one message
+    uint8_t block[ARROW_BLOCK_SIZE];
+
+    // Messages listed by the vector being built
+    const t_arrowBlock *blocks;
+    size_t count;
+
+    // Tables and vectors of the footer
+    uint32_t schema, footer;
+    uint32_t vectors[2];
+
+    /* -------------------- METADATA -------------------- */
+
+    // End of stream marker, for readers of the stream part
+    putValue(block, ARROW_CONTINUATION, 4);
+    putValue(block + 4, 0, 4);
+    writeBytes(block, 8);
+
+    fbInit(&builder);
+    schema = buildSchema(&builder);
+
+    // Vectors of structures are built from their end, one block at a time
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        blocks = pass ? batches : dictionaries;
+        count = pass ? batchCount : ARROW_DICTIONARIES;
+
+        fbPrep(&builder, 4, ARROW_BLOCK_SIZE * count);
+        fbPrep(&builder, ARROW_ALIGNMENT, ARROW_BLOCK_SIZE * count);
+
+        for (size_t i = count; i > 0; i--)
+        {
+            memset(block, 0, sizeof(block));
+            putValue(block, blocks[i - 1].offset, 8);
+            putValue(block + 8, (uint32_t)blocks[i - 1].metadataLength, 4);
+            putValue(block + 16, blocks[i - 1].bodyLength, 8);
+            fbPush(&builder, block, ARROW_BLOCK_SIZE);
+        }
+
+        putValue(block, count, 4);
+        fbPush(&builder, block, 4);
+        vectors[pass] = builder.used;
+    }
+
+    fbStartTable(&builder);
+    fbField(&builder, 0, ARROW_METADATA_V5, 2);
+    fbOffsetField(&builder, 1, schema);
+    fbOffsetField(&builder, 2, vectors[0]);
+    fbOffsetField(&builder, 3, vectors[1]);
+    footer = fbEndTable(&builder);
+    fbFinish(&builder, footer);
+
+    /* -------------------- FOOTER -------------------- */
+
+    writeBytes(builder.data + ARROW_METADATA_SIZE - builder.used, builder.used);
+
+    putValue(block, builder.used, 4);
+    writeBytes(block, 4);
+    writeBytes(ARROW_MAGIC, ARROW_MAGIC_SIZE);
+}
+
+
+/* *****************************************************************
+    *                      METADATA FUNCTIONS                     *
+   ***************************************************************** */
+
+// Builds the Schema table, in the schema message and in the footer
+static uint32_t buildSchema(t_flatBuilder *b)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Tables of each field
+    uint32_t fieldTables[ARROW_FIELDS];
+    uint32_t name, type, indexType, dictionary, children, fieldVector;
+
+    /* -------------------- FIELDS -------------------- */
+
+    for (uint8_t i = 0; i < ARROW_FIELDS; i++)
+    {
+        name = fbString(b, fields[i].name);
+
+        // Readers require the children, even when there are none
+        children = fbOffsetVector(b, NULL, 0);
+
+        dictionary = 0;
+
+        if (fields[i].dictionary >= 0)
+        {
+            fbStartTable(b);
+            fbField(b, 0, fields[i].bitWidth, 4);
+            fbField(b, 1, fields[i].isSigned, 1);
+            indexType = fbEndTable(b);
+
+            fbStartTable(b);
+            fbField(b, 0, (uint64_t)fields[i].dictionary, 8);
+            fbOffsetField(b, 1, indexType);
+            dictionary = fbEndTable(b);
+
+            // The values of a dictionary field are its texts
+            fbStartTable(b);
+            type = fbEndTable(b);
+        }
+
+        else if (fields[i].type == ARROW_TYPE_TIMESTAMP)
+        {
+            fbStartTable(b);
+            fbField(b, 0, ARROW_UNIT_MICROSECOND, 2);
+            type = fbEndTable(b);
+        }
+
+        else
+        {
+            fbStartTable(b);
+            fbField(b, 0, fields[i].bitWidth, 4);
+            fbField(b, 1, fields[i].isSigned, 1);
+            type = fbEndTable(b);
+        }
+
+        fbStartTable(b);
+        fbOffsetField(b, 0, name);
+        fbField(b, 1, 0, 1);
+        fbField(b, 2, fields[i].type, 1);
+        fbOffsetField(b, 3, type);
+        if (dictionary)
+        {
+            fbOffsetField(b, 4, dictionary);
+        }
+        fbOffsetField(b, 5, children);
+        fieldTables[i] = fbEndTable(b);
+    }
+
+    /* -------------------- SCHEMA -------------------- */
+
+    fieldVector = fbOffsetVector(b, fieldTables, ARROW_FIELDS);
+
+    fbStartTable(b);
+    fbOffsetField(b, 1, fieldVector);
+    return fbEndTable(b);
+}
+
+// Builds the Message table around a header and writes the metadata
+static void writeMetadata(uint8_t type, uint32_t header, int64_t bodyLength, t_arrowBlock *block)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Prefix of the message: marker and padded metadata length
+    uint8_t prefix[8];
+    uint32_t length;
+
+    /* -------------------- MESSAGE -------------------- */
+
+    fbStartTable(&builder);
+    fbField(&builder, 0, ARROW_METADATA_V5, 2);
+    fbField(&builder, 1, type, 1);
+    fbOffsetField(&builder, 2, header);
+    fbField(&builder, 3, (uint64_t)bodyLength, 8);
+    fbFinish(&builder, fbEndTable(&builder));
+
+    // The body starts on an 8-byte boundary
+    length = (uint32_t)alignLength(builder.used);
+
+    block->offset = fileOffset;
+    block->metadataLength = (int32_t)(8 + length);
+    block->bodyLength = bodyLength;
+
+    putValue(prefix, ARROW_CONTINUATION, 4);
+    putValue(prefix + 4, length, 4);
+    writeBytes(prefix, 8);
+    writeBytes(builder.data + ARROW_METADATA_SIZE - builder.used, builder.used);
+    writePadding();
+}
+
+// Builds a RecordBatch table from its nodes and buffers
+static uint32_t buildRecordBatch(t_flatBuilder *b, int64_t length, const uint8_t *nodes,
+                                 size_t nodeCount, const uint8_t *buffers, size_t bufferCount)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Vectors of the table
+    uint32_t nodeVector, bufferVector;
+
+    /* -------------------- TABLE -------------------- */
+
+    nodeVector = fbStructVector(b, nodes, ARROW_NODE_SIZE, nodeCount);
+    bufferVector = fbStructVector(b, buffers, ARROW_BUFFER_SIZE, bufferCount);
+
+    fbStartTable(b);
+    fbField(b, 0, (uint64_t)length, 8);
+    fbOffsetField(b, 1, nodeVector);
+    fbOffsetField(b, 2, bufferVector);
+    return fbEndTable(b);
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the start of a column at a row, and the width of its values
+static const uint8_t *getColumn(const t_columns *columns, uint8_t field, size_t row,
+                                uint8_t *width)
+{
+    switch (field)
+    {
+    case 0:
+        *width = sizeof(*columns->timeUs);
+        return (const uint8_t *)(columns->timeUs + row);
+
+    case 1:
+        *width = sizeof(*columns->node);
+        return (const uint8_t *)(columns->node + row);
+
+    case 2:
+        *width = sizeof(*columns->seq);
+        return (const uint8_t *)(columns->seq + row);
+
+    case 3:
+        *width = sizeof(*columns->flags);
+        return columns->flags + row;
+
+    case 4:
+        *width = sizeof(*columns->sensor);
+        return (const uint8_t *)(columns->sensor + row);
+
+    case 5:
+        *width = sizeof(*columns->channel);
+        return (const uint8_t *)(columns->channel + row);
+
+    // Derived from the channels, only for the batch being written
+    case 6:
+        *width = sizeof(*unitColumn);
+        return (const uint8_t *)unitColumn;
+
+    default:
+        *width = sizeof(*columns->value);
+        return (const uint8_t *)(columns->value + row);
+    }
+}
+
+// Writes bytes to the file
+static void writeBytes(const void *data, size_t length)
+{
+    if (length > 0 && fwrite(data, 1, length, file) != length)
+    {
+        writeError = 1;
+    }
+
+    fileOffset += length;
+}
+
+// Writes zeros up to the next 8-byte boundary of the file
+static void writePadding()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Zeros to write from
+    static const uint8_t zeros[ARROW_ALIGNMENT] = {0};
+
+    /* -------------------- PADDING -------------------- */
+
+    writeBytes(zeros, alignLength(fileOffset) - fileOffset);
+}
+
+// Writes a little endian value into a structure
+static void putValue(uint8_t *buffer, uint64_t value, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Rounds a length up to a multiple of 8
+static int64_t alignLength(int64_t length)
+{
+    return (length + ARROW_ALIGNMENT - 1) & ~(int64_t)(ARROW_ALIGNMENT - 1);
+}
+
+
+/* *****************************************************************
+    *                     FLATBUFFERS FUNCTIONS                   *
+   ***************************************************************** */
+
+// FlatBuffers: starts an empty buffer
+static void fbInit(t_flatBuilder *b)
+{
+    b->used = 0;
+    b->minAlign = 1;
+    b->slotCount = 0;
+    b->overflow = 0;
+}
+
+// FlatBuffers: pads so that after extra bytes the position is aligned
+static void fbPrep(t_flatBuilder *b, uint32_t size, uint32_t extra)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Zeros to add in front
+    uint32_t padding;
+    uint8_t zero = 0;
+
+    /* -------------------- ALIGNMENT -------------------- */
+
+    if (size > b->minAlign)
+    {
+        b->minAlign = size;
+    }
+
+    padding = (~(b->used + extra) + 1) & (size - 1);
+
+    while (padding--)
+    {
+        fbPush(b, &zero, 1);
+    }
+}
+
+// FlatBuffers: adds bytes in front of the buffer
+static void fbPush(t_flatBuilder *b, const void *data, uint32_t length)
+{
+    if (b->used + length > ARROW_METADATA_SIZE)
+    {
+        b->overflow = 1;
+        return;
+    }
+
+    b->used += length;
+    memcpy(b->data + ARROW_METADATA_SIZE - b->used, data, length);
+}
+
+// FlatBuffers: adds an aligned little endian scalar
+static void fbScalar(t_flatBuilder *b, uint64_t value, uint8_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bytes of the value
+    uint8_t bytes[8];
+
+    /* -------------------- SCALAR -------------------- */
+
+    fbPrep(b, size, 0);
+    putValue(bytes, value, size);
+    fbPush(b, bytes, size);
+}
+
+// FlatBuffers: adds an offset to an earlier object
+static void fbOffset(t_flatBuilder *b, uint32_t target)
+{
+    // Relative to the offset itself, the object lies further in the buffer
+    fbPrep(b, 4, 0);
+    fbScalar(b, b->used + 4 - target, 4);
+}
+
+// FlatBuffers: adds a string, returns its position
+static uint32_t fbString(t_flatBuilder *b, const char *text)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the text, without the null terminating it
+    uint32_t length = (uint32_t)strlen(text);
+    uint8_t zero = 0;
+
+    /* -------------------- STRING -------------------- */
+
+    fbPrep(b, 4, length + 1);
+    fbPush(b, &zero, 1);
+    fbPush(b, text, length);
+    fbScalar(b, length, 4);
+
+    return b->used;
+}
+
+// FlatBuffers: adds a vector of offsets, returns its position
+static uint32_t fbOffsetVector(t_flatBuilder *b, const uint32_t *targets, size_t count)
+{
+    fbPrep(b, 4, 4 * count);
+
+    for (size_t i = count; i > 0; i--)
+    {
+        fbOffset(b, targets[i - 1]);
+    }
+
+    fbScalar(b, count, 4);
+    return b->used;
+}
+
+// FlatBuffers: adds a vector of structures, returns its position
+static uint32_t fbStructVector(t_flatBuilder *b, const uint8_t *data, size_t size, size_t count)
+{
+    // The length sits right before the first structure, 8-byte aligned
+    fbPrep(b, 4, size * count);
+    fbPrep(b, ARROW_ALIGNMENT, size * count);
+    fbPush(b, data, size * count);
+    fbScalar(b, count, 4);
+
+    return b->used;
+}
+
+// FlatBuffers: opens a table
+static void fbStartTable(t_flatBuilder *b)
+{
+    memset(b->slots, 0, sizeof(b->slots));
+    b->slotCount = 0;
+    b->tableEnd = b->used;
+}
+
+// FlatBuffers: adds a scalar field to the open table
+static void fbField(t_flatBuilder *b, uint8_t slot, uint64_t value, uint8_t size)
+{
+    fbScalar(b, value, size);
+
+    b->slots[slot] = b->used;
+    if (slot >= b->slotCount)
+    {
+        b->slotCount = slot + 1;
+    }
+}
+
+// FlatBuffers: adds an offset field to the open table
+static void fbOffsetField(t_flatBuilder *b, uint8_t slot, uint32_t target)
+{
+    fbOffset(b, target);
+
+    b->slots[slot] = b->used;
+    if (slot >= b->slotCount)
+    {
+        b->slotCount = slot + 1;
+    }
+}
+
+// FlatBuffers: closes the open table with its vtable, returns its position
+static uint32_t fbEndTable(t_flatBuilder *b)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Position of the table, where its vtable offset goes
+    uint32_t table;
+
+    // Entry of the vtable
+    uint8_t entry[2];
+
+    /* -------------------- TABLE -------------------- */
+
+    fbScalar(b, 0, 4);
+    table = b->used;
+
+    /* -------------------- VTABLE -------------------- */
+
+    // Offset of each field from the start of the table, 0 if absent
+    for (uint8_t slot = b->slotCount; slot > 0; slot--)
+    {
+        putValue(entry, b->slots[slot - 1] ? table - b->slots[slot - 1] : 0, 2);
+        fbPush(b, entry, 2);
+    }
+
+    putValue(entry, table - b->tableEnd, 2);
+    fbPush(b, entry, 2);
+
+    putValue(entry, 4 + 2 * b->slotCount, 2);
+    fbPush(b, entry, 2);
+
+    // The vtable lies before the table, at a positive distance
+    if (!b->overflow)
+    {
+        putValue(b->data + ARROW_METADATA_SIZE - table, b->used - table, 4);
+    }
+
+    return table;
+}
+
+// FlatBuffers: adds the root offset, the buffer is complete
+static void fbFinish(t_flatBuilder *b, uint32_t root)
+{
+    fbPrep(b, b->minAlign, 4);
+    fbOffset(b, root);
+}
@@ -0,0 +1,35 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef ARROW_hpp
+#define ARROW_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types
+#include <stdint.h>
+
+// Columns to write
+#include "Columns.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Rows per record batch, a reader maps one batch at a time
+#define ARROW_BATCH_ROWS 65536
+
+// Largest metadata of a message or of the footer
+#define ARROW_METADATA_SIZE 8192
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Writes the columns to an Arrow IPC file (Feather V2), uncompressed so
+// readers can map the columns straight from the file. Sensors, channels
+// and units are dictionary encoded
+// @param path: File to create
+// @param columns: Columns to write
+// @return: 1 if the file was written, 0 otherwise
+uint8_t writeArrowFile(const char *path, const t_columns *columns);
+
+#endif // ARROW_hpp
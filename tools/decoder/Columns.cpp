@@ -0,0 +1,291 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file gathers the decoded readings into typed columns, one
+    array per field, so the writers hand them over as they are and
+    no object is built per row. Sensors, channels and units are
+    stored once in dictionaries, the rows only keep their index.
+    Names come from the schema frames, or from this build for the
+    channels no schema described.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the column store
+#include "Columns.hpp"
+
+// malloc(), realloc() and free() for the columns
+#include <stdlib.h>
+
+// strcmp(), strlen() and memset() for the dictionaries
+#include <string.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Doubles the rows allocated to every column
+// @param columns: Columns to grow
+// @return: 1 if the memory could be allocated, 0 otherwise
+static uint8_t growColumns(t_columns *columns);
+
+// Returns the index of a sensor, adding it to the dictionary if new
+// @param columns: Columns being filled
+// @param name: Name of the sensor
+// @return: Index of the sensor, -1 if the dictionary is full
+static int8_t findSensor(t_columns *columns, const char *name);
+
+// Copies a label of this build without its trailing ':'
+// @param text: Destination of FRAME_TEXT_SIZE bytes
+// @param label: Label to copy
+static void copyLabel(char *text, const char *label);
+
+
+/* *****************************************************************
+    *                        SETUP FUNCTIONS                      *
+   ***************************************************************** */
+
+// Prepares empty columns, the dictionaries named after this build
+// @param columns: Columns to prepare
+// @return: 1 if the columns could be allocated, 0 otherwise
+uint8_t initColumns(t_columns *columns)
+{
+    memset(columns, 0, sizeof(*columns));
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        copyLabel(columns->names[ch], getChannelName((e_channel)ch));
+        copyLabel(columns->units[ch], getChannelUnit((e_channel)ch));
+    }
+
+    return growColumns(columns);
+}
+
+// Releases the memory of the columns
+// @param columns: Columns to release
+void freeColumns(t_columns *columns)
+{
+    free(columns->timeUs);
+    free(columns->node);
+    free(columns->seq);
+    free(columns->flags);
+    free(columns->sensor);
+    free(columns->channel);
+    free(columns->value);
+
+    memset(columns, 0, sizeof(*columns));
+}
+
+
+/* *****************************************************************
+    *                      DICTIONARY FUNCTIONS                   *
+   ***************************************************************** */
+
+// Takes the names of a schema frame into the dictionaries
+// @param columns: Columns being filled
+// @param schema: Decoded schema frame
+// @param sensorOf: Array of CH_COUNT entries receiving the sensor index of each channel
+// @return: 1 if the sensors fit in the dictionary, 0 otherwise
+uint8_t addColumnsSchema(t_columns *columns, const t_frameSchema *schema, int8_t *sensorOf)
+{
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!(schema->channelMask & (1UL << ch)))
+        {
+            continue;
+        }
+
+        // The first schema naming a channel is kept, the columns hold a
+        // single name per channel
+        if (!(columns->describedMask & (1UL << ch)))
+        {
+            strcpy(columns->names[ch], schema->name[ch]);
+            strcpy(columns->units[ch], schema->unit[ch]);
+            columns->describedMask |= 1UL << ch;
+        }
+
+        sensorOf[ch] = findSensor(columns, schema->sensors[schema->sensor[ch]]);
+        if (sensorOf[ch] < 0)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Fills the sensor index of each channel with the sensors of this build,
+// for streams without a schema frame
+// @param columns: Columns being filled
+// @param sensorOf: Array of CH_COUNT entries receiving the sensor index of each channel
+void getDefaultSensors(t_columns *columns, int8_t *sensorOf)
+{
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        sensorOf[ch] = findSensor(columns, getChannelSource((e_channel)ch));
+    }
+}
+
+
+/* *****************************************************************
+    *                         ROW FUNCTIONS                       *
+   ***************************************************************** */
+
+// Appends the valid readings of a sample set, one row each
+// @param columns: Columns being filled
+// @param header: Header of the frame carrying the sample set
+// @param set: Sample set, times in the frame time base
+// @param sensorOf: Sensor index of each channel, from addColumnsSchema()
+// @return: 1 if the rows could be stored, 0 if memory ran out
+uint8_t addColumnsSamples(t_columns *columns, const t_frameHeader *header, const t_sampleSet *set,
+                          const int8_t *sensorOf)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Row being written
+    size_t row;
+
+    /* -------------------- ROWS -------------------- */
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (!isSampleValid(set, (e_channel)ch))
+        {
+            continue;
+        }
+
+        if (columns->rows == columns->capacity && !growColumns(columns))
+        {
+            return 0;
+        }
+
+        row = columns->rows++;
+        columns->timeUs[row] = (int64_t)set->timeUs[ch];
+        columns->node[row] = header->nodeId;
+        columns->seq[row] = header->seq;
+        columns->flags[row] = header->flags;
+        columns->sensor[row] = sensorOf[ch];
+        columns->channel[row] = (int8_t)ch;
+        columns->value[row] = set->value[ch];
+    }
+
+    return 1;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Doubles the rows allocated to every column
+static uint8_t growColumns(t_columns *columns)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // New number of rows
+    size_t capacity = columns->capacity ? columns->capacity * 2 : COLUMNS_INITIAL_ROWS;
+
+    // Columns reallocated, kept apart so a failure leaves the old ones valid
+    void *timeUs, *node, *seq, *flags, *sensor, *channel, *value;
+
+    /* -------------------- ALLOCATION -------------------- */
+
+    timeUs = realloc(columns->timeUs, capacity * sizeof(*columns->timeUs));
+    if (timeUs)
+    {
+        columns->timeUs = (int64_t *)timeUs;
+    }
+
+    node = realloc(columns->node, capacity * sizeof(*columns->node));
+    if (node)
+    {
+        columns->node = (uint16_t *)node;
+    }
+
+    seq = realloc(columns->seq, capacity * sizeof(*columns->seq));
+    if (seq)
+    {
+        columns->seq = (uint16_t *)seq;
+    }
+
+    flags = realloc(columns->flags, capacity * sizeof(*columns->flags));
+    if (flags)
+    {
+        columns->flags = (uint8_t *)flags;
+    }
+
+    sensor = realloc(columns->sensor, capacity * sizeof(*columns->sensor));
+    if (sensor)
+    {
+        columns->sensor = (int8_t *)sensor;
+    }
+
+    channel = realloc(columns->channel, capacity * sizeof(*columns->channel));
+    if (channel)
+    {
+        columns->channel = (int8_t *)channel;
+    }
+
+    value = realloc(columns->value, capacity * sizeof(*columns->value));
+    if (value)
+    {
+        columns->value = (int32_t *)value;
+    }
+
+    if (!timeUs || !node || !seq || !flags || !sensor || !channel || !value)
+    {
+        return 0;
+    }
+
+    columns->capacity = capacity;
+    return 1;
+}
+
+// Returns the index of a sensor, adding it to the dictionary if new
+static int8_t findSensor(t_columns *columns, const char *name)
+{
+    for (uint8_t i = 0; i < columns->sensorCount; i++)
+    {
+        if (strcmp(columns->sensors[i], name) == 0)
+        {
+            return (int8_t)i;
+        }
+    }
+
+    if (columns->sensorCount == COLUMNS_MAX_SENSORS || strlen(name) >= FRAME_TEXT_SIZE)
+    {
+        return -1;
+    }
+
+    strcpy(columns->sensors[columns->sensorCount], name);
+    return (int8_t)columns->sensorCount++;
+}
+
+// Copies a label of this build without its trailing ':'
+static void copyLabel(char *text, const char *label)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Length of the label, the ':' of the text output excluded
+    size_t length = strlen(label);
+
+    /* -------------------- COPY -------------------- */
+
+    if (length > 0 && label[length - 1] == ':')
+    {
+        length--;
+    }
+
+    if (length >= FRAME_TEXT_SIZE)
+    {
+        length = FRAME_TEXT_SIZE - 1;
+    }
+
+    memcpy(text, label, length);
+    text[length] = '\0';
+}
@@ -0,0 +1,97 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef COLUMNS_hpp
+#define COLUMNS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types and sizes
+#include <stdint.h>
+#include <stddef.h>
+
+// Frames, schemas and channels of the firmware
+#include "../../src/protocols/Frame.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Rows allocated at first, doubled whenever the columns are full
+#define COLUMNS_INITIAL_ROWS 4096
+
+// Distinct sensor names kept in the dictionary
+#define COLUMNS_MAX_SENSORS 64
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// One row per reading, each field in its own typed column
+typedef struct
+{
+    // Rows stored and allocated
+    size_t rows;
+    size_t capacity;
+
+    // Capture time of the reading, in the time base of its frame
+    int64_t *timeUs;
+
+    // Sender, sequence number and flags (FRAME_FLAG_x) of the frame
+    uint16_t *node;
+    uint16_t *seq;
+    uint8_t *flags;
+
+    // Indexes in the sensor and channel dictionaries, the unit of a
+    // reading is that of its channel
+    int8_t *sensor;
+    int8_t *channel;
+
+    // Reading in the unit of its channel
+    int32_t *value;
+
+    // Sensor dictionary, shared by every input
+    uint8_t sensorCount;
+    char sensors[COLUMNS_MAX_SENSORS][FRAME_TEXT_SIZE];
+
+    // Channel and unit dictionaries, indexed by channel (e_channel)
+    char names[CH_COUNT][FRAME_TEXT_SIZE];
+    char units[CH_COUNT][FRAME_TEXT_SIZE];
+
+    // Channels named by a schema frame, the others by this build
+    uint32_t describedMask;
+
+} t_columns;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Prepares empty columns, the dictionaries named after this build
+// @param columns: Columns to prepare
+// @return: 1 if the columns could be allocated, 0 otherwise
+uint8_t initColumns(t_columns *columns);
+
+// Releases the memory of the columns
+// @param columns: Columns to release
+void freeColumns(t_columns *columns);
+
+// Takes the names of a schema frame into the dictionaries
+// @param columns: Columns being filled
+// @param schema: Decoded schema frame
+// @param sensorOf: Array of CH_COUNT entries receiving the sensor index of each channel
+// @return: 1 if the sensors fit in the dictionary, 0 otherwise
+uint8_t addColumnsSchema(t_columns *columns, const t_frameSchema *schema, int8_t *sensorOf);
+
+// Appends the valid readings of a sample set, one row each
+// @param columns: Columns being filled
+// @param header: Header of the frame carrying the sample set
+// @param set: Sample set, times in the frame time base
+// @param sensorOf: Sensor index of each channel, from addColumnsSchema()
+// @return: 1 if the rows could be stored, 0 if memory ran out
+uint8_t addColumnsSamples(t_columns *columns, const t_frameHeader *header, const t_sampleSet *set,
+                          const int8_t *sensorOf);
+
+// Fills the sensor index of each channel with the sensors of this build,
+// for streams without a schema frame
+// @param columns: Columns being filled
+// @param sensorOf: Array of CH_COUNT entries receiving the sensor index of each channel
+void getDefaultSensors(t_columns *columns, int8_t *sensorOf);
+
+#endif // COLUMNS_hpp
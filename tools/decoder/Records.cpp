@@ -0,0 +1,220 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file walks the records of a session file, or of a device
+    file written by the ingest server, and decodes each frame into
+    the columns with the frame decoders of the firmware. Schema
+    frames name the channels and their sensors, sample and batch
+    frames add rows, packed frames hold more records. A damaged
+    record is counted and skipped, and an incomplete last record is
+    left for the next block so a growing file can be followed.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the record decoder
+#include "Records.hpp"
+
+// malloc() and free() for the unpacked records
+#include <stdlib.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Decodes one frame into the columns
+// @param stream: Stream the frame belongs to
+// @param frame: Frame of the record
+// @param length: Length of the frame
+// @param columns: Columns receiving the readings
+// @return: 1 if the frame was decoded, 0 if it was refused
+static uint8_t decodeFrame(t_recordStream *stream, const uint8_t *frame, uint16_t length,
+                           t_columns *columns);
+
+
+/* *****************************************************************
+    *                       STREAM FUNCTIONS                      *
+   ***************************************************************** */
+
+// Starts a stream, its channels named after this build until a schema
+// frame arrives
+// @param stream: Stream to start
+// @param columns: Columns the stream is decoded into
+void initRecordStream(t_recordStream *stream, t_columns *columns)
+{
+    for (uint8_t i = 0; i <= FRAME_TYPE_PARITY; i++)
+    {
+        stream->frames[i] = 0;
+    }
+
+    stream->rejected = 0;
+    stream->outOfMemory = 0;
+
+    getDefaultSensors(columns, stream->sensorOf);
+}
+
+// Decodes the complete records of a block into the columns
+// @param stream: Stream the block belongs to
+// @param data: Records, the last one possibly incomplete
+// @param length: Length of the block
+// @param columns: Columns receiving the readings
+// @return: Bytes of complete records used, the rest waits for more data
+size_t decodeRecords(t_recordStream *stream, const uint8_t *data, size_t length,
+                     t_columns *columns)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Start of the record being read
+    size_t position = 0;
+
+    // Frame of the record
+    size_t frameStart;
+    uint16_t frameLength;
+
+    /* -------------------- RECORDS -------------------- */
+
+    while (position < length && !stream->outOfMemory)
+    {
+        if (data[position] != RECORDS_LONG_RECORD)
+        {
+            frameStart = position + 1;
+            frameLength = data[position];
+        }
+
+        else if (position + 3 <= length)
+        {
+            frameStart = position + 3;
+            frameLength = data[position + 1] | ((uint16_t)data[position + 2] << 8);
+        }
+
+        else
+        {
+            break;
+        }
+
+        if (frameStart + frameLength > length)
+        {
+            break;
+        }
+
+        if (!decodeFrame(stream, data + frameStart, frameLength, columns))
+        {
+            stream->rejected++;
+        }
+
+        position = frameStart + frameLength;
+    }
+
+    return position;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Decodes one frame into the columns
+static uint8_t decodeFrame(t_recordStream *stream, const uint8_t *frame, uint16_t length,
+                           t_columns *columns)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Decoded header, schema and samples
+    t_frameHeader header;
+    t_frameSchema schema;
+    t_sampleSet sets[FRAME_BATCH_MAX_SAMPLES];
+    uint64_t timesUs[FRAME_BATCH_MAX_SAMPLES];
+    uint8_t count = 0;
+
+    // Records of a packed frame
+    uint8_t *unpacked;
+    uint16_t unpackedLength;
+
+    /* -------------------- DISPATCH -------------------- */
+
+    if (length < FRAME_HEADER_SIZE + FRAME_CRC_SIZE)
+    {
+        return 0;
+    }
+
+    switch (frame[2])
+    {
+    case FRAME_TYPE_SAMPLES:
+        count = (length <= UINT8_MAX && decodeSampleFrame(frame, (uint8_t)length, &header, sets));
+        break;
+
+    case FRAME_TYPE_BATCH:
+        count = decodeSampleBatch(frame, length, &header, sets, timesUs, FRAME_BATCH_MAX_SAMPLES);
+        break;
+
+    case FRAME_TYPE_SCHEMA:
+        if (length > UINT8_MAX || !decodeSchemaFrame(frame, (uint8_t)length, &header, &schema))
+        {
+            return 0;
+        }
+
+        // A dictionary full of sensors leaves the channels on the build names
+        if (!addColumnsSchema(columns, &schema, stream->sensorOf))
+        {
+            getDefaultSensors(columns, stream->sensorOf);
+            return 0;
+        }
+
+        stream->frames[FRAME_TYPE_SCHEMA]++;
+        return 1;
+
+    case FRAME_TYPE_PACKED:
+        unpacked = (uint8_t *)malloc(RECORDS_MAX_FRAME);
+        if (!unpacked)
+        {
+            stream->outOfMemory = 1;
+            return 0;
+        }
+
+        // The records of a packed frame must all be complete
+        unpackedLength = decodePackedFrame(frame, length, &header, unpacked, RECORDS_MAX_FRAME);
+        count = (unpackedLength &&
+                 decodeRecords(stream, unpacked, unpackedLength, columns) == unpackedLength);
+
+        free(unpacked);
+
+        if (count)
+        {
+            stream->frames[FRAME_TYPE_PACKED]++;
+        }
+
+        return count;
+
+    case FRAME_TYPE_PARITY:
+        // Only useful on the radio link, where a frame can be lost
+        stream->frames[FRAME_TYPE_PARITY]++;
+        return 1;
+
+    default:
+        return 0;
+    }
+
+    /* -------------------- ROWS -------------------- */
+
+    if (!count)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (!addColumnsSamples(columns, &header, &sets[i], stream->sensorOf))
+        {
+            stream->outOfMemory = 1;
+            return 0;
+        }
+    }
+
+    stream->frames[header.type]++;
+    return 1;
+}
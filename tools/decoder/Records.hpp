@@ -0,0 +1,63 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef RECORDS_hpp
+#define RECORDS_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types and sizes
+#include <stdint.h>
+#include <stddef.h>
+
+// Columns receiving the readings
+#include "Columns.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Records are a frame preceded by its length on one byte, as the
+// recorder writes them. A zero length introduces a frame of up to 64 kB
+// whose length follows on 2 bytes: a packed frame holding records, or a
+// batch too long for one byte
+#define RECORDS_LONG_RECORD 0
+
+// Largest frame and largest block of records a packed frame unpacks to
+#define RECORDS_MAX_FRAME 65535
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Decoding state of one stream of records
+typedef struct
+{
+    // Sensor index of each channel, from the last schema frame
+    int8_t sensorOf[CH_COUNT];
+
+    // Frames decoded by type (FRAME_TYPE_x) and records refused
+    uint32_t frames[FRAME_TYPE_PARITY + 1];
+    uint32_t rejected;
+
+    // Set once the columns could not grow, the rest is not decoded
+    uint8_t outOfMemory;
+
+} t_recordStream;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Starts a stream, its channels named after this build until a schema
+// frame arrives
+// @param stream: Stream to start
+// @param columns: Columns the stream is decoded into
+void initRecordStream(t_recordStream *stream, t_columns *columns);
+
+// Decodes the complete records of a block into the columns
+// @param stream: Stream the block belongs to
+// @param data: Records, the last one possibly incomplete
+// @param length: Length of the block
+// @param columns: Columns receiving the readings
+// @return: Bytes of complete records used, the rest waits for more data
+size_t decodeRecords(t_recordStream *stream, const uint8_t *data, size_t length,
+                     t_columns *columns);
+
+#endif // RECORDS_hpp
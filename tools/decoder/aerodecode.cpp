@@ -0,0 +1,180 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file is the host decoder of the recorded sessions and of
+    the device files of the ingest server. Every input is decoded
+    into the same columns, one row per reading, written as an Arrow
+    IPC file that pandas, pyarrow and DuckDB load directly:
+
+        aerodecode -o flight.arrow 00042.bin 00043.bin
+
+    Arrow rather than Parquet: the columns are written as they are
+    stored, without the encoding pages of Parquet, and the files
+    convert to Parquet in one pyarrow or DuckDB call when needed.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Columns, records and the Arrow writer
+#include "Columns.hpp"
+#include "Records.hpp"
+#include "Arrow.hpp"
+
+// fopen(), fread() and fprintf() for the inputs and the report
+#include <stdio.h>
+
+// malloc() and free() for the input files
+#include <stdlib.h>
+
+// strcmp() for the options
+#include <string.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Decodes a whole file into the columns
+// @param path: File of records
+// @param columns: Columns receiving the readings
+// @return: 1 if the file could be read, 0 otherwise
+static uint8_t decodeFile(const char *path, t_columns *columns);
+
+// Prints how to call the tool
+static void printUsage();
+
+
+/* *****************************************************************
+    *                         MAIN FUNCTION                       *
+   ***************************************************************** */
+
+int main(int argc, char **argv)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Output file and first input
+    const char *output = NULL;
+    int first = 1;
+
+    // Decoded readings
+    t_columns columns;
+    uint8_t ok = 1;
+
+    /* -------------------- OPTIONS -------------------- */
+
+    if (argc > 2 && strcmp(argv[1], "-o") == 0)
+    {
+        output = argv[2];
+        first = 3;
+    }
+
+    if (!output || first >= argc)
+    {
+        printUsage();
+        return 2;
+    }
+
+    /* -------------------- DECODING -------------------- */
+
+    if (!initColumns(&columns))
+    {
+        fprintf(stderr, "aerodecode: out of memory\n");
+        return 1;
+    }
+
+    for (int i = first; i < argc && ok; i++)
+    {
+        ok = decodeFile(argv[i], &columns);
+    }
+
+    if (ok && !writeArrowFile(output, &columns))
+    {
+        fprintf(stderr, "aerodecode: cannot write %s\n", output);
+        ok = 0;
+    }
+
+    if (ok)
+    {
+        fprintf(stderr, "aerodecode: %zu readings, %u sensors written to %s\n", columns.rows,
+                columns.sensorCount, output);
+    }
+
+    freeColumns(&columns);
+    return ok ? 0 : 1;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Decodes a whole file into the columns
+static uint8_t decodeFile(const char *path, t_columns *columns)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Input file and its content
+    FILE *file;
+    uint8_t *data;
+    long length;
+    size_t used;
+
+    // Decoding state, each file is a stream of its own
+    t_recordStream stream;
+
+    /* -------------------- FILE -------------------- */
+
+    file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "aerodecode: cannot open %s\n", path);
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    data = (uint8_t *)malloc(length > 0 ? length : 1);
+    if (!data || fread(data, 1, length, file) != (size_t)length)
+    {
+        fprintf(stderr, "aerodecode: cannot read %s\n", path);
+        free(data);
+        fclose(file);
+        return 0;
+    }
+
+    fclose(file);
+
+    /* -------------------- RECORDS -------------------- */
+
+    initRecordStream(&stream, columns);
+    used = decodeRecords(&stream, data, length, columns);
+    free(data);
+
+    if (stream.outOfMemory)
+    {
+        fprintf(stderr, "aerodecode: out of memory in %s\n", path);
+        return 0;
+    }
+
+    // A session cut by a power loss ends inside a record
+    fprintf(stderr,
+            "%s: %u schema, %u sample, %u batch, %u packed frames, %u refused, %zu bytes cut\n",
+            path, stream.frames[FRAME_TYPE_SCHEMA], stream.frames[FRAME_TYPE_SAMPLES],
+            stream.frames[FRAME_TYPE_BATCH], stream.frames[FRAME_TYPE_PACKED], stream.rejected,
+            (size_t)length - used);
+
+    return 1;
+}
+
+// Prints how to call the tool
+static void printUsage()
+{
+    fprintf(stderr, "usage: aerodecode -o <output.arrow> <records> [<records> ...]\n"
+                    "  <records>: session file of the recorder or device file of aeroingest\n");
+}
@@ -0,0 +1,65 @@
+"""Reads back the Arrow file of test_decoder with pyarrow.
+
+The table must hold the readings of the CSV file written next to it,
+with the column types of the decoder and dictionary encoded sensors,
+channels and units. Run with: make -C tools check
+"""
+
+import csv
+import sys
+
+import pyarrow as pa
+import pyarrow.ipc as ipc
+
+
+# Column types written by the decoder
+EXPECTED_SCHEMA = pa.schema([
+    pa.field("time", pa.timestamp("us"), nullable=False),
+    pa.field("node", pa.uint16(), nullable=False),
+    pa.field("seq", pa.uint16(), nullable=False),
+    pa.field("flags", pa.uint8(), nullable=False),
+    pa.field("sensor", pa.dictionary(pa.int8(), pa.utf8()), nullable=False),
+    pa.field("channel", pa.dictionary(pa.int8(), pa.utf8()), nullable=False),
+    pa.field("unit", pa.dictionary(pa.int8(), pa.utf8()), nullable=False),
+    pa.field("value", pa.int32(), nullable=False),
+])
+
+
+def main(directory):
+    reader = ipc.open_file(f"{directory}/test.arrow")
+    table = reader.read_all()
+    table.validate(full=True)
+
+    if not table.schema.equals(EXPECTED_SCHEMA):
+        print(f"check_arrow: unexpected schema\n{table.schema}")
+        return 1
+
+    # Readers such as pandas refuse repeated dictionary values
+    for name in ("sensor", "channel", "unit"):
+        for chunk in table.column(name).chunks:
+            values = chunk.dictionary.to_pylist()
+            if len(set(values)) != len(values):
+                print(f"check_arrow: repeated values in the {name} dictionary")
+                return 1
+
+    with open(f"{directory}/test.csv", newline="", encoding="utf-8") as file:
+        expected = list(csv.DictReader(file))
+
+    # Times compared as microseconds, like in the CSV file
+    rows = table.set_column(0, "time", table.column("time").cast(pa.int64())).to_pylist()
+    if len(rows) != len(expected):
+        print(f"check_arrow: {len(rows)} rows, {len(expected)} expected")
+        return 1
+
+    for index, (row, wanted) in enumerate(zip(rows, expected)):
+        got = {name: str(value) for name, value in row.items()}
+        if got != wanted:
+            print(f"check_arrow: row {index} is {got}, expected {wanted}")
+            return 1
+
+    print(f"check_arrow: {len(rows)} rows in {reader.num_record_batches} batches match")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1] if len(sys.argv) > 1 else "."))
@@ -0,0 +1,475 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks the host decoder: sessions encoded with the
+    frame code of the firmware, with schema, sample, packed and
+    batch records, a damaged record and a cut last record, must
+    decode to the readings they were built from. The columns are
+    then written as an Arrow file, with the expected readings in a
+    CSV file next to it, which check_arrow.py reads back with
+    pyarrow. Run with: make -C tools check
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Decoder under test
+#include "Columns.hpp"
+#include "Records.hpp"
+#include "Arrow.hpp"
+
+// Compressor of the packed records
+#include "../../src/protocols/Compress.hpp"
+
+// printf() and fopen() for the results and the CSV file
+#include <stdio.h>
+
+// malloc() and free() for the sessions
+#include <stdlib.h>
+
+// memcpy() and strcmp() for the records and the names
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Checks a condition, reporting the line of a failure
+#define CHECK(condition)                                                     \
+    do                                                                       \
+    {                                                                        \
+        if (!(condition))                                                    \
+        {                                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+// Largest session built by the tests
+#define SESSION_SIZE (1024 * 1024)
+
+// Sample records of the long session, enough for two record batches
+#define LONG_SESSION_SAMPLES 5000
+
+// Unit of the tests
+#define TEST_NODE 0x1A2B
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Reading expected in the columns
+typedef struct
+{
+    int64_t timeUs;
+    uint16_t node;
+    uint16_t seq;
+    uint8_t flags;
+    int8_t channel;
+    int32_t value;
+
+} t_expectedRow;
+
+// Session being built and the readings it holds
+typedef struct
+{
+    uint8_t *data;
+    size_t length;
+
+    t_expectedRow *rows;
+    size_t rowCount;
+
+    uint16_t seq;
+
+} t_session;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Checks failed so far
+static int failures = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Prepares an empty session
+static void startSession(t_session *session);
+
+// Adds a schema record for every channel
+static void addSchema(t_session *session);
+
+// Adds a sample record, or returns it in records when given
+static uint16_t addSample(t_session *session, const t_sampleSet *set, uint64_t timeUs,
+                          uint8_t *records);
+
+// Adds a long record holding a frame
+static void addLongRecord(t_session *session, const uint8_t *frame, uint16_t length);
+
+// Builds the sample set of a cycle
+static void buildSet(t_sampleSet *set, uint32_t cycle, uint64_t timeUs);
+
+// Checks the columns against the readings of the sessions decoded so far
+static void checkRows(const t_columns *columns, const t_session *sessions, uint8_t count);
+
+// Writes the expected readings of the sessions as CSV
+static uint8_t writeExpected(const char *path, const t_columns *columns,
+                             const t_session *sessions, uint8_t count);
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Session of every record type, a damaged record and a cut last record
+static void test_mixed_session(t_session *session, t_columns *columns)
+{
+    t_recordStream stream;
+    t_sampleSet set, sets[FRAME_BATCH_MAX_SAMPLES];
+    uint64_t timesUs[FRAME_BATCH_MAX_SAMPLES];
+    t_frameHeader header;
+    uint8_t records[1024], frame[FRAME_BATCH_MAX_SIZE];
+    uint16_t recordsLength = 0, length;
+    uint64_t timeUs = 1000000;
+    size_t damaged, cut;
+
+    startSession(session);
+    addSchema(session);
+
+    // Sample records, as recorded uncompressed
+    for (uint32_t cycle = 0; cycle < 20; cycle++, timeUs += 500000)
+    {
+        buildSet(&set, cycle, timeUs);
+        addSample(session, &set, timeUs, NULL);
+    }
+
+    // A block of records compressed into a packed record
+    for (uint32_t cycle = 20; cycle < 30; cycle++, timeUs += 500000)
+    {
+        buildSet(&set, cycle, timeUs);
+        recordsLength += addSample(session, &set, timeUs, records + recordsLength);
+    }
+
+    header.flags = 0;
+    header.nodeId = TEST_NODE;
+    header.seq = session->seq++;
+    header.timeUs = 0;
+
+    length = encodePackedFrame(records, recordsLength, &header, frame, sizeof(frame));
+    CHECK(length > 0);
+    addLongRecord(session, frame, length);
+
+    // A batch too long for a short record
+    for (uint8_t i = 0; i < FRAME_BATCH_MAX_SAMPLES; i++, timeUs += 500000)
+    {
+        buildSet(&sets[i], 30 + i, timeUs);
+        timesUs[i] = timeUs;
+    }
+
+    header.flags = FRAME_FLAG_UTC;
+    header.seq = session->seq++;
+    header.timeUs = timesUs[0];
+
+    length = encodeSampleBatch(sets, timesUs, FRAME_BATCH_MAX_SAMPLES, &header, frame,
+                               sizeof(frame));
+    CHECK(length > 255);
+    addLongRecord(session, frame, length);
+
+    for (uint8_t i = 0; i < FRAME_BATCH_MAX_SAMPLES; i++)
+    {
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+        {
+            if (isSampleValid(&sets[i], (e_channel)ch))
+            {
+                t_expectedRow *row = &session->rows[session->rowCount++];
+
+                row->timeUs = (int64_t)timesUs[i];
+                row->node = TEST_NODE;
+                row->seq = header.seq;
+                row->flags = FRAME_FLAG_UTC;
+                row->channel = (int8_t)ch;
+                row->value = sets[i].value[ch];
+            }
+        }
+    }
+
+    // A damaged record, skipped, then a record cut by a power loss
+    buildSet(&set, 40, timeUs);
+    damaged = session->length;
+    addSample(session, &set, timeUs, NULL);
+    session->data[damaged + 10] ^= 0x40;
+    session->rowCount -= __builtin_popcount(set.validMask);
+
+    cut = session->length;
+    addSample(session, &set, timeUs, NULL);
+    session->rowCount -= __builtin_popcount(set.validMask);
+    session->length -= 5;
+
+    initRecordStream(&stream, columns);
+    CHECK(decodeRecords(&stream, session->data, session->length, columns) == cut);
+    CHECK(stream.frames[FRAME_TYPE_SCHEMA] == 1);
+    CHECK(stream.frames[FRAME_TYPE_SAMPLES] == 30);
+    CHECK(stream.frames[FRAME_TYPE_PACKED] == 1);
+    CHECK(stream.frames[FRAME_TYPE_BATCH] == 1);
+    CHECK(stream.rejected == 1);
+    CHECK(!stream.outOfMemory);
+}
+
+// Session without a schema, as recorded before the schema frames
+static void test_session_without_schema(t_session *session, t_columns *columns)
+{
+    t_recordStream stream;
+    t_sampleSet set;
+    uint64_t timeUs = 90000000;
+
+    startSession(session);
+
+    for (uint32_t cycle = 0; cycle < 5; cycle++, timeUs += 500000)
+    {
+        buildSet(&set, cycle, timeUs);
+        addSample(session, &set, timeUs, NULL);
+    }
+
+    initRecordStream(&stream, columns);
+    CHECK(decodeRecords(&stream, session->data, session->length, columns) == session->length);
+    CHECK(stream.frames[FRAME_TYPE_SAMPLES] == 5);
+    CHECK(stream.rejected == 0);
+}
+
+// Long session, more rows than one record batch
+static void test_long_session(t_session *session, t_columns *columns)
+{
+    t_recordStream stream;
+    t_sampleSet set;
+    uint64_t timeUs = 200000000;
+
+    startSession(session);
+    addSchema(session);
+
+    for (uint32_t cycle = 0; cycle < LONG_SESSION_SAMPLES; cycle++, timeUs += 500000)
+    {
+        // Every channel, as on a unit fitted with every sensor
+        clearSampleSet(&set);
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+        {
+            setSampleValue(&set, (e_channel)ch, (int32_t)(cycle * (ch + 1)), timeUs - ch * 1000);
+        }
+
+        addSample(session, &set, timeUs, NULL);
+    }
+
+    initRecordStream(&stream, columns);
+    CHECK(decodeRecords(&stream, session->data, session->length, columns) == session->length);
+    CHECK(stream.frames[FRAME_TYPE_SAMPLES] == LONG_SESSION_SAMPLES);
+    CHECK(columns->rows > ARROW_BATCH_ROWS);
+}
+
+// Runs every test, the first argument is the directory of the output files
+int main(int argc, char **argv)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Sessions decoded into the same columns
+    t_session sessions[3];
+    t_columns columns;
+
+    // Output files
+    const char *directory = argc > 1 ? argv[1] : ".";
+    char arrowPath[256], csvPath[256];
+
+    /* -------------------- TESTS -------------------- */
+
+    CHECK(initColumns(&columns));
+
+    test_mixed_session(&sessions[0], &columns);
+    checkRows(&columns, sessions, 1);
+
+    test_session_without_schema(&sessions[1], &columns);
+    checkRows(&columns, sessions, 2);
+
+    test_long_session(&sessions[2], &columns);
+    checkRows(&columns, sessions, 3);
+
+    // The three sessions share one sensor dictionary
+    CHECK(columns.sensorCount == 7);
+
+    /* -------------------- OUTPUT FILES -------------------- */
+
+    snprintf(arrowPath, sizeof(arrowPath), "%s/test.arrow", directory);
+    snprintf(csvPath, sizeof(csvPath), "%s/test.csv", directory);
+
+    CHECK(writeArrowFile(arrowPath, &columns));
+    CHECK(writeExpected(csvPath, &columns, sessions, 3));
+
+    printf("test_decoder: %zu rows, %d failures\n", columns.rows, failures);
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        free(sessions[i].data);
+        free(sessions[i].rows);
+    }
+
+    freeColumns(&columns);
+    return failures ? 1 : 0;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Prepares an empty session
+static void startSession(t_session *session)
+{
+    session->data = (uint8_t *)malloc(SESSION_SIZE);
+    session->length = 0;
+    session->rows =
+        (t_expectedRow *)malloc(LONG_SESSION_SAMPLES * CH_COUNT * sizeof(t_expectedRow));
+    session->rowCount = 0;
+    session->seq = 0;
+}
+
+// Adds a schema record for every channel
+static void addSchema(t_session *session)
+{
+    t_frameHeader header;
+    uint8_t length;
+
+    header.flags = 0;
+    header.nodeId = TEST_NODE;
+    header.seq = session->seq++;
+    header.timeUs = 0;
+
+    length = encodeSchemaFrame((1UL << CH_COUNT) - 1, &header, session->data + session->length + 1,
+                               FRAME_SCHEMA_MAX_SIZE);
+    CHECK(length > 0);
+
+    session->data[session->length] = length;
+    session->length += 1 + length;
+}
+
+// Adds a sample record, or returns it in records when given
+static uint16_t addSample(t_session *session, const t_sampleSet *set, uint64_t timeUs,
+                          uint8_t *records)
+{
+    t_frameHeader header;
+    uint8_t *record = records ? records : session->data + session->length;
+    uint8_t length;
+
+    header.flags = 0;
+    header.nodeId = TEST_NODE;
+    header.seq = session->seq++;
+    header.timeUs = timeUs;
+
+    length = encodeSampleFrame(set, &header, 0, record + 1, FRAME_MAX_SIZE);
+    CHECK(length > 0);
+    record[0] = length;
+
+    if (!records)
+    {
+        session->length += 1 + length;
+    }
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (isSampleValid(set, (e_channel)ch))
+        {
+            t_expectedRow *row = &session->rows[session->rowCount++];
+
+            row->timeUs = (int64_t)set->timeUs[ch];
+            row->node = TEST_NODE;
+            row->seq = header.seq;
+            row->flags = 0;
+            row->channel = (int8_t)ch;
+            row->value = set->value[ch];
+        }
+    }
+
+    return 1 + length;
+}
+
+// Adds a long record holding a frame
+static void addLongRecord(t_session *session, const uint8_t *frame, uint16_t length)
+{
+    session->data[session->length] = RECORDS_LONG_RECORD;
+    session->data[session->length + 1] = length & 0xFF;
+    session->data[session->length + 2] = length >> 8;
+    memcpy(session->data + session->length + 3, frame, length);
+    session->length += 3 + length;
+}
+
+// Builds the sample set of a cycle
+static void buildSet(t_sampleSet *set, uint32_t cycle, uint64_t timeUs)
+{
+    clearSampleSet(set);
+
+    // Readings a few ms apart, as the sensors are read in turn
+    setSampleValue(set, CH_TEMP, 2150 + cycle % 40, timeUs - 12000);
+    setSampleValue(set, CH_PRESSURE, 101325 - cycle, timeUs - 10000);
+    setSampleValue(set, CH_CO2, 415 + cycle % 7, timeUs - 4000);
+    setSampleValue(set, CH_PM2_5, 8 + cycle % 3, timeUs - 2000);
+
+    // Negative values, and a channel missing from some cycles
+    setSampleValue(set, CH_CLIMB, -(int32_t)(cycle * 13), timeUs);
+
+    if (cycle % 4 == 0)
+    {
+        setSampleValue(set, CH_CO, 3, timeUs - 3000);
+    }
+}
+
+// Checks the columns against the readings of the sessions decoded so far
+static void checkRows(const t_columns *columns, const t_session *sessions, uint8_t count)
+{
+    size_t row = 0;
+    uint8_t mismatches = 0;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < sessions[i].rowCount && row < columns->rows; j++, row++)
+        {
+            const t_expectedRow *expected = &sessions[i].rows[j];
+
+            if (columns->timeUs[row] != expected->timeUs || columns->node[row] != expected->node ||
+                columns->seq[row] != expected->seq || columns->flags[row] != expected->flags ||
+                columns->channel[row] != expected->channel ||
+                columns->value[row] != expected->value ||
+                strcmp(columns->sensors[columns->sensor[row]],
+                       getChannelSource((e_channel)expected->channel)) != 0)
+            {
+                mismatches++;
+            }
+        }
+
+        CHECK(mismatches == 0);
+    }
+
+    CHECK(row == columns->rows);
+}
+
+// Writes the expected readings of the sessions as CSV
+static uint8_t writeExpected(const char *path, const t_columns *columns,
+                             const t_session *sessions, uint8_t count)
+{
+    FILE *file = fopen(path, "w");
+
+    if (!file)
+    {
+        return 0;
+    }
+
+    fprintf(file, "time,node,seq,flags,sensor,channel,unit,value\n");
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < sessions[i].rowCount; j++)
+        {
+            const t_expectedRow *row = &sessions[i].rows[j];
+
+            fprintf(file, "%lld,%u,%u,%u,%s,%s,%s,%ld\n", (long long)row->timeUs, row->node,
+                    row->seq, row->flags, getChannelSource((e_channel)row->channel),
+                    columns->names[row->channel], columns->units[row->channel], (long)row->value);
+        }
+    }
+
+    return fclose(file) == 0;
+}
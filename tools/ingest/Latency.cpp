@@ -0,0 +1,142 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file keeps the latencies of the ingest server in a log-linear
+    histogram: exact buckets up to 512 us, then 256 buckets for each
+    power of two. The memory stays fixed for a server running for
+    months, and unlike the P-square estimator of the firmware the
+    99.9th percentile is as precise as the median.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the latency histogram
+#include "Latency.hpp"
+
+// memset() for the buckets
+#include <string.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Returns the bucket of a latency
+static uint32_t getBucket(uint64_t us);
+
+// Returns the highest latency of a bucket
+static uint64_t getBucketTop(uint32_t bucket);
+
+
+/* *****************************************************************
+    *                     HISTOGRAM FUNCTIONS                     *
+   ***************************************************************** */
+
+// Empties a latency histogram
+// @param latency: Histogram to empty
+void initLatency(t_latency *latency)
+{
+    memset(latency, 0, sizeof(*latency));
+}
+
+// Counts a latency
+// @param latency: Histogram to update
+// @param us: Latency in microseconds
+void addLatency(t_latency *latency, uint64_t us)
+{
+    if (us > LATENCY_MAX_US)
+    {
+        us = LATENCY_MAX_US;
+    }
+
+    latency->bucket[getBucket(us)]++;
+    latency->count++;
+    latency->sumUs += us;
+
+    if (us > latency->maxUs)
+    {
+        latency->maxUs = us;
+    }
+}
+
+// Returns a percentile of the latencies counted
+// @param latency: Histogram to query
+// @param p: Percentile between 0 and 1
+// @return: Highest latency of the bucket holding the percentile, in us
+uint64_t getLatencyPercentile(const t_latency *latency, double p)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Rank of the percentile among the latencies, from 1
+    uint64_t rank = (uint64_t)(p * latency->count + 0.999999);
+
+    // Latencies in the buckets walked so far
+    uint64_t seen = 0;
+
+    /* -------------------- WALK -------------------- */
+
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += latency->bucket[i];
+
+        if (seen >= rank)
+        {
+            return getBucketTop(i) < latency->maxUs ? getBucketTop(i) : latency->maxUs;
+        }
+    }
+
+    return latency->maxUs;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Returns the bucket of a latency
+static uint32_t getBucket(uint64_t us)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bits dropped from the latency, 0 below 1 << LATENCY_SUB_BITS
+    uint32_t shift = 0;
+
+    /* -------------------- BUCKET -------------------- */
+
+    if (us >> LATENCY_SUB_BITS)
+    {
+        shift = (63 - __builtin_clzll(us)) - LATENCY_SUB_BITS + 1;
+    }
+
+    // us >> shift is in [256, 512) once shifted, right after the
+    // buckets of the power of two below
+    return (shift << (LATENCY_SUB_BITS - 1)) + (uint32_t)(us >> shift);
+}
+
+// Returns the highest latency of a bucket
+static uint64_t getBucketTop(uint32_t bucket)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bits dropped from the latencies of the bucket
+    uint32_t shift = 0;
+
+    /* -------------------- LATENCY -------------------- */
+
+    if (bucket >> LATENCY_SUB_BITS)
+    {
+        shift = (bucket >> (LATENCY_SUB_BITS - 1)) - 1;
+    }
+
+    return ((uint64_t)(bucket - (shift << (LATENCY_SUB_BITS - 1))) << shift) + (1ULL << shift) -
+           1;
+}
@@ -0,0 +1,56 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef LATENCY_hpp
+#define LATENCY_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types
+#include <stdint.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Buckets per power of two are 1 << (LATENCY_SUB_BITS - 1), a latency
+// is known within 0.4%, exactly below 1 << LATENCY_SUB_BITS us
+#define LATENCY_SUB_BITS 9
+
+// Longest latency told apart, in us (71 minutes)
+#define LATENCY_MAX_US 0xFFFFFFFFULL
+
+// Buckets covering 0 to LATENCY_MAX_US
+#define LATENCY_BUCKETS ((32 - LATENCY_SUB_BITS + 2) << (LATENCY_SUB_BITS - 1))
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Latencies counted in log-linear buckets, the tail percentiles stay
+// exact to the bucket whatever the number of latencies
+typedef struct
+{
+    uint64_t count;
+    uint64_t sumUs;
+    uint64_t maxUs;
+    uint32_t bucket[LATENCY_BUCKETS];
+
+} t_latency;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Empties a latency histogram
+// @param latency: Histogram to empty
+void initLatency(t_latency *latency);
+
+// Counts a latency
+// @param latency: Histogram to update
+// @param us: Latency in microseconds
+void addLatency(t_latency *latency, uint64_t us);
+
+// Returns a percentile of the latencies counted
+// @param latency: Histogram to query
+// @param p: Percentile between 0 and 1
+// @return: Highest latency of the bucket holding the percentile, in us
+uint64_t getLatencyPercentile(const t_latency *latency, double p);
+
+#endif // LATENCY_hpp
@@ -0,0 +1,393 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file simulates units for the load test of the ingest server.
+    Each unit sends a hello line, then measurements laid out as those
+    of sendAllSensors(): a time section, one section per sensor with
+    its capture time and readings, and the line ending the
+    measurement. Part of the units talk over ptys, which the server
+    opens like RFCOMM device nodes, the others over TCP.
+
+    The measurements of a unit are due at a fixed rate, the units
+    spread over the period. A measurement carries its due time, not
+    the time it could be written, so a server too slow to read still
+    shows in the latencies instead of slowing the load down unseen.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the simulated units
+#include "Simulator.hpp"
+
+// Labels, units and sensors of the channels
+#include "../../src/processing/Channels.hpp"
+
+// posix_openpt(), grantpt(), unlockpt() and ptsname_r() for the ptys
+#include <stdlib.h>
+#include <fcntl.h>
+
+// socket(), connect() and TCP_NODELAY for the TCP units
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// write() and close() for the connections
+#include <unistd.h>
+
+// clock_gettime() and clock_nanosleep() for the rate
+#include <time.h>
+
+// errno for the interrupted writes
+#include <errno.h>
+
+// snprintf() for the measurements
+#include <stdio.h>
+
+// strcmp() and memset() for the sections
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Typical value of each channel, in its unit
+static const int32_t baseValues[CH_COUNT] = {2150, 45, 1013, 100, 415, 2,   1,    0,
+                                             0,    3,  5,    8,   10,  12000, 0};
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Sends the measurements of every unit, body of the thread
+static void *runUnits(void *argument);
+
+// Lays out a measurement of a unit
+// @return: Length of the text
+static int buildMeasurement(t_simulator *simulator, uint16_t unit, uint64_t timeUs, char *text);
+
+// Writes a text whole, retrying after interruptions
+// @return: 1 if every byte was written, 0 otherwise
+static uint8_t writeText(int fd, const char *text, int length);
+
+// Returns the next value of the generator of a unit (xorshift)
+static uint32_t getRandom(uint32_t *state);
+
+// Returns the monotonic host time, the clock of the simulated units
+static uint64_t getMonotonicUs();
+
+
+/* *****************************************************************
+    *                        SETUP FUNCTIONS                      *
+   ***************************************************************** */
+
+// Opens the connections of the units, before the server reads them
+// @param simulator: Simulator to prepare
+// @param unitCount: Number of units, at most SIMULATOR_MAX_UNITS
+// @param ptyCount: Units over ptys, the others connect to the port
+// @param port: TCP port of the server on the loopback address
+// @param rateHz: Measurements per second of each unit
+// @param seconds: Duration of the load
+// @return: 1 if every connection is open, 0 otherwise
+uint8_t initSimulator(t_simulator *simulator, uint16_t unitCount, uint16_t ptyCount,
+                      uint16_t port, uint32_t rateHz, uint32_t seconds)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Address of the server
+    struct sockaddr_in address;
+    int option = 1;
+
+    /* -------------------- SETTINGS -------------------- */
+
+    memset(simulator, 0, sizeof(*simulator));
+
+    if (unitCount > SIMULATOR_MAX_UNITS || ptyCount > unitCount || rateHz == 0)
+    {
+        return 0;
+    }
+
+    simulator->unitCount = unitCount;
+    simulator->ptyCount = ptyCount;
+    simulator->rateHz = rateHz;
+    simulator->rounds = rateHz * seconds;
+
+    for (uint16_t i = 0; i < SIMULATOR_MAX_UNITS; i++)
+    {
+        simulator->fd[i] = -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    /* -------------------- CONNECTIONS -------------------- */
+
+    for (uint16_t i = 0; i < unitCount; i++)
+    {
+        simulator->random[i] = 0x9E3779B9u ^ ((uint32_t)i * 2654435761u);
+
+        if (i < ptyCount)
+        {
+            simulator->fd[i] = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+            if (simulator->fd[i] < 0 || grantpt(simulator->fd[i]) != 0 ||
+                unlockpt(simulator->fd[i]) != 0 ||
+                ptsname_r(simulator->fd[i], simulator->path[i], SIMULATOR_PATH_SIZE) != 0)
+            {
+                return 0;
+            }
+        }
+
+        else
+        {
+            // Connected before the server accepts, the listen backlog
+            // holds them
+            simulator->fd[i] = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (simulator->fd[i] < 0 ||
+                connect(simulator->fd[i], (struct sockaddr *)&address, sizeof(address)) != 0)
+            {
+                return 0;
+            }
+
+            // Each measurement is one write, sent at once
+            setsockopt(simulator->fd[i], IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+        }
+    }
+
+    return 1;
+}
+
+// Starts sending the measurements, from a thread of their own. The unit
+// clock is the monotonic host clock, so the server can tell the latency
+// of each measurement from its time reference line
+// @param simulator: Simulator ready to start
+// @return: 1 if the thread started, 0 otherwise
+uint8_t startSimulator(t_simulator *simulator)
+{
+    simulator->startUs = getMonotonicUs();
+    simulator->started = (pthread_create(&simulator->thread, NULL, runUnits, simulator) == 0);
+
+    return simulator->started;
+}
+
+// Tells whether every measurement was sent, the counters are final then
+// @param simulator: Simulator to query
+// @return: 1 once the thread is done, 0 before
+uint8_t isSimulatorFinished(t_simulator *simulator)
+{
+    return __atomic_load_n(&simulator->finished, __ATOMIC_ACQUIRE);
+}
+
+// Waits for the thread and closes the connections of the units
+// @param simulator: Simulator to stop
+void freeSimulator(t_simulator *simulator)
+{
+    if (simulator->started)
+    {
+        pthread_join(simulator->thread, NULL);
+        simulator->started = 0;
+    }
+
+    for (uint16_t i = 0; i < simulator->unitCount; i++)
+    {
+        if (simulator->fd[i] >= 0)
+        {
+            close(simulator->fd[i]);
+            simulator->fd[i] = -1;
+        }
+    }
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Sends the measurements of every unit, body of the thread
+static void *runUnits(void *argument)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Simulator and the period of a unit
+    t_simulator *simulator = (t_simulator *)argument;
+    uint64_t periodUs = 1000000ULL / simulator->rateHz;
+
+    // Measurement being sent and its due time
+    char text[SIMULATOR_BLOCK_SIZE];
+    int length;
+    uint64_t dueUs;
+    struct timespec due;
+
+    /* -------------------- HELLO LINES -------------------- */
+
+    for (uint16_t i = 0; i < simulator->unitCount; i++)
+    {
+        length = snprintf(text, sizeof(text),
+                          "HELLO:AeroSense-%04X,node=%04X,profile=drone,frame=1,build=load test,"
+                          "conn=1,time=%llu\r\n",
+                          SIMULATOR_FIRST_NODE + i, SIMULATOR_FIRST_NODE + i,
+                          (unsigned long long)getMonotonicUs());
+
+        if (!writeText(simulator->fd[i], text, length))
+        {
+            simulator->failures++;
+        }
+    }
+
+    /* -------------------- MEASUREMENTS -------------------- */
+
+    for (uint32_t round = 0; round < simulator->rounds; round++)
+    {
+        for (uint16_t i = 0; i < simulator->unitCount; i++)
+        {
+            dueUs = simulator->startUs + round * periodUs + i * periodUs / simulator->unitCount;
+
+            due.tv_sec = dueUs / 1000000;
+            due.tv_nsec = (dueUs % 1000000) * 1000;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+            {
+            }
+
+            length = buildMeasurement(simulator, i, dueUs, text);
+
+            if (writeText(simulator->fd[i], text, length))
+            {
+                simulator->sets++;
+                simulator->bytes += length;
+            }
+
+            else
+            {
+                simulator->failures++;
+            }
+        }
+    }
+
+    __atomic_store_n(&simulator->finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Lays out a measurement of a unit
+static int buildMeasurement(t_simulator *simulator, uint16_t unit, uint64_t timeUs, char *text)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Divider of the sections, as sent by sendSectionHeader()
+    const char divider[] = "------------------------------";
+
+    // Length of the text and sensor of the section being laid out
+    int length;
+    const char *sensor;
+    int32_t value;
+
+    /* -------------------- TIME -------------------- */
+
+    length = snprintf(text, SIMULATOR_BLOCK_SIZE,
+                      "\r\n%s\r\nTIME\r\n%s\r\nLocal:%llu\r\nUTC:UNSYNCED\r\nSync:NONE\r\n\r\n",
+                      divider, divider, (unsigned long long)timeUs);
+
+    /* -------------------- SENSORS -------------------- */
+
+    // One section per sensor, its channels in the order of the channels
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        sensor = getChannelSource((e_channel)ch);
+
+        // The section was laid out with the first channel of the sensor
+        for (uint8_t i = 0; i < ch; i++)
+        {
+            if (strcmp(sensor, getChannelSource((e_channel)i)) == 0)
+            {
+                sensor = NULL;
+                break;
+            }
+        }
+
+        if (!sensor)
+        {
+            continue;
+        }
+
+        length += snprintf(text + length, SIMULATOR_BLOCK_SIZE - length,
+                           "\r\n%s\r\n%s SENSOR\r\n%s\r\nTime:%llu\r\n", divider, sensor, divider,
+                           (unsigned long long)timeUs);
+
+        for (uint8_t i = ch; i < CH_COUNT; i++)
+        {
+            if (strcmp(sensor, getChannelSource((e_channel)i)) != 0)
+            {
+                continue;
+            }
+
+            value = baseValues[i] + (int32_t)(getRandom(&simulator->random[unit]) % 11) - 5;
+            length += snprintf(text + length, SIMULATOR_BLOCK_SIZE - length, "%s%ld%s\r\n",
+                               getChannelName((e_channel)i), (long)value,
+                               getChannelUnit((e_channel)i));
+        }
+    }
+
+    /* -------------------- END -------------------- */
+
+    length += snprintf(text + length, SIMULATOR_BLOCK_SIZE - length,
+                       "HEALTH:0\r\n\r\n\r\n%s\r\nEND OF MEASUREMENT\r\n%s\r\n", divider, divider);
+
+    return length;
+}
+
+// Writes a text whole, retrying after interruptions
+static uint8_t writeText(int fd, const char *text, int length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bytes written by a call
+    ssize_t written;
+
+    /* -------------------- WRITES -------------------- */
+
+    while (length > 0)
+    {
+        written = write(fd, text, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0)
+        {
+            return 0;
+        }
+
+        text += written;
+        length -= written;
+    }
+
+    return 1;
+}
+
+// Returns the next value of the generator of a unit (xorshift)
+static uint32_t getRandom(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+
+// Returns the monotonic host time, the clock of the simulated units
+static uint64_t getMonotonicUs()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of the clock
+    struct timespec now;
+
+    /* -------------------- TIME -------------------- */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,96 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef SIMULATOR_hpp
+#define SIMULATOR_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types
+#include <stdint.h>
+
+// pthread_t for the thread of the units
+#include <pthread.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Most units simulated at once
+#define SIMULATOR_MAX_UNITS 4096
+
+// First node identifier of the simulated units
+#define SIMULATOR_FIRST_NODE 0x1000
+
+// Longest pty path, e.g. "/dev/pts/123"
+#define SIMULATOR_PATH_SIZE 32
+
+// Longest text of one measurement
+#define SIMULATOR_BLOCK_SIZE 2048
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Units sending measurements to the ingest server, over ptys standing
+// for their RFCOMM ports or over TCP connections
+typedef struct
+{
+    // Units, the first ptyCount over ptys, the others over TCP
+    uint16_t unitCount;
+    uint16_t ptyCount;
+
+    // Measurements per second of each unit, and number of each unit
+    uint32_t rateHz;
+    uint32_t rounds;
+
+    // Unit end of each connection: pty master or TCP socket, and the
+    // pty the server opens as if it were a device node
+    int fd[SIMULATOR_MAX_UNITS];
+    char path[SIMULATOR_MAX_UNITS][SIMULATOR_PATH_SIZE];
+
+    // State of the value generator of each unit
+    uint32_t random[SIMULATOR_MAX_UNITS];
+
+    // Thread of the units, set once it sent every measurement
+    pthread_t thread;
+    uint8_t started;
+    uint8_t finished;
+
+    // Monotonic time of the first measurement, measurements and bytes
+    // sent, failed writes
+    uint64_t startUs;
+    uint64_t sets;
+    uint64_t bytes;
+    uint32_t failures;
+
+} t_simulator;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Opens the connections of the units, before the server reads them
+// @param simulator: Simulator to prepare
+// @param unitCount: Number of units, at most SIMULATOR_MAX_UNITS
+// @param ptyCount: Units over ptys, the others connect to the port
+// @param port: TCP port of the server on the loopback address
+// @param rateHz: Measurements per second of each unit
+// @param seconds: Duration of the load
+// @return: 1 if every connection is open, 0 otherwise
+uint8_t initSimulator(t_simulator *simulator, uint16_t unitCount, uint16_t ptyCount,
+                      uint16_t port, uint32_t rateHz, uint32_t seconds);
+
+// Starts sending the measurements, from a thread of their own. The unit
+// clock is the monotonic host clock, so the server can tell the latency
+// of each measurement from its time reference line
+// @param simulator: Simulator ready to start
+// @return: 1 if the thread started, 0 otherwise
+uint8_t startSimulator(t_simulator *simulator);
+
+// Tells whether every measurement was sent, the counters are final then
+// @param simulator: Simulator to query
+// @return: 1 once the thread is done, 0 before
+uint8_t isSimulatorFinished(t_simulator *simulator);
+
+// Waits for the thread and closes the connections of the units
+// @param simulator: Simulator to stop
+void freeSimulator(t_simulator *simulator);
+
+#endif // SIMULATOR_hpp
@@ -0,0 +1,620 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file stores the sample sets of each unit in a file of its
+    own, "<directory>/<node>.bin", in the record format of the session
+    files of the recorder: a schema frame, then sample frames, packed
+    in blocks when that makes them smaller. aerodecode reads them as
+    it reads the sessions.
+
+    Records wait in memory for a group commit: every unit with records
+    waiting is written, then each of their files is synced once, so
+    the cost of a sync is shared by every record that arrived during
+    the commit interval instead of being paid per record. With many
+    units, a single syncfs() replaces the syncs of their files: each
+    fdatasync() ends in a journal commit of its own. A file cut
+    in the middle of a record by a crash is truncated to its last
+    complete record when it is opened again.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the device files
+#include "Storage.hpp"
+
+// Compression of the blocks
+#include "../../src/protocols/Compress.hpp"
+
+// open(), fstat(), mkdir() and the O_x flags for the files
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// pread(), write(), ftruncate(), fdatasync(), fsync(), syncfs() and close() for the files
+#include <unistd.h>
+
+// errno for the directory and the interrupted writes
+#include <errno.h>
+
+// snprintf() for the paths
+#include <stdio.h>
+
+// malloc(), realloc(), calloc() and free() for the devices
+#include <stdlib.h>
+
+// memcpy(), memmove(), memset() and strlen() for the records
+#include <string.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Appends a frame to the records waiting of a unit
+// @return: 1 if the record waits for the commit, 0 if out of memory
+static uint8_t appendRecord(t_storage *storage, t_device *device, const uint8_t *frame,
+                            uint16_t length, uint64_t nowUs);
+
+// Packs the records waiting of a unit in place, block by block
+// @return: Length of the packed records
+static size_t packRecords(t_device *device, uint64_t *packed);
+
+// Writes a buffer whole, retrying after interruptions
+// @return: 1 if every byte was written, 0 otherwise
+static uint8_t writeAll(int fd, const uint8_t *data, size_t length);
+
+// Returns the end of the last complete record of a file
+static off_t findRecordsEnd(int fd, off_t size);
+
+// Syncs the directory, so a new file is found again after a crash
+// @return: 1 if the directory reached the disk, 0 otherwise
+static uint8_t syncDirectory(const t_storage *storage);
+
+
+/* *****************************************************************
+    *                        SETUP FUNCTIONS                      *
+   ***************************************************************** */
+
+// Prepares the storage of the device files
+// @param storage: Storage to prepare
+// @param directory: Directory of the device files, created if missing
+// @param intervalUs: Longest time a record waits for its commit
+// @return: 1 if the directory can be used, 0 otherwise
+uint8_t initStorage(t_storage *storage, const char *directory, uint64_t intervalUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Status of the directory
+    struct stat status;
+
+    /* -------------------- DIRECTORY -------------------- */
+
+    memset(storage, 0, sizeof(*storage));
+    storage->intervalUs = intervalUs;
+
+    if (strlen(directory) >= sizeof(storage->directory))
+    {
+        return 0;
+    }
+
+    strcpy(storage->directory, directory);
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST)
+    {
+        return 0;
+    }
+
+    if (stat(directory, &status) != 0 || !S_ISDIR(status.st_mode))
+    {
+        return 0;
+    }
+
+    /* -------------------- DEVICES -------------------- */
+
+    storage->devices = (t_device **)calloc(STORAGE_NODES, sizeof(*storage->devices));
+    storage->dirty = (uint16_t *)malloc(STORAGE_NODES * sizeof(*storage->dirty));
+
+    if (!storage->devices || !storage->dirty)
+    {
+        free(storage->devices);
+        free(storage->dirty);
+        storage->devices = NULL;
+        storage->dirty = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+// Commits the records waiting and closes every device file
+// @param storage: Storage to close
+void freeStorage(t_storage *storage)
+{
+    if (!storage->devices)
+    {
+        return;
+    }
+
+    commitStorage(storage);
+
+    for (uint32_t i = 0; i < STORAGE_NODES; i++)
+    {
+        if (storage->devices[i])
+        {
+            close(storage->devices[i]->fd);
+            free(storage->devices[i]->pending);
+            free(storage->devices[i]);
+        }
+    }
+
+    free(storage->devices);
+    free(storage->dirty);
+    storage->devices = NULL;
+    storage->dirty = NULL;
+}
+
+
+/* *****************************************************************
+    *                        DEVICE FUNCTIONS                     *
+   ***************************************************************** */
+
+// Opens the file of a unit, after its last complete record, and adds a
+// schema frame so a decoder can read it alone
+// @param storage: Storage of the device files
+// @param nodeId: Unit to open
+// @param nowUs: Monotonic host time, starts the wait for the commit
+// @return: 1 if the file is open, 0 otherwise
+uint8_t openDevice(t_storage *storage, uint16_t nodeId, uint64_t nowUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Path, file and its status
+    char path[STORAGE_PATH_SIZE];
+    int fd;
+    struct stat status;
+    off_t end;
+
+    // Device and its schema frame
+    t_device *device;
+    t_frameHeader header;
+    uint8_t frame[FRAME_SCHEMA_MAX_SIZE];
+    uint8_t length;
+
+    /* -------------------- FILE -------------------- */
+
+    if (storage->devices[nodeId])
+    {
+        return 1;
+    }
+
+    snprintf(path, sizeof(path), "%s/%04X.bin", storage->directory, nodeId);
+
+    fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    // A crash may have cut the last record, the next ones follow it
+    if (fstat(fd, &status) != 0 ||
+        ((end = findRecordsEnd(fd, status.st_size)) < status.st_size && ftruncate(fd, end) != 0))
+    {
+        close(fd);
+        return 0;
+    }
+
+    // Records committed to a new file would be lost with its name
+    if (status.st_size == 0 && !storage->noSync && !syncDirectory(storage))
+    {
+        storage->errors++;
+    }
+
+    /* -------------------- DEVICE -------------------- */
+
+    device = (t_device *)calloc(1, sizeof(*device));
+    if (!device)
+    {
+        close(fd);
+        return 0;
+    }
+
+    device->nodeId = nodeId;
+    device->fd = fd;
+    storage->devices[nodeId] = device;
+
+    // The file may follow a restart of the server, its schema is repeated
+    header.type = FRAME_TYPE_SCHEMA;
+    header.flags = 0;
+    header.nodeId = nodeId;
+    header.seq = device->seq++;
+    header.timeUs = 0;
+
+    length = encodeSchemaFrame((1UL << CH_COUNT) - 1, &header, frame, sizeof(frame));
+
+    return length && appendRecord(storage, device, frame, length, nowUs);
+}
+
+// Adds a sample set of a unit as a sample frame, written at the next commit
+// @param storage: Storage of the device files
+// @param nodeId: Unit of the sample set, opened if needed
+// @param set: Sample set, capture times in UTC
+// @param timeUs: UTC time of the sample set
+// @param nowUs: Monotonic host time, starts the wait for the commit
+// @return: 1 if the sample set waits for the commit, 0 otherwise
+uint8_t storeSampleSet(t_storage *storage, uint16_t nodeId, const t_sampleSet *set,
+                       uint64_t timeUs, uint64_t nowUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Device and the frame of the sample set
+    t_device *device;
+    t_frameHeader header;
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t length;
+
+    /* -------------------- FRAME -------------------- */
+
+    if (!openDevice(storage, nodeId, nowUs))
+    {
+        return 0;
+    }
+
+    device = storage->devices[nodeId];
+
+    header.type = FRAME_TYPE_SAMPLES;
+    header.flags = FRAME_FLAG_UTC;
+    header.nodeId = nodeId;
+    header.seq = device->seq++;
+    header.timeUs = timeUs;
+
+    length = encodeSampleFrame(set, &header, 0, frame, sizeof(frame));
+
+    return length && appendRecord(storage, device, frame, length, nowUs);
+}
+
+
+/* *****************************************************************
+    *                        COMMIT FUNCTIONS                     *
+   ***************************************************************** */
+
+// Returns the time left before the records waiting must be committed
+// @param storage: Storage of the device files
+// @param nowUs: Monotonic host time
+// @return: Time left in us, 0 if due now, -1 if nothing waits
+int64_t getCommitDelay(const t_storage *storage, uint64_t nowUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time waited by the oldest record
+    uint64_t waitedUs = nowUs - storage->firstPendingUs;
+
+    /* -------------------- DELAY -------------------- */
+
+    if (!storage->pendingRecords)
+    {
+        return -1;
+    }
+
+    if (storage->pendingBytes >= STORAGE_COMMIT_BYTES || waitedUs >= storage->intervalUs)
+    {
+        return 0;
+    }
+
+    return (int64_t)(storage->intervalUs - waitedUs);
+}
+
+// Writes the records waiting of every unit, then waits until all of
+// them reached the disk: one sync per file, or one for the file system
+// past STORAGE_SYNCFS_FILES files, for any number of records
+// @param storage: Storage of the device files
+// @return: Number of records committed
+uint32_t commitStorage(t_storage *storage)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Device being committed and the length of its packed records
+    t_device *device;
+    size_t length;
+
+    // Records of this commit
+    uint32_t records = storage->pendingRecords;
+
+    /* -------------------- WRITES -------------------- */
+
+    if (!records)
+    {
+        return 0;
+    }
+
+    // Every file is written before the first sync, the disk is given
+    // all the blocks of the commit at once
+    for (uint32_t i = 0; i < storage->dirtyCount; i++)
+    {
+        device = storage->devices[storage->dirty[i]];
+        length = packRecords(device, &storage->packed);
+
+        if (writeAll(device->fd, device->pending, length))
+        {
+            device->written += length;
+            storage->bytes += length;
+        }
+
+        else
+        {
+            storage->errors++;
+        }
+
+        device->pendingLength = 0;
+    }
+
+    /* -------------------- SYNCS -------------------- */
+
+    // Past a few files one sync of the file system costs less than a
+    // journal commit per file
+    if (!storage->noSync && storage->dirtyCount >= STORAGE_SYNCFS_FILES)
+    {
+        if (syncfs(storage->devices[storage->dirty[0]]->fd) != 0)
+        {
+            storage->errors++;
+        }
+    }
+
+    else if (!storage->noSync)
+    {
+        for (uint32_t i = 0; i < storage->dirtyCount; i++)
+        {
+            if (fdatasync(storage->devices[storage->dirty[i]]->fd) != 0)
+            {
+                storage->errors++;
+            }
+        }
+    }
+
+    storage->dirtyCount = 0;
+    storage->pendingRecords = 0;
+    storage->pendingBytes = 0;
+    storage->records += records;
+    storage->commits++;
+
+    return records;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Appends a frame to the records waiting of a unit
+static uint8_t appendRecord(t_storage *storage, t_device *device, const uint8_t *frame,
+                            uint16_t length, uint64_t nowUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Grown buffer of the records waiting
+    uint8_t *pending;
+    size_t size;
+
+    /* -------------------- BUFFER -------------------- */
+
+    if (device->pendingLength + 3 + length > device->pendingSize)
+    {
+        size = device->pendingSize ? device->pendingSize * 2 : STORAGE_BLOCK_SIZE;
+        while (size < device->pendingLength + 3 + length)
+        {
+            size *= 2;
+        }
+
+        pending = (uint8_t *)realloc(device->pending, size);
+        if (!pending)
+        {
+            return 0;
+        }
+
+        device->pending = pending;
+        device->pendingSize = size;
+    }
+
+    if (device->pendingLength == 0)
+    {
+        storage->dirty[storage->dirtyCount++] = device->nodeId;
+    }
+
+    if (storage->pendingRecords == 0)
+    {
+        storage->firstPendingUs = nowUs;
+    }
+
+    /* -------------------- RECORD -------------------- */
+
+    // Frames are at least a header long, a length byte is never zero
+    device->pending[device->pendingLength++] = (uint8_t)length;
+    memcpy(device->pending + device->pendingLength, frame, length);
+    device->pendingLength += length;
+
+    storage->pendingRecords++;
+    storage->pendingBytes += 1 + length;
+
+    return 1;
+}
+
+// Packs the records waiting of a unit in place, block by block
+static size_t packRecords(t_device *device, uint64_t *packed)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Block being packed and the end of the packed records
+    size_t start = 0;
+    size_t end;
+    size_t output = 0;
+    uint8_t records;
+
+    // Packed frame of a block
+    t_frameHeader header;
+    uint8_t frame[STORAGE_BLOCK_SIZE];
+    uint16_t length;
+
+    /* -------------------- BLOCKS -------------------- */
+
+    while (start < device->pendingLength)
+    {
+        // Whole records, every record is far shorter than a block
+        end = start;
+        records = 0;
+        while (end < device->pendingLength &&
+               end + 1 + device->pending[end] - start <= STORAGE_BLOCK_SIZE)
+        {
+            end += 1 + device->pending[end];
+            records++;
+        }
+
+        length = 0;
+
+        // A single frame does not compress, as in flushRecorder() the
+        // packed record is kept only if smaller than the block
+        if (records > 1)
+        {
+            header.flags = 0;
+            header.nodeId = device->nodeId;
+            header.seq = device->seq++;
+            header.timeUs = 0;
+
+            length = encodePackedFrame(device->pending + start, (uint16_t)(end - start), &header,
+                                       frame, (uint16_t)(end - start - 3));
+        }
+
+        // The output never passes the block it replaces
+        if (length)
+        {
+            device->pending[output] = STORAGE_PACKED_RECORD;
+            device->pending[output + 1] = (uint8_t)(length & 0xFF);
+            device->pending[output + 2] = (uint8_t)(length >> 8);
+            memcpy(device->pending + output + 3, frame, length);
+            output += 3 + length;
+            (*packed)++;
+        }
+
+        else
+        {
+            memmove(device->pending + output, device->pending + start, end - start);
+            output += end - start;
+        }
+
+        start = end;
+    }
+
+    return output;
+}
+
+// Writes a buffer whole, retrying after interruptions
+static uint8_t writeAll(int fd, const uint8_t *data, size_t length)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bytes written by a call
+    ssize_t written;
+
+    /* -------------------- WRITES -------------------- */
+
+    while (length > 0)
+    {
+        written = write(fd, data, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0)
+        {
+            return 0;
+        }
+
+        data += written;
+        length -= written;
+    }
+
+    return 1;
+}
+
+// Returns the end of the last complete record of a file
+static off_t findRecordsEnd(int fd, off_t size)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Part of the file read, and its position in the file
+    uint8_t block[65536];
+    off_t base = 0;
+    ssize_t count = 0;
+
+    // Record being checked and the next one
+    off_t position = 0;
+    off_t next;
+    const uint8_t *head;
+
+    /* -------------------- RECORDS -------------------- */
+
+    // Only the lengths are read, the frames are skipped
+    while (position < size)
+    {
+        if (position + 3 > base + count)
+        {
+            base = position;
+            count = pread(fd, block, sizeof(block), base);
+            if (count <= 0)
+            {
+                break;
+            }
+        }
+
+        head = block + (position - base);
+
+        if (head[0] != STORAGE_PACKED_RECORD)
+        {
+            next = position + 1 + head[0];
+        }
+
+        else if (position + 3 <= base + count)
+        {
+            next = position + 3 + (head[1] | ((uint16_t)head[2] << 8));
+        }
+
+        else
+        {
+            break;
+        }
+
+        if (next > size)
+        {
+            break;
+        }
+
+        position = next;
+    }
+
+    return position;
+}
+
+// Syncs the directory, so a new file is found again after a crash
+static uint8_t syncDirectory(const t_storage *storage)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Directory of the device files and the result of its sync
+    int fd;
+    uint8_t synced;
+
+    /* -------------------- SYNC -------------------- */
+
+    fd = open(storage->directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    synced = (fsync(fd) == 0);
+    close(fd);
+
+    return synced;
+}
@@ -0,0 +1,138 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef STORAGE_hpp
+#define STORAGE_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types
+#include <stdint.h>
+
+// size_t for the buffered bytes
+#include <stddef.h>
+
+// Sample sets and the frames they are stored as
+#include "../../src/processing/Channels.hpp"
+#include "../../src/protocols/Frame.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Number of node identifiers, each unit has its own file
+#define STORAGE_NODES 65536
+
+// Longest path of a device file, e.g. "<directory>/1A2B.bin"
+#define STORAGE_PATH_SIZE 512
+
+// Records are packed in blocks of at most this size, the window of the
+// compressor. A zero length instead introduces a packed block, like in
+// the session files of the recorder
+#define STORAGE_BLOCK_SIZE 4096
+#define STORAGE_PACKED_RECORD 0
+
+// Buffered bytes that commit at once, whatever the time waited
+#define STORAGE_COMMIT_BYTES (4UL * 1024 * 1024)
+
+// Files written by a commit from which the file system is synced at
+// once instead of file by file
+#define STORAGE_SYNCFS_FILES 16
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// File of one unit and its records waiting for the next commit
+typedef struct
+{
+    // Unit, its file and the sequence of its next frame
+    uint16_t nodeId;
+    int fd;
+    uint16_t seq;
+
+    // Records waiting, written by the next commit
+    uint8_t *pending;
+    size_t pendingLength;
+    size_t pendingSize;
+
+    // Bytes written to the file since it was opened
+    uint64_t written;
+
+} t_device;
+
+// Device files of the ingest server, committed together
+typedef struct
+{
+    // Directory of the device files, room is left for "/1A2B.bin"
+    char directory[STORAGE_PATH_SIZE - 9];
+
+    // Devices by node identifier, NULL until their first record
+    t_device **devices;
+
+    // Devices with records waiting, and the number of those records
+    uint16_t *dirty;
+    uint32_t dirtyCount;
+    uint32_t pendingRecords;
+    size_t pendingBytes;
+
+    // Host time of the oldest record waiting, and the longest wait
+    uint64_t firstPendingUs;
+    uint64_t intervalUs;
+
+    // Set to skip fdatasync(), for storage that does not need it
+    uint8_t noSync;
+
+    // Commits, records committed, blocks packed, bytes written, failed
+    // writes or syncs
+    uint64_t commits;
+    uint64_t records;
+    uint64_t packed;
+    uint64_t bytes;
+    uint64_t errors;
+
+} t_storage;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Prepares the storage of the device files
+// @param storage: Storage to prepare
+// @param directory: Directory of the device files, created if missing
+// @param intervalUs: Longest time a record waits for its commit
+// @return: 1 if the directory can be used, 0 otherwise
+uint8_t initStorage(t_storage *storage, const char *directory, uint64_t intervalUs);
+
+// Commits the records waiting and closes every device file
+// @param storage: Storage to close
+void freeStorage(t_storage *storage);
+
+// Opens the file of a unit, after its last complete record, and adds a
+// schema frame so a decoder can read it alone
+// @param storage: Storage of the device files
+// @param nodeId: Unit to open
+// @param nowUs: Monotonic host time, starts the wait for the commit
+// @return: 1 if the file is open, 0 otherwise
+uint8_t openDevice(t_storage *storage, uint16_t nodeId, uint64_t nowUs);
+
+// Adds a sample set of a unit as a sample frame, written at the next commit
+// @param storage: Storage of the device files
+// @param nodeId: Unit of the sample set, opened if needed
+// @param set: Sample set, capture times in UTC
+// @param timeUs: UTC time of the sample set
+// @param nowUs: Monotonic host time, starts the wait for the commit
+// @return: 1 if the sample set waits for the commit, 0 otherwise
+uint8_t storeSampleSet(t_storage *storage, uint16_t nodeId, const t_sampleSet *set,
+                       uint64_t timeUs, uint64_t nowUs);
+
+// Returns the time left before the records waiting must be committed
+// @param storage: Storage of the device files
+// @param nowUs: Monotonic host time
+// @return: Time left in us, 0 if due now, -1 if nothing waits
+int64_t getCommitDelay(const t_storage *storage, uint64_t nowUs);
+
+// Writes the records waiting of every unit, then waits until all of
+// them reached the disk: one sync per file, or one for the file system
+// past STORAGE_SYNCFS_FILES files, for any number of records
+// @param storage: Storage of the device files
+// @return: Number of records committed
+uint32_t commitStorage(t_storage *storage);
+
+#endif // STORAGE_hpp
@@ -0,0 +1,452 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file decodes the text stream of one unit as it arrives,
+    in blocks cut anywhere. Lines are assembled in the state of the
+    connection, the hello line identifies the unit and anchors its
+    clock, and the readings of a measurement ("CO2:415ppm" as sent
+    by sendData()) are gathered into a sample set completed by the
+    line that ends the measurement. Statuses in place of a value,
+    section headers and other lines are passed over.
+
+    Readings are placed on the host clock through the offset between
+    the host time a time line arrives and the unit time it carries.
+    The lowest offset is the least delayed line, it is taken at once,
+    a higher one only moves the offset by a fraction so a line held
+    in a queue barely shifts it and a drifting unit is still followed.
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Includes the header for the stream decoder
+#include "Stream.hpp"
+
+// strtoll() and strtoull() for the values
+#include <stdlib.h>
+
+// strncmp(), strchr(), strlen() and memcpy() for the lines
+#include <string.h>
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Decodes a complete line
+// @param stream: State of the connection
+// @param hostUs: Host UTC time the line arrived
+// @return: Event caused by the line
+static e_streamEvent parseLine(t_stream *stream, uint64_t hostUs);
+
+// Decodes a hello line, "HELLO:<name>,node=1A2B,...,time=<us>"
+static e_streamEvent parseHello(t_stream *stream, uint64_t hostUs);
+
+// Decodes the reading of a channel, the line after its label
+static e_streamEvent parseReading(t_stream *stream, e_channel channel, const char *text,
+                                  uint64_t hostUs);
+
+// Completes the sample set being assembled, if it holds a reading
+// @return: 1 if a sample set is complete, 0 otherwise
+static uint8_t completeSet(t_stream *stream, uint64_t hostUs);
+
+// Completes the sample set and keeps the line for the next call, which
+// starts the next set with it
+static e_streamEvent holdLine(t_stream *stream, uint64_t hostUs);
+
+// Takes a host time and unit time pair into the clock offset
+static void updateOffset(t_stream *stream, uint64_t hostUs, uint64_t unitUs);
+
+// Reads an unsigned decimal time
+// @param text: Text of the time
+// @param timeUs: Pointer where the time is stored
+// @return: 1 if the text starts with a number, 0 otherwise
+static uint8_t parseTime(const char *text, uint64_t *timeUs);
+
+
+/* *****************************************************************
+    *                       STREAM FUNCTIONS                      *
+   ***************************************************************** */
+
+// Prepares the decoding state of a new connection
+// @param stream: State to prepare
+void initStream(t_stream *stream)
+{
+    memset(stream, 0, sizeof(*stream));
+
+    clearSampleSet(&stream->set);
+    clearSampleSet(&stream->done);
+}
+
+// Decodes received bytes up to the next event, call again with the rest
+// of the bytes until STREAM_EVENT_NONE
+// @param stream: State of the connection
+// @param data: Received bytes
+// @param length: Number of bytes
+// @param hostUs: Host UTC time the bytes arrived
+// @param used: Pointer where the number of bytes used is stored
+// @return: Event that stopped the decoding, STREAM_EVENT_NONE once all is used
+e_streamEvent feedStream(t_stream *stream, const uint8_t *data, size_t length, uint64_t hostUs,
+                         size_t *used)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Event caused by a line
+    e_streamEvent event;
+
+    /* -------------------- HELD LINE -------------------- */
+
+    *used = 0;
+
+    // The line that completed the last sample set starts the next one
+    if (stream->lineHeld)
+    {
+        stream->lineHeld = 0;
+        event = parseLine(stream, hostUs);
+        stream->lineLength = 0;
+
+        if (event != STREAM_EVENT_NONE)
+        {
+            return event;
+        }
+    }
+
+    /* -------------------- LINES -------------------- */
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (data[i] == '\n')
+        {
+            stream->lines++;
+
+            if (stream->overflow)
+            {
+                stream->overflow = 0;
+                stream->lineLength = 0;
+                stream->skipped++;
+                continue;
+            }
+
+            stream->line[stream->lineLength] = '\0';
+            event = parseLine(stream, hostUs);
+
+            if (!stream->lineHeld)
+            {
+                stream->lineLength = 0;
+            }
+
+            if (event != STREAM_EVENT_NONE)
+            {
+                *used = i + 1;
+                return event;
+            }
+        }
+
+        // println() ends the lines with "\r\n"
+        else if (data[i] == '\r' || stream->overflow)
+        {
+            continue;
+        }
+
+        else if (stream->lineLength + 1 < STREAM_LINE_SIZE)
+        {
+            stream->line[stream->lineLength++] = (char)data[i];
+        }
+
+        else
+        {
+            stream->overflow = 1;
+        }
+    }
+
+    *used = length;
+    return STREAM_EVENT_NONE;
+}
+
+// Ends the connection, completing the sample set being assembled
+// @param stream: State of the connection
+// @param hostUs: Host UTC time of the end
+// @return: 1 if a sample set is complete (STREAM_EVENT_SET), 0 otherwise
+uint8_t endStream(t_stream *stream, uint64_t hostUs)
+{
+    // A line cut by the end of the connection is not trusted
+    stream->lineLength = 0;
+    stream->overflow = 0;
+    stream->lineHeld = 0;
+
+    return completeSet(stream, hostUs);
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Decodes a complete line
+static e_streamEvent parseLine(t_stream *stream, uint64_t hostUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Line and the label of a channel
+    const char *line = stream->line;
+    const char *label;
+    size_t labelLength;
+
+    // Time carried by the line
+    uint64_t timeUs;
+
+    /* -------------------- LINE TYPES -------------------- */
+
+    if (strncmp(line, "HELLO:", 6) == 0)
+    {
+        return parseHello(stream, hostUs);
+    }
+
+    if (strcmp(line, STREAM_END_LINE) == 0)
+    {
+        return completeSet(stream, hostUs) ? STREAM_EVENT_SET : STREAM_EVENT_NONE;
+    }
+
+    // Time reference of a measurement, sent at its start
+    if (strncmp(line, "Local:", 6) == 0 && parseTime(line + 6, &timeUs))
+    {
+        if (stream->set.validMask)
+        {
+            return holdLine(stream, hostUs);
+        }
+
+        stream->setLocalUs = timeUs;
+        updateOffset(stream, hostUs, timeUs);
+        return STREAM_EVENT_NONE;
+    }
+
+    // Capture time of the sensor section that follows
+    if (strncmp(line, "Time:", 5) == 0 && parseTime(line + 5, &timeUs))
+    {
+        stream->sectionUs = timeUs;
+        return STREAM_EVENT_NONE;
+    }
+
+    /* -------------------- READINGS -------------------- */
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        // The labels end with ':', "CO:" cannot match "CO2:415ppm"
+        label = getChannelName((e_channel)ch);
+        labelLength = strlen(label);
+
+        if (strncmp(line, label, labelLength) == 0)
+        {
+            return parseReading(stream, (e_channel)ch, line + labelLength, hostUs);
+        }
+    }
+
+    return STREAM_EVENT_NONE;
+}
+
+// Decodes a hello line, "HELLO:<name>,node=1A2B,...,time=<us>"
+static e_streamEvent parseHello(t_stream *stream, uint64_t hostUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Field being read and its end
+    const char *field = stream->line + 6;
+    const char *end;
+
+    // Fields of the hello line
+    char name[STREAM_NAME_SIZE];
+    size_t nameLength;
+    long long node = -1;
+    unsigned long long connection = 0;
+    uint64_t unitUs = 0;
+    uint8_t timed = 0;
+
+    /* -------------------- FIELDS -------------------- */
+
+    end = strchr(field, ',');
+    nameLength = end ? (size_t)(end - field) : strlen(field);
+    if (nameLength >= STREAM_NAME_SIZE)
+    {
+        nameLength = STREAM_NAME_SIZE - 1;
+    }
+
+    memcpy(name, field, nameLength);
+    name[nameLength] = '\0';
+
+    // Comma-separated key=value fields, the build date holds no comma
+    while (end)
+    {
+        field = end + 1;
+        end = strchr(field, ',');
+
+        if (strncmp(field, "node=", 5) == 0)
+        {
+            node = strtoll(field + 5, NULL, 16);
+        }
+
+        else if (strncmp(field, "conn=", 5) == 0)
+        {
+            connection = strtoull(field + 5, NULL, 10);
+        }
+
+        else if (strncmp(field, "time=", 5) == 0)
+        {
+            timed = parseTime(field + 5, &unitUs);
+        }
+    }
+
+    if (node < 0 || node > UINT16_MAX)
+    {
+        stream->skipped++;
+        return STREAM_EVENT_NONE;
+    }
+
+    /* -------------------- IDENTITY -------------------- */
+
+    // The readings so far belong to the unit before this line
+    if (stream->set.validMask)
+    {
+        return holdLine(stream, hostUs);
+    }
+
+    stream->identified = 1;
+    stream->nodeId = (uint16_t)node;
+    stream->connection = (uint16_t)connection;
+    memcpy(stream->name, name, nameLength + 1);
+
+    // A new connection may follow a reboot, the unit clock restarted
+    stream->synced = 0;
+    stream->sectionUs = 0;
+    stream->setLocalUs = 0;
+
+    if (timed)
+    {
+        updateOffset(stream, hostUs, unitUs);
+    }
+
+    return STREAM_EVENT_HELLO;
+}
+
+// Decodes the reading of a channel, the line after its label
+static e_streamEvent parseReading(t_stream *stream, e_channel channel, const char *text,
+                                  uint64_t hostUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Value and the unit after it
+    long long value;
+    char *unit;
+
+    /* -------------------- VALUE -------------------- */
+
+    // A status such as "PREHEAT" in place of the value
+    value = strtoll(text, &unit, 10);
+    if (unit == text)
+    {
+        return STREAM_EVENT_NONE;
+    }
+
+    if (!stream->identified)
+    {
+        stream->unidentified++;
+        return STREAM_EVENT_NONE;
+    }
+
+    // A channel read twice belongs to the next measurement, as the
+    // readings of an event report
+    if (isSampleValid(&stream->set, channel))
+    {
+        return holdLine(stream, hostUs);
+    }
+
+    if (value > INT32_MAX)
+    {
+        value = INT32_MAX;
+    }
+
+    else if (value < INT32_MIN)
+    {
+        value = INT32_MIN;
+    }
+
+    setSampleValue(&stream->set, channel, (int32_t)value,
+                   (stream->synced && stream->sectionUs) ? stream->sectionUs + stream->offsetUs
+                                                         : hostUs);
+    stream->readings++;
+
+    return STREAM_EVENT_NONE;
+}
+
+// Completes the sample set being assembled, if it holds a reading
+static uint8_t completeSet(t_stream *stream, uint64_t hostUs)
+{
+    if (!stream->set.validMask)
+    {
+        return 0;
+    }
+
+    stream->done = stream->set;
+    stream->doneTimeUs = hostUs;
+    stream->doneLocalUs = stream->setLocalUs;
+    stream->sets++;
+
+    clearSampleSet(&stream->set);
+    stream->setLocalUs = 0;
+
+    return 1;
+}
+
+// Completes the sample set and keeps the line for the next call, which
+// starts the next set with it
+static e_streamEvent holdLine(t_stream *stream, uint64_t hostUs)
+{
+    stream->lineHeld = 1;
+
+    // Only called with a reading in the set, it is always completed
+    completeSet(stream, hostUs);
+    return STREAM_EVENT_SET;
+}
+
+// Takes a host time and unit time pair into the clock offset
+static void updateOffset(t_stream *stream, uint64_t hostUs, uint64_t unitUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Offset given by this pair
+    int64_t offsetUs = (int64_t)(hostUs - unitUs);
+
+    /* -------------------- OFFSET -------------------- */
+
+    if (!stream->synced || offsetUs < stream->offsetUs)
+    {
+        stream->offsetUs = offsetUs;
+        stream->synced = 1;
+    }
+
+    else
+    {
+        stream->offsetUs += (offsetUs - stream->offsetUs) >> STREAM_OFFSET_SHIFT;
+    }
+}
+
+// Reads an unsigned decimal time
+static uint8_t parseTime(const char *text, uint64_t *timeUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // End of the number
+    char *end;
+
+    /* -------------------- TIME -------------------- */
+
+    if (*text < '0' || *text > '9')
+    {
+        return 0;
+    }
+
+    *timeUs = strtoull(text, &end, 10);
+    return end != text;
+}
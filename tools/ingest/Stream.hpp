@@ -0,0 +1,118 @@
+/* *****************************************************************
+    *                    HEADER CONFIGURATION                     *
+   ***************************************************************** */
+
+// Ensure the header is included only once
+#ifndef STREAM_hpp
+#define STREAM_hpp
+
+/* --------------------- NECESSARY LIBRARIES --------------------- */
+
+// Standard integer types
+#include <stdint.h>
+
+// size_t for the received blocks
+#include <stddef.h>
+
+// Sample sets built from the readings
+#include "../../src/processing/Channels.hpp"
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Longest line kept, longer lines are skipped
+#define STREAM_LINE_SIZE 160
+
+// Longest unit name of a hello line, the terminating null included
+#define STREAM_NAME_SIZE 32
+
+// Line ending the readings of a measurement, sent by sendAllSensors()
+#define STREAM_END_LINE "END OF MEASUREMENT"
+
+// A clock offset above the lowest one seen moves it by this fraction
+#define STREAM_OFFSET_SHIFT 6
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// What ended a call to feedStream()
+typedef enum
+{
+    // Every byte was used, nothing to report
+    STREAM_EVENT_NONE,
+
+    // A hello line identified the unit (nodeId, name, connection)
+    STREAM_EVENT_HELLO,
+
+    // A sample set is complete (done, doneTimeUs, doneLocalUs)
+    STREAM_EVENT_SET
+
+} e_streamEvent;
+
+// Decoding state of one connection
+typedef struct
+{
+    // Line being assembled, set while a line too long is skipped and
+    // while a line waits for the event it caused to be handled
+    char line[STREAM_LINE_SIZE];
+    uint16_t lineLength;
+    uint8_t overflow;
+    uint8_t lineHeld;
+
+    // Unit given by the last hello line
+    uint8_t identified;
+    uint16_t nodeId;
+    uint16_t connection;
+    char name[STREAM_NAME_SIZE];
+
+    // Host time minus unit time, from the hello and time reference
+    // lines, to place the readings on the host clock
+    uint8_t synced;
+    int64_t offsetUs;
+
+    // Capture time of the section being read, unit clock, 0 if unknown
+    uint64_t sectionUs;
+
+    // Sample set being assembled and the unit time of its measurement
+    // (its "Local:" line)
+    t_sampleSet set;
+    uint64_t setLocalUs;
+
+    // Last complete sample set, its host time (the line ending it) and
+    // the unit time of its measurement
+    t_sampleSet done;
+    uint64_t doneTimeUs;
+    uint64_t doneLocalUs;
+
+    // Lines read, readings kept, sets completed, readings received
+    // before any hello line, lines too long or malformed
+    uint32_t lines;
+    uint32_t readings;
+    uint32_t sets;
+    uint32_t unidentified;
+    uint32_t skipped;
+
+} t_stream;
+
+/* ---------------- PUBLIC FUNCTIONS PROTOTYPES ---------------- */
+
+// Prepares the decoding state of a new connection
+// @param stream: State to prepare
+void initStream(t_stream *stream);
+
+// Decodes received bytes up to the next event, call again with the rest
+// of the bytes until STREAM_EVENT_NONE
+// @param stream: State of the connection
+// @param data: Received bytes
+// @param length: Number of bytes
+// @param hostUs: Host UTC time the bytes arrived
+// @param used: Pointer where the number of bytes used is stored
+// @return: Event that stopped the decoding, STREAM_EVENT_NONE once all is used
+e_streamEvent feedStream(t_stream *stream, const uint8_t *data, size_t length, uint64_t hostUs,
+                         size_t *used);
+
+// Ends the connection, completing the sample set being assembled
+// @param stream: State of the connection
+// @param hostUs: Host UTC time of the end
+// @return: 1 if a sample set is complete (STREAM_EVENT_SET), 0 otherwise
+uint8_t endStream(t_stream *stream, uint64_t hostUs);
+
+#endif // STREAM_hpp
@@ -0,0 +1,1009 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file is the ingest server of the ground side: one process
+    reads the streams of many units at once and stores each unit in
+    a file of its own, in place of a terminal watched per unit.
+
+        aeroingest -d flights /dev/rfcomm0 /dev/rfcomm1 -l 5555
+
+    Inputs are RFCOMM or serial device nodes (a pty stands for one in
+    the tests) and TCP connections. A single epoll loop waits on all
+    of them, each connection keeps its own decoding state (Stream)
+    and the sample sets go to the device files (Storage), committed
+    together every few milliseconds. A device node that hangs up is
+    opened again once a second, and every new connection is asked for
+    the hello line identifying its unit.
+
+    The load test runs the same server against simulated units, half
+    over ptys and half over TCP, and reports the ingest rate and the
+    latency from the due time of a measurement to its commit:
+
+        aeroingest -d /tmp/load --load 300 --rate 10 --seconds 10
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Decoding of the streams, device files, latencies and simulated units
+#include "Stream.hpp"
+#include "Storage.hpp"
+#include "Latency.hpp"
+#include "Simulator.hpp"
+
+// epoll_create1(), epoll_ctl() and epoll_wait() for the loop
+#include <sys/epoll.h>
+
+// socket(), bind(), listen() and accept4() for the TCP inputs
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// open(), read(), write() and close() for the inputs
+#include <fcntl.h>
+#include <unistd.h>
+
+// tcgetattr(), cfmakeraw() and tcsetattr() for the device nodes
+#include <termios.h>
+
+// getrlimit() and setrlimit() for the number of open files
+#include <sys/resource.h>
+
+// sigaction() for the end of the server
+#include <signal.h>
+
+// getopt_long() for the options
+#include <getopt.h>
+
+// clock_gettime() for the timestamps
+#include <time.h>
+
+// errno for the reads
+#include <errno.h>
+
+// fprintf() and snprintf() for the report
+#include <stdio.h>
+
+// malloc(), realloc(), calloc(), free() and strtoul() for the state
+#include <stdlib.h>
+
+// memset() and strerror() for the connections
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Events handled per wait, and bytes read per event
+#define INGEST_MAX_EVENTS 256
+#define INGEST_READ_SIZE  65536
+
+// Most connections and device nodes at once
+#define INGEST_MAX_CONNECTIONS 8192
+#define INGEST_MAX_INPUTS      SIMULATOR_MAX_UNITS
+
+// Default longest wait of a sample set for its commit
+#define INGEST_COMMIT_MS 20
+
+// Wait before a device node is opened again
+#define INGEST_REOPEN_US 1000000ULL
+
+// Defaults of the load test
+#define INGEST_LOAD_RATE_HZ 10
+#define INGEST_LOAD_SECONDS 10
+
+// Longest wait for the last measurements once the load is sent
+#define INGEST_DRAIN_US 5000000ULL
+
+// Longest description of a connection, a path or an address
+#define INGEST_PEER_SIZE 64
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Device node, opened again after each hang up
+typedef struct
+{
+    const char *path;
+
+    // Open connection, NULL while waiting to open it again
+    struct s_connection *connection;
+    uint64_t retryUs;
+
+    // Set for the ptys of the load test, closed for good at the end
+    uint8_t once;
+
+} t_input;
+
+// Connection of a unit, a device node or a TCP socket
+typedef struct s_connection
+{
+    int fd;
+    uint32_t index;
+
+    // Device node of the connection, NULL for a TCP socket
+    t_input *input;
+    char peer[INGEST_PEER_SIZE];
+
+    // Decoding state and bytes received
+    t_stream stream;
+    uint64_t bytes;
+
+} t_connection;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Loop, TCP listener and the open connections
+static int epollFd = -1;
+static int listenFd = -1;
+static t_connection *connections[INGEST_MAX_CONNECTIONS];
+static uint32_t connectionCount = 0;
+
+// Device nodes
+static t_input inputs[INGEST_MAX_INPUTS];
+static uint32_t inputCount = 0;
+
+// Device files, and the time reference of each sample set waiting for
+// the commit (monotonic, the latency runs from it)
+static t_storage storage;
+static uint64_t *pendingUs = NULL;
+static size_t pendingCount = 0;
+static size_t pendingSize = 0;
+
+// Latencies and counters of the report
+static t_latency latency;
+static uint64_t bytesRead = 0;
+static uint64_t setsStored = 0;
+static uint64_t setsRefused = 0;
+static uint64_t readingsStored = 0;
+static uint32_t connectionsOpened = 0;
+
+// Load test, its simulated units measure the latency from their due time
+static t_simulator *simulator = NULL;
+
+// Set by SIGINT and SIGTERM
+static volatile sig_atomic_t stopRequested = 0;
+
+// Set to print each connection
+static uint8_t verbose = 1;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Waits for the inputs and handles them until the end
+static void runLoop();
+
+// Opens the TCP listener on the loopback or on every address
+// @param port: Port to listen to, 0 for any free port
+// @param loopback: Set to only accept local connections
+// @return: Port listened to, 0 on failure
+static uint16_t openListener(uint16_t port, uint8_t loopback);
+
+// Accepts the waiting TCP connections
+static void acceptConnections();
+
+// Opens a device node in raw mode
+// @return: 1 if the device node is open, 0 otherwise
+static uint8_t openInput(t_input *input);
+
+// Adds a connection to the loop and asks for its hello line
+// @return: Connection added, NULL if the table is full
+static t_connection *addConnection(int fd, t_input *input, const char *peer);
+
+// Reads a connection and decodes what arrived
+// @return: 1 if the connection is still open, 0 if it ended
+static uint8_t readConnection(t_connection *connection);
+
+// Ends a connection, storing its last sample set
+static void closeConnection(t_connection *connection);
+
+// Stores the last sample set completed by a connection
+static void storeSet(t_connection *connection, uint64_t arrivalUs);
+
+// Commits the sample sets waiting and counts their latencies
+static void commitSets();
+
+// Returns the time left before the loop must wake up
+// @return: Time left in ms, -1 to wait for the inputs alone
+static int getLoopTimeout(uint64_t nowUs);
+
+// Prints the rates, the commits and the latencies
+static void printReport(uint64_t elapsedUs);
+
+// Prints how to call the tool
+static void printUsage();
+
+// Raises the limit of open files to its hard limit
+static void raiseFileLimit();
+
+// Asks the loop to end, on SIGINT and SIGTERM
+static void requestStop(int signal);
+
+// Returns the UTC time of the host, the time base of the stored frames
+static uint64_t getRealtimeUs();
+
+// Returns the monotonic time of the host, the time base of the latencies
+static uint64_t getMonotonicUs();
+
+
+/* *****************************************************************
+    *                         MAIN FUNCTION                       *
+   ***************************************************************** */
+
+int main(int argc, char **argv)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Options
+    static const struct option options[] = {
+        {"dir", required_argument, NULL, 'd'},     {"listen", required_argument, NULL, 'l'},
+        {"commit", required_argument, NULL, 'c'},  {"no-sync", no_argument, NULL, 'n'},
+        {"load", required_argument, NULL, 'L'},    {"rate", required_argument, NULL, 'r'},
+        {"seconds", required_argument, NULL, 's'}, {"pty", required_argument, NULL, 'p'},
+        {NULL, 0, NULL, 0}};
+    const char *directory = NULL;
+    long port = -1;
+    unsigned long commitMs = INGEST_COMMIT_MS;
+    uint8_t noSync = 0;
+    unsigned long loadUnits = 0;
+    unsigned long loadRate = INGEST_LOAD_RATE_HZ;
+    unsigned long loadSeconds = INGEST_LOAD_SECONDS;
+    long loadPtys = -1;
+    int option;
+
+    // Time the ingest started, and the end of the signals
+    uint64_t startUs;
+    struct sigaction action;
+
+    // Measurements sent by the simulated units, all of them must be stored
+    uint64_t setsSent = 0;
+
+    /* -------------------- OPTIONS -------------------- */
+
+    while ((option = getopt_long(argc, argv, "d:l:c:n", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            directory = optarg;
+            break;
+        case 'l':
+            port = strtol(optarg, NULL, 10);
+            break;
+        case 'c':
+            commitMs = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            noSync = 1;
+            break;
+        case 'L':
+            loadUnits = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            loadRate = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            loadSeconds = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            loadPtys = strtol(optarg, NULL, 10);
+            break;
+        default:
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (!directory || port > 65535 || loadUnits > SIMULATOR_MAX_UNITS || loadRate == 0 ||
+        (long)loadUnits < loadPtys || argc - optind > INGEST_MAX_INPUTS ||
+        (!loadUnits && port < 0 && optind >= argc))
+    {
+        printUsage();
+        return 2;
+    }
+
+    /* -------------------- SETUP -------------------- */
+
+    raiseFileLimit();
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // A unit gone before its hello request is written is not an error
+    signal(SIGPIPE, SIG_IGN);
+
+    initLatency(&latency);
+
+    if (!initStorage(&storage, directory, commitMs * 1000))
+    {
+        fprintf(stderr, "aeroingest: cannot use the directory %s\n", directory);
+        return 1;
+    }
+
+    storage.noSync = noSync;
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        fprintf(stderr, "aeroingest: epoll: %s\n", strerror(errno));
+        return 1;
+    }
+
+    // The units of the load test connect on the loopback
+    if (port >= 0 || loadUnits)
+    {
+        port = openListener(port >= 0 ? (uint16_t)port : 0, port < 0);
+        if (!port)
+        {
+            fprintf(stderr, "aeroingest: cannot listen: %s\n", strerror(errno));
+            return 1;
+        }
+    }
+
+    for (int i = optind; i < argc; i++)
+    {
+        inputs[inputCount].path = argv[i];
+        openInput(&inputs[inputCount++]);
+    }
+
+    /* -------------------- LOAD TEST -------------------- */
+
+    if (loadUnits)
+    {
+        simulator = (t_simulator *)malloc(sizeof(*simulator));
+        verbose = 0;
+
+        if (!simulator ||
+            !initSimulator(simulator, loadUnits, loadPtys >= 0 ? loadPtys : loadUnits / 2,
+                           (uint16_t)port, loadRate, loadSeconds))
+        {
+            fprintf(stderr, "aeroingest: cannot open the simulated units: %s\n",
+                    strerror(errno));
+            return 1;
+        }
+
+        // The ptys are opened as device nodes, raw before the first byte
+        for (uint16_t i = 0; i < simulator->ptyCount && inputCount < INGEST_MAX_INPUTS; i++)
+        {
+            inputs[inputCount].path = simulator->path[i];
+            inputs[inputCount].once = 1;
+
+            if (!openInput(&inputs[inputCount++]))
+            {
+                fprintf(stderr, "aeroingest: cannot open %s\n", simulator->path[i]);
+                return 1;
+            }
+        }
+
+        fprintf(stderr, "aeroingest: %lu units (%u over ptys, %lu over TCP) at %lu Hz for %lu s\n",
+                loadUnits, simulator->ptyCount, loadUnits - simulator->ptyCount, loadRate,
+                loadSeconds);
+
+        if (!startSimulator(simulator))
+        {
+            fprintf(stderr, "aeroingest: cannot start the simulated units\n");
+            return 1;
+        }
+    }
+
+    /* -------------------- INGEST -------------------- */
+
+    startUs = simulator ? simulator->startUs : getMonotonicUs();
+
+    runLoop();
+
+    while (connectionCount > 0)
+    {
+        closeConnection(connections[connectionCount - 1]);
+    }
+
+    commitSets();
+    printReport(getMonotonicUs() - startUs);
+
+    /* -------------------- END -------------------- */
+
+    freeStorage(&storage);
+
+    if (simulator)
+    {
+        setsSent = simulator->sets;
+        freeSimulator(simulator);
+        free(simulator);
+    }
+
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+    }
+
+    close(epollFd);
+    free(pendingUs);
+
+    return (storage.errors || setsStored < setsSent) ? 1 : 0;
+}
+
+
+/* *****************************************************************
+    *                          LOOP FUNCTIONS                     *
+   ***************************************************************** */
+
+// Waits for the inputs and handles them until the end
+static void runLoop()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Events of a wait
+    struct epoll_event events[INGEST_MAX_EVENTS];
+    int count;
+
+    // Current time and the time the load was sent
+    uint64_t nowUs;
+    uint64_t finishedUs = 0;
+
+    /* -------------------- LOOP -------------------- */
+
+    while (!stopRequested)
+    {
+        count = epoll_wait(epollFd, events, INGEST_MAX_EVENTS, getLoopTimeout(getMonotonicUs()));
+
+        if (count < 0 && errno != EINTR)
+        {
+            fprintf(stderr, "aeroingest: epoll: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr == NULL)
+            {
+                acceptConnections();
+            }
+
+            else if (!readConnection((t_connection *)events[i].data.ptr))
+            {
+                closeConnection((t_connection *)events[i].data.ptr);
+            }
+        }
+
+        /* -------------------- COMMIT -------------------- */
+
+        nowUs = getMonotonicUs();
+
+        if (getCommitDelay(&storage, nowUs) == 0)
+        {
+            commitSets();
+        }
+
+        /* -------------------- DEVICE NODES -------------------- */
+
+        for (uint32_t i = 0; i < inputCount; i++)
+        {
+            if (!inputs[i].connection && !inputs[i].once && nowUs >= inputs[i].retryUs)
+            {
+                openInput(&inputs[i]);
+            }
+        }
+
+        /* -------------------- END OF THE LOAD -------------------- */
+
+        if (simulator && isSimulatorFinished(simulator))
+        {
+            if (!finishedUs)
+            {
+                finishedUs = nowUs;
+            }
+
+            // Every measurement sent is stored, or the rest is lost
+            if (setsStored + setsRefused >= simulator->sets || nowUs - finishedUs > INGEST_DRAIN_US)
+            {
+                break;
+            }
+        }
+    }
+}
+
+// Returns the time left before the loop must wake up
+static int getLoopTimeout(uint64_t nowUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Shortest wait, -1 for none
+    int64_t waitUs = getCommitDelay(&storage, nowUs);
+
+    /* -------------------- WAITS -------------------- */
+
+    for (uint32_t i = 0; i < inputCount; i++)
+    {
+        if (!inputs[i].connection && !inputs[i].once)
+        {
+            int64_t retryUs = inputs[i].retryUs > nowUs ? inputs[i].retryUs - nowUs : 0;
+            if (waitUs < 0 || retryUs < waitUs)
+            {
+                waitUs = retryUs;
+            }
+        }
+    }
+
+    // The end of the load is checked ten times a second
+    if (simulator && (waitUs < 0 || waitUs > 100000))
+    {
+        waitUs = 100000;
+    }
+
+    return waitUs < 0 ? -1 : (int)((waitUs + 999) / 1000);
+}
+
+
+/* *****************************************************************
+    *                        INPUT FUNCTIONS                      *
+   ***************************************************************** */
+
+// Opens the TCP listener on the loopback or on every address
+static uint16_t openListener(uint16_t port, uint8_t loopback)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Address listened to
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int option = 1;
+    struct epoll_event event;
+
+    /* -------------------- LISTENER -------------------- */
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+    {
+        return 0;
+    }
+
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+
+    // The simulated units connect before the first accept
+    if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0 ||
+        getsockname(listenFd, (struct sockaddr *)&address, &length) != 0)
+    {
+        return 0;
+    }
+
+    // The listener is the only event without a connection
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0)
+    {
+        return 0;
+    }
+
+    return ntohs(address.sin_port);
+}
+
+// Accepts the waiting TCP connections
+static void acceptConnections()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Accepted socket and its address
+    int fd;
+    struct sockaddr_in address;
+    socklen_t length;
+    char peer[INGEST_PEER_SIZE];
+
+    /* -------------------- CONNECTIONS -------------------- */
+
+    while (1)
+    {
+        length = sizeof(address);
+        fd = accept4(listenFd, (struct sockaddr *)&address, &length,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        snprintf(peer, sizeof(peer), "%s:%u", inet_ntoa(address.sin_addr),
+                 ntohs(address.sin_port));
+
+        if (!addConnection(fd, NULL, peer))
+        {
+            close(fd);
+        }
+    }
+}
+
+// Opens a device node in raw mode
+static uint8_t openInput(t_input *input)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Device node and its settings
+    int fd;
+    struct termios settings;
+
+    /* -------------------- DEVICE NODE -------------------- */
+
+    input->retryUs = getMonotonicUs() + INGEST_REOPEN_US;
+
+    fd = open(input->path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    // Bytes as they come, no echo, no line editing, no CR translation
+    if (isatty(fd) && tcgetattr(fd, &settings) == 0)
+    {
+        cfmakeraw(&settings);
+        settings.c_cc[VMIN] = 1;
+        settings.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &settings);
+    }
+
+    input->connection = addConnection(fd, input, input->path);
+    if (!input->connection)
+    {
+        close(fd);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Adds a connection to the loop and asks for its hello line
+static t_connection *addConnection(int fd, t_input *input, const char *peer)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // New connection and its event
+    t_connection *connection;
+    struct epoll_event event;
+
+    /* -------------------- CONNECTION -------------------- */
+
+    if (connectionCount >= INGEST_MAX_CONNECTIONS)
+    {
+        return NULL;
+    }
+
+    connection = (t_connection *)calloc(1, sizeof(*connection));
+    if (!connection)
+    {
+        return NULL;
+    }
+
+    connection->fd = fd;
+    connection->input = input;
+    snprintf(connection->peer, sizeof(connection->peer), "%s", peer);
+    initStream(&connection->stream);
+
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        free(connection);
+        return NULL;
+    }
+
+    connection->index = connectionCount;
+    connections[connectionCount++] = connection;
+    connectionsOpened++;
+
+    // A unit connected before the server started sent its hello line
+    // to no one, the 'H' command asks for it again
+    if (write(fd, "H", 1) != 1 && verbose)
+    {
+        fprintf(stderr, "aeroingest: %s: cannot ask for the hello line\n", peer);
+    }
+
+    if (verbose)
+    {
+        fprintf(stderr, "aeroingest: %s: connected\n", peer);
+    }
+
+    return connection;
+}
+
+// Reads a connection and decodes what arrived
+static uint8_t readConnection(t_connection *connection)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Bytes received and the part decoded so far
+    static uint8_t data[INGEST_READ_SIZE];
+    ssize_t length;
+    size_t used;
+
+    // Arrival time of the bytes, for the frames and for the latency
+    uint64_t hostUs;
+    uint64_t arrivalUs;
+
+    // Stream of the connection
+    t_stream *stream = &connection->stream;
+
+    /* -------------------- READ -------------------- */
+
+    length = read(connection->fd, data, sizeof(data));
+    if (length < 0 && (errno == EAGAIN || errno == EINTR))
+    {
+        return 1;
+    }
+
+    // End of a socket, or EIO once the other end of a tty is gone
+    if (length <= 0)
+    {
+        return 0;
+    }
+
+    hostUs = getRealtimeUs();
+    arrivalUs = getMonotonicUs();
+    connection->bytes += length;
+    bytesRead += length;
+
+    /* -------------------- DECODING -------------------- */
+
+    for (size_t position = 0; position < (size_t)length || stream->lineHeld; position += used)
+    {
+        switch (feedStream(stream, data + position, length - position, hostUs, &used))
+        {
+        case STREAM_EVENT_HELLO:
+            if (!openDevice(&storage, stream->nodeId, arrivalUs))
+            {
+                fprintf(stderr, "aeroingest: %s: cannot open the file of %04X\n",
+                        connection->peer, stream->nodeId);
+            }
+
+            if (verbose)
+            {
+                fprintf(stderr, "aeroingest: %s: unit %04X %s, connection %u\n",
+                        connection->peer, stream->nodeId, stream->name, stream->connection);
+            }
+            break;
+
+        case STREAM_EVENT_SET:
+            storeSet(connection, arrivalUs);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return 1;
+}
+
+// Ends a connection, storing its last sample set
+static void closeConnection(t_connection *connection)
+{
+    if (endStream(&connection->stream, getRealtimeUs()))
+    {
+        storeSet(connection, getMonotonicUs());
+    }
+
+    if (verbose)
+    {
+        fprintf(stderr, "aeroingest: %s: closed, %llu bytes, %u measurements, %u readings\n",
+                connection->peer, (unsigned long long)connection->bytes,
+                connection->stream.sets, connection->stream.readings);
+    }
+
+    // A device node is opened again, a TCP unit connects again
+    if (connection->input)
+    {
+        connection->input->connection = NULL;
+        connection->input->retryUs = getMonotonicUs() + INGEST_REOPEN_US;
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+
+    connections[connection->index] = connections[--connectionCount];
+    connections[connection->index]->index = connection->index;
+    free(connection);
+}
+
+
+/* *****************************************************************
+    *                        STORAGE FUNCTIONS                    *
+   ***************************************************************** */
+
+// Stores the last sample set completed by a connection
+static void storeSet(t_connection *connection, uint64_t arrivalUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Stream of the connection and the grown list of time references
+    t_stream *stream = &connection->stream;
+    uint64_t *grown;
+
+    /* -------------------- SAMPLE SET -------------------- */
+
+    if (!storeSampleSet(&storage, stream->nodeId, &stream->done, stream->doneTimeUs, arrivalUs))
+    {
+        setsRefused++;
+        return;
+    }
+
+    setsStored++;
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        readingsStored += isSampleValid(&stream->done, (e_channel)ch);
+    }
+
+    /* -------------------- LATENCY -------------------- */
+
+    if (pendingCount == pendingSize)
+    {
+        grown = (uint64_t *)realloc(pendingUs, (pendingSize ? pendingSize * 2 : 1024) *
+                                                   sizeof(*pendingUs));
+        if (!grown)
+        {
+            return;
+        }
+
+        pendingUs = grown;
+        pendingSize = pendingSize ? pendingSize * 2 : 1024;
+    }
+
+    // The simulated units run on the monotonic clock of the host, the
+    // latency starts at the due time of their measurement
+    pendingUs[pendingCount++] =
+        (simulator && stream->doneLocalUs) ? stream->doneLocalUs : arrivalUs;
+}
+
+// Commits the sample sets waiting and counts their latencies
+static void commitSets()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time the commit reached the disk
+    uint64_t doneUs;
+
+    /* -------------------- COMMIT -------------------- */
+
+    commitStorage(&storage);
+    doneUs = getMonotonicUs();
+
+    for (size_t i = 0; i < pendingCount; i++)
+    {
+        addLatency(&latency, doneUs > pendingUs[i] ? doneUs - pendingUs[i] : 0);
+    }
+
+    pendingCount = 0;
+}
+
+
+/* *****************************************************************
+    *                         REPORT FUNCTIONS                    *
+   ***************************************************************** */
+
+// Prints the rates, the commits and the latencies
+static void printReport(uint64_t elapsedUs)
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Duration in seconds
+    double seconds = elapsedUs / 1e6;
+
+    /* -------------------- REPORT -------------------- */
+
+    if (seconds <= 0)
+    {
+        seconds = 1e-6;
+    }
+
+    fprintf(stderr, "aeroingest: %u connections, %llu measurements", connectionsOpened,
+            (unsigned long long)setsStored);
+
+    if (simulator)
+    {
+        fprintf(stderr, " of %llu sent", (unsigned long long)simulator->sets);
+    }
+
+    fprintf(stderr, ", %llu readings in %.2f s, %llu refused\n",
+            (unsigned long long)readingsStored, seconds, (unsigned long long)setsRefused);
+
+    fprintf(stderr, "aeroingest: %.0f measurements/s, %.0f readings/s, %.2f MB/s received\n",
+            setsStored / seconds, readingsStored / seconds, bytesRead / seconds / 1e6);
+
+    fprintf(stderr,
+            "aeroingest: %llu commits, %.1f records per commit, %llu blocks packed, "
+            "%.2f MB written, %llu write errors\n",
+            (unsigned long long)storage.commits,
+            storage.commits ? (double)storage.records / storage.commits : 0.0,
+            (unsigned long long)storage.packed, storage.bytes / 1e6,
+            (unsigned long long)storage.errors);
+
+    fprintf(stderr,
+            "aeroingest: latency from %s to disk: p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, "
+            "max %.2f ms\n",
+            simulator ? "due time" : "arrival", getLatencyPercentile(&latency, 0.50) / 1e3,
+            getLatencyPercentile(&latency, 0.99) / 1e3, getLatencyPercentile(&latency, 0.999) / 1e3,
+            latency.maxUs / 1e3);
+}
+
+// Prints how to call the tool
+static void printUsage()
+{
+    fprintf(stderr,
+            "usage: aeroingest -d <directory> [-l <port>] [-c <ms>] [-n] [<device> ...]\n"
+            "       aeroingest -d <directory> --load <units> [--rate <Hz>] [--seconds <s>]\n"
+            "                  [--pty <units>] [-c <ms>] [-n]\n"
+            "  -d, --dir      directory of the device files, one per unit\n"
+            "  -l, --listen   TCP port of the units, on every address\n"
+            "  -c, --commit   longest wait of a measurement for its commit (%u ms)\n"
+            "  -n, --no-sync  skip fdatasync(), the commits only reach the page cache\n"
+            "  <device>       RFCOMM or serial device node, opened again after a hang up\n"
+            "  --load         simulated units of the load test\n"
+            "  --rate         measurements per second of each unit (%u)\n"
+            "  --seconds      duration of the load (%u)\n"
+            "  --pty          units over ptys, the others over TCP (half)\n",
+            INGEST_COMMIT_MS, INGEST_LOAD_RATE_HZ, INGEST_LOAD_SECONDS);
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Raises the limit of open files to its hard limit
+static void raiseFileLimit()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Limits of the process
+    struct rlimit limit;
+
+    /* -------------------- LIMIT -------------------- */
+
+    // Each unit takes a connection and a device file, a load test both
+    // ends of each connection
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Asks the loop to end, on SIGINT and SIGTERM
+static void requestStop(int signal)
+{
+    stopRequested = 1;
+}
+
+// Returns the UTC time of the host, the time base of the stored frames
+static uint64_t getRealtimeUs()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of the clock
+    struct timespec now;
+
+    /* -------------------- TIME -------------------- */
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// Returns the monotonic time of the host, the time base of the latencies
+static uint64_t getMonotonicUs()
+{
+    /* -------------------- LOCAL VARIABLES -------------------- */
+
+    // Time of the clock
+    struct timespec now;
+
+    /* -------------------- TIME -------------------- */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,538 @@
+/* *****************************************************************
+    *                        INFORMATION                          *
+   *****************************************************************
+
+    This file checks the parts of the ingest server: the stream
+    decoder must give the same sample sets wherever the stream is
+    cut, keep the clock offset, pass over statuses and long lines,
+    and complete a set on the lines that start the next one. The
+    device files written by the storage must decode with the host
+    decoder, also after a cut last record, and the latency histogram
+    must keep its percentiles within a bucket. Run with:
+    make -C tools check
+
+*/
+
+
+/* *****************************************************************
+    *                     FILE CONFIGURATION                      *
+   ***************************************************************** */
+
+/* ---------------------- NECESSARY HEADERS ---------------------- */
+
+// Parts of the ingest server under test
+#include "Stream.hpp"
+#include "Storage.hpp"
+#include "Latency.hpp"
+
+// Host decoder, to read the device files back
+#include "../decoder/Columns.hpp"
+#include "../decoder/Records.hpp"
+
+// open(), read(), write() and close() for the device files
+#include <fcntl.h>
+#include <unistd.h>
+
+// printf() and snprintf() for the results and the texts
+#include <stdio.h>
+
+// malloc() and free() for the device files
+#include <stdlib.h>
+
+// memset() and strlen() for the texts
+#include <string.h>
+
+/* -------------------- MACROS AND CONSTANTS -------------------- */
+
+// Checks a condition, reporting the line of a failure
+#define CHECK(condition)                                                     \
+    do                                                                       \
+    {                                                                        \
+        if (!(condition))                                                    \
+        {                                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+// Longest text and most sample sets decoded by a test
+#define TEXT_SIZE 4096
+#define MAX_SETS  16
+
+// Largest device file read back
+#define FILE_SIZE (1024 * 1024)
+
+// Sample sets stored for a unit, enough for several packed blocks
+#define STORED_SETS 500
+
+// Units of the tests
+#define TEST_NODE  0x1A2B
+#define OTHER_NODE 0x0001
+
+/* ---------------------- DATA STRUCTURES ---------------------- */
+
+// Events of a decoded stream, in their order
+typedef struct
+{
+    t_sampleSet sets[MAX_SETS];
+    uint8_t setCount;
+    uint8_t helloCount;
+
+    // Event of each call, 'H' for a hello and 'S' for a sample set
+    char order[MAX_SETS * 2 + 1];
+
+} t_decoded;
+
+/* ---------------------- GLOBAL VARIABLES ---------------------- */
+
+// Checks failed so far
+static int failures = 0;
+
+/* ----------------- PRIVATE FUNCTIONS PROTOTYPES ----------------- */
+
+// Decodes a text up to its end, collecting the events in decoded
+static void feedText(t_stream *stream, const char *text, size_t length, uint64_t hostUs,
+                     t_decoded *decoded);
+
+// Lays out a measurement as sendAllSensors() does, with a status in
+// place of the CO reading
+// @return: Length of the text
+static int buildMeasurement(char *text, size_t size, uint64_t localUs, int32_t base);
+
+// Checks that two sample sets hold the same readings at the same times
+static uint8_t isSameSet(const t_sampleSet *a, const t_sampleSet *b);
+
+// Builds the sample set of a cycle
+static void buildSet(t_sampleSet *set, uint32_t cycle, uint64_t timeUs);
+
+// Reads a device file whole
+// @return: Length of the file, 0 if it cannot be read
+static size_t readFile(const char *path, uint8_t *data);
+
+
+/* *****************************************************************
+    *                        TEST FUNCTIONS                       *
+   ***************************************************************** */
+
+// Stream cut at every byte gives the sets of the stream read whole
+static void test_stream_split()
+{
+    t_stream stream;
+    t_decoded whole, split;
+    char text[TEXT_SIZE];
+    size_t length;
+    uint32_t mismatches = 0;
+
+    length = snprintf(text, sizeof(text),
+                      "HELLO:AeroSense-1A2B,node=1A2B,profile=drone,frame=1,build=Jan  1 2026 "
+                      "00:00:00,conn=3,time=1000000\r\n");
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        length += buildMeasurement(text + length, sizeof(text) - length, 2000000 + i * 500000,
+                                   100 + i);
+    }
+
+    initStream(&stream);
+    memset(&whole, 0, sizeof(whole));
+    feedText(&stream, text, length, 5000000, &whole);
+
+    CHECK(strcmp(whole.order, "HSSS") == 0);
+    CHECK(stream.identified && stream.nodeId == TEST_NODE && stream.connection == 3);
+    CHECK(strcmp(stream.name, "AeroSense-1A2B") == 0);
+    CHECK(stream.readings == 9);
+
+    // Readings on the host clock, the status passed over
+    CHECK(whole.sets[0].validMask ==
+          ((1UL << CH_TEMP) | (1UL << CH_CO2) | (1UL << CH_CLIMB)));
+    CHECK(whole.sets[0].value[CH_TEMP] == 100 && whole.sets[0].value[CH_CO2] == 101);
+    CHECK(whole.sets[0].value[CH_CLIMB] == -100);
+    CHECK(whole.sets[2].value[CH_TEMP] == 102);
+
+    // Each time reference arrived sooner than the last one, its offset
+    // is taken at once
+    CHECK(whole.sets[1].timeUs[CH_TEMP] == 5000000 - 2000);
+
+    for (size_t cut = 1; cut < length; cut++)
+    {
+        initStream(&stream);
+        memset(&split, 0, sizeof(split));
+        feedText(&stream, text, cut, 5000000, &split);
+        feedText(&stream, text + cut, length - cut, 5000000, &split);
+
+        if (strcmp(split.order, whole.order) != 0)
+        {
+            mismatches++;
+            continue;
+        }
+
+        for (uint8_t i = 0; i < split.setCount; i++)
+        {
+            mismatches += !isSameSet(&split.sets[i], &whole.sets[i]);
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+// Clock offset: the lowest offset at once, a higher one by a fraction
+static void test_stream_clock()
+{
+    t_stream stream;
+    t_decoded decoded;
+    const char hello[] = "HELLO:unit,node=0001,time=1000\n";
+    const char earlier[] = "Local:2000\n";
+    const char later[] = "Local:3000\n";
+    const char untimed[] = "HELLO:unit,node=0001\nTime:5000\nCO2:400ppm\nEND OF MEASUREMENT\n";
+
+    initStream(&stream);
+    memset(&decoded, 0, sizeof(decoded));
+
+    feedText(&stream, hello, strlen(hello), 10000, &decoded);
+    CHECK(stream.synced && stream.offsetUs == 9000);
+
+    feedText(&stream, earlier, strlen(earlier), 10500, &decoded);
+    CHECK(stream.offsetUs == 8500);
+
+    feedText(&stream, later, strlen(later), 20000, &decoded);
+    CHECK(stream.offsetUs == 8500 + ((17000 - 8500) >> STREAM_OFFSET_SHIFT));
+
+    // A hello without time: the unit clock is unknown, the readings
+    // take the time they arrived
+    feedText(&stream, untimed, strlen(untimed), 777000, &decoded);
+    CHECK(!stream.synced);
+    CHECK(decoded.setCount == 1 && decoded.sets[0].timeUs[CH_CO2] == 777000);
+}
+
+// Lines that belong to the next measurement complete the open set first
+static void test_stream_held_lines()
+{
+    t_stream stream;
+    t_decoded decoded;
+    char text[TEXT_SIZE];
+    size_t length;
+
+    length = snprintf(text, sizeof(text),
+                      "HELLO:a,node=0001,time=0\n%s1C\n%s2ppm\n%s3C\n"
+                      "HELLO:b,node=0002,time=0\n%s4C\nLocal:10\n%s5C\n",
+                      getChannelName(CH_TEMP), getChannelName(CH_CO2), getChannelName(CH_TEMP),
+                      getChannelName(CH_TEMP), getChannelName(CH_TEMP));
+
+    initStream(&stream);
+    memset(&decoded, 0, sizeof(decoded));
+    feedText(&stream, text, length, 1000, &decoded);
+
+    // Duplicate channel, hello while a set is open, time reference
+    // while a set is open
+    CHECK(strcmp(decoded.order, "HSSHS") == 0);
+    CHECK(decoded.sets[0].value[CH_TEMP] == 1 && decoded.sets[0].value[CH_CO2] == 2);
+    CHECK(decoded.sets[1].validMask == (1UL << CH_TEMP) && decoded.sets[1].value[CH_TEMP] == 3);
+    CHECK(decoded.sets[2].value[CH_TEMP] == 4);
+    CHECK(stream.nodeId == 0x0002);
+
+    // The last reading waits for the end of the connection, the cut
+    // line after it is dropped
+    feedText(&stream, "CO2:9", 5, 2000, &decoded);
+    CHECK(endStream(&stream, 3000));
+    CHECK(stream.done.validMask == (1UL << CH_TEMP) && stream.done.value[CH_TEMP] == 5);
+    CHECK(stream.doneTimeUs == 3000 && stream.doneLocalUs == 10);
+    CHECK(!endStream(&stream, 4000));
+}
+
+// Readings before the hello line, and lines too long to keep
+static void test_stream_skipped()
+{
+    t_stream stream;
+    t_decoded decoded;
+    char text[TEXT_SIZE];
+    size_t length;
+
+    length = snprintf(text, sizeof(text), "%s400ppm\nHELLO:a,node=0001\n", getChannelName(CH_CO2));
+    memset(text + length, 'A', 2 * STREAM_LINE_SIZE);
+    length += 2 * STREAM_LINE_SIZE;
+    length += snprintf(text + length, sizeof(text) - length, "\n%s7C\nHELLO:bad,conn=1\n%s\n",
+                       getChannelName(CH_TEMP), STREAM_END_LINE);
+
+    initStream(&stream);
+    memset(&decoded, 0, sizeof(decoded));
+    feedText(&stream, text, length, 1000, &decoded);
+
+    CHECK(stream.unidentified == 1);
+    CHECK(stream.skipped == 2);
+    CHECK(strcmp(decoded.order, "HS") == 0);
+    CHECK(decoded.sets[0].validMask == (1UL << CH_TEMP) && decoded.sets[0].value[CH_TEMP] == 7);
+}
+
+// Device files decode with the host decoder, also after a cut record
+static void test_storage(const char *directory)
+{
+    t_storage storage;
+    t_sampleSet set;
+    t_columns columns;
+    t_recordStream records;
+    char path[STORAGE_PATH_SIZE - 9], node[STORAGE_PATH_SIZE], other[STORAGE_PATH_SIZE];
+    uint8_t *data = (uint8_t *)malloc(FILE_SIZE);
+    const uint8_t cut[] = {40, 1, 2, 3, 4, 5, 6};
+    size_t length, stored;
+    uint64_t timeUs = 1780000000000000ULL;
+    uint32_t mismatches = 0;
+    size_t row = 0;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/devices", directory);
+    snprintf(node, sizeof(node), "%s/%04X.bin", path, TEST_NODE);
+    snprintf(other, sizeof(other), "%s/%04X.bin", path, OTHER_NODE);
+    unlink(node);
+    unlink(other);
+
+    if (!initStorage(&storage, path, 20000))
+    {
+        CHECK(!"storage");
+        free(data);
+        return;
+    }
+
+    storage.noSync = 1;
+
+    // Two units, committed together
+    for (uint32_t cycle = 0; cycle < STORED_SETS; cycle++)
+    {
+        buildSet(&set, cycle, timeUs + cycle * 100000);
+        CHECK(storeSampleSet(&storage, TEST_NODE, &set, timeUs + cycle * 100000, cycle));
+    }
+
+    CHECK(storeSampleSet(&storage, OTHER_NODE, &set, timeUs, 0));
+    // Due once the first record waited the commit interval
+    CHECK(getCommitDelay(&storage, 5000) == 15000);
+    CHECK(getCommitDelay(&storage, 20000) == 0);
+    CHECK(commitStorage(&storage) == STORED_SETS + 3);
+    CHECK(getCommitDelay(&storage, 0) == -1);
+    CHECK(storage.packed > 0 && storage.errors == 0);
+    freeStorage(&storage);
+
+    // Every reading back, in UTC
+    stored = readFile(node, data);
+    CHECK(initColumns(&columns));
+    initRecordStream(&records, &columns);
+
+    CHECK(decodeRecords(&records, data, stored, &columns) == stored);
+    CHECK(records.frames[FRAME_TYPE_SCHEMA] == 1);
+    CHECK(records.frames[FRAME_TYPE_SAMPLES] == STORED_SETS);
+    CHECK(records.frames[FRAME_TYPE_PACKED] == storage.packed);
+    CHECK(records.rejected == 0);
+
+    for (uint32_t cycle = 0; cycle < STORED_SETS; cycle++)
+    {
+        buildSet(&set, cycle, timeUs + cycle * 100000);
+
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+        {
+            if (!isSampleValid(&set, (e_channel)ch))
+            {
+                continue;
+            }
+
+            if (row >= columns.rows || columns.node[row] != TEST_NODE ||
+                columns.flags[row] != FRAME_FLAG_UTC || columns.channel[row] != ch ||
+                columns.value[row] != set.value[ch] ||
+                columns.timeUs[row] != (int64_t)set.timeUs[ch])
+            {
+                mismatches++;
+            }
+
+            row++;
+        }
+    }
+
+    CHECK(mismatches == 0 && row == columns.rows);
+    freeColumns(&columns);
+
+    // A record cut by a crash is dropped when the file is opened again
+    fd = open(node, O_WRONLY | O_APPEND);
+    CHECK(fd >= 0 && write(fd, cut, sizeof(cut)) == (ssize_t)sizeof(cut));
+    close(fd);
+
+    CHECK(initStorage(&storage, path, 20000));
+    storage.noSync = 1;
+    CHECK(storeSampleSet(&storage, TEST_NODE, &set, timeUs, 0));
+    freeStorage(&storage);
+
+    length = readFile(node, data);
+    CHECK(initColumns(&columns));
+    initRecordStream(&records, &columns);
+
+    CHECK(decodeRecords(&records, data, length, &columns) == length);
+    CHECK(records.frames[FRAME_TYPE_SCHEMA] == 2);
+    CHECK(records.frames[FRAME_TYPE_SAMPLES] == STORED_SETS + 1);
+    CHECK(records.rejected == 0);
+    CHECK(memcmp(data + stored, cut, sizeof(cut)) != 0);
+
+    freeColumns(&columns);
+    free(data);
+}
+
+// Percentiles within a bucket, exact for the short latencies
+static void test_latency()
+{
+    t_latency latency;
+    uint64_t us;
+
+    initLatency(&latency);
+    CHECK(getLatencyPercentile(&latency, 0.5) == 0);
+
+    for (uint64_t i = 1; i <= 1000; i++)
+    {
+        addLatency(&latency, i);
+    }
+
+    CHECK(latency.count == 1000 && latency.maxUs == 1000);
+    CHECK(getLatencyPercentile(&latency, 0.5) == 500);
+    CHECK(getLatencyPercentile(&latency, 0.0) == 1);
+    CHECK(getLatencyPercentile(&latency, 1.0) == 1000);
+
+    us = getLatencyPercentile(&latency, 0.99);
+    CHECK(us >= 990 && us <= 990 * 1.004);
+
+    // Long latencies known within 0.4%, the longest ones capped
+    initLatency(&latency);
+    addLatency(&latency, 1234567);
+    addLatency(&latency, 2000000);
+    addLatency(&latency, 1ULL << 40);
+
+    us = getLatencyPercentile(&latency, 0.2);
+    CHECK(us >= 1234567 && us <= 1234567 * 1.004);
+
+    us = getLatencyPercentile(&latency, 0.5);
+    CHECK(us >= 2000000 && us <= 2000000 * 1.004);
+
+    CHECK(latency.maxUs == LATENCY_MAX_US);
+    CHECK(getLatencyPercentile(&latency, 1.0) == LATENCY_MAX_US);
+}
+
+// Runs every test, the first argument is the directory of the device files
+int main(int argc, char **argv)
+{
+    const char *directory = argc > 1 ? argv[1] : ".";
+
+    test_stream_split();
+    test_stream_clock();
+    test_stream_held_lines();
+    test_stream_skipped();
+    test_storage(directory);
+    test_latency();
+
+    printf("test_ingest: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
+
+
+/* *****************************************************************
+    *                      PRIVATE FUNCTIONS                      *
+   ***************************************************************** */
+
+// Decodes a text up to its end, collecting the events in decoded
+static void feedText(t_stream *stream, const char *text, size_t length, uint64_t hostUs,
+                     t_decoded *decoded)
+{
+    const uint8_t *data = (const uint8_t *)text;
+    size_t position = 0, used;
+    e_streamEvent event;
+    size_t events = strlen(decoded->order);
+
+    // As the server reads: again after each event, and once more for a
+    // line held for the next set
+    while (position < length || stream->lineHeld)
+    {
+        event = feedStream(stream, data + position, length - position, hostUs, &used);
+        position += used;
+
+        if (event == STREAM_EVENT_SET && decoded->setCount < MAX_SETS)
+        {
+            decoded->sets[decoded->setCount++] = stream->done;
+            decoded->order[events++] = 'S';
+        }
+
+        else if (event == STREAM_EVENT_HELLO && events < MAX_SETS * 2)
+        {
+            decoded->helloCount++;
+            decoded->order[events++] = 'H';
+        }
+    }
+
+    decoded->order[events] = '\0';
+}
+
+// Lays out a measurement as sendAllSensors() does, with a status in
+// place of the CO reading
+static int buildMeasurement(char *text, size_t size, uint64_t localUs, int32_t base)
+{
+    const char divider[] = "------------------------------";
+
+    return snprintf(text, size,
+                    "\r\n%s\r\nTIME\r\n%s\r\nLocal:%llu\r\nUTC:UNSYNCED\r\n\r\n"
+                    "\r\n%s\r\nSHT SENSOR\r\n%s\r\nTime:%llu\r\n%s%ld%s\r\n"
+                    "\r\n%s\r\nGAS SENSOR\r\n%s\r\nTime:%llu\r\n%sPREHEAT\r\n%s%ld%s\r\n"
+                    "%s%ld %s\r\n\r\n%s\r\n%s\r\n%s\r\n",
+                    divider, divider, (unsigned long long)localUs, divider, divider,
+                    (unsigned long long)(localUs - 2000), getChannelName(CH_TEMP), (long)base,
+                    getChannelUnit(CH_TEMP), divider, divider, (unsigned long long)(localUs - 1000),
+                    getChannelName(CH_CO), getChannelName(CH_CO2), (long)(base + 1),
+                    getChannelUnit(CH_CO2), getChannelName(CH_CLIMB), (long)-base,
+                    getChannelUnit(CH_CLIMB), divider, STREAM_END_LINE, divider);
+}
+
+// Checks that two sample sets hold the same readings at the same times
+static uint8_t isSameSet(const t_sampleSet *a, const t_sampleSet *b)
+{
+    if (a->validMask != b->validMask)
+    {
+        return 0;
+    }
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (isSampleValid(a, (e_channel)ch) &&
+            (a->value[ch] != b->value[ch] || a->timeUs[ch] != b->timeUs[ch]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Builds the sample set of a cycle
+static void buildSet(t_sampleSet *set, uint32_t cycle, uint64_t timeUs)
+{
+    clearSampleSet(set);
+
+    setSampleValue(set, CH_TEMP, 2150 + cycle % 40, timeUs - 12000);
+    setSampleValue(set, CH_PRESSURE, 101325 - cycle, timeUs - 10000);
+    setSampleValue(set, CH_CO2, 415 + cycle % 7, timeUs - 4000);
+    setSampleValue(set, CH_CLIMB, -(int32_t)(cycle * 13), timeUs);
+
+    if (cycle % 4 == 0)
+    {
+        setSampleValue(set, CH_CO, 3, timeUs - 3000);
+    }
+}
+
+// Reads a device file whole
+static size_t readFile(const char *path, uint8_t *data)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t count;
+    size_t length = 0;
+
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    while (length < FILE_SIZE && (count = read(fd, data + length, FILE_SIZE - length)) > 0)
+    {
+        length += count;
+    }
+
+    close(fd);
+    return length;
+}